@@ -4947,6 +4947,281 @@ static void test_RegRenameKey(void)
     RegCloseKey(key);
 }
 
+static void test_many_subkeys(void)
+{
+    static const unsigned int count = 300;
+    char name[64], prev[64], buffer[64];
+    DWORD i, len, subkeys, values, dw;
+    HKEY key, clsid, subkey;
+    LSTATUS ret;
+
+    /* mimic the registration of many COM classes by an installer */
+    ret = RegCreateKeyExA(hkey_main, "CLSID", 0, NULL, 0, KEY_ALL_ACCESS, NULL, &clsid, NULL);
+    ok(!ret, "Unexpected return value %ld.\n", ret);
+
+    for (i = 0; i < count; i++)
+    {
+        /* scatter the names so that they are not created in sorted order */
+        dw = (i * 2654435761u) ^ 0x5a5a5a5a;
+        sprintf(name, "{%08lX-%04lX-11D0-8C%02lX-00A0C9%06lX}", dw, i & 0xffff, i % 256, i);
+        ret = RegCreateKeyExA(clsid, name, 0, NULL, 0, KEY_ALL_ACCESS, NULL, &key, NULL);
+        ok(!ret, "Unexpected return value %ld.\n", ret);
+        ret = RegSetValueExA(key, NULL, 0, REG_SZ, (BYTE *)"Test class", sizeof("Test class"));
+        ok(!ret, "Unexpected return value %ld.\n", ret);
+        ret = RegCreateKeyExA(key, "InprocServer32", 0, NULL, 0, KEY_ALL_ACCESS, NULL, &subkey, NULL);
+        ok(!ret, "Unexpected return value %ld.\n", ret);
+        ret = RegSetValueExA(subkey, "ThreadingModel", 0, REG_SZ, (BYTE *)"Both", sizeof("Both"));
+        ok(!ret, "Unexpected return value %ld.\n", ret);
+        RegCloseKey(subkey);
+        RegCloseKey(key);
+
+        sprintf(name, "Value%lu", dw);
+        ret = RegSetValueExA(clsid, name, 0, REG_DWORD, (BYTE *)&i, sizeof(i));
+        ok(!ret, "Unexpected return value %ld.\n", ret);
+    }
+
+    ret = RegQueryInfoKeyA(clsid, NULL, NULL, NULL, &subkeys, NULL, NULL, &values, NULL, NULL, NULL, NULL);
+    ok(!ret, "Unexpected return value %ld.\n", ret);
+    ok(subkeys == count, "Unexpected subkey count %lu.\n", subkeys);
+    ok(values == count, "Unexpected value count %lu.\n", values);
+
+    /* lookups are case insensitive */
+    dw = (17 * 2654435761u) ^ 0x5a5a5a5a;
+    sprintf(name, "{%08lx-%04lx-11d0-8c%02lx-00a0c9%06lx}\\inprocserver32", dw, 17ul, 17ul, 17ul);
+    ret = RegOpenKeyExA(clsid, name, 0, KEY_READ, &key);
+    ok(!ret, "Unexpected return value %ld.\n", ret);
+    RegCloseKey(key);
+    sprintf(name, "VALUE%lu", dw);
+    len = sizeof(dw);
+    ret = RegQueryValueExA(clsid, name, NULL, NULL, (BYTE *)&dw, &len);
+    ok(!ret, "Unexpected return value %ld.\n", ret);
+    ok(dw == 17, "Unexpected value %lu.\n", dw);
+
+    /* a renamed key is enumerated at its new position */
+    sprintf(name, "{%08lX-%04lX-11D0-8C%02lX-00A0C9%06lX}", (DWORD)((42 * 2654435761u) ^ 0x5a5a5a5a), 42ul, 42ul, 42ul);
+    ret = RegOpenKeyExA(clsid, name, 0, KEY_ALL_ACCESS, &key);
+    ok(!ret, "Unexpected return value %ld.\n", ret);
+    ret = RegRenameKey(key, NULL, L"{00000000-0000-0000-0000-000000000000}");
+    ok(!ret, "Unexpected return value %ld.\n", ret);
+    RegCloseKey(key);
+
+    prev[0] = 0;
+    for (i = 0; i < count; i++)
+    {
+        len = sizeof(buffer);
+        ret = RegEnumKeyExA(clsid, i, buffer, &len, NULL, NULL, NULL, NULL);
+        ok(!ret, "Unexpected return value %ld.\n", ret);
+        if (!i) ok(!strcmp(buffer, "{00000000-0000-0000-0000-000000000000}"), "Unexpected first key %s.\n", buffer);
+        else ok(lstrcmpiA(prev, buffer) < 0, "Keys %s and %s are not sorted.\n", prev, buffer);
+        strcpy(prev, buffer);
+    }
+    len = sizeof(buffer);
+    ret = RegEnumKeyExA(clsid, count, buffer, &len, NULL, NULL, NULL, NULL);
+    ok(ret == ERROR_NO_MORE_ITEMS, "Unexpected return value %ld.\n", ret);
+
+    for (i = 0; i < count; i++)
+    {
+        len = sizeof(buffer);
+        ret = RegEnumValueA(clsid, i, buffer, &len, NULL, NULL, NULL, NULL);
+        ok(!ret, "Unexpected return value %ld.\n", ret);
+    }
+    len = sizeof(buffer);
+    ret = RegEnumValueA(clsid, count, buffer, &len, NULL, NULL, NULL, NULL);
+    ok(ret == ERROR_NO_MORE_ITEMS, "Unexpected return value %ld.\n", ret);
+
+    /* delete half of the keys and values, then create them again */
+    for (i = 1; i < count; i += 2)
+    {
+        dw = (i * 2654435761u) ^ 0x5a5a5a5a;
+        sprintf(name, "{%08lX-%04lX-11D0-8C%02lX-00A0C9%06lX}\\InprocServer32", dw, i & 0xffff, i % 256, i);
+        ret = RegDeleteKeyA(clsid, name);
+        ok(!ret, "Unexpected return value %ld.\n", ret);
+        *strchr(name, '\\') = 0;
+        ret = RegDeleteKeyA(clsid, name);
+        ok(!ret, "Unexpected return value %ld.\n", ret);
+        sprintf(name, "Value%lu", dw);
+        ret = RegDeleteValueA(clsid, name);
+        ok(!ret, "Unexpected return value %ld.\n", ret);
+    }
+    for (i = 1; i < count; i += 2)
+    {
+        dw = (i * 2654435761u) ^ 0x5a5a5a5a;
+        sprintf(name, "{%08lX-%04lX-11D0-8C%02lX-00A0C9%06lX}", dw, i & 0xffff, i % 256, i);
+        ret = RegCreateKeyExA(clsid, name, 0, NULL, 0, KEY_ALL_ACCESS, NULL, &key, NULL);
+        ok(!ret, "Unexpected return value %ld.\n", ret);
+        RegCloseKey(key);
+        sprintf(name, "Value%lu", dw);
+        ret = RegSetValueExA(clsid, name, 0, REG_DWORD, (BYTE *)&i, sizeof(i));
+        ok(!ret, "Unexpected return value %ld.\n", ret);
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        dw = (i * 2654435761u) ^ 0x5a5a5a5a;
+        if (i == 42) continue;
+        sprintf(name, "{%08lx-%04lx-11d0-8c%02lx-00a0c9%06lx}", dw, i & 0xffff, i % 256, i);
+        ret = RegOpenKeyExA(clsid, name, 0, KEY_READ, &key);
+        ok(!ret, "Unexpected return value %ld for %s.\n", ret, name);
+        RegCloseKey(key);
+        sprintf(name, "VALUE%lu", dw);
+        len = sizeof(dw);
+        ret = RegQueryValueExA(clsid, name, NULL, NULL, (BYTE *)&dw, &len);
+        ok(!ret, "Unexpected return value %ld for %s.\n", ret, name);
+        ok(dw == i, "Unexpected value %lu.\n", dw);
+    }
+
+    prev[0] = 0;
+    for (i = 0; i < count; i++)
+    {
+        len = sizeof(buffer);
+        ret = RegEnumKeyExA(clsid, i, buffer, &len, NULL, NULL, NULL, NULL);
+        ok(!ret, "Unexpected return value %ld.\n", ret);
+        ok(lstrcmpiA(prev, buffer) < 0, "Keys %s and %s are not sorted.\n", prev, buffer);
+        strcpy(prev, buffer);
+    }
+    ret = RegQueryInfoKeyA(clsid, NULL, NULL, NULL, &subkeys, NULL, NULL, &values, NULL, NULL, NULL, NULL);
+    ok(!ret, "Unexpected return value %ld.\n", ret);
+    ok(subkeys == count, "Unexpected subkey count %lu.\n", subkeys);
+    ok(values == count, "Unexpected value count %lu.\n", values);
+
+    ret = delete_key(clsid);
+    ok(!ret, "Unexpected return value %ld.\n", ret);
+    RegCloseKey(clsid);
+}
+
+static void benchmark_many_subkeys(void)
+{
+    static const unsigned int count = 100000;
+    DWORD i, len, dw, start;
+    char name[64], buffer[64];
+    HKEY key, clsid;
+    LSTATUS ret;
+
+    /* time the operations that depend on the number of children of a key, with
+     * names that keep the key and value indexes growing all the way through */
+    ret = RegCreateKeyExA(hkey_main, "CLSID", 0, NULL, 0, KEY_ALL_ACCESS, NULL, &clsid, NULL);
+    ok(!ret, "Unexpected return value %ld.\n", ret);
+
+    start = GetTickCount();
+    for (i = 0; i < count; i++)
+    {
+        dw = (i * 2654435761u) ^ 0x5a5a5a5a;
+        sprintf(name, "{%08lX-%04lX-11D0-8C%02lX-00A0C9%06lX}", dw, i & 0xffff, i % 256, i);
+        ret = RegCreateKeyExA(clsid, name, 0, NULL, 0, KEY_ALL_ACCESS, NULL, &key, NULL);
+        ok(!ret, "Unexpected return value %ld.\n", ret);
+        RegCloseKey(key);
+        sprintf(name, "Value%lu", dw);
+        ret = RegSetValueExA(clsid, name, 0, REG_DWORD, (BYTE *)&i, sizeof(i));
+        ok(!ret, "Unexpected return value %ld.\n", ret);
+    }
+    trace("created %u keys and values in %lu ms\n", count, GetTickCount() - start);
+
+    start = GetTickCount();
+    for (i = 0; i < count; i++)
+    {
+        dw = (i * 2654435761u) ^ 0x5a5a5a5a;
+        sprintf(name, "{%08lx-%04lx-11d0-8c%02lx-00a0c9%06lx}", dw, i & 0xffff, i % 256, i);
+        ret = RegOpenKeyExA(clsid, name, 0, KEY_READ, &key);
+        ok(!ret, "Unexpected return value %ld.\n", ret);
+        RegCloseKey(key);
+        sprintf(name, "VALUE%lu", dw);
+        len = sizeof(dw);
+        ret = RegQueryValueExA(clsid, name, NULL, NULL, (BYTE *)&dw, &len);
+        ok(!ret, "Unexpected return value %ld.\n", ret);
+    }
+    trace("looked up %u keys and values in %lu ms\n", count, GetTickCount() - start);
+
+    start = GetTickCount();
+    for (i = 0; i < count; i++)
+    {
+        len = sizeof(buffer);
+        ret = RegEnumKeyExA(clsid, i, buffer, &len, NULL, NULL, NULL, NULL);
+        ok(!ret, "Unexpected return value %ld.\n", ret);
+        len = sizeof(buffer);
+        ret = RegEnumValueA(clsid, i, buffer, &len, NULL, NULL, NULL, NULL);
+        ok(!ret, "Unexpected return value %ld.\n", ret);
+    }
+    trace("enumerated %u keys and values in %lu ms\n", count, GetTickCount() - start);
+
+    start = GetTickCount();
+    for (i = 0; i < count; i++)
+    {
+        dw = (i * 2654435761u) ^ 0x5a5a5a5a;
+        sprintf(name, "Value%lu", dw);
+        ret = RegDeleteValueA(clsid, name);
+        ok(!ret, "Unexpected return value %ld.\n", ret);
+    }
+    trace("deleted %u values in %lu ms\n", count, GetTickCount() - start);
+
+    start = GetTickCount();
+    ret = delete_key(clsid);
+    ok(!ret, "Unexpected return value %ld.\n", ret);
+    trace("deleted %u keys in %lu ms\n", count, GetTickCount() - start);
+    RegCloseKey(clsid);
+}
+
+struct query_bench_thread
+{
+    HANDLE start;
+    HKEY key;
+};
+
+static DWORD WINAPI query_bench_proc(void *arg)
+{
+    struct query_bench_thread *params = arg;
+    DWORD i, len, dw;
+    LSTATUS ret;
+
+    WaitForSingleObject(params->start, INFINITE);
+    for (i = 0; i < 50000; i++)
+    {
+        len = sizeof(dw);
+        ret = RegQueryValueExA(params->key, "Bench", NULL, NULL, (BYTE *)&dw, &len);
+        if (ret) break;
+    }
+    return i;
+}
+
+static void benchmark_query_value_clients(void)
+{
+    struct query_bench_thread params[8];
+    HANDLE threads[8], start;
+    DWORD i, count, time, dw = 1, done;
+    LSTATUS ret;
+
+    /* each thread is a separate server client, and every query is one server request */
+    ret = RegSetValueExA(hkey_main, "Bench", 0, REG_DWORD, (BYTE *)&dw, sizeof(dw));
+    ok(!ret, "Unexpected return value %ld.\n", ret);
+
+    for (count = 1; count <= ARRAY_SIZE(threads); count *= 2)
+    {
+        start = CreateEventW(NULL, TRUE, FALSE, NULL);
+        for (i = 0; i < count; i++)
+        {
+            params[i].start = start;
+            params[i].key = hkey_main;
+            threads[i] = CreateThread(NULL, 0, query_bench_proc, &params[i], 0, NULL);
+        }
+        time = GetTickCount();
+        SetEvent(start);
+        WaitForMultipleObjects(count, threads, TRUE, INFINITE);
+        time = max(GetTickCount() - time, 1);
+
+        for (i = 0; i < count; i++)
+        {
+            GetExitCodeThread(threads[i], &done);
+            ok(done == 50000, "Unexpected query count %lu.\n", done);
+            CloseHandle(threads[i]);
+        }
+        trace("%lu clients: %lu queries in %lu ms, %lu requests/s\n", count, count * 50000, time,
+                count * 50000 * 1000 / time);
+        CloseHandle(start);
+    }
+
+    ret = RegDeleteValueA(hkey_main, "Bench");
+    ok(!ret, "Unexpected return value %ld.\n", ret);
+}
+
 START_TEST(registry)
 {
     /* Load pointers for functions that are not available in all Windows versions */
@@ -4988,6 +5263,11 @@ START_TEST(registry)
     test_EnumDynamicTimeZoneInformation();
     test_perflib_key();
     test_RegRenameKey();
+    test_many_subkeys();
+    if (winetest_interactive)
+        benchmark_many_subkeys();
+    if (winetest_interactive)
+        benchmark_query_value_clients();
 
     /* cleanup */
     delete_key( hkey_main );
@@ -934,6 +934,201 @@ static void test_FDICopy(void)
     FDIDestroy(hfdi);
 }
 
+static char folder_data_byte(unsigned int file, unsigned int pos)
+{
+    /* compressible, but not trivially so */
+    return "abcdefghijklmnopqrstuvwxyz0123456789"[(pos * (file + 7) / 5 + pos / 300) % 36];
+}
+
+static void create_large_test_file(const char *name, unsigned int file, unsigned int size)
+{
+    HANDLE handle;
+    DWORD written;
+    char *data;
+    unsigned int i;
+
+    data = HeapAlloc(GetProcessHeap(), 0, size);
+    for (i = 0; i < size; i++) data[i] = folder_data_byte(file, i);
+
+    handle = CreateFileA(name, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL);
+    ok(handle != INVALID_HANDLE_VALUE, "Failure to open file %s\n", name);
+    WriteFile(handle, data, size, &written, NULL);
+    CloseHandle(handle);
+
+    HeapFree(GetProcessHeap(), 0, data);
+}
+
+struct folder_file
+{
+    unsigned int file;
+    unsigned int size;
+    unsigned int pos;
+    BOOL mismatch;
+};
+
+static struct folder_file folder_files[3];
+static const unsigned int folder_file_sizes[3] = { 200000, 70000, 33000 };
+
+static UINT CDECL fdi_folder_write(INT_PTR hf, void *pv, UINT cb)
+{
+    struct folder_file *file = (struct folder_file *)hf;
+    const char *data = pv;
+    UINT i;
+
+    for (i = 0; i < cb && !file->mismatch; i++)
+        file->mismatch = data[i] != folder_data_byte(file->file, file->pos + i);
+    file->pos += cb;
+    return cb;
+}
+
+static INT_PTR CDECL fdi_folder_notify(FDINOTIFICATIONTYPE fdint, FDINOTIFICATION *info)
+{
+    struct folder_file *file;
+    unsigned int i;
+
+    switch (fdint)
+    {
+    case fdintCOPY_FILE:
+        if (sscanf(info->psz1, "large%u.dat", &i) != 1 || i >= ARRAY_SIZE(folder_files))
+        {
+            ok(0, "unexpected file %s\n", info->psz1);
+            return 0;
+        }
+        ok(info->cb == folder_file_sizes[i], "%u: expected %u, got %lu\n", i, folder_file_sizes[i], info->cb);
+        ok(info->iFolder == i, "%u: expected folder %u, got %u\n", i, i, info->iFolder);
+        file = &folder_files[i];
+        file->file = i;
+        file->size = info->cb;
+        file->pos = 0;
+        file->mismatch = FALSE;
+        return (INT_PTR)file;
+
+    case fdintCLOSE_FILE_INFO:
+        file = (struct folder_file *)info->hf;
+        ok(file->pos == file->size, "%u: expected %u bytes, got %u\n", file->file, file->size, file->pos);
+        ok(!file->mismatch, "%u: got wrong data\n", file->file);
+        return 1;
+
+    default:
+        return 0;
+    }
+}
+
+/* create extract.cab with each of the large test files in its own folder */
+static void create_folders_cab_file(void)
+{
+    char file_name[MAX_PATH];
+    CCAB cabParams;
+    unsigned int i;
+    HFCI hfci;
+    ERF erf;
+    BOOL ret;
+
+    set_cab_parameters(&cabParams);
+
+    hfci = FCICreate(&erf, file_placed, mem_alloc, mem_free, fci_open,
+                     fci_read, fci_write, fci_close, fci_seek,
+                     fci_delete, get_temp_file, &cabParams, NULL);
+    ok(hfci != NULL, "Failed to create an FCI context\n");
+
+    for (i = 0; i < ARRAY_SIZE(folder_files); i++)
+    {
+        sprintf(file_name, "large%u.dat", i);
+        create_large_test_file(file_name, i, folder_file_sizes[i]);
+        add_file(hfci, file_name);
+        ret = FCIFlushFolder(hfci, get_next_cabinet, progress);
+        ok(ret, "Failed to flush the folder\n");
+        DeleteFileA(file_name);
+    }
+
+    ret = FCIFlushCabinet(hfci, FALSE, get_next_cabinet, progress);
+    ok(ret, "Failed to flush the cabinet\n");
+    FCIDestroy(hfci);
+}
+
+static void test_FDICopy_folders(void)
+{
+    char name[] = "extract.cab", path[MAX_PATH + 1];
+    unsigned int i;
+    HFDI hfdi;
+    ERF erf;
+    BOOL ret;
+
+    create_folders_cab_file();
+
+    lstrcpyA(path, CURR_DIR);
+    lstrcatA(path, "\\");
+
+    hfdi = FDICreate(fdi_alloc, fdi_free, fdi_open, fdi_read,
+                     fdi_folder_write, fdi_close, fdi_seek,
+                     cpuUNKNOWN, &erf);
+    ok(hfdi != NULL, "FDICreate error %d\n", erf.erfOper);
+
+    memset(folder_files, 0, sizeof(folder_files));
+    ret = FDICopy(hfdi, name, path, 0, fdi_folder_notify, NULL, 0);
+    ok(ret, "FDICopy error %d\n", erf.erfOper);
+    for (i = 0; i < ARRAY_SIZE(folder_files); i++)
+        ok(folder_files[i].size == folder_file_sizes[i], "%u: file was not extracted\n", i);
+
+    FDIDestroy(hfdi);
+    DeleteFileA(name);
+}
+
+static UINT CDECL fdi_bench_write(INT_PTR hf, void *pv, UINT cb)
+{
+    *(ULONGLONG *)hf += cb;
+    return cb;
+}
+
+static INT_PTR CDECL fdi_bench_notify(FDINOTIFICATIONTYPE fdint, FDINOTIFICATION *info)
+{
+    switch (fdint)
+    {
+    case fdintCOPY_FILE:
+        return (INT_PTR)info->pv;
+    case fdintCLOSE_FILE_INFO:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+static void benchmark_FDICopy(void)
+{
+    char name[] = "extract.cab", path[MAX_PATH + 1];
+    LARGE_INTEGER freq, start, end;
+    ULONGLONG written = 0;
+    unsigned int i;
+    HFDI hfdi;
+    ERF erf;
+    BOOL ret;
+
+    create_folders_cab_file();
+
+    lstrcpyA(path, CURR_DIR);
+    lstrcatA(path, "\\");
+
+    hfdi = FDICreate(fdi_alloc, fdi_free, fdi_open, fdi_read,
+                     fdi_bench_write, fdi_close, fdi_seek,
+                     cpuUNKNOWN, &erf);
+    ok(hfdi != NULL, "FDICreate error %d\n", erf.erfOper);
+
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < 200; i++)
+    {
+        ret = FDICopy(hfdi, name, path, 0, fdi_bench_notify, NULL, &written);
+        ok(ret, "FDICopy error %d\n", erf.erfOper);
+    }
+    QueryPerformanceCounter(&end);
+
+    trace("extracted %I64u bytes in %I64u ms, %.1f MB/s\n", written,
+          (end.QuadPart - start.QuadPart) * 1000 / freq.QuadPart,
+          written / 1e6 * freq.QuadPart / (end.QuadPart - start.QuadPart));
+
+    FDIDestroy(hfdi);
+    DeleteFileA(name);
+}
 
 START_TEST(fdi)
 {
@@ -947,4 +1142,8 @@ START_TEST(fdi)
     test_FDIDestroy();
     test_FDIIsCabinet();
     test_FDICopy();
+    test_FDICopy_folders();
+
+    if (winetest_interactive)
+        benchmark_FDICopy();
 }
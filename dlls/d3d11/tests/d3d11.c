@@ -35452,6 +35452,262 @@ static void test_clear_during_render(void)
     release_test_context(&test_context);
 }
 
+static void test_shader_cache_child(void)
+{
+    static const struct vec4 color = {0.25f, 0.5f, 0.75f, 1.0f};
+    struct d3d11_test_context test_context;
+
+    if (!init_test_context(&test_context, NULL))
+        return;
+
+    draw_color_quad(&test_context, &color);
+    check_texture_color(test_context.backbuffer, 0xffbf8040, 1);
+
+    release_test_context(&test_context);
+}
+
+struct shader_cache_file
+{
+    char name[17];
+    DWORD size;
+    ULONGLONG index;
+    FILETIME write_time;
+};
+
+/* Entries are named after the 64-bit hash of their key. */
+static unsigned int get_shader_cache_files(const char *dir, struct shader_cache_file *files, unsigned int max_count)
+{
+    BY_HANDLE_FILE_INFORMATION info;
+    unsigned int count = 0;
+    WIN32_FIND_DATAA data;
+    char path[MAX_PATH];
+    HANDLE find, file;
+
+    sprintf(path, "%s\\*", dir);
+    if ((find = FindFirstFileA(path, &data)) == INVALID_HANDLE_VALUE)
+        return 0;
+    do
+    {
+        if (strlen(data.cFileName) != 16 || strspn(data.cFileName, "0123456789abcdef") != 16)
+            continue;
+        sprintf(path, "%s\\%s", dir, data.cFileName);
+        file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                NULL, OPEN_EXISTING, 0, NULL);
+        ok(file != INVALID_HANDLE_VALUE, "Failed to open %s, error %lu.\n", path, GetLastError());
+        if (file == INVALID_HANDLE_VALUE)
+            continue;
+        if (count < max_count && GetFileInformationByHandle(file, &info))
+        {
+            strcpy(files[count].name, data.cFileName);
+            files[count].size = info.nFileSizeLow;
+            files[count].index = ((ULONGLONG)info.nFileIndexHigh << 32) | info.nFileIndexLow;
+            files[count].write_time = info.ftLastWriteTime;
+            ++count;
+        }
+        CloseHandle(file);
+    } while (FindNextFileA(find, &data));
+    FindClose(find);
+
+    return count;
+}
+
+static const struct shader_cache_file *find_shader_cache_file(const struct shader_cache_file *files,
+        unsigned int count, const char *name)
+{
+    unsigned int i;
+
+    for (i = 0; i < count; ++i)
+    {
+        if (!strcmp(files[i].name, name))
+            return &files[i];
+    }
+    return NULL;
+}
+
+static void set_shader_cache_file_time(const char *dir, const char *name, unsigned int hours_ago)
+{
+    ULARGE_INTEGER time;
+    char path[MAX_PATH];
+    FILETIME filetime;
+    HANDLE file;
+
+    GetSystemTimeAsFileTime(&filetime);
+    time.LowPart = filetime.dwLowDateTime;
+    time.HighPart = filetime.dwHighDateTime;
+    time.QuadPart -= (ULONGLONG)hours_ago * 3600 * 10000000;
+    filetime.dwLowDateTime = time.LowPart;
+    filetime.dwHighDateTime = time.HighPart;
+
+    sprintf(path, "%s\\%s", dir, name);
+    file = CreateFileA(path, FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            NULL, OPEN_EXISTING, 0, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "Failed to open %s, error %lu.\n", path, GetLastError());
+    SetFileTime(file, NULL, NULL, &filetime);
+    CloseHandle(file);
+}
+
+/* Keep the key, and make the cached data one byte shorter, which is not valid SPIR-V. */
+static void truncate_shader_cache_file(const char *dir, const char *name)
+{
+    struct
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key_size;
+        uint64_t data_size;
+    } header;
+    char path[MAX_PATH];
+    HANDLE file;
+    DWORD size;
+    BOOL ret;
+
+    sprintf(path, "%s\\%s", dir, name);
+    file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "Failed to open %s, error %lu.\n", path, GetLastError());
+    ret = ReadFile(file, &header, sizeof(header), &size, NULL);
+    ok(ret && size == sizeof(header), "Failed to read %s, error %lu.\n", path, GetLastError());
+    --header.data_size;
+    SetFilePointer(file, 0, NULL, FILE_BEGIN);
+    ret = WriteFile(file, &header, sizeof(header), &size, NULL);
+    ok(ret && size == sizeof(header), "Failed to write %s, error %lu.\n", path, GetLastError());
+    SetFilePointer(file, -1, NULL, FILE_END);
+    SetEndOfFile(file);
+    CloseHandle(file);
+}
+
+static void run_shader_cache_child(const char *dir, unsigned int size_mb)
+{
+    char **argv, cmdline[MAX_PATH * 2], config[1024], old_config[512];
+    PROCESS_INFORMATION pi;
+    STARTUPINFOA si = {0};
+    DWORD len;
+    BOOL ret;
+
+    winetest_get_mainargs(&argv);
+    sprintf(cmdline, "\"%s\" d3d11 shader_cache", argv[0]);
+
+    len = GetEnvironmentVariableA("WINE_D3D_CONFIG", old_config, sizeof(old_config));
+    ok(len < sizeof(old_config), "Got unexpected length %lu.\n", len);
+    sprintf(config, "%s%sshader_cache_size=%u,shader_cache_path=%s",
+            len ? old_config : "", len ? "," : "", size_mb, dir);
+    SetEnvironmentVariableA("WINE_D3D_CONFIG", config);
+
+    si.cb = sizeof(si);
+    ret = CreateProcessA(NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi);
+    ok(ret, "Failed to create process, error %lu.\n", GetLastError());
+    SetEnvironmentVariableA("WINE_D3D_CONFIG", len ? old_config : NULL);
+    if (!ret)
+        return;
+
+    wait_child_process(pi.hProcess);
+    CloseHandle(pi.hProcess);
+    CloseHandle(pi.hThread);
+}
+
+static void test_shader_cache(void)
+{
+    struct shader_cache_file files[64], new_files[64];
+    const struct shader_cache_file *file;
+    unsigned int count, new_count, i, hits, rewritten;
+    char dir[MAX_PATH], cache_dir[MAX_PATH], path[MAX_PATH];
+    ULONGLONG total_size;
+    WIN32_FIND_DATAA data;
+    HANDLE find, handle;
+    static char fake[0x60000];
+    DWORD size;
+    BOOL ret;
+
+    if (!damavand)
+    {
+        skip("The shader cache is only used by the Vulkan renderer.\n");
+        return;
+    }
+
+    GetTempPathA(ARRAY_SIZE(path), path);
+    GetTempFileNameA(path, "wsc", 0, dir);
+    DeleteFileA(dir);
+    ret = CreateDirectoryA(dir, NULL);
+    ok(ret, "Failed to create directory, error %lu.\n", GetLastError());
+    sprintf(cache_dir, "%s\\vulkan", dir);
+
+    /* The first device compiles the shaders and stores them. */
+    run_shader_cache_child(dir, 16);
+    count = get_shader_cache_files(cache_dir, files, ARRAY_SIZE(files));
+    ok(count > 0, "Got unexpected count %u.\n", count);
+    if (!count)
+        goto done;
+
+    /* A second device reads them back. Hits only update the entry time, while the
+     * Vulkan pipeline cache is stored again. */
+    for (i = 0; i < count; ++i)
+        set_shader_cache_file_time(cache_dir, files[i].name, 1);
+    run_shader_cache_child(dir, 16);
+    new_count = get_shader_cache_files(cache_dir, new_files, ARRAY_SIZE(new_files));
+    ok(new_count == count, "Got unexpected count %u, expected %u.\n", new_count, count);
+    hits = rewritten = 0;
+    for (i = 0; i < count; ++i)
+    {
+        if (!(file = find_shader_cache_file(new_files, new_count, files[i].name)))
+        {
+            ok(0, "Entry %s was removed.\n", files[i].name);
+            continue;
+        }
+        if (file->index != files[i].index)
+            ++rewritten;
+        else if (CompareFileTime(&file->write_time, &files[i].write_time) > 0)
+            ++hits;
+    }
+    ok(hits >= count - 1, "Got %u hits for %u entries.\n", hits, count);
+    ok(rewritten <= 1, "Got %u rewritten entries.\n", rewritten);
+
+    /* Unusable entries are compiled and stored again. */
+    for (i = 0; i < count; ++i)
+        truncate_shader_cache_file(cache_dir, files[i].name);
+    run_shader_cache_child(dir, 16);
+    new_count = get_shader_cache_files(cache_dir, new_files, ARRAY_SIZE(new_files));
+    ok(new_count >= count - 1, "Got unexpected count %u, expected %u.\n", new_count, count);
+    for (i = 0; i < count; ++i)
+    {
+        if ((file = find_shader_cache_file(new_files, new_count, files[i].name)))
+            ok(file->size != files[i].size - 1, "Entry %s was not replaced.\n", files[i].name);
+    }
+    count = get_shader_cache_files(cache_dir, files, ARRAY_SIZE(files));
+
+    /* Older entries are evicted first when the cache exceeds its size limit. */
+    for (i = 0; i < 4; ++i)
+    {
+        sprintf(path, "%s\\%016x", cache_dir, i + 1);
+        handle = CreateFileA(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL);
+        ok(handle != INVALID_HANDLE_VALUE, "Failed to create %s, error %lu.\n", path, GetLastError());
+        WriteFile(handle, fake, sizeof(fake), &size, NULL);
+        CloseHandle(handle);
+        set_shader_cache_file_time(cache_dir, path + strlen(cache_dir) + 1, 5 - i);
+    }
+    run_shader_cache_child(dir, 1);
+    new_count = get_shader_cache_files(cache_dir, new_files, ARRAY_SIZE(new_files));
+    ok(!find_shader_cache_file(new_files, new_count, "0000000000000001"), "Oldest entry was not evicted.\n");
+    total_size = 0;
+    for (i = 0; i < new_count; ++i)
+        total_size += new_files[i].size;
+    ok(total_size <= 1024 * 1024, "Got unexpected total size %s.\n", wine_dbgstr_longlong(total_size));
+    for (i = 0; i < count; ++i)
+        ok(!!find_shader_cache_file(new_files, new_count, files[i].name), "Entry %s was evicted.\n", files[i].name);
+
+done:
+    sprintf(path, "%s\\*", cache_dir);
+    if ((find = FindFirstFileA(path, &data)) != INVALID_HANDLE_VALUE)
+    {
+        do
+        {
+            sprintf(path, "%s\\%s", cache_dir, data.cFileName);
+            DeleteFileA(path);
+        } while (FindNextFileA(find, &data));
+        FindClose(find);
+    }
+    RemoveDirectoryA(cache_dir);
+    RemoveDirectoryA(dir);
+}
+
 START_TEST(d3d11)
 {
     unsigned int argc, i;
@@ -35475,6 +35731,11 @@ START_TEST(d3d11)
         use_mt = FALSE;
 
     argc = winetest_get_mainargs(&argv);
+    if (argc >= 3 && !strcmp(argv[2], "shader_cache"))
+    {
+        test_shader_cache_child();
+        return;
+    }
     for (i = 2; i < argc; ++i)
     {
         if (!strcmp(argv[i], "--validate"))
@@ -35657,4 +35918,5 @@ START_TEST(d3d11)
      * (Radeon 560, Windows 10) */
     test_instanced_draw();
     test_generate_mips();
+    test_shader_cache();
 }
@@ -286,6 +286,87 @@ static inline float get_current_sample(const IDirectSoundBufferImpl *dsb,
     return dsb->get(dsb, buffer + (mixpos % buflen), channel);
 }
 
+/**
+ * Return the number of frames that can be read contiguously from mixpos, at most count.
+ * mixpos is wrapped around for looping buffers; returns 0 past the end of a
+ * non-looping buffer.
+ */
+static UINT get_contiguous_frames(const IDirectSoundBufferImpl *dsb, DWORD buflen,
+        DWORD *mixpos, UINT count)
+{
+    UINT istride = dsb->pwfx->nBlockAlign, frames;
+
+    if (*mixpos >= buflen)
+    {
+        if (!(dsb->playflags & DSBPLAY_LOOPING))
+            return 0;
+        *mixpos %= buflen;
+    }
+    frames = (buflen - *mixpos) / istride;
+    if (!frames) frames = 1; /* partial frame at the end of the buffer */
+    return min(frames, count);
+}
+
+/**
+ * Read count samples of one channel into a contiguous float array, a block at a
+ * time instead of wrapping the position for every sample.
+ */
+static void get_current_samples(const IDirectSoundBufferImpl *dsb, BYTE *buffer, DWORD buflen,
+        DWORD mixpos, DWORD channel, float *out, UINT count)
+{
+    UINT istride = dsb->pwfx->nBlockAlign;
+    UINT i, frames;
+
+    while (count)
+    {
+        if (!(frames = get_contiguous_frames(dsb, buflen, &mixpos, count)))
+        {
+            memset(out, 0, count * sizeof(float));
+            return;
+        }
+        if (dsb->get == getbpp[4])
+        {
+            const float *src = (const float *)(buffer + mixpos) + channel;
+            UINT step = istride / sizeof(float);
+
+            for (i = 0; i < frames; i++)
+                out[i] = src[i * step];
+        }
+        else
+        {
+            for (i = 0; i < frames; i++)
+                out[i] = dsb->get(dsb, buffer + mixpos + i * istride, channel);
+        }
+        out += frames;
+        count -= frames;
+        mixpos += frames * istride;
+    }
+}
+
+/**
+ * Copy count float frames directly into the temporary buffer, for float buffers
+ * that have the same channel layout as the device.
+ */
+static void copy_current_frames(const IDirectSoundBufferImpl *dsb, BYTE *buffer, DWORD buflen,
+        DWORD mixpos, float *out, UINT count)
+{
+    UINT istride = dsb->pwfx->nBlockAlign;
+    UINT frames;
+
+    while (count)
+    {
+        if (!(frames = get_contiguous_frames(dsb, buflen, &mixpos, count)))
+        {
+            memset(out, 0, count * istride);
+            return;
+        }
+        memcpy(out, buffer + mixpos, frames * istride);
+        out += frames * istride / sizeof(float);
+        count -= frames;
+        mixpos += frames * istride;
+    }
+}
+
 static UINT cp_fields_noresample(IDirectSoundBufferImpl *dsb, UINT count)
 {
     UINT istride = dsb->pwfx->nBlockAlign;
@@ -301,6 +382,17 @@ static UINT cp_fields_noresample(IDirectSoundBufferImpl *dsb, UINT count)
         committed_samples = committed_samples <= count ? committed_samples : count;
     }
 
+    if (dsb->get == getbpp[4] && dsb->put == putieee32 && istride == ostride &&
+        dsb->mix_channels == dsb->pwfx->nChannels)
+    {
+        /* no format conversion needed */
+        copy_current_frames(dsb, dsb->committedbuff, dsb->writelead, dsb->committed_mixpos,
+                dsb->device->tmp_buffer, committed_samples);
+        copy_current_frames(dsb, dsb->buffer->memory, dsb->buflen, dsb->sec_mixpos + committed_samples * istride,
+                dsb->device->tmp_buffer + committed_samples * ostride / sizeof(float), count - committed_samples);
+        return count;
+    }
+
     for (i = 0; i < committed_samples; i++)
         for (channel = 0; channel < dsb->mix_channels; channel++)
             dsb->put(dsb, i * ostride, channel, get_current_sample(dsb, dsb->committedbuff,
@@ -362,12 +454,12 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
      */
     itmp = intermediate;
     for (channel = 0; channel < channels; channel++) {
-        for (i = 0; i < committed_samples; i++)
-            *(itmp++) = get_current_sample(dsb, dsb->committedbuff,
-                dsb->writelead, dsb->committed_mixpos + i * istride, channel);
-        for (; i < required_input; i++)
-            *(itmp++) = get_current_sample(dsb, dsb->buffer->memory,
-                    dsb->buflen, dsb->sec_mixpos + i * istride, channel);
+        get_current_samples(dsb, dsb->committedbuff, dsb->writelead,
+                dsb->committed_mixpos, channel, itmp, committed_samples);
+        get_current_samples(dsb, dsb->buffer->memory, dsb->buflen,
+                dsb->sec_mixpos + committed_samples * istride, channel,
+                itmp + committed_samples, required_input - committed_samples);
+        itmp += required_input;
     }
 
     for(i = 0; i < count; ++i) {
@@ -485,11 +577,16 @@ static void DSOUND_MixToTemporary(IDirectSoundBufferImpl *dsb, DWORD frames)
 	}
 }
 
-static void DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, INT frames)
+/**
+ * Add the temporary buffer to the mix buffer, applying volume and pan in the
+ * same pass.
+ */
+static void DSOUND_MixWithVol(const IDirectSoundBufferImpl *dsb, float *mix_buffer, INT frames)
 {
 	INT	i;
 	float vols[DS_MAX_CHANNELS];
 	UINT channels = dsb->device->pwfx->nChannels, chan;
+	const float *ibuf = dsb->device->tmp_buffer;
 
 	TRACE("(%p,%d)\n",dsb,frames);
 	TRACE("left = %lx, right = %lx\n", dsb->volpan.dwTotalAmpFactor[0],
@@ -498,20 +595,33 @@ static void DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, INT frames)
 	if ((!(dsb->dsbd.dwFlags & DSBCAPS_CTRLPAN) || (dsb->volpan.lPan == 0)) &&
 	    (!(dsb->dsbd.dwFlags & DSBCAPS_CTRLVOLUME) || (dsb->volpan.lVolume == 0)) &&
 	     !(dsb->dsbd.dwFlags & DSBCAPS_CTRL3D))
-		return; /* Nothing to do */
+	{
+		mixieee32(dsb->device->tmp_buffer, mix_buffer, frames * channels);
+		return;
+	}
 
 	if (channels > DS_MAX_CHANNELS)
 	{
 		FIXME("There is no support for %u channels\n", channels);
+		mixieee32(dsb->device->tmp_buffer, mix_buffer, frames * channels);
 		return;
 	}
 
 	for (i = 0; i < channels; ++i)
 		vols[i] = dsb->volpan.dwTotalAmpFactor[i] / ((float)0xFFFF);
 
+	if (channels == 2)
+	{
+		for (i = 0; i < frames; ++i){
+			mix_buffer[2 * i] += ibuf[2 * i] * vols[0];
+			mix_buffer[2 * i + 1] += ibuf[2 * i + 1] * vols[1];
+		}
+		return;
+	}
+
 	for(i = 0; i < frames; ++i){
 		for(chan = 0; chan < channels; ++chan){
-			dsb->device->tmp_buffer[i * channels + chan] *= vols[chan];
+			mix_buffer[i * channels + chan] += ibuf[i * channels + chan] * vols[chan];
 		}
 	}
 }
@@ -530,7 +640,6 @@ static void DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, INT frames)
  */
 static DWORD DSOUND_MixInBuffer(IDirectSoundBufferImpl *dsb, float *mix_buffer, DWORD frames)
 {
-	float *ibuf;
 	DWORD oldpos;
 
 	TRACE("sec_mixpos=%ld/%ld\n", dsb->sec_mixpos, dsb->buflen);
@@ -539,14 +648,10 @@ static DWORD DSOUND_MixInBuffer(IDirectSoundBufferImpl *dsb, float *mix_buffer,
 	/* Resample buffer to temporary buffer specifically allocated for this purpose, if needed */
 	oldpos = dsb->sec_mixpos;
 	DSOUND_MixToTemporary(dsb, frames);
-	ibuf = dsb->device->tmp_buffer;
 
-	if (secondarybuffer_is_audible(dsb)) {
-		/* Apply volume if needed */
-		DSOUND_MixerVol(dsb, frames);
-
-		mixieee32(ibuf, mix_buffer, frames * dsb->device->pwfx->nChannels);
-	}
+	/* Apply volume if needed while mixing */
+	if (secondarybuffer_is_audible(dsb))
+		DSOUND_MixWithVol(dsb, mix_buffer, frames);
 
 	/* check for notification positions */
 	if (dsb->dsbd.dwFlags & DSBCAPS_CTRLPOSITIONNOTIFY &&
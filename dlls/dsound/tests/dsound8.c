@@ -28,6 +28,7 @@
 #define COBJMACROS
 #include <windows.h>
 #include <stdio.h>
+#include <math.h>
 
 #include "wine/test.h"
 #include "mmsystem.h"
@@ -1881,6 +1882,128 @@ static void test_AcquireResources(void)
     IDirectSound_Release(dsound);
 }
 
+static ULONGLONG get_process_cpu_time(void)
+{
+    FILETIME create, exit, kernel, user;
+
+    GetProcessTimes(GetCurrentProcess(), &create, &exit, &kernel, &user);
+    return ((ULONGLONG)kernel.dwHighDateTime << 32 | kernel.dwLowDateTime) +
+           ((ULONGLONG)user.dwHighDateTime << 32 | user.dwLowDateTime);
+}
+
+/* Traces the CPU time the mixer spends on looping secondary buffers in various formats */
+static void benchmark_mixer(void)
+{
+    static const struct
+    {
+        WORD tag, bits;
+        DWORD rate;
+        LONG volume;
+        const char *name;
+    }
+    configs[] =
+    {
+        {WAVE_FORMAT_PCM,        16, 48000, DSBVOLUME_MAX, "16-bit 48kHz"},
+        {WAVE_FORMAT_PCM,        16, 48000, -1200,         "16-bit 48kHz attenuated"},
+        {WAVE_FORMAT_PCM,        16, 44100, DSBVOLUME_MAX, "16-bit 44.1kHz"},
+        {WAVE_FORMAT_IEEE_FLOAT, 32, 48000, DSBVOLUME_MAX, "float 48kHz"},
+        {WAVE_FORMAT_IEEE_FLOAT, 32, 44100, -1200,         "float 44.1kHz attenuated"},
+    };
+    static const DWORD duration = 2000;
+    IDirectSoundBuffer *primary, *secondaries[16];
+    ULONGLONG start, idle, busy;
+    IDirectSound8 *dsound;
+    DSBUFFERDESC bufdesc;
+    WAVEFORMATEX fmt;
+    unsigned int c, i, j;
+    DWORD size;
+    void *data;
+    HRESULT hr;
+
+    hr = DirectSoundCreate8(NULL, &dsound, NULL);
+    ok(hr == DS_OK || hr == DSERR_NODRIVER, "Got hr %#lx.\n", hr);
+    if (FAILED(hr))
+        return;
+
+    hr = IDirectSound8_SetCooperativeLevel(dsound, get_hwnd(), DSSCL_PRIORITY);
+    ok(hr == DS_OK, "Got hr %#lx.\n", hr);
+
+    memset(&bufdesc, 0, sizeof(bufdesc));
+    bufdesc.dwSize = sizeof(bufdesc);
+    bufdesc.dwFlags = DSBCAPS_PRIMARYBUFFER;
+    hr = IDirectSound8_CreateSoundBuffer(dsound, &bufdesc, &primary, NULL);
+    ok(hr == S_OK, "CreateSoundBuffer failed: %08lx\n", hr);
+    if (hr != S_OK)
+    {
+        IDirectSound8_Release(dsound);
+        return;
+    }
+
+    start = get_process_cpu_time();
+    Sleep(duration);
+    idle = get_process_cpu_time() - start;
+    trace("mixer idle: %.1f%% CPU\n", idle / (duration * 100.0));
+
+    for (c = 0; c < ARRAY_SIZE(configs); c++)
+    {
+        fmt.wFormatTag = configs[c].tag;
+        fmt.nChannels = 2;
+        fmt.nSamplesPerSec = configs[c].rate;
+        fmt.wBitsPerSample = configs[c].bits;
+        fmt.nBlockAlign = fmt.nChannels * fmt.wBitsPerSample / 8;
+        fmt.nAvgBytesPerSec = fmt.nBlockAlign * fmt.nSamplesPerSec;
+        fmt.cbSize = 0;
+
+        bufdesc.dwFlags = DSBCAPS_GETCURRENTPOSITION2 | DSBCAPS_LOCSOFTWARE | DSBCAPS_CTRLVOLUME;
+        bufdesc.dwBufferBytes = fmt.nAvgBytesPerSec / 2;
+        bufdesc.lpwfxFormat = &fmt;
+
+        /* a quiet tone, so that the sum of all the buffers doesn't clip */
+        for (i = 0; i < ARRAY_SIZE(secondaries); i++)
+        {
+            hr = IDirectSound8_CreateSoundBuffer(dsound, &bufdesc, &secondaries[i], NULL);
+            ok(hr == S_OK, "CreateSoundBuffer failed: %08lx\n", hr);
+            if (hr != S_OK)
+                break;
+
+            hr = IDirectSoundBuffer_Lock(secondaries[i], 0, 0, &data, &size, NULL, NULL, DSBLOCK_ENTIREBUFFER);
+            ok(hr == S_OK, "Lock failed: %08lx\n", hr);
+            for (j = 0; j < size / (fmt.wBitsPerSample / 8); j++)
+            {
+                double sample = sin(j * (i + 1) * 0.01) / 64;
+                if (fmt.wFormatTag == WAVE_FORMAT_IEEE_FLOAT)
+                    ((float *)data)[j] = sample;
+                else
+                    ((short *)data)[j] = sample * 32767;
+            }
+            IDirectSoundBuffer_Unlock(secondaries[i], data, size, NULL, 0);
+
+            hr = IDirectSoundBuffer_SetVolume(secondaries[i], configs[c].volume);
+            ok(hr == S_OK, "SetVolume failed: %08lx\n", hr);
+            hr = IDirectSoundBuffer_Play(secondaries[i], 0, 0, DSBPLAY_LOOPING);
+            ok(hr == S_OK, "Play failed: %08lx\n", hr);
+        }
+
+        if (i == ARRAY_SIZE(secondaries))
+        {
+            start = get_process_cpu_time();
+            Sleep(duration);
+            busy = get_process_cpu_time() - start;
+            trace("mixer %u x %s: %.1f%% CPU, %.2f%% per buffer above idle\n", i, configs[c].name,
+                  busy / (duration * 100.0), ((double)busy - idle) / (duration * 100.0 * i));
+        }
+
+        while (i--)
+        {
+            IDirectSoundBuffer_Stop(secondaries[i]);
+            IDirectSoundBuffer_Release(secondaries[i]);
+        }
+    }
+
+    IDirectSoundBuffer_Release(primary);
+    IDirectSound8_Release(dsound);
+}
+
 START_TEST(dsound8)
 {
     DWORD cookie;
@@ -1904,5 +2027,7 @@ START_TEST(dsound8)
 
     CoRevokeClassObject(cookie);
 
+    if (winetest_interactive) benchmark_mixer();
+
     CoUninitialize();
 }
@@ -353,6 +353,42 @@ extern void factory_detach_fontcollection(IDWriteFactory7 *factory, IDWriteFontC
 extern void factory_detach_gdiinterop(IDWriteFactory7 *factory, IDWriteGdiInterop1 *interop);
 extern struct fontfacecached *factory_cache_fontface(IDWriteFactory7 *factory, struct list *fontfaces,
         IDWriteFontFace5 *fontface);
+
+/* Shaping results of layout runs, cached per factory. Font faces are identified by
+   their file, so that results are reused by layouts that create new font face objects. */
+struct shaped_run_key
+{
+    unsigned int hash;
+    IDWriteFontFileLoader *loader;  /* referenced by cache entries only */
+    unsigned int face_index;
+    unsigned int simulations;
+    float emsize;
+    DWRITE_SCRIPT_ANALYSIS sa;
+    unsigned int is_sideways : 1;
+    unsigned int is_rtl : 1;
+    unsigned int gdi_compatible : 1;
+    unsigned int use_gdi_natural : 1;
+    float ppdip;
+    DWRITE_MATRIX transform;
+    unsigned int string_length;
+    unsigned int data_size;
+    const void *data;               /* file reference key, text, locale name and user features */
+};
+
+struct shaped_run
+{
+    unsigned int glyph_count;
+    UINT16 *glyphs;
+    UINT16 *clustermap;
+    DWRITE_SHAPING_GLYPH_PROPERTIES *glyph_props;
+    float *advances;
+    DWRITE_GLYPH_OFFSET *offsets;
+};
+
+extern BOOL factory_get_shaped_run(IDWriteFactory7 *factory, struct shaped_run_key *key, struct shaped_run *run);
+extern void factory_cache_shaped_run(IDWriteFactory7 *factory, struct shaped_run_key *key,
+        const struct shaped_run *run);
+
 extern void    get_logfont_from_font(IDWriteFont*,LOGFONTW*);
 extern void    get_logfont_from_fontface(IDWriteFontFace*,LOGFONTW*);
 extern HRESULT get_fontsig_from_font(IDWriteFont*,FONTSIGNATURE*);
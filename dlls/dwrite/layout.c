@@ -950,7 +950,6 @@ static HRESULT layout_shape_get_glyphs(struct dwrite_textlayout *layout, struct
     unsigned int max_count;
     HRESULT hr;
 
-    run->descr.localeName = get_layout_range_by_pos(layout, run->descr.textPosition)->locale;
     run->clustermap = calloc(run->descr.stringLength, sizeof(*run->clustermap));
     if (!run->clustermap)
         return E_OUTOFMEMORY;
@@ -965,9 +964,6 @@ static HRESULT layout_shape_get_glyphs(struct dwrite_textlayout *layout, struct
     if (!context->text_props || !context->glyph_props)
         return E_OUTOFMEMORY;
 
-    if (FAILED(hr = layout_shape_get_user_features(layout, context)))
-        return hr;
-
     for (;;)
     {
         hr = IDWriteTextAnalyzer2_GetGlyphs(context->analyzer, run->descr.string, run->descr.stringLength, run->run.fontFace,
@@ -1114,25 +1110,160 @@ static HRESULT layout_shape_get_positions(struct dwrite_textlayout *layout, stru
         WARN("%s: failed to get glyph placement info, hr %#lx.\n", debugstr_rundescr(&run->descr), hr);
     }
 
-    if (SUCCEEDED(hr))
-        hr = layout_shape_apply_character_spacing(layout, context);
-
     run->run.glyphAdvances = run->advances;
     run->run.glyphOffsets = run->offsets;
 
     return hr;
 }
 
+/* Longer runs are shaped every time, they are unlikely to be repeated. */
+#define MAX_SHAPED_RUN_LENGTH 256
+
+static BOOL layout_shape_get_cache_key(const struct dwrite_textlayout *layout, const struct shaping_context *context,
+        struct shaped_run_key *key, BYTE **data)
+{
+    const struct regular_layout_run *run = context->run;
+    unsigned int i, size, locale_length, file_key_size;
+    struct dwrite_fontface *fontface;
+    IDWriteFontFileLoader *loader;
+    const void *file_key;
+    BYTE *ptr;
+
+    *data = NULL;
+
+    if (!run->descr.stringLength || run->descr.stringLength > MAX_SHAPED_RUN_LENGTH)
+        return FALSE;
+
+    fontface = unsafe_impl_from_IDWriteFontFace(run->run.fontFace);
+    if (!fontface->file || FAILED(IDWriteFontFile_GetReferenceKey(fontface->file, &file_key, &file_key_size)))
+        return FALSE;
+    if (FAILED(IDWriteFontFile_GetLoader(fontface->file, &loader)))
+        return FALSE;
+    /* The font file keeps the loader alive for the duration of the lookup,
+       cache entries hold their own reference. */
+    IDWriteFontFileLoader_Release(loader);
+
+    memset(key, 0, sizeof(*key));
+    key->loader = loader;
+    key->face_index = fontface->index;
+    key->simulations = fontface->simulations;
+    key->emsize = run->run.fontEmSize;
+    key->sa.script = run->sa.script;
+    key->sa.shapes = run->sa.shapes;
+    key->is_sideways = !!run->run.isSideways;
+    key->is_rtl = run->run.bidiLevel & 1;
+    if (is_layout_gdi_compatible(layout))
+    {
+        key->gdi_compatible = 1;
+        key->use_gdi_natural = layout->measuringmode == DWRITE_MEASURING_MODE_GDI_NATURAL;
+        key->ppdip = layout->ppdip;
+        key->transform = layout->transform;
+    }
+    key->string_length = run->descr.stringLength;
+
+    locale_length = wcslen(run->descr.localeName) + 1;
+    size = sizeof(file_key_size) + file_key_size + (run->descr.stringLength + locale_length) * sizeof(WCHAR);
+    for (i = 0; i < context->user_features.range_count; ++i)
+    {
+        size += 2 * sizeof(UINT32) + context->user_features.features[i]->featureCount *
+                sizeof(*context->user_features.features[i]->features);
+    }
+
+    if (!(ptr = *data = malloc(size)))
+        return FALSE;
+
+    memcpy(ptr, &file_key_size, sizeof(file_key_size));
+    ptr += sizeof(file_key_size);
+    memcpy(ptr, file_key, file_key_size);
+    ptr += file_key_size;
+    memcpy(ptr, run->descr.string, run->descr.stringLength * sizeof(WCHAR));
+    ptr += run->descr.stringLength * sizeof(WCHAR);
+    memcpy(ptr, run->descr.localeName, locale_length * sizeof(WCHAR));
+    ptr += locale_length * sizeof(WCHAR);
+    for (i = 0; i < context->user_features.range_count; ++i)
+    {
+        const DWRITE_TYPOGRAPHIC_FEATURES *features = context->user_features.features[i];
+        UINT32 header[2] = { context->user_features.range_lengths[i], features->featureCount };
+
+        memcpy(ptr, header, sizeof(header));
+        ptr += sizeof(header);
+        memcpy(ptr, features->features, features->featureCount * sizeof(*features->features));
+        ptr += features->featureCount * sizeof(*features->features);
+    }
+
+    key->data = *data;
+    key->data_size = size;
+
+    return TRUE;
+}
+
+static BOOL layout_shape_get_cached_run(struct dwrite_textlayout *layout, struct shaping_context *context,
+        struct shaped_run_key *key)
+{
+    struct regular_layout_run *run = context->run;
+    struct shaped_run shaped;
+
+    if (!factory_get_shaped_run(layout->factory, key, &shaped))
+        return FALSE;
+
+    run->glyphcount = shaped.glyph_count;
+    run->run.glyphIndices = run->glyphs = shaped.glyphs;
+    run->descr.clusterMap = run->clustermap = shaped.clustermap;
+    run->run.glyphAdvances = run->advances = shaped.advances;
+    run->run.glyphOffsets = run->offsets = shaped.offsets;
+    context->glyph_props = shaped.glyph_props;
+
+    return TRUE;
+}
+
+static void layout_shape_cache_run(struct dwrite_textlayout *layout, struct shaping_context *context,
+        struct shaped_run_key *key)
+{
+    struct regular_layout_run *run = context->run;
+    struct shaped_run shaped;
+
+    if (!run->glyphcount)
+        return;
+
+    shaped.glyph_count = run->glyphcount;
+    shaped.glyphs = run->glyphs;
+    shaped.clustermap = run->clustermap;
+    shaped.glyph_props = context->glyph_props;
+    shaped.advances = run->advances;
+    shaped.offsets = run->offsets;
+    factory_cache_shaped_run(layout->factory, key, &shaped);
+}
+
 static HRESULT layout_shape_run(struct dwrite_textlayout *layout, struct regular_layout_run *run)
 {
     struct shaping_context context = { 0 };
+    struct shaped_run_key key;
+    BYTE *key_data;
     HRESULT hr;
 
     context.analyzer = get_text_analyzer();
     context.run = run;
 
-    if (SUCCEEDED(hr = layout_shape_get_glyphs(layout, &context)))
-        hr = layout_shape_get_positions(layout, &context);
+    run->descr.localeName = get_layout_range_by_pos(layout, run->descr.textPosition)->locale;
+
+    if (SUCCEEDED(hr = layout_shape_get_user_features(layout, &context)))
+    {
+        /* Character spacing is applied on top of cached results, it's set per layout. */
+        if (layout_shape_get_cache_key(layout, &context, &key, &key_data) &&
+                layout_shape_get_cached_run(layout, &context, &key))
+        {
+            TRACE("%s: using cached shaping results.\n", debugstr_rundescr(&run->descr));
+        }
+        else if (SUCCEEDED(hr = layout_shape_get_glyphs(layout, &context)) &&
+                SUCCEEDED(hr = layout_shape_get_positions(layout, &context)) && key_data)
+        {
+            layout_shape_cache_run(layout, &context, &key);
+        }
+        free(key_data);
+    }
+
+    if (SUCCEEDED(hr))
+        hr = layout_shape_apply_character_spacing(layout, &context);
 
     layout_shape_clear_context(&context);
 
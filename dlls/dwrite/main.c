@@ -609,6 +609,15 @@ struct dwritefactory
     struct list file_loaders;
 
     CRITICAL_SECTION cs;
+
+    struct
+    {
+        SRWLOCK lock;
+        struct wine_rb_tree tree;
+        struct list mru;
+        size_t max_size;
+        size_t size;
+    } shaped_runs;
 };
 
 static inline struct dwritefactory *impl_from_IDWriteFactory7(IDWriteFactory7 *iface)
@@ -627,6 +636,63 @@ static void release_fontface_cache(struct list *fontfaces)
     }
 }
 
+struct shaped_run_entry
+{
+    struct wine_rb_entry entry;
+    struct list mru;
+    struct shaped_run_key key;
+    struct shaped_run run;
+    size_t size;
+};
+
+static int shaped_run_compare(const void *k, const struct wine_rb_entry *e)
+{
+    const struct shaped_run_entry *entry = WINE_RB_ENTRY_VALUE(e, const struct shaped_run_entry, entry);
+    const struct shaped_run_key *key = k, *key2 = &entry->key;
+    int ret;
+
+    if ((ret = memcmp(key, key2, offsetof(struct shaped_run_key, data)))) return ret;
+    return memcmp(key->data, key2->data, key->data_size);
+}
+
+static void free_shaped_run_entries(struct list *entries)
+{
+    struct shaped_run_entry *entry, *entry2;
+
+    LIST_FOR_EACH_ENTRY_SAFE(entry, entry2, entries, struct shaped_run_entry, mru)
+    {
+        list_remove(&entry->mru);
+        IDWriteFontFileLoader_Release(entry->key.loader);
+        free(entry);
+    }
+}
+
+static void release_shaped_runs(struct dwritefactory *factory)
+{
+    free_shaped_run_entries(&factory->shaped_runs.mru);
+}
+
+/* Drops cached runs shaped with fonts from given loader, so that an unregistered
+   loader is not kept alive by the cache. */
+static void purge_shaped_runs(struct dwritefactory *factory, IDWriteFontFileLoader *loader)
+{
+    struct shaped_run_entry *entry, *entry2;
+    struct list purged = LIST_INIT(purged);
+
+    AcquireSRWLockExclusive(&factory->shaped_runs.lock);
+    LIST_FOR_EACH_ENTRY_SAFE(entry, entry2, &factory->shaped_runs.mru, struct shaped_run_entry, mru)
+    {
+        if (entry->key.loader != loader) continue;
+        factory->shaped_runs.size -= entry->size;
+        wine_rb_remove(&factory->shaped_runs.tree, &entry->entry);
+        list_remove(&entry->mru);
+        list_add_tail(&purged, &entry->mru);
+    }
+    ReleaseSRWLockExclusive(&factory->shaped_runs.lock);
+
+    free_shaped_run_entries(&purged);
+}
+
 static void release_fileloader(struct fileloader *fileloader)
 {
     list_remove(&fileloader->entry);
@@ -645,6 +711,8 @@ static void release_dwritefactory(struct dwritefactory *factory)
     release_fontface_cache(&factory->localfontfaces);
     LeaveCriticalSection(&factory->cs);
 
+    release_shaped_runs(factory);
+
     LIST_FOR_EACH_ENTRY_SAFE(loader, loader2, &factory->collection_loaders, struct collectionloader, entry) {
         list_remove(&loader->entry);
         IDWriteFontCollectionLoader_Release(loader->loader);
@@ -1173,6 +1241,7 @@ static HRESULT WINAPI dwritefactory_UnregisterFontFileLoader(IDWriteFactory7 *if
         return E_INVALIDARG;
 
     release_fileloader(found);
+    purge_shaped_runs(factory, loader);
     return S_OK;
 }
 
@@ -2099,6 +2168,137 @@ static void init_dwritefactory(struct dwritefactory *factory, DWRITE_FACTORY_TYP
 
     InitializeCriticalSection(&factory->cs);
     factory->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": dwritefactory.lock");
+
+    InitializeSRWLock(&factory->shaped_runs.lock);
+    wine_rb_init(&factory->shaped_runs.tree, shaped_run_compare);
+    list_init(&factory->shaped_runs.mru);
+    factory->shaped_runs.max_size = 0x100000;
+}
+
+static unsigned int shaped_run_hash(const struct shaped_run_key *key)
+{
+    const BYTE *ptr = (const BYTE *)&key->loader, *end = (const BYTE *)&key->data;
+    unsigned int hash = 2166136261u;
+
+    for (; ptr < end; ++ptr)
+        hash = (hash ^ *ptr) * 16777619u;
+    for (ptr = key->data, end = ptr + key->data_size; ptr < end; ++ptr)
+        hash = (hash ^ *ptr) * 16777619u;
+
+    return hash;
+}
+
+BOOL factory_get_shaped_run(IDWriteFactory7 *iface, struct shaped_run_key *key, struct shaped_run *run)
+{
+    struct dwritefactory *factory = impl_from_IDWriteFactory7(iface);
+    struct shaped_run_entry *entry;
+    const struct shaped_run *cached;
+    struct wine_rb_entry *e;
+    unsigned int count;
+    BOOL ret = FALSE;
+
+    key->hash = shaped_run_hash(key);
+
+    AcquireSRWLockExclusive(&factory->shaped_runs.lock);
+    if ((e = wine_rb_get(&factory->shaped_runs.tree, key)))
+    {
+        entry = WINE_RB_ENTRY_VALUE(e, struct shaped_run_entry, entry);
+        list_remove(&entry->mru);
+        list_add_head(&factory->shaped_runs.mru, &entry->mru);
+
+        cached = &entry->run;
+        count = cached->glyph_count;
+        run->glyph_count = count;
+        run->glyphs = malloc(count * sizeof(*run->glyphs));
+        run->clustermap = malloc(key->string_length * sizeof(*run->clustermap));
+        run->glyph_props = malloc(count * sizeof(*run->glyph_props));
+        run->advances = malloc(count * sizeof(*run->advances));
+        run->offsets = malloc(count * sizeof(*run->offsets));
+        if ((ret = run->glyphs && run->clustermap && run->glyph_props && run->advances && run->offsets))
+        {
+            memcpy(run->glyphs, cached->glyphs, count * sizeof(*run->glyphs));
+            memcpy(run->clustermap, cached->clustermap, key->string_length * sizeof(*run->clustermap));
+            memcpy(run->glyph_props, cached->glyph_props, count * sizeof(*run->glyph_props));
+            memcpy(run->advances, cached->advances, count * sizeof(*run->advances));
+            memcpy(run->offsets, cached->offsets, count * sizeof(*run->offsets));
+        }
+    }
+    ReleaseSRWLockExclusive(&factory->shaped_runs.lock);
+
+    if (e && !ret)
+    {
+        free(run->glyphs);
+        free(run->clustermap);
+        free(run->glyph_props);
+        free(run->advances);
+        free(run->offsets);
+        memset(run, 0, sizeof(*run));
+    }
+
+    return ret;
+}
+
+void factory_cache_shaped_run(IDWriteFactory7 *iface, struct shaped_run_key *key, const struct shaped_run *run)
+{
+    struct dwritefactory *factory = impl_from_IDWriteFactory7(iface);
+    struct shaped_run_entry *entry, *old_entry;
+    struct list evicted = LIST_INIT(evicted);
+    unsigned int count = run->glyph_count;
+    size_t size;
+    BYTE *ptr;
+
+    /* Arrays are laid out after the entry, in decreasing order of alignment. */
+    size = sizeof(*entry) + count * (sizeof(*run->advances) + sizeof(*run->offsets) + sizeof(*run->glyphs)
+            + sizeof(*run->glyph_props)) + key->string_length * sizeof(*run->clustermap) + key->data_size;
+    if (size > factory->shaped_runs.max_size / 16) return;
+    if (!(entry = malloc(size))) return;
+
+    ptr = (BYTE *)(entry + 1);
+    entry->run.glyph_count = count;
+    entry->run.advances = memcpy(ptr, run->advances, count * sizeof(*run->advances));
+    ptr += count * sizeof(*run->advances);
+    entry->run.offsets = memcpy(ptr, run->offsets, count * sizeof(*run->offsets));
+    ptr += count * sizeof(*run->offsets);
+    entry->run.glyphs = memcpy(ptr, run->glyphs, count * sizeof(*run->glyphs));
+    ptr += count * sizeof(*run->glyphs);
+    entry->run.glyph_props = memcpy(ptr, run->glyph_props, count * sizeof(*run->glyph_props));
+    ptr += count * sizeof(*run->glyph_props);
+    entry->run.clustermap = memcpy(ptr, run->clustermap, key->string_length * sizeof(*run->clustermap));
+    ptr += key->string_length * sizeof(*run->clustermap);
+    entry->key = *key;
+    entry->key.hash = shaped_run_hash(key);
+    entry->key.data = memcpy(ptr, key->data, key->data_size);
+    entry->size = size;
+
+    AcquireSRWLockExclusive(&factory->shaped_runs.lock);
+
+    while (factory->shaped_runs.size + size > factory->shaped_runs.max_size
+            && !list_empty(&factory->shaped_runs.mru))
+    {
+        old_entry = LIST_ENTRY(list_tail(&factory->shaped_runs.mru), struct shaped_run_entry, mru);
+        factory->shaped_runs.size -= old_entry->size;
+        wine_rb_remove(&factory->shaped_runs.tree, &old_entry->entry);
+        list_remove(&old_entry->mru);
+        list_add_tail(&evicted, &old_entry->mru);
+    }
+
+    if (wine_rb_put(&factory->shaped_runs.tree, &entry->key, &entry->entry) == -1)
+    {
+        /* Another thread cached the same run. */
+        free(entry);
+    }
+    else
+    {
+        /* Keep the loader alive, so its address can't be reused by another loader
+           while it's part of a cache key. */
+        IDWriteFontFileLoader_AddRef(entry->key.loader);
+        list_add_head(&factory->shaped_runs.mru, &entry->mru);
+        factory->shaped_runs.size += size;
+    }
+
+    ReleaseSRWLockExclusive(&factory->shaped_runs.lock);
+
+    free_shaped_run_entries(&evicted);
 }
 
 void factory_detach_fontcollection(IDWriteFactory7 *iface, IDWriteFontCollection3 *collection)
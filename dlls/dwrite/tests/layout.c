@@ -7052,6 +7052,229 @@ if (SUCCEEDED(hr))
     IDWriteFactory_Release(factory);
 }
 
+static void test_layout_throughput(void)
+{
+    static const WCHAR *strings[] =
+    {
+        L"File", L"Edit", L"View", L"Help", L"OK", L"Cancel", L"Apply",
+        L"Open recent project", L"Save all changes before closing?",
+        L"The quick brown fox jumps over the lazy dog.",
+    };
+    static const unsigned int iterations = 200;
+    DWRITE_TEXT_METRICS metrics, expected[ARRAY_SIZE(strings)];
+    LARGE_INTEGER freq, start, end;
+    IDWriteTextFormat *format;
+    IDWriteTextLayout *layout;
+    IDWriteFactory *factory;
+    unsigned int i, j;
+    HRESULT hr;
+
+    factory = create_factory();
+
+    hr = IDWriteFactory_CreateTextFormat(factory, L"Tahoma", NULL, DWRITE_FONT_WEIGHT_NORMAL, DWRITE_FONT_STYLE_NORMAL,
+            DWRITE_FONT_STRETCH_NORMAL, 12.0f, L"en-us", &format);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+
+    /* Layouts of the same strings are rebuilt, as UI toolkits do on every frame. */
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < iterations; ++i)
+    {
+        for (j = 0; j < ARRAY_SIZE(strings); ++j)
+        {
+            hr = IDWriteFactory_CreateTextLayout(factory, strings[j], lstrlenW(strings[j]), format, 500.0f, 100.0f, &layout);
+            ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+
+            hr = IDWriteTextLayout_GetMetrics(layout, &metrics);
+            ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+            if (!i)
+                expected[j] = metrics;
+            else if (memcmp(&metrics, &expected[j], sizeof(metrics)))
+            {
+                ok(0, "%s: unexpected metrics, width %.8e, expected %.8e.\n", wine_dbgstr_w(strings[j]),
+                        metrics.width, expected[j].width);
+            }
+
+            IDWriteTextLayout_Release(layout);
+        }
+    }
+    QueryPerformanceCounter(&end);
+
+    trace("%.0f layouts/s\n", iterations * ARRAY_SIZE(strings) * (double)freq.QuadPart /
+            (end.QuadPart - start.QuadPart));
+
+    IDWriteTextFormat_Release(format);
+    IDWriteFactory_Release(factory);
+}
+
+struct layout_cache_test
+{
+    DWRITE_FONT_WEIGHT weight;
+    float size;
+    unsigned int count;
+    DWRITE_CLUSTER_METRICS metrics[64];
+};
+
+static void get_layout_clusters(IDWriteFactory *factory, IDWriteFontCollection *collection, const WCHAR *family,
+        const WCHAR *text, struct layout_cache_test *test)
+{
+    IDWriteTextFormat *format;
+    IDWriteTextLayout *layout;
+    HRESULT hr;
+
+    hr = IDWriteFactory_CreateTextFormat(factory, family, collection, test->weight, DWRITE_FONT_STYLE_NORMAL,
+            DWRITE_FONT_STRETCH_NORMAL, test->size, L"en-us", &format);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+
+    hr = IDWriteFactory_CreateTextLayout(factory, text, lstrlenW(text), format, 1000.0f, 100.0f, &layout);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+
+    test->count = 0;
+    hr = IDWriteTextLayout_GetClusterMetrics(layout, test->metrics, ARRAY_SIZE(test->metrics), &test->count);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+
+    IDWriteTextLayout_Release(layout);
+    IDWriteTextFormat_Release(format);
+}
+
+static void test_layout_cache(void)
+{
+    static const WCHAR *strings[] =
+    {
+        L"File", L"Open recent project",
+        L"The quick brown fox jumps over the lazy dog.",
+    };
+    static const struct layout_cache_test tests[] =
+    {
+        { DWRITE_FONT_WEIGHT_NORMAL, 12.0f },
+        { DWRITE_FONT_WEIGHT_NORMAL, 24.0f },
+        { DWRITE_FONT_WEIGHT_BOLD, 12.0f },
+    };
+    struct layout_cache_test expected[ARRAY_SIZE(tests)], test;
+    IDWriteFactory *factory, *factory2;
+    unsigned int i, j, k;
+
+    factory = create_factory();
+
+    for (i = 0; i < ARRAY_SIZE(strings); ++i)
+    {
+        /* Reference metrics come from separate factories, so they are never served from the cache. */
+        for (j = 0; j < ARRAY_SIZE(tests); ++j)
+        {
+            factory2 = create_factory();
+            expected[j] = tests[j];
+            get_layout_clusters(factory2, NULL, L"Tahoma", strings[i], &expected[j]);
+            IDWriteFactory_Release(factory2);
+        }
+        ok(memcmp(expected[0].metrics, expected[1].metrics, sizeof(expected[0].metrics)),
+                "%s: expected different metrics for different sizes.\n", wine_dbgstr_w(strings[i]));
+
+        /* Same text with different fonts is laid out repeatedly in one factory, every result
+           has to match what is shaped for its own font. */
+        for (k = 0; k < 3; ++k)
+        {
+            for (j = 0; j < ARRAY_SIZE(tests); ++j)
+            {
+                winetest_push_context("%s, test %u, iteration %u", wine_dbgstr_w(strings[i]), j, k);
+
+                test = tests[j];
+                get_layout_clusters(factory, NULL, L"Tahoma", strings[i], &test);
+                ok(test.count == expected[j].count, "Unexpected cluster count %u, expected %u.\n",
+                        test.count, expected[j].count);
+                ok(!memcmp(test.metrics, expected[j].metrics, expected[j].count * sizeof(*test.metrics)),
+                        "Unexpected cluster metrics.\n");
+
+                winetest_pop_context();
+            }
+        }
+    }
+
+    IDWriteFactory_Release(factory);
+}
+
+static void get_resource_layout_clusters(IDWriteFactory *factory, IDWriteFontFileLoader *loader,
+        const WCHAR *text, struct layout_cache_test *test)
+{
+    IDWriteFontCollectionLoader *collection_loader;
+    IDWriteFontCollection *collection;
+    HRSRC font;
+    HRESULT hr;
+
+    collection_loader = create_resource_collection_loader(loader);
+    hr = IDWriteFactory_RegisterFontFileLoader(factory, loader);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+    hr = IDWriteFactory_RegisterFontCollectionLoader(factory, collection_loader);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+
+    font = FindResourceA(GetModuleHandleA(NULL), (LPCSTR)MAKEINTRESOURCE(1), (LPCSTR)RT_RCDATA);
+    ok(!!font, "Failed to find font resource\n");
+    hr = IDWriteFactory_CreateCustomFontCollection(factory, collection_loader, &font, sizeof(font), &collection);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+
+    get_layout_clusters(factory, collection, L"wine_test", text, test);
+
+    IDWriteFontCollection_Release(collection);
+    hr = IDWriteFactory_UnregisterFontCollectionLoader(factory, collection_loader);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+    hr = IDWriteFactory_UnregisterFontFileLoader(factory, loader);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+    IDWriteFontCollectionLoader_Release(collection_loader);
+}
+
+static void test_layout_cache_loader(void)
+{
+    static const WCHAR text[] = L"ABDA! BAD";
+    static const struct layout_cache_test tests[] =
+    {
+        { DWRITE_FONT_WEIGHT_NORMAL, 12.0f },
+        { DWRITE_FONT_WEIGHT_NORMAL, 24.0f },
+    };
+    struct layout_cache_test expected[ARRAY_SIZE(tests)], test;
+    IDWriteFontFileLoader *loader;
+    IDWriteFactory *factory;
+    unsigned int i, j;
+    ULONG ref;
+
+    /* Reference metrics are shaped in a new factory for each size, without any cached runs. */
+    for (i = 0; i < ARRAY_SIZE(tests); ++i)
+    {
+        factory = create_factory();
+        loader = create_resource_file_loader();
+        expected[i] = tests[i];
+        get_resource_layout_clusters(factory, loader, text, &expected[i]);
+        ok(expected[i].count == lstrlenW(text), "Unexpected cluster count %u.\n", expected[i].count);
+        IDWriteFontFileLoader_Release(loader);
+        IDWriteFactory_Release(factory);
+    }
+
+    /* Loaders are unregistered and released after each layout, the next one is likely to be
+       allocated at the same address. Runs cached for the previous loader must not be used,
+       and the cache must not keep it alive. */
+    factory = create_factory();
+    for (i = 0; i < 3; ++i)
+    {
+        for (j = 0; j < ARRAY_SIZE(tests); ++j)
+        {
+            winetest_push_context("test %u, iteration %u", j, i);
+
+            loader = create_resource_file_loader();
+            test = tests[j];
+            get_resource_layout_clusters(factory, loader, text, &test);
+            ok(test.count == expected[j].count, "Unexpected cluster count %u, expected %u.\n",
+                    test.count, expected[j].count);
+            ok(!memcmp(test.metrics, expected[j].metrics, expected[j].count * sizeof(*test.metrics)),
+                    "Unexpected cluster metrics.\n");
+
+            ref = IDWriteFontFileLoader_Release(loader);
+            if (!strcmp(winetest_platform, "wine"))
+                ok(!ref, "Unexpected loader refcount %lu.\n", ref);
+
+            winetest_pop_context();
+        }
+    }
+    IDWriteFactory_Release(factory);
+}
+
 START_TEST(layout)
 {
     IDWriteFactory *factory;
@@ -7108,6 +7331,10 @@ START_TEST(layout)
     test_text_format_axes();
     test_layout_range_length();
     test_HitTestTextRange();
+    if (winetest_interactive)
+        test_layout_throughput();
+    test_layout_cache();
+    test_layout_cache_loader();
 
     IDWriteFactory_Release(factory);
 }
@@ -3529,11 +3529,208 @@ static void test_simple_graphics(void)
     DeleteDC(mem_dc);
 }
 
+static HBITMAP create_32bpp_dib( HDC hdc, int width, int height, DWORD **bits )
+{
+    BITMAPINFO bmi;
+
+    memset( &bmi, 0, sizeof(bmi) );
+    bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+    bmi.bmiHeader.biWidth = width;
+    bmi.bmiHeader.biHeight = -height;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+    return CreateDIBSection( hdc, &bmi, DIB_RGB_COLORS, (void **)bits, NULL, 0 );
+}
+
+static void test_alpha_blend_pixels(void)
+{
+    static const struct
+    {
+        DWORD dst, src;
+        DWORD expect[2];  /* with a constant alpha of 0xff and 0x80 */
+    }
+    tests[] =
+    {
+        { 0x11223344, 0xff102030, { 0xff102030, 0x8819293a } },
+        { 0x11223344, 0x00000000, { 0x11223344, 0x11223344 } },
+        { 0x80808080, 0x80402010, { 0xc0806050, 0xa0807068 } },
+        { 0x80808080, 0x40201008, { 0xa0807068, 0x90807874 } },
+    };
+    static const BYTE alphas[2] = { 0xff, 0x80 };
+    BLENDFUNCTION blend = { AC_SRC_OVER, 0, 0xff, AC_SRC_ALPHA };
+    HBITMAP dst_bmp, src_bmp, old_dst, old_src;
+    DWORD *dst_bits, *src_bits;
+    HDC dst_dc, src_dc;
+    unsigned int i, j;
+
+    dst_dc = CreateCompatibleDC( 0 );
+    src_dc = CreateCompatibleDC( 0 );
+    dst_bmp = create_32bpp_dib( dst_dc, ARRAY_SIZE(tests), 1, &dst_bits );
+    src_bmp = create_32bpp_dib( src_dc, ARRAY_SIZE(tests), 1, &src_bits );
+    old_dst = SelectObject( dst_dc, dst_bmp );
+    old_src = SelectObject( src_dc, src_bmp );
+
+    for (j = 0; j < ARRAY_SIZE(alphas); j++)
+    {
+        blend.SourceConstantAlpha = alphas[j];
+        for (i = 0; i < ARRAY_SIZE(tests); i++)
+        {
+            dst_bits[i] = tests[i].dst;
+            src_bits[i] = tests[i].src;
+        }
+        GdiAlphaBlend( dst_dc, 0, 0, ARRAY_SIZE(tests), 1, src_dc, 0, 0, ARRAY_SIZE(tests), 1, blend );
+        for (i = 0; i < ARRAY_SIZE(tests); i++)
+            ok( dst_bits[i] == tests[i].expect[j], "%u: alpha %02x: got %08lx, expected %08lx\n",
+                i, alphas[j], dst_bits[i], tests[i].expect[j] );
+    }
+
+    /* without AC_SRC_ALPHA the source alpha is blended with the constant alpha like the other channels */
+    blend.AlphaFormat = 0;
+    blend.SourceConstantAlpha = 0x80;
+    dst_bits[0] = 0x40404040;
+    src_bits[0] = 0x00804020;
+    dst_bits[1] = 0x11223344;
+    src_bits[1] = 0xff102030;
+    dst_bits[2] = 0x80808080;
+    src_bits[2] = 0x40201008;
+    GdiAlphaBlend( dst_dc, 0, 0, 3, 1, src_dc, 0, 0, 3, 1, blend );
+    ok( dst_bits[0] == 0x20604030, "got %08lx\n", dst_bits[0] );
+    ok( dst_bits[1] == 0x8819293a, "got %08lx\n", dst_bits[1] );
+    ok( dst_bits[2] == 0x60504844, "got %08lx\n", dst_bits[2] );
+
+    SelectObject( dst_dc, old_dst );
+    SelectObject( src_dc, old_src );
+    DeleteObject( dst_bmp );
+    DeleteObject( src_bmp );
+    DeleteDC( dst_dc );
+    DeleteDC( src_dc );
+}
+
+static void test_convert_to_24(void)
+{
+    BYTE buffer[sizeof(BITMAPINFO)], dst[3 * 16];
+    BITMAPINFO *bmi = (BITMAPINFO *)buffer;
+    HBITMAP bmp;
+    DWORD *bits;
+    int i, width, ret;
+    HDC hdc;
+
+    hdc = CreateCompatibleDC( 0 );
+    for (width = 1; width <= 9; width++)
+    {
+        bmp = create_32bpp_dib( hdc, width, 1, &bits );
+        for (i = 0; i < width; i++) bits[i] = 0x80402010 + i * 0x01030507;
+
+        memset( bmi, 0, sizeof(bmi->bmiHeader) );
+        bmi->bmiHeader.biSize = sizeof(bmi->bmiHeader);
+        bmi->bmiHeader.biWidth = width;
+        bmi->bmiHeader.biHeight = -1;
+        bmi->bmiHeader.biPlanes = 1;
+        bmi->bmiHeader.biBitCount = 24;
+        bmi->bmiHeader.biCompression = BI_RGB;
+        memset( dst, 0xcc, sizeof(dst) );
+        ret = GetDIBits( hdc, bmp, 0, 1, dst, bmi, DIB_RGB_COLORS );
+        ok( ret == 1, "width %d: GetDIBits returned %d\n", width, ret );
+
+        for (i = 0; i < width; i++)
+        {
+            DWORD pixel = dst[i * 3] | dst[i * 3 + 1] << 8 | dst[i * 3 + 2] << 16;
+            ok( pixel == (bits[i] & 0xffffff), "width %d: pixel %d got %06lx, expected %06lx\n",
+                width, i, pixel, bits[i] & 0xffffff );
+        }
+        ok( dst[(width * 3 + 3) & ~3] == 0xcc, "width %d: wrote past the row\n", width );
+        DeleteObject( bmp );
+    }
+    DeleteDC( hdc );
+}
+
+static double elapsed_mpix( const LARGE_INTEGER *start, unsigned int count )
+{
+    LARGE_INTEGER freq, end;
+
+    QueryPerformanceCounter( &end );
+    QueryPerformanceFrequency( &freq );
+    return count * (double)freq.QuadPart / (end.QuadPart - start->QuadPart) / 1e6;
+}
+
+/* Traces the throughput of per-pixel alpha blending and of the 32 to 24-bpp conversion */
+static void benchmark_blend_convert(void)
+{
+    static const int width = 1023, height = 768, count = 20;
+    BLENDFUNCTION blend = { AC_SRC_OVER, 0, 0xff, AC_SRC_ALPHA };
+    HBITMAP dst_bmp, src_bmp, old_dst, old_src;
+    DWORD *dst_bits, *src_bits;
+    BYTE buffer[sizeof(BITMAPINFO)];
+    BITMAPINFO *bmi = (BITMAPINFO *)buffer;
+    HDC dst_dc, src_dc;
+    LARGE_INTEGER start;
+    BYTE *dst;
+    int i;
+
+    dst_dc = CreateCompatibleDC( 0 );
+    src_dc = CreateCompatibleDC( 0 );
+    dst_bmp = create_32bpp_dib( dst_dc, width, height, &dst_bits );
+    src_bmp = create_32bpp_dib( src_dc, width, height, &src_bits );
+    old_dst = SelectObject( dst_dc, dst_bmp );
+    old_src = SelectObject( src_dc, src_bmp );
+
+    /* mix opaque, transparent and translucent premultiplied pixels */
+    for (i = 0; i < width * height; i++)
+    {
+        BYTE a = (i % 3) ? (i * 7) & 0xff : ((i / 3) & 1) * 0xff;
+        src_bits[i] = a << 24 | RGB( (i & 0xff) * a / 255, ((i >> 8) & 0xff) * a / 255, a / 2 );
+        dst_bits[i] = i * 0x01020305;
+    }
+
+    blend.SourceConstantAlpha = 0xff;
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++)
+        GdiAlphaBlend( dst_dc, 0, 0, width, height, src_dc, 0, 0, width, height, blend );
+    trace( "AlphaBlend per-pixel alpha: %.1f MPix/s\n", elapsed_mpix( &start, count * width * height ) );
+
+    blend.SourceConstantAlpha = 0x80;
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++)
+        GdiAlphaBlend( dst_dc, 0, 0, width, height, src_dc, 0, 0, width, height, blend );
+    trace( "AlphaBlend per-pixel and constant alpha: %.1f MPix/s\n", elapsed_mpix( &start, count * width * height ) );
+
+    blend.AlphaFormat = 0;
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++)
+        GdiAlphaBlend( dst_dc, 0, 0, width, height, src_dc, 0, 0, width, height, blend );
+    trace( "AlphaBlend constant alpha: %.1f MPix/s\n", elapsed_mpix( &start, count * width * height ) );
+
+    memset( bmi, 0, sizeof(bmi->bmiHeader) );
+    bmi->bmiHeader.biSize = sizeof(bmi->bmiHeader);
+    bmi->bmiHeader.biWidth = width;
+    bmi->bmiHeader.biHeight = -height;
+    bmi->bmiHeader.biPlanes = 1;
+    bmi->bmiHeader.biBitCount = 24;
+    bmi->bmiHeader.biCompression = BI_RGB;
+    dst = malloc( ((width * 3 + 3) & ~3) * height );
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++)
+        GetDIBits( src_dc, src_bmp, 0, height, dst, bmi, DIB_RGB_COLORS );
+    trace( "32 to 24-bpp conversion: %.1f MPix/s\n", elapsed_mpix( &start, count * width * height ) );
+    free( dst );
+
+    SelectObject( dst_dc, old_dst );
+    SelectObject( src_dc, old_src );
+    DeleteObject( dst_bmp );
+    DeleteObject( src_bmp );
+    DeleteDC( dst_dc );
+    DeleteDC( src_dc );
+}
+
 START_TEST(dib)
 {
     CryptAcquireContextW(&crypt_prov, NULL, NULL, PROV_RSA_FULL, CRYPT_VERIFYCONTEXT);
 
     test_simple_graphics();
+    test_alpha_blend_pixels();
+    test_convert_to_24();
+    if (winetest_interactive) benchmark_blend_convert();
 
     CryptReleaseContext(crypt_prov, 0);
 }
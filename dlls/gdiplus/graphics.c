@@ -596,12 +596,10 @@ static GpStatus alpha_blend_pixels(GpGraphics *graphics, INT dst_x, INT dst_y,
     return alpha_blend_pixels_hrgn(graphics, dst_x, dst_y, src, src_width, src_height, src_stride, NULL, fmt);
 }
 
-static ARGB blend_colors(ARGB start, ARGB end, REAL position)
+/* pos is the position between start and end, in the range [0, 0xff] */
+static inline ARGB blend_colors_pos(ARGB start, ARGB end, INT pos)
 {
     INT start_a, end_a, final_a;
-    INT pos;
-
-    pos = gdip_round(position * 0xff);
 
     start_a = ((start >> 24) & 0xff) * (pos ^ 0xff);
     end_a = ((end >> 24) & 0xff) * pos;
@@ -616,6 +614,11 @@ static ARGB blend_colors(ARGB start, ARGB end, REAL position)
         (((start & 0xff) * start_a + ((end & 0xff) * end_a)) / final_a);
 }
 
+static ARGB blend_colors(ARGB start, ARGB end, REAL position)
+{
+    return blend_colors_pos(start, end, gdip_round(position * 0xff));
+}
+
 static ARGB blend_line_gradient(GpLineGradient* brush, REAL position)
 {
     REAL blendfac;
@@ -1076,6 +1079,103 @@ static ARGB resample_bitmap_pixel(GDIPCONST GpRect *src_rect, LPBYTE bits, UINT
     }
 }
 
+/* Resamples count pixels of a destination scanline. point is the source position
+ * of the first pixel, and it is advanced by (dx, dy) for every following pixel.
+ * Pixels with a source position outside of bounds are left untouched.
+ *
+ * The interpolation mode is only checked once per scanline, and pixels whose
+ * samples are all inside of src_rect are read directly, without the wrap mode
+ * handling of sample_bitmap_pixel. The results are the same as the ones of
+ * resample_bitmap_pixel. */
+static void resample_bitmap_span(GDIPCONST GpRect *src_rect, LPBYTE bits, UINT width,
+    UINT height, GpPointF point, REAL dx, REAL dy, GDIPCONST GpRectF *bounds, ARGB *dst, INT count,
+    GDIPCONST GpImageAttributes *attributes, InterpolationMode interpolation, PixelOffsetMode offset_mode)
+{
+    const ARGB *pixels = (const ARGB *)bits;
+    const INT src_left = src_rect->X, src_top = src_rect->Y;
+    const INT src_right = src_left + src_rect->Width, src_bottom = src_top + src_rect->Height;
+    const REAL bounds_right = bounds->X + bounds->Width, bounds_bottom = bounds->Y + bounds->Height;
+    static int fixme;
+    INT i;
+
+    switch (interpolation)
+    {
+    case InterpolationModeNearestNeighbor:
+    {
+        FLOAT pixel_offset;
+
+        if (offset_mode == PixelOffsetModeHalf || offset_mode == PixelOffsetModeHighQuality)
+            pixel_offset = 0.0;
+        else
+            pixel_offset = 0.5;
+
+        for (i = 0; i < count; i++, point.X += dx, point.Y += dy)
+        {
+            INT x, y;
+
+            if (point.X < bounds->X || point.X >= bounds_right ||
+                point.Y < bounds->Y || point.Y >= bounds_bottom)
+                continue;
+
+            x = floorf(point.X + pixel_offset);
+            y = floorf(point.Y + pixel_offset);
+
+            if (x >= src_left && x < src_right && y >= src_top && y < src_bottom)
+                dst[i] = pixels[(x - src_left) + (y - src_top) * src_rect->Width];
+            else
+                dst[i] = sample_bitmap_pixel(src_rect, bits, width, height, x, y, attributes);
+        }
+        break;
+    }
+
+    default:
+        if (interpolation != InterpolationModeBilinear && !fixme++)
+            FIXME("Unimplemented interpolation %i\n", interpolation);
+        /* fall-through */
+    case InterpolationModeBilinear:
+        for (i = 0; i < count; i++, point.X += dx, point.Y += dy)
+        {
+            REAL leftxf, topyf;
+            INT leftx, rightx, topy, bottomy, x_pos;
+            const ARGB *top_row, *bottom_row;
+            ARGB top, bottom;
+
+            if (point.X < bounds->X || point.X >= bounds_right ||
+                point.Y < bounds->Y || point.Y >= bounds_bottom)
+                continue;
+
+            leftxf = floorf(point.X);
+            leftx = (INT)leftxf;
+            rightx = (INT)ceilf(point.X);
+            topyf = floorf(point.Y);
+            topy = (INT)topyf;
+            bottomy = (INT)ceilf(point.Y);
+
+            if (leftx < src_left || rightx >= src_right || topy < src_top || bottomy >= src_bottom)
+            {
+                dst[i] = resample_bitmap_pixel(src_rect, bits, width, height, &point, attributes,
+                                               InterpolationModeBilinear, offset_mode);
+                continue;
+            }
+
+            top_row = pixels + (topy - src_top) * src_rect->Width - src_left;
+            bottom_row = pixels + (bottomy - src_top) * src_rect->Width - src_left;
+
+            if (leftx == rightx && topy == bottomy)
+            {
+                dst[i] = top_row[leftx];
+                continue;
+            }
+
+            x_pos = gdip_round((point.X - leftxf) * 0xff);
+            top = blend_colors_pos(top_row[leftx], top_row[rightx], x_pos);
+            bottom = blend_colors_pos(bottom_row[leftx], bottom_row[rightx], x_pos);
+            dst[i] = blend_colors(top, bottom, point.Y - topyf);
+        }
+        break;
+    }
+}
+
 static REAL intersect_line_scanline(const GpPointF *p1, const GpPointF *p2, REAL y)
 {
     return (p1->X - p2->X) * (p2->Y - y) / (p2->Y - p1->Y) + p2->X;
@@ -3140,7 +3240,7 @@ GpStatus WINGDIPAPI GdipDrawImagePointsRect(GpGraphics *graphics, GpImage *image
             RECT dst_area;
             GpRectF graphics_bounds;
             GpRect src_area;
-            int i, x, y, src_stride, dst_stride;
+            int i, y, src_stride, dst_stride;
             LPBYTE src_data, dst_data, dst_dyn_data=NULL;
             BitmapData lockeddata;
             InterpolationMode interpolation = graphics->interpolation;
@@ -3225,7 +3325,8 @@ GpStatus WINGDIPAPI GdipDrawImagePointsRect(GpGraphics *graphics, GpImage *image
                 REAL m11, m12, m21, m22, mdx, mdy;
                 REAL x_dx, x_dy, y_dx, y_dy;
                 ARGB *dst_color;
-                GpPointF src_pointf_row, src_pointf;
+                GpPointF src_pointf_row;
+                GpRectF src_bounds;
 
                 m11 = (ptf[1].X - ptf[0].X) / srcwidth;
                 m12 = (ptf[1].Y - ptf[0].Y) / srcwidth;
@@ -3261,18 +3362,18 @@ GpStatus WINGDIPAPI GdipDrawImagePointsRect(GpGraphics *graphics, GpImage *image
                 src_pointf_row.Y = dst_to_src.matrix[5] +
                                    dst_area.left * x_dy + dst_area.top * y_dy;
 
+                src_bounds.X = srcx;
+                src_bounds.Y = srcy;
+                src_bounds.Width = srcwidth;
+                src_bounds.Height = srcheight;
+
                 for (y = dst_area.top; y < dst_area.bottom;
                      y++, src_pointf_row.X += y_dx, src_pointf_row.Y += y_dy)
                 {
-                    for (x = dst_area.left, src_pointf = src_pointf_row; x < dst_area.right;
-                         x++, src_pointf.X += x_dx, src_pointf.Y += x_dy)
-                    {
-                        if (src_pointf.X >= srcx && src_pointf.X < srcx + srcwidth &&
-                            src_pointf.Y >= srcy && src_pointf.Y < srcy + srcheight)
-                            *dst_color = resample_bitmap_pixel(&src_area, src_data, bitmap->width, bitmap->height, &src_pointf,
-                                                               imageAttributes, interpolation, offset_mode);
-                        dst_color++;
-                    }
+                    resample_bitmap_span(&src_area, src_data, bitmap->width, bitmap->height, src_pointf_row,
+                                         x_dx, x_dy, &src_bounds, dst_color, dst_area.right - dst_area.left,
+                                         imageAttributes, interpolation, offset_mode);
+                    dst_color += dst_area.right - dst_area.left;
                 }
             }
             else
@@ -7354,6 +7354,233 @@ static void test_printer_dc(void)
     DeleteDC(hdc_printer);
 }
 
+extern BOOL color_match(ARGB c1, ARGB c2, BYTE max_diff);
+
+/* Upscaling a 4x4 bitmap by two maps every even destination pixel onto a source
+ * pixel. Odd pixels fall halfway between two source pixels, where nearest neighbour
+ * may round either way, and the last row and column sample half a pixel past the
+ * source rectangle, where Windows results are implementation specific. */
+static void test_DrawImage_resample(void)
+{
+    static const ARGB nearest_clamp[64] =
+    {
+        0xff101080, 0xff501080, 0xff501080, 0xff901080, 0xff901080, 0xffd01080, 0xffd01080, 0x00000000,
+        0xff105080, 0xff505080, 0xff505080, 0xff905080, 0xff905080, 0xffd05080, 0xffd05080, 0x00000000,
+        0xff105080, 0xff505080, 0xff505080, 0xff905080, 0xff905080, 0xffd05080, 0xffd05080, 0x00000000,
+        0xff109080, 0xff509080, 0xff509080, 0xff909080, 0xff909080, 0xffd09080, 0xffd09080, 0x00000000,
+        0xff109080, 0xff509080, 0xff509080, 0xff909080, 0xff909080, 0xffd09080, 0xffd09080, 0x00000000,
+        0xff10d080, 0xff50d080, 0xff50d080, 0xff90d080, 0xff90d080, 0xffd0d080, 0xffd0d080, 0x00000000,
+        0xff10d080, 0xff50d080, 0xff50d080, 0xff90d080, 0xff90d080, 0xffd0d080, 0xffd0d080, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000
+    };
+    static const ARGB nearest_tile[64] =
+    {
+        0xff101080, 0xff501080, 0xff501080, 0xff901080, 0xff901080, 0xffd01080, 0xffd01080, 0xff101080,
+        0xff105080, 0xff505080, 0xff505080, 0xff905080, 0xff905080, 0xffd05080, 0xffd05080, 0xff105080,
+        0xff105080, 0xff505080, 0xff505080, 0xff905080, 0xff905080, 0xffd05080, 0xffd05080, 0xff105080,
+        0xff109080, 0xff509080, 0xff509080, 0xff909080, 0xff909080, 0xffd09080, 0xffd09080, 0xff109080,
+        0xff109080, 0xff509080, 0xff509080, 0xff909080, 0xff909080, 0xffd09080, 0xffd09080, 0xff109080,
+        0xff10d080, 0xff50d080, 0xff50d080, 0xff90d080, 0xff90d080, 0xffd0d080, 0xffd0d080, 0xff10d080,
+        0xff10d080, 0xff50d080, 0xff50d080, 0xff90d080, 0xff90d080, 0xffd0d080, 0xffd0d080, 0xff10d080,
+        0xff101080, 0xff501080, 0xff501080, 0xff901080, 0xff901080, 0xffd01080, 0xffd01080, 0xff101080
+    };
+    static const ARGB bilinear_clamp[64] =
+    {
+        0xff101080, 0xff301080, 0xff501080, 0xff701080, 0xff901080, 0xffb01080, 0xffd01080, 0x7fd01080,
+        0xff103080, 0xff303080, 0xff503080, 0xff703080, 0xff903080, 0xffb03080, 0xffd03080, 0x7fd03080,
+        0xff105080, 0xff305080, 0xff505080, 0xff705080, 0xff905080, 0xffb05080, 0xffd05080, 0x7fd05080,
+        0xff107080, 0xff307080, 0xff507080, 0xff707080, 0xff907080, 0xffb07080, 0xffd07080, 0x7fd07080,
+        0xff109080, 0xff309080, 0xff509080, 0xff709080, 0xff909080, 0xffb09080, 0xffd09080, 0x7fd09080,
+        0xff10b080, 0xff30b080, 0xff50b080, 0xff70b080, 0xff90b080, 0xffb0b080, 0xffd0b080, 0x7fd0b080,
+        0xff10d080, 0xff30d080, 0xff50d080, 0xff70d080, 0xff90d080, 0xffb0d080, 0xffd0d080, 0x7fd0d080,
+        0x7f10d080, 0x7f30d080, 0x7f50d080, 0x7f70d080, 0x7f90d080, 0x7fb0d080, 0x7fd0d080, 0x3fd0d080
+    };
+    static const ARGB bilinear_tile[64] =
+    {
+        0xff101080, 0xff301080, 0xff501080, 0xff701080, 0xff901080, 0xffb01080, 0xffd01080, 0xff6f1080,
+        0xff103080, 0xff303080, 0xff503080, 0xff703080, 0xff903080, 0xffb03080, 0xffd03080, 0xff6f3080,
+        0xff105080, 0xff305080, 0xff505080, 0xff705080, 0xff905080, 0xffb05080, 0xffd05080, 0xff6f5080,
+        0xff107080, 0xff307080, 0xff507080, 0xff707080, 0xff907080, 0xffb07080, 0xffd07080, 0xff6f7080,
+        0xff109080, 0xff309080, 0xff509080, 0xff709080, 0xff909080, 0xffb09080, 0xffd09080, 0xff6f9080,
+        0xff10b080, 0xff30b080, 0xff50b080, 0xff70b080, 0xff90b080, 0xffb0b080, 0xffd0b080, 0xff6fb080,
+        0xff10d080, 0xff30d080, 0xff50d080, 0xff70d080, 0xff90d080, 0xffb0d080, 0xffd0d080, 0xff6fd080,
+        0xff106f80, 0xff306f80, 0xff506f80, 0xff706f80, 0xff906f80, 0xffb06f80, 0xffd06f80, 0xff6f6f80
+    };
+    static const struct
+    {
+        InterpolationMode mode;
+        WrapMode wrap;
+        const ARGB *expect;
+    }
+    tests[] =
+    {
+        { InterpolationModeNearestNeighbor, WrapModeClamp, nearest_clamp },
+        { InterpolationModeNearestNeighbor, WrapModeTile, nearest_tile },
+        { InterpolationModeBilinear, WrapModeClamp, bilinear_clamp },
+        { InterpolationModeBilinear, WrapModeTile, bilinear_tile },
+    };
+    GpImageAttributes *attributes;
+    GpBitmap *src, *dst;
+    GpGraphics *graphics;
+    GpTexture *texture;
+    GpStatus status;
+    ARGB color, expected, drawn[64];
+    UINT i, x, y;
+
+    status = GdipCreateBitmapFromScan0(4, 4, 0, PixelFormat32bppARGB, NULL, &src);
+    expect(Ok, status);
+    for (y = 0; y < 4; y++)
+        for (x = 0; x < 4; x++)
+        {
+            status = GdipBitmapSetPixel(src, x, y, 0xff000080 | ((0x10 + 0x40 * x) << 16) | ((0x10 + 0x40 * y) << 8));
+            expect(Ok, status);
+        }
+
+    status = GdipCreateBitmapFromScan0(8, 8, 0, PixelFormat32bppARGB, NULL, &dst);
+    expect(Ok, status);
+    status = GdipGetImageGraphicsContext((GpImage *)dst, &graphics);
+    expect(Ok, status);
+    status = GdipSetCompositingMode(graphics, CompositingModeSourceCopy);
+    expect(Ok, status);
+    status = GdipSetPixelOffsetMode(graphics, PixelOffsetModeNone);
+    expect(Ok, status);
+    status = GdipCreateImageAttributes(&attributes);
+    expect(Ok, status);
+
+    for (i = 0; i < ARRAY_SIZE(tests); i++)
+    {
+        status = GdipSetInterpolationMode(graphics, tests[i].mode);
+        expect(Ok, status);
+        status = GdipSetImageAttributesWrapMode(attributes, tests[i].wrap, 0, FALSE);
+        expect(Ok, status);
+
+        status = GdipDrawImageRectRectI(graphics, (GpImage *)src, 0, 0, 8, 8, 0, 0, 4, 4,
+                UnitPixel, attributes, NULL, NULL);
+        expect(Ok, status);
+
+        for (y = 0; y < 8; y++)
+            for (x = 0; x < 8; x++)
+            {
+                status = GdipBitmapGetPixel(dst, x, y, &drawn[y * 8 + x]);
+                expect(Ok, status);
+            }
+
+        for (y = 0; y < 7; y++)
+            for (x = 0; x < 7; x++)
+            {
+                color = drawn[y * 8 + x];
+                expected = tests[i].expect[y * 8 + x];
+                if (tests[i].mode == InterpolationModeNearestNeighbor)
+                    ok(color == expected || broken(color == tests[i].expect[(y & ~1) * 8 + (x & ~1)]),
+                            "%u: got %08lx at (%u,%u), expected %08lx.\n", i, color, x, y, expected);
+                else
+                    ok(color_match(color, expected, 2), "%u: got %08lx at (%u,%u), expected %08lx.\n",
+                            i, color, x, y, expected);
+            }
+
+        if (strcmp(winetest_platform, "wine"))
+            continue;
+
+        /* Texture brushes go through the per-pixel resampler, the scanline one used
+         * for images has to produce the same results, including on the edges. */
+        status = GdipCreateTextureIA((GpImage *)src, attributes, 0.0, 0.0, 4.0, 4.0, &texture);
+        expect(Ok, status);
+        status = GdipScaleTextureTransform(texture, 2.0, 2.0, MatrixOrderAppend);
+        expect(Ok, status);
+        status = GdipFillRectangleI(graphics, (GpBrush *)texture, 0, 0, 8, 8);
+        expect(Ok, status);
+        GdipDeleteBrush((GpBrush *)texture);
+
+        for (y = 0; y < 8; y++)
+            for (x = 0; x < 8; x++)
+            {
+                status = GdipBitmapGetPixel(dst, x, y, &color);
+                expect(Ok, status);
+                ok(color == drawn[y * 8 + x], "%u: got %08lx at (%u,%u) with a texture brush, drawn %08lx.\n",
+                        i, color, x, y, drawn[y * 8 + x]);
+                ok(drawn[y * 8 + x] == tests[i].expect[y * 8 + x], "%u: got %08lx at (%u,%u), expected %08lx.\n",
+                        i, drawn[y * 8 + x], x, y, tests[i].expect[y * 8 + x]);
+            }
+    }
+
+    GdipDisposeImageAttributes(attributes);
+    GdipDeleteGraphics(graphics);
+    GdipDisposeImage((GpImage *)dst);
+    GdipDisposeImage((GpImage *)src);
+}
+
+static void test_DrawImage_throughput(void)
+{
+    static const struct
+    {
+        InterpolationMode mode;
+        const char *name;
+    }
+    modes[] =
+    {
+        { InterpolationModeNearestNeighbor, "nearest neighbor" },
+        { InterpolationModeBilinear, "bilinear" },
+        { InterpolationModeHighQualityBilinear, "high quality bilinear" },
+        { InterpolationModeHighQualityBicubic, "high quality bicubic" },
+    };
+    static const UINT src_size = 256, dst_size = 600, iterations = 10;
+    LARGE_INTEGER freq, start, end;
+    GpBitmap *src, *dst;
+    GpGraphics *graphics;
+    BitmapData lockeddata;
+    GpStatus status;
+    GpRect rect = { 0, 0, src_size, src_size };
+    UINT i, x, y;
+    ARGB color;
+
+    status = GdipCreateBitmapFromScan0(src_size, src_size, 0, PixelFormat32bppARGB, NULL, &src);
+    expect(Ok, status);
+    status = GdipBitmapLockBits(src, &rect, ImageLockModeWrite, PixelFormat32bppARGB, &lockeddata);
+    expect(Ok, status);
+    for (y = 0; y < src_size; y++)
+    {
+        DWORD *row = (DWORD *)((BYTE *)lockeddata.Scan0 + y * lockeddata.Stride);
+        for (x = 0; x < src_size; x++)
+            row[x] = 0xff000000 | (x << 16) | (y << 8) | ((x ^ y) & 0xff);
+    }
+    status = GdipBitmapUnlockBits(src, &lockeddata);
+    expect(Ok, status);
+
+    status = GdipCreateBitmapFromScan0(dst_size, dst_size, 0, PixelFormat32bppARGB, NULL, &dst);
+    expect(Ok, status);
+    status = GdipGetImageGraphicsContext((GpImage *)dst, &graphics);
+    expect(Ok, status);
+
+    QueryPerformanceFrequency(&freq);
+
+    /* Scaled draws of a large bitmap, as done by reporting and charting applications. */
+    for (i = 0; i < ARRAY_SIZE(modes); i++)
+    {
+        status = GdipSetInterpolationMode(graphics, modes[i].mode);
+        expect(Ok, status);
+
+        QueryPerformanceCounter(&start);
+        for (x = 0; x < iterations; x++)
+        {
+            status = GdipDrawImageRectRectI(graphics, (GpImage *)src, 0, 0, dst_size, dst_size,
+                    0, 0, src_size, src_size, UnitPixel, NULL, NULL, NULL);
+            expect(Ok, status);
+        }
+        QueryPerformanceCounter(&end);
+
+        status = GdipBitmapGetPixel(dst, dst_size / 2, dst_size / 2, &color);
+        expect(Ok, status);
+        ok((color & 0xff000000) == 0xff000000, "%s: got color %08lx.\n", modes[i].name, color);
+
+        trace("%s: %.1f MPix/s\n", modes[i].name, (double)dst_size * dst_size * iterations *
+                freq.QuadPart / (end.QuadPart - start.QuadPart) / 1000000.0);
+    }
+
+    GdipDeleteGraphics(graphics);
+    GdipDisposeImage((GpImage *)dst);
+    GdipDisposeImage((GpImage *)src);
+}
+
 START_TEST(graphics)
 {
     struct GdiplusStartupInput gdiplusStartupInput;
@@ -7451,6 +7678,9 @@ START_TEST(graphics)
     test_gdi_interop_bitmap();
     test_gdi_interop_hdc();
     test_printer_dc();
+    test_DrawImage_resample();
+    if (winetest_interactive)
+        test_DrawImage_throughput();
 
     GdiplusShutdown(gdiplusToken);
     DestroyWindow( hwnd );
@@ -548,10 +548,23 @@ static HRESULT maybe_to_primitive(script_ctx_t *ctx, jsval_t val, jsval_t *r)
 /* ECMA-262 5.1 Edition    15.12.3 (abstract operation Quote) */
 static HRESULT json_quote(stringify_ctx_t *ctx, const WCHAR *ptr, size_t len)
 {
+    size_t run;
+
     if(!ptr || !append_char(ctx, '"'))
         return E_OUTOFMEMORY;
 
-    while(len--) {
+    while(len) {
+        /* Copy characters that don't need escaping in one go. */
+        for(run = 0; run < len && ptr[run] >= ' ' && ptr[run] != '"' && ptr[run] != '\\'; run++);
+        if(run) {
+            if(!append_string_len(ctx, ptr, run))
+                return E_OUTOFMEMORY;
+            ptr += run;
+            len -= run;
+            if(!len)
+                break;
+        }
+
         switch(*ptr) {
         case '"':
         case '\\':
@@ -578,18 +591,15 @@ static HRESULT json_quote(stringify_ctx_t *ctx, const WCHAR *ptr, size_t len)
             if(!append_simple_quote(ctx, 't'))
                 return E_OUTOFMEMORY;
             break;
-        default:
-            if(*ptr < ' ') {
-                WCHAR buf[7];
-                swprintf(buf, ARRAY_SIZE(buf), L"\\u%04x", *ptr);
-                if(!append_string(ctx, buf))
-                    return E_OUTOFMEMORY;
-            }else {
-                if(!append_char(ctx, *ptr))
-                    return E_OUTOFMEMORY;
-            }
+        default: {
+            WCHAR buf[7];
+            swprintf(buf, ARRAY_SIZE(buf), L"\\u%04x", *ptr);
+            if(!append_string(ctx, buf))
+                return E_OUTOFMEMORY;
+        }
         }
         ptr++;
+        len--;
     }
 
     return append_char(ctx, '"') ? S_OK : E_OUTOFMEMORY;
@@ -860,6 +870,29 @@ static HRESULT stringify(stringify_ctx_t *ctx, jsdisp_t *object, const WCHAR *na
     return hres;
 }
 
+/* Hands the buffer over to the result string, so it doesn't need to be copied again. */
+static jsstr_t *stringify_result(stringify_ctx_t *ctx)
+{
+    WCHAR *buf;
+    jsstr_t *ret;
+
+    if(!append_char(ctx, 0))
+        return NULL;
+
+    buf = realloc(ctx->buf, ctx->buf_len*sizeof(WCHAR));
+    if(buf) {
+        ctx->buf = buf;
+        ctx->buf_size = ctx->buf_len;
+    }
+
+    ret = jsstr_alloc_heap(ctx->buf, ctx->buf_len-1);
+    if(ret) {
+        ctx->buf = NULL;
+        ctx->buf_size = ctx->buf_len = 0;
+    }
+    return ret;
+}
+
 /* ECMA-262 5.1 Edition    15.12.3 */
 static HRESULT JSON_stringify(script_ctx_t *ctx, jsval_t vthis, WORD flags, unsigned argc, jsval_t *argv, jsval_t *r)
 {
@@ -923,7 +956,7 @@ static HRESULT JSON_stringify(script_ctx_t *ctx, jsval_t vthis, WORD flags, unsi
         assert(!stringify_ctx.stack_top);
 
         if(hres == S_OK) {
-            jsstr_t *ret = jsstr_alloc_len(stringify_ctx.buf, stringify_ctx.buf_len);
+            jsstr_t *ret = stringify_result(&stringify_ctx);
             if(ret)
                 *r = jsval_string(ret);
             else
@@ -34,13 +34,28 @@
  */
 #define JSSTR_MAX_ROPE_DEPTH 100
 
+/*
+ * This is the initial size of a string builder buffer.
+ */
+#define JSSTR_MIN_BUILDER_SIZE 64
+
 const char *debugstr_jsstr(jsstr_t *str)
 {
     return jsstr_is_inline(str) ? debugstr_wn(jsstr_as_inline(str)->buf, jsstr_length(str))
         : jsstr_is_heap(str) ? debugstr_wn(jsstr_as_heap(str)->buf, jsstr_length(str))
+        : jsstr_is_slice(str) ? debugstr_wn(jsstr_as_slice(str)->builder->buf, jsstr_length(str))
         : wine_dbg_sprintf("%s...", debugstr_jsstr(jsstr_as_rope(str)->left));
 }
 
+static void jsstr_builder_release(jsstr_builder_t *builder)
+{
+    if(--builder->ref)
+        return;
+
+    free(builder->buf);
+    free(builder);
+}
+
 void jsstr_free(jsstr_t *str)
 {
     switch(jsstr_tag(str)) {
@@ -53,6 +68,9 @@ void jsstr_free(jsstr_t *str)
         jsstr_release(rope->right);
         break;
     }
+    case JSSTR_SLICE:
+        jsstr_builder_release(jsstr_as_slice(str)->builder);
+        break;
     case JSSTR_INLINE:
         break;
     }
@@ -83,6 +101,24 @@ jsstr_t *jsstr_alloc_buf(unsigned len, WCHAR **buf)
     return &ret->str;
 }
 
+/* Takes ownership of buf, which must be allocated by malloc() and have room for len+1 characters. */
+jsstr_t *jsstr_alloc_heap(WCHAR *buf, unsigned len)
+{
+    jsstr_heap_t *ret;
+
+    if(len > JSSTR_MAX_LENGTH)
+        return NULL;
+
+    ret = malloc(sizeof(*ret));
+    if(!ret)
+        return NULL;
+
+    jsstr_init(&ret->str, len, JSSTR_HEAP);
+    buf[len] = 0;
+    ret->buf = buf;
+    return &ret->str;
+}
+
 jsstr_t *jsstr_alloc_len(const WCHAR *buf, unsigned len)
 {
     jsstr_t *ret;
@@ -121,6 +157,9 @@ void jsstr_extract(jsstr_t *str, unsigned off, unsigned len, WCHAR *buf)
         return;
     case JSSTR_ROPE:
         return jsstr_rope_extract(jsstr_as_rope(str), off, len, buf);
+    case JSSTR_SLICE:
+        memcpy(buf, jsstr_as_slice(str)->builder->buf+off, len*sizeof(WCHAR));
+        return;
     }
 }
 
@@ -135,6 +174,9 @@ static int jsstr_cmp_str(jsstr_t *jsstr, const WCHAR *str, unsigned len)
     case JSSTR_HEAP:
         ret = memcmp(jsstr_as_heap(jsstr)->buf, str, len*sizeof(WCHAR));
         return ret || jsstr_length(jsstr) == len ? ret : 1;
+    case JSSTR_SLICE:
+        ret = memcmp(jsstr_as_slice(jsstr)->builder->buf, str, len*sizeof(WCHAR));
+        return ret || jsstr_length(jsstr) == len ? ret : 1;
     case JSSTR_ROPE: {
         jsstr_rope_t *rope = jsstr_as_rope(jsstr);
         unsigned left_len = jsstr_length(rope->left);
@@ -152,11 +194,11 @@ static int jsstr_cmp_str(jsstr_t *jsstr, const WCHAR *str, unsigned len)
 
 #define TMP_BUF_SIZE 256
 
-static int ropes_cmp(jsstr_rope_t *left, jsstr_rope_t *right)
+static int non_flat_cmp(jsstr_t *left, jsstr_t *right)
 {
     WCHAR left_buf[TMP_BUF_SIZE], right_buf[TMP_BUF_SIZE];
-    unsigned left_len = jsstr_length(&left->str);
-    unsigned right_len = jsstr_length(&right->str);
+    unsigned left_len = jsstr_length(left);
+    unsigned right_len = jsstr_length(right);
     unsigned cmp_off = 0, cmp_size;
     int ret;
 
@@ -166,8 +208,8 @@ static int ropes_cmp(jsstr_rope_t *left, jsstr_rope_t *right)
         if(cmp_size > TMP_BUF_SIZE)
             cmp_size = TMP_BUF_SIZE;
 
-        jsstr_rope_extract(left, cmp_off, cmp_size, left_buf);
-        jsstr_rope_extract(right, cmp_off, cmp_size, right_buf);
+        jsstr_extract(left, cmp_off, cmp_size, left_buf);
+        jsstr_extract(right, cmp_off, cmp_size, right_buf);
         ret = memcmp(left_buf, right_buf, cmp_size);
         if(ret)
             return ret;
@@ -204,7 +246,77 @@ int jsstr_cmp(jsstr_t *str1, jsstr_t *str2)
         return ret || len1 == len2 ? -ret : 1;
     }
 
-    return ropes_cmp(jsstr_as_rope(str1), jsstr_as_rope(str2));
+    return non_flat_cmp(str1, str2);
+}
+
+static jsstr_t *jsstr_alloc_slice(jsstr_builder_t *builder)
+{
+    jsstr_slice_t *ret;
+
+    ret = malloc(sizeof(*ret));
+    if(!ret)
+        return NULL;
+
+    jsstr_init(&ret->str, builder->len, JSSTR_SLICE);
+    builder->ref++;
+    ret->builder = builder;
+    return &ret->str;
+}
+
+static BOOL jsstr_builder_grow(jsstr_builder_t *builder, unsigned len)
+{
+    unsigned new_size;
+    WCHAR *new_buf;
+
+    if(len <= builder->size)
+        return TRUE;
+
+    new_size = max(builder->size * 2, len);
+    if(new_size > JSSTR_MAX_LENGTH)
+        new_size = JSSTR_MAX_LENGTH;
+
+    new_buf = realloc(builder->buf, (new_size+1) * sizeof(WCHAR));
+    if(!new_buf)
+        return FALSE;
+
+    builder->buf = new_buf;
+    builder->size = new_size;
+    return TRUE;
+}
+
+static jsstr_t *jsstr_builder_append(jsstr_builder_t *builder, jsstr_t *str)
+{
+    unsigned len = jsstr_length(str);
+
+    if(!jsstr_builder_grow(builder, builder->len + len))
+        return NULL;
+
+    /* str may be a slice of the same builder, but it can't overlap with the appended part. */
+    jsstr_flush(str, builder->buf + builder->len);
+    builder->len += len;
+    return jsstr_alloc_slice(builder);
+}
+
+static jsstr_t *jsstr_builder_concat(jsstr_t *str1, jsstr_t *str2)
+{
+    jsstr_builder_t *builder;
+    jsstr_t *ret;
+
+    builder = calloc(1, sizeof(*builder));
+    if(!builder)
+        return NULL;
+
+    builder->ref = 1;
+    if(!jsstr_builder_grow(builder, max(2 * (jsstr_length(str1) + jsstr_length(str2)), JSSTR_MIN_BUILDER_SIZE))) {
+        free(builder);
+        return NULL;
+    }
+
+    jsstr_flush(str1, builder->buf);
+    builder->len = jsstr_length(str1);
+    ret = jsstr_builder_append(builder, str2);
+    jsstr_builder_release(builder);
+    return ret;
 }
 
 jsstr_t *jsstr_concat(jsstr_t *str1, jsstr_t *str2)
@@ -221,6 +333,16 @@ jsstr_t *jsstr_concat(jsstr_t *str1, jsstr_t *str2)
     if(!len2)
         return jsstr_addref(str1);
 
+    if(len1+len2 > JSSTR_MAX_LENGTH)
+        return NULL;
+
+    /* Append in place if str1 ends at the end of its builder buffer. */
+    if(jsstr_is_slice(str1)) {
+        jsstr_builder_t *builder = jsstr_as_slice(str1)->builder;
+        if(builder->len == len1 && !builder->frozen)
+            return jsstr_builder_append(builder, str2);
+    }
+
     if(len1 + len2 >= JSSTR_SHORT_STRING_LENGTH) {
         unsigned depth, depth2;
         jsstr_rope_t *rope;
@@ -231,9 +353,6 @@ jsstr_t *jsstr_concat(jsstr_t *str1, jsstr_t *str2)
             depth = depth2;
 
         if(depth++ < JSSTR_MAX_ROPE_DEPTH) {
-            if(len1+len2 > JSSTR_MAX_LENGTH)
-                return NULL;
-
             rope = malloc(sizeof(*rope));
             if(!rope)
                 return NULL;
@@ -244,6 +363,12 @@ jsstr_t *jsstr_concat(jsstr_t *str1, jsstr_t *str2)
             rope->depth = depth;
             return &rope->str;
         }
+
+        /*
+         * The string is most likely being built by repeated appends. Switch to a builder, so
+         * that following appends don't need to copy the whole string again.
+         */
+        return jsstr_builder_concat(str1, str2);
     }
 
     ret = jsstr_alloc_buf(len1+len2, &ptr);
@@ -257,6 +382,7 @@ jsstr_t *jsstr_concat(jsstr_t *str1, jsstr_t *str2)
 }
 
 C_ASSERT(sizeof(jsstr_heap_t) <= sizeof(jsstr_rope_t));
+C_ASSERT(sizeof(jsstr_heap_t) <= sizeof(jsstr_slice_t));
 
 const WCHAR *jsstr_rope_flatten(jsstr_rope_t *str)
 {
@@ -277,6 +403,32 @@ const WCHAR *jsstr_rope_flatten(jsstr_rope_t *str)
     return jsstr_as_heap(&str->str)->buf = buf;
 }
 
+const WCHAR *jsstr_slice_flatten(jsstr_slice_t *str)
+{
+    jsstr_builder_t *builder = str->builder;
+    unsigned len = jsstr_length(&str->str);
+    WCHAR *buf;
+
+    /* The last slice may use the builder buffer, as long as nothing is appended to it later. */
+    if(len == builder->len) {
+        builder->frozen = TRUE;
+        builder->buf[len] = 0;
+        return builder->buf;
+    }
+
+    buf = malloc((len+1) * sizeof(WCHAR));
+    if(!buf)
+        return NULL;
+
+    memcpy(buf, builder->buf, len*sizeof(WCHAR));
+    buf[len] = 0;
+
+    /* Transform to heap string */
+    jsstr_builder_release(builder);
+    str->str.length_flags |= JSSTR_HEAP;
+    return jsstr_as_heap(&str->str)->buf = buf;
+}
+
 static jsstr_t *empty_str, *nan_str, *undefined_str, *null_bstr_str;
 
 jsstr_t *jsstr_nan(void)
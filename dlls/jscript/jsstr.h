@@ -24,12 +24,18 @@
  * - heap string - a structure containing a pointer to buffer on the heap.
  * - roper string - a product of concatenation of two strings. Instead of copying whole
  *   buffers, we may store just references to concatenated strings.
+ * - slice string - a prefix of a growable buffer shared by a string builder. Concatenating
+ *   to the slice that ends at the end of the used part of the buffer appends in place, so
+ *   strings built by repeated appends don't copy their whole content on every append.
+ *   Other slices of the same builder keep seeing only their own prefix.
  *
  * String layout may change over life time of the string. Currently possible transformation
- * is when a rope string becomes a heap stream. That happens when we need a real, linear
+ * is when a rope or slice string becomes a heap stream. That happens when we need a real, linear
  * zero-terminated buffer (a flat buffer). At this point the type of the string is changed
  * and the new buffer is stored in the string, so that subsequent operations requiring
- * a flat string won't need to flatten it again.
+ * a flat string won't need to flatten it again. The slice that ends at the end of the
+ * builder buffer is an exception: it can use the builder buffer directly, which stops
+ * further in place appends to the builder.
  *
  * In the future more layouts and transformations may be added.
  */
@@ -47,6 +53,7 @@ struct _jsstr_t {
 #define JSSTR_FLAG_TAG_MASK 3
 
 typedef enum {
+    JSSTR_SLICE  = 0,
     JSSTR_INLINE = JSSTR_FLAG_FLAT,
     JSSTR_HEAP   = JSSTR_FLAG_FLAT|JSSTR_FLAG_LBIT,
     JSSTR_ROPE   = JSSTR_FLAG_LBIT
@@ -77,6 +84,11 @@ static inline BOOL jsstr_is_rope(jsstr_t *str)
     return jsstr_tag(str) == JSSTR_ROPE;
 }
 
+static inline BOOL jsstr_is_slice(jsstr_t *str)
+{
+    return jsstr_tag(str) == JSSTR_SLICE;
+}
+
 typedef struct {
     jsstr_t str;
     WCHAR buf[];
@@ -94,8 +106,22 @@ typedef struct {
     unsigned depth;
 } jsstr_rope_t;
 
+typedef struct {
+    unsigned ref;
+    unsigned len;  /* length of the longest slice */
+    unsigned size; /* buffer size, not counting space for the terminating null */
+    BOOL frozen;   /* the buffer was exposed as a flat string and may not be appended to */
+    WCHAR *buf;
+} jsstr_builder_t;
+
+typedef struct {
+    jsstr_t str;
+    jsstr_builder_t *builder;
+} jsstr_slice_t;
+
 jsstr_t *jsstr_alloc_len(const WCHAR*,unsigned);
 jsstr_t *jsstr_alloc_buf(unsigned,WCHAR**);
+jsstr_t *jsstr_alloc_heap(WCHAR*,unsigned);
 
 static inline jsstr_t *jsstr_alloc(const WCHAR *str)
 {
@@ -131,13 +157,20 @@ static inline jsstr_rope_t *jsstr_as_rope(jsstr_t *str)
     return CONTAINING_RECORD(str, jsstr_rope_t, str);
 }
 
+static inline jsstr_slice_t *jsstr_as_slice(jsstr_t *str)
+{
+    return CONTAINING_RECORD(str, jsstr_slice_t, str);
+}
+
 const WCHAR *jsstr_rope_flatten(jsstr_rope_t*);
+const WCHAR *jsstr_slice_flatten(jsstr_slice_t*);
 
 static inline const WCHAR *jsstr_flatten(jsstr_t *str)
 {
     return jsstr_is_inline(str) ? jsstr_as_inline(str)->buf
         : jsstr_is_heap(str) ? jsstr_as_heap(str)->buf
-        : jsstr_rope_flatten(jsstr_as_rope(str));
+        : jsstr_is_rope(str) ? jsstr_rope_flatten(jsstr_as_rope(str))
+        : jsstr_slice_flatten(jsstr_as_slice(str));
 }
 
 void jsstr_extract(jsstr_t*,unsigned,unsigned,WCHAR*);
@@ -149,6 +182,8 @@ static inline unsigned jsstr_flush(jsstr_t *str, WCHAR *buf)
         memcpy(buf, jsstr_as_inline(str)->buf, len*sizeof(WCHAR));
     }else if(jsstr_is_heap(str)) {
         memcpy(buf, jsstr_as_heap(str)->buf, len*sizeof(WCHAR));
+    }else if(jsstr_is_slice(str)) {
+        memcpy(buf, jsstr_as_slice(str)->builder->buf, len*sizeof(WCHAR));
     }else {
         jsstr_rope_t *rope = jsstr_as_rope(str);
         jsstr_flush(rope->left, buf);
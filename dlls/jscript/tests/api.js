@@ -1956,6 +1956,7 @@ ok(isNaN(tmp), "Math.tan(-Infinity) is not NaN");
         [[1], "1"],
         [["test"], "\"test\""],
         [["test\"\\\b\f\n\r\t\u0002 !"], "\"test\\\"\\\\\\b\\f\\n\\r\\t\\u0002 !\""],
+        [["\"a\"bc\u001fd"], "\"\\\"a\\\"bc\\u001fd\""],
         [[NaN], "null"],
         [[Infinity], "null"],
         [[-Infinity], "null"],
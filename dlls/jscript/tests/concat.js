@@ -0,0 +1,38 @@
+/*
+ * Copyright 2026 The Wine Project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* Strings built by repeated appends, read back from time to time. */
+
+var s, html, i, j;
+
+for(j = 0; j < 10; j++) {
+    s = "";
+    for(i = 0; i < 20000; i++)
+        s += "item" + i + ";";
+    if(s.indexOf("item19999;") == -1)
+        throw "missing item";
+}
+
+html = "";
+for(i = 0; i < 20000; i++) {
+    html += "<tr><td>" + i + "</td><td>" + (i * 2) + "</td></tr>\n";
+    if(!(i % 1000))
+        html.charAt(html.length - 1);
+}
+
+s = html = null;
@@ -0,0 +1,39 @@
+/*
+ * Copyright 2026 The Wine Project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* JSON.stringify over a large object graph. */
+
+var data = [], s, i, j;
+
+for(i = 0; i < 2000; i++) {
+    data.push({
+        id: i,
+        name: "item \"" + i + "\"",
+        tags: ["a", "b", "c"],
+        nested: {value: i / 3, flag: !!(i % 2), text: "line\nbreak"}
+    });
+}
+
+for(j = 0; j < 10; j++) {
+    s = JSON.stringify(data);
+    if(!s.length)
+        throw "empty result";
+}
+
+s = JSON.stringify(data, null, 2);
+data = s = null;
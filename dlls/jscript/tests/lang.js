@@ -2081,6 +2081,37 @@ function returnTest() {
 
 ok(returnTest() === undefined, "returnTest = " + returnTest());
 
+function testStringBuilding() {
+    var s = "", prefix, expected = "", i;
+
+    for(i = 0; i < 1000; i++) {
+        s += "ab";
+        if(i == 499)
+            prefix = s;
+    }
+    ok(s.length === 2000, "s.length = " + s.length);
+    ok(prefix.length === 1000, "prefix.length = " + prefix.length);
+    ok(s.substring(0, 1000) === prefix, "s does not start with prefix");
+
+    tmp = prefix + "x";
+    ok(tmp.length === 1001 && tmp.charAt(1000) === "x", "prefix + \"x\" = " + tmp);
+    ok(s.charAt(1000) === "a", "s.charAt(1000) = " + s.charAt(1000));
+    ok(prefix.indexOf("x") === -1, "prefix.indexOf(\"x\") = " + prefix.indexOf("x"));
+
+    ok(s.indexOf("ba", 1990) === 1991, "s.indexOf(\"ba\", 1990) = " + s.indexOf("ba", 1990));
+    s += "cd";
+    ok(s.length === 2002 && s.slice(-4) === "abcd", "s.slice(-4) = " + s.slice(-4));
+
+    s += s;
+    ok(s.length === 4004 && s.slice(2000, 2004) === "cdab", "s.slice(2000, 2004) = " + s.slice(2000, 2004));
+
+    for(i = 0; i < 500; i++)
+        expected += "ab";
+    ok(prefix === expected, "prefix changed");
+}
+
+testStringBuilding();
+
 ActiveXObject = 1;
 ok(ActiveXObject === 1, "ActiveXObject = " + ActiveXObject);
 
@@ -4397,6 +4397,8 @@ static void run_benchmarks(void)
     run_benchmark("dna.js");
     run_benchmark("base64.js");
     run_benchmark("validateinput.js");
+    run_benchmark("concat.js");
+    run_benchmark("json.js");
 }
 
 static BOOL check_jscript(void)
@@ -5688,6 +5688,91 @@ static void test_overlapped_read(void)
     ok(ret, "Unexpected error %lu.\n", GetLastError());
 }
 
+static void test_overlapped_many(void)
+{
+    static const char prefix[] = "pfx";
+    static const unsigned int count = 64, block = 4096;
+    char temp_path[MAX_PATH], file_name[MAX_PATH];
+    OVERLAPPED ov[64];
+    HANDLE hfile, events[64];
+    unsigned char *buffer;
+    DWORD ret, bytes_count, i;
+
+    ret = GetTempPathA(MAX_PATH, temp_path);
+    ok(ret, "Unexpected error %lu.\n", GetLastError());
+    ret = GetTempFileNameA(temp_path, prefix, 0, file_name);
+    ok(ret, "Unexpected error %lu.\n", GetLastError());
+
+    buffer = HeapAlloc(GetProcessHeap(), 0, count * block);
+    hfile = CreateFileA(file_name, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+            FILE_FLAG_OVERLAPPED | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+    ok(hfile != INVALID_HANDLE_VALUE, "Failed to create file, GetLastError() %lu.\n", GetLastError());
+
+    for (i = 0; i < count; i++)
+    {
+        events[i] = CreateEventA(NULL, TRUE, FALSE, NULL);
+        memset(buffer + i * block, i, block);
+    }
+
+    /* many outstanding writes, each with its own event */
+    for (i = 0; i < count; i++)
+    {
+        memset(&ov[i], 0, sizeof(ov[i]));
+        ov[i].Offset = i * block;
+        ov[i].hEvent = events[i];
+        ret = WriteFile(hfile, buffer + i * block, block, NULL, &ov[i]);
+        ok(ret || GetLastError() == ERROR_IO_PENDING,
+                "Unexpected WriteFile result, ret %#lx, GetLastError() %lu.\n", ret, GetLastError());
+    }
+    ret = WaitForMultipleObjects(count, events, TRUE, 10000);
+    ok(ret < count, "Unexpected wait result %#lx.\n", ret);
+    for (i = 0; i < count; i++)
+    {
+        ret = GetOverlappedResult(hfile, &ov[i], &bytes_count, FALSE);
+        ok(ret && bytes_count == block, "Unexpected result %#lx, bytes_count %lu, GetLastError() %lu.\n",
+                ret, bytes_count, GetLastError());
+    }
+
+    /* read them back in reverse order */
+    memset(buffer, 0xcc, count * block);
+    for (i = 0; i < count; i++)
+    {
+        memset(&ov[i], 0, sizeof(ov[i]));
+        ov[i].Offset = (count - 1 - i) * block;
+        ov[i].hEvent = events[i];
+        ret = ReadFile(hfile, buffer + (count - 1 - i) * block, block, NULL, &ov[i]);
+        ok(ret || GetLastError() == ERROR_IO_PENDING,
+                "Unexpected ReadFile result, ret %#lx, GetLastError() %lu.\n", ret, GetLastError());
+    }
+    ret = WaitForMultipleObjects(count, events, TRUE, 10000);
+    ok(ret < count, "Unexpected wait result %#lx.\n", ret);
+
+    for (i = 0; i < count; i++)
+    {
+        ret = GetOverlappedResult(hfile, &ov[i], &bytes_count, FALSE);
+        ok(ret && bytes_count == block, "Unexpected result %#lx, bytes_count %lu, GetLastError() %lu.\n",
+                ret, bytes_count, GetLastError());
+        ok(buffer[i * block] == (unsigned char)i && buffer[(i + 1) * block - 1] == (unsigned char)i,
+                "Unexpected data in block %lu.\n", i);
+    }
+
+    /* reads past the end of the file complete with an error */
+    memset(&ov[0], 0, sizeof(ov[0]));
+    ov[0].Offset = count * block;
+    ov[0].hEvent = events[0];
+    ret = ReadFile(hfile, buffer, block, NULL, &ov[0]);
+    ok(!ret && (GetLastError() == ERROR_IO_PENDING || broken(GetLastError() == ERROR_HANDLE_EOF)),
+            "Unexpected ReadFile result, ret %#lx, GetLastError() %lu.\n", ret, GetLastError());
+    ret = GetOverlappedResult(hfile, &ov[0], &bytes_count, TRUE);
+    ok(!ret && GetLastError() == ERROR_HANDLE_EOF, "Unexpected result %#lx, GetLastError() %lu.\n",
+            ret, GetLastError());
+    ok(!bytes_count, "Unexpected read size %lu.\n", bytes_count);
+
+    for (i = 0; i < count; i++) CloseHandle(events[i]);
+    CloseHandle(hfile);
+    HeapFree(GetProcessHeap(), 0, buffer);
+}
+
 static void test_file_readonly_access(void)
 {
     static const DWORD default_sharing = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
@@ -6266,6 +6351,7 @@ START_TEST(file)
     test_GetFileAttributesExW();
     test_post_completion();
     test_overlapped_read();
+    test_overlapped_many();
     test_file_readonly_access();
     test_find_file_stream();
     test_SetFileTime();
@@ -3727,6 +3727,358 @@ static void test_heap_sizes(void)
     test_heap_size( 0x150000 );
 }
 
+struct bin_cache_thread
+{
+    HANDLE heap;
+    HANDLE freed;
+    HANDLE done;
+    void *ptrs[64];
+    void *kept[16];
+};
+
+static DWORD WINAPI bin_cache_thread_proc( void *arg )
+{
+    struct bin_cache_thread *params = arg;
+    void *ptrs[32];
+    UINT i;
+    BOOL ret;
+
+    /* free the blocks of another thread, then reuse their size */
+    for (i = 0; i < ARRAY_SIZE(params->ptrs); i++)
+    {
+        ret = HeapFree( params->heap, 0, params->ptrs[i] );
+        ok( ret, "HeapFree failed, error %lu\n", GetLastError() );
+    }
+    for (i = 0; i < ARRAY_SIZE(ptrs); i++)
+    {
+        ptrs[i] = HeapAlloc( params->heap, 0, 0x30 );
+        ok( !!ptrs[i], "HeapAlloc failed, error %lu\n", GetLastError() );
+        memset( ptrs[i], 0x55, 0x30 );
+    }
+
+    /* keep some blocks, and free the others while still running */
+    for (i = 0; i < ARRAY_SIZE(params->kept); i++) params->kept[i] = ptrs[i];
+    for (; i < ARRAY_SIZE(ptrs); i++) HeapFree( params->heap, 0, ptrs[i] );
+
+    SetEvent( params->freed );
+    WaitForSingleObject( params->done, INFINITE );
+    return 0;
+}
+
+static void check_heap_blocks_( unsigned int line, HANDLE heap, void **ptrs, UINT count )
+{
+    PROCESS_HEAP_ENTRY entry;
+    BOOL ret, found[128] = {0};
+    UINT i;
+
+    ret = HeapValidate( heap, 0, NULL );
+    ok_(__FILE__, line)( ret, "HeapValidate failed\n" );
+    for (i = 0; i < count; i++)
+    {
+        ret = HeapValidate( heap, 0, ptrs[i] );
+        ok_(__FILE__, line)( ret, "HeapValidate %p failed\n", ptrs[i] );
+        ok_(__FILE__, line)( HeapSize( heap, 0, ptrs[i] ) == 0x30, "got size %#Ix\n", HeapSize( heap, 0, ptrs[i] ) );
+    }
+
+    /* LFH blocks are walked individually on Windows, and as their whole group on Wine,
+     * every block in use must be in a busy entry either way */
+    memset( &entry, 0, sizeof(entry) );
+    SetLastError( 0xdeadbeef );
+    while (HeapWalk( heap, &entry ))
+    {
+        if (entry.wFlags & (PROCESS_HEAP_REGION | PROCESS_HEAP_UNCOMMITTED_RANGE)) continue;
+        for (i = 0; i < count; i++)
+        {
+            if ((char *)ptrs[i] < (char *)entry.lpData) continue;
+            if ((char *)ptrs[i] >= (char *)entry.lpData + entry.cbData) continue;
+            ok_(__FILE__, line)( entry.wFlags & PROCESS_HEAP_ENTRY_BUSY, "%p in free entry %p size %#lx\n",
+                                 ptrs[i], entry.lpData, entry.cbData );
+            found[i] = TRUE;
+        }
+    }
+    ok_(__FILE__, line)( GetLastError() == ERROR_NO_MORE_ITEMS, "got error %lu\n", GetLastError() );
+    for (i = 0; i < count; i++) ok_(__FILE__, line)( found[i], "%p not found\n", ptrs[i] );
+}
+#define check_heap_blocks( a, b, c ) check_heap_blocks_( __LINE__, a, b, c )
+
+static int __cdecl compare_ptrs( const void *a, const void *b )
+{
+    const char *ptr_a = *(char *const *)a, *ptr_b = *(char *const *)b;
+    return ptr_a < ptr_b ? -1 : ptr_a > ptr_b;
+}
+
+static void test_thread_cached_blocks(void)
+{
+    struct bin_cache_thread params;
+    void *ptrs[ARRAY_SIZE(params.kept) + 64];
+    ULONG compat_info = 2;
+    HANDLE thread;
+    UINT i, count;
+    BOOL ret;
+
+    params.heap = HeapCreate( 0, 0, 0 );
+    ret = pHeapSetInformation( params.heap, HeapCompatibilityInformation, &compat_info, sizeof(compat_info) );
+    ok( ret, "HeapSetInformation failed, error %lu\n", GetLastError() );
+    params.freed = CreateEventW( NULL, FALSE, FALSE, NULL );
+    params.done = CreateEventW( NULL, FALSE, FALSE, NULL );
+
+    /* enough blocks of the same size to use the LFH on Windows too */
+    for (i = 0; i < 0x800; i++) HeapFree( params.heap, 0, HeapAlloc( params.heap, 0, 0x30 ) );
+    for (i = 0; i < ARRAY_SIZE(params.ptrs); i++)
+    {
+        params.ptrs[i] = HeapAlloc( params.heap, 0, 0x30 );
+        ok( !!params.ptrs[i], "HeapAlloc failed, error %lu\n", GetLastError() );
+    }
+
+    thread = CreateThread( NULL, 0, bin_cache_thread_proc, &params, 0, NULL );
+    WaitForSingleObject( params.freed, INFINITE );
+
+    /* the other thread still holds the blocks it freed last */
+    check_heap_blocks( params.heap, params.kept, ARRAY_SIZE(params.kept) );
+    for (i = 0; i < ARRAY_SIZE(params.kept); i++) ptrs[i] = params.kept[i];
+    for (count = i; count < ARRAY_SIZE(ptrs); count++)
+    {
+        ptrs[count] = HeapAlloc( params.heap, 0, 0x30 );
+        ok( !!ptrs[count], "HeapAlloc failed, error %lu\n", GetLastError() );
+    }
+    check_heap_blocks( params.heap, ptrs, count );
+    for (i = ARRAY_SIZE(params.kept); i < count; i++) HeapFree( params.heap, 0, ptrs[i] );
+
+    /* exiting with freed blocks still cached */
+    SetEvent( params.done );
+    WaitForSingleObject( thread, INFINITE );
+    CloseHandle( thread );
+    check_heap_blocks( params.heap, params.kept, ARRAY_SIZE(params.kept) );
+
+    /* no block may be given out twice, nor overlap another one */
+    for (count = ARRAY_SIZE(params.kept); count < ARRAY_SIZE(ptrs); count++)
+    {
+        ptrs[count] = HeapAlloc( params.heap, 0, 0x30 );
+        ok( !!ptrs[count], "HeapAlloc failed, error %lu\n", GetLastError() );
+    }
+    check_heap_blocks( params.heap, ptrs, count );
+    qsort( ptrs, count, sizeof(*ptrs), compare_ptrs );
+    for (i = 1; i < count; i++)
+        ok( (char *)ptrs[i - 1] + 0x30 <= (char *)ptrs[i], "%p overlaps %p\n", ptrs[i - 1], ptrs[i] );
+
+    for (i = 0; i < count; i++)
+    {
+        ret = HeapFree( params.heap, 0, ptrs[i] );
+        ok( ret, "HeapFree failed, error %lu\n", GetLastError() );
+    }
+    check_heap_blocks( params.heap, NULL, 0 );
+
+    CloseHandle( params.freed );
+    CloseHandle( params.done );
+    HeapDestroy( params.heap );
+}
+
+struct heap_bench_thread
+{
+    HANDLE heap;
+    HANDLE start;
+    DWORD seed;
+};
+
+static DWORD WINAPI heap_bench_proc( void *arg )
+{
+    struct heap_bench_thread *params = arg;
+    DWORD i, j, seed = params->seed;
+    void *ptrs[16];
+
+    WaitForSingleObject( params->start, INFINITE );
+    for (i = 0; i < 200000; i++)
+    {
+        for (j = 0; j < ARRAY_SIZE(ptrs); j++)
+        {
+            seed = seed * 1103515245 + 12345;
+            ptrs[j] = HeapAlloc( params->heap, 0, 8 + (seed >> 16) % 248 );
+        }
+        for (j = 0; j < ARRAY_SIZE(ptrs); j++) HeapFree( params->heap, 0, ptrs[j] );
+    }
+    return 0;
+}
+
+/* blocks passed between two threads in batches, each thread freeing the blocks of the other */
+struct heap_bench_pipe
+{
+    HANDLE heap;
+    HANDLE start;
+    HANDLE filled[2];
+    HANDLE emptied[2];
+    void *batches[2][256];
+};
+
+struct heap_bench_side
+{
+    struct heap_bench_pipe *pipe;
+    UINT index;
+};
+
+#define HEAP_BENCH_BATCHES 2000
+
+static void heap_bench_fill( HANDLE heap, void **batch, DWORD *seed )
+{
+    UINT i;
+
+    for (i = 0; i < 256; i++)
+    {
+        *seed = *seed * 1103515245 + 12345;
+        batch[i] = HeapAlloc( heap, 0, 8 + (*seed >> 16) % 248 );
+    }
+}
+
+static void heap_bench_empty( HANDLE heap, void **batch )
+{
+    UINT i;
+
+    for (i = 0; i < 256; i++) HeapFree( heap, 0, batch[i] );
+}
+
+static DWORD WINAPI heap_bench_producer( void *arg )
+{
+    struct heap_bench_pipe *pipe = arg;
+    DWORD i, seed = 0;
+
+    WaitForSingleObject( pipe->start, INFINITE );
+    for (i = 0; i < HEAP_BENCH_BATCHES; i++)
+    {
+        WaitForSingleObject( pipe->emptied[i & 1], INFINITE );
+        heap_bench_fill( pipe->heap, pipe->batches[i & 1], &seed );
+        SetEvent( pipe->filled[i & 1] );
+    }
+    return 0;
+}
+
+static DWORD WINAPI heap_bench_consumer( void *arg )
+{
+    struct heap_bench_pipe *pipe = arg;
+    DWORD i;
+
+    WaitForSingleObject( pipe->start, INFINITE );
+    for (i = 0; i < HEAP_BENCH_BATCHES; i++)
+    {
+        WaitForSingleObject( pipe->filled[i & 1], INFINITE );
+        heap_bench_empty( pipe->heap, pipe->batches[i & 1] );
+        SetEvent( pipe->emptied[i & 1] );
+    }
+    return 0;
+}
+
+/* both sides take turns to free the batch of the other side, and allocate a new one */
+static DWORD WINAPI heap_bench_ping_pong( void *arg )
+{
+    struct heap_bench_side *side = arg;
+    struct heap_bench_pipe *pipe = side->pipe;
+    DWORD i, seed = side->index;
+
+    WaitForSingleObject( pipe->start, INFINITE );
+    for (i = 0; i < HEAP_BENCH_BATCHES / 2; i++)
+    {
+        WaitForSingleObject( pipe->filled[side->index], INFINITE );
+        if (pipe->batches[0][0]) heap_bench_empty( pipe->heap, pipe->batches[0] );
+        heap_bench_fill( pipe->heap, pipe->batches[0], &seed );
+        SetEvent( pipe->filled[!side->index] );
+    }
+    return 0;
+}
+
+static void benchmark_heap_pipes( BOOL ping_pong )
+{
+    struct heap_bench_pipe pipes[4];
+    struct heap_bench_side sides[8];
+    HANDLE threads[8], heap, start;
+    ULONG compat_info = 2;
+    DWORD i, j, count, time;
+    BOOL ret;
+
+    for (count = 1; count <= ARRAY_SIZE(pipes); count *= 2)
+    {
+        heap = HeapCreate( 0, 0, 0 );
+        ret = pHeapSetInformation( heap, HeapCompatibilityInformation, &compat_info, sizeof(compat_info) );
+        ok( ret, "HeapSetInformation failed, error %lu\n", GetLastError() );
+        start = CreateEventW( NULL, TRUE, FALSE, NULL );
+
+        for (i = 0; i < count; i++)
+        {
+            memset( &pipes[i], 0, sizeof(pipes[i]) );
+            pipes[i].heap = heap;
+            pipes[i].start = start;
+            for (j = 0; j < 2; j++)
+            {
+                pipes[i].filled[j] = CreateEventW( NULL, FALSE, ping_pong && !j, NULL );
+                pipes[i].emptied[j] = CreateEventW( NULL, FALSE, TRUE, NULL );
+                sides[2 * i + j].pipe = &pipes[i];
+                sides[2 * i + j].index = j;
+            }
+            if (ping_pong)
+            {
+                threads[2 * i] = CreateThread( NULL, 0, heap_bench_ping_pong, &sides[2 * i], 0, NULL );
+                threads[2 * i + 1] = CreateThread( NULL, 0, heap_bench_ping_pong, &sides[2 * i + 1], 0, NULL );
+            }
+            else
+            {
+                threads[2 * i] = CreateThread( NULL, 0, heap_bench_producer, &pipes[i], 0, NULL );
+                threads[2 * i + 1] = CreateThread( NULL, 0, heap_bench_consumer, &pipes[i], 0, NULL );
+            }
+        }
+        time = GetTickCount();
+        SetEvent( start );
+        WaitForMultipleObjects( 2 * count, threads, TRUE, INFINITE );
+        time = GetTickCount() - time;
+        trace( "%lu %s pairs: %lu cross-thread allocations and frees in %lu ms\n", count,
+               ping_pong ? "ping-pong" : "producer/consumer", count * HEAP_BENCH_BATCHES * 256, time );
+
+        for (i = 0; i < count; i++)
+        {
+            if (ping_pong) heap_bench_empty( heap, pipes[i].batches[0] );
+            for (j = 0; j < 2; j++)
+            {
+                CloseHandle( pipes[i].filled[j] );
+                CloseHandle( pipes[i].emptied[j] );
+            }
+        }
+        for (i = 0; i < 2 * count; i++) CloseHandle( threads[i] );
+        CloseHandle( start );
+        HeapDestroy( heap );
+    }
+}
+
+static void benchmark_heap_threads(void)
+{
+    struct heap_bench_thread params[8];
+    HANDLE threads[8], heap, start;
+    ULONG compat_info = 2;
+    DWORD i, count, time;
+    BOOL ret;
+
+    /* small blocks allocated and freed in batches by threads sharing a LFH heap */
+    for (count = 1; count <= ARRAY_SIZE(threads); count *= 2)
+    {
+        heap = HeapCreate( 0, 0, 0 );
+        ret = pHeapSetInformation( heap, HeapCompatibilityInformation, &compat_info, sizeof(compat_info) );
+        ok( ret, "HeapSetInformation failed, error %lu\n", GetLastError() );
+        start = CreateEventW( NULL, TRUE, FALSE, NULL );
+
+        for (i = 0; i < count; i++)
+        {
+            params[i].heap = heap;
+            params[i].start = start;
+            params[i].seed = i;
+            threads[i] = CreateThread( NULL, 0, heap_bench_proc, &params[i], 0, NULL );
+        }
+        time = GetTickCount();
+        SetEvent( start );
+        WaitForMultipleObjects( count, threads, TRUE, INFINITE );
+        time = GetTickCount() - time;
+        trace( "%lu threads: %lu allocations and frees in %lu ms\n", count, count * 200000 * 16, time );
+
+        for (i = 0; i < count; i++) CloseHandle( threads[i] );
+        CloseHandle( start );
+        HeapDestroy( heap );
+    }
+}
+
 START_TEST(heap)
 {
     int argc;
@@ -3764,4 +4116,11 @@ START_TEST(heap)
     }
     else win_skip( "RtlGetNtGlobalFlags not found, skipping heap debug tests\n" );
     test_heap_sizes();
+    test_thread_cached_blocks();
+    if (winetest_interactive)
+    {
+        benchmark_heap_threads();
+        benchmark_heap_pipes( FALSE );
+        benchmark_heap_pipes( TRUE );
+    }
 }
@@ -79,6 +79,7 @@ static PVOID    (WINAPI *pResolveDelayLoadedAPI)(PVOID, PCIMAGE_DELAYLOAD_DESCRI
                                                  PIMAGE_THUNK_DATA ThunkAddress,ULONG);
 static PVOID (WINAPI *pRtlImageDirectoryEntryToData)(HMODULE,BOOL,WORD,ULONG *);
 static PIMAGE_NT_HEADERS (WINAPI *pRtlImageNtHeader)(HMODULE);
+static void * (WINAPI *pRtlFindExportedRoutineByName)(HMODULE,const char *);
 static DWORD (WINAPI *pFlsAlloc)(PFLS_CALLBACK_FUNCTION);
 static BOOL (WINAPI *pFlsSetValue)(DWORD, PVOID);
 static PVOID (WINAPI *pFlsGetValue)(DWORD);
@@ -4177,6 +4178,99 @@ static void test_LoadPackagedLibrary(void)
             h, GetLastError());
 }
 
+#define check_export_names(a) check_export_names_(__LINE__, a)
+static DWORD check_export_names_( unsigned int line, HMODULE module )
+{
+    const IMAGE_EXPORT_DIRECTORY *exports;
+    const DWORD *functions, *names;
+    const WORD *ordinals;
+    const char *name, *proc;
+    void *expect[2], *ret;
+    DWORD i, pass, forwarded = 0;
+    ULONG size;
+
+    exports = pRtlImageDirectoryEntryToData( module, TRUE, IMAGE_DIRECTORY_ENTRY_EXPORT, &size );
+    ok_(__FILE__, line)( exports != NULL, "no export directory\n" );
+    if (!exports) return 0;
+    ok_(__FILE__, line)( exports->NumberOfNames > 32, "got %lu names\n", exports->NumberOfNames );
+
+    functions = (const DWORD *)((const char *)module + exports->AddressOfFunctions);
+    names = (const DWORD *)((const char *)module + exports->AddressOfNames);
+    ordinals = (const WORD *)((const char *)module + exports->AddressOfNameOrdinals);
+
+    /* RtlFindExportedRoutineByName before and after GetProcAddress,
+     * which builds the names index of large export tables */
+    for (pass = 0; pass < 2; pass++)
+    {
+        for (i = 0; i < exports->NumberOfNames; i++)
+        {
+            name = (const char *)module + names[i];
+            proc = (const char *)module + functions[ordinals[i]];
+            /* forwarded exports are not resolved by RtlFindExportedRoutineByName */
+            if (proc >= (const char *)exports && proc < (const char *)exports + size) expect[0] = NULL;
+            else expect[0] = (void *)proc;
+
+            if (pass)
+            {
+                if (!expect[0]) forwarded++;
+                ret = GetProcAddress( module, name );
+                expect[1] = GetProcAddress( module, (LPCSTR)(ULONG_PTR)(exports->Base + ordinals[i]) );
+                ok_(__FILE__, line)( ret == expect[1], "%s: got %p, expected %p\n", name, ret, expect[1] );
+                if (expect[0])
+                    ok_(__FILE__, line)( ret == expect[0], "%s: got %p, expected %p\n", name, ret, expect[0] );
+            }
+            if (!pRtlFindExportedRoutineByName) continue;
+            ret = pRtlFindExportedRoutineByName( module, name );
+            ok_(__FILE__, line)( ret == expect[0], "%s: got %p, expected %p\n", name, ret, expect[0] );
+        }
+    }
+
+    ret = GetProcAddress( module, "wine_no_such_export" );
+    ok_(__FILE__, line)( !ret, "got %p\n", ret );
+    if (pRtlFindExportedRoutineByName)
+    {
+        ret = pRtlFindExportedRoutineByName( module, "wine_no_such_export" );
+        ok_(__FILE__, line)( !ret, "got %p\n", ret );
+    }
+    return forwarded;
+}
+
+static void test_export_names(void)
+{
+    HMODULE module, base;
+    DWORD forwarded;
+
+    if (!pRtlFindExportedRoutineByName) win_skip( "RtlFindExportedRoutineByName is not present\n" );
+
+    forwarded = check_export_names( GetModuleHandleA( "kernel32.dll" ) );
+    ok( forwarded, "no forwarded exports\n" );
+
+    /* the index of an unloaded module must not be used for a module loaded again,
+     * which usually happens at the same address */
+    if (GetModuleHandleA( "imagehlp.dll" ))
+    {
+        skip( "imagehlp.dll is already loaded\n" );
+        return;
+    }
+    base = LoadLibraryA( "imagehlp.dll" );
+    ok( base != NULL, "failed to load imagehlp.dll, error %lu\n", GetLastError() );
+    if (!base) return;
+    check_export_names( base );
+    FreeLibrary( base );
+    if (GetModuleHandleA( "imagehlp.dll" ))
+    {
+        skip( "imagehlp.dll was not unloaded\n" );
+        return;
+    }
+
+    module = LoadLibraryA( "imagehlp.dll" );
+    ok( module != NULL, "failed to load imagehlp.dll, error %lu\n", GetLastError() );
+    if (!module) return;
+    if (module != base) trace( "imagehlp.dll loaded at %p, previously at %p\n", module, base );
+    check_export_names( module );
+    FreeLibrary( module );
+}
+
 static void test_Wow64Transition(void)
 {
     char buffer[400];
@@ -4235,6 +4329,7 @@ START_TEST(loader)
     pRtlReleasePebLock = (void *)GetProcAddress(ntdll, "RtlReleasePebLock");
     pRtlImageDirectoryEntryToData = (void *)GetProcAddress(ntdll, "RtlImageDirectoryEntryToData");
     pRtlImageNtHeader = (void *)GetProcAddress(ntdll, "RtlImageNtHeader");
+    pRtlFindExportedRoutineByName = (void *)GetProcAddress(ntdll, "RtlFindExportedRoutineByName");
     pFlsAlloc = (void *)GetProcAddress(kernel32, "FlsAlloc");
     pFlsSetValue = (void *)GetProcAddress(kernel32, "FlsSetValue");
     pFlsGetValue = (void *)GetProcAddress(kernel32, "FlsGetValue");
@@ -4290,6 +4385,7 @@ START_TEST(loader)
     test_dll_file( "kernel32.dll" );
     test_dll_file( "advapi32.dll" );
     test_dll_file( "user32.dll" );
+    test_export_names();
     test_Wow64Transition();
     /* loader test must be last, it can corrupt the internal loader state on Windows */
     test_Loader();
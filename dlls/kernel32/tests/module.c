@@ -1226,6 +1226,139 @@ static void test_AddDllDirectory(void)
     ok( GetLastError() == ERROR_INVALID_PARAMETER, "wrong error %lu\n", GetLastError() );
 }
 
+static void set_dir_write_time( const char *dir, const FILETIME *time )
+{
+    HANDLE handle;
+    BOOL ret;
+
+    handle = CreateFileA( dir, FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                          NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, 0 );
+    ok( handle != INVALID_HANDLE_VALUE, "failed to open %s err %lu\n", dir, GetLastError() );
+    ret = SetFileTime( handle, NULL, NULL, time );
+    ok( ret, "SetFileTime failed err %lu\n", GetLastError() );
+    CloseHandle( handle );
+}
+
+static void get_dir_write_time( const char *dir, FILETIME *time )
+{
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    BOOL ret;
+
+    ret = GetFileAttributesExA( dir, GetFileExInfoStandard, &data );
+    ok( ret, "GetFileAttributesEx failed err %lu\n", GetLastError() );
+    *time = data.ftLastWriteTime;
+}
+
+#define check_search_load(name, flags, expect) check_search_load_( __LINE__, name, flags, expect )
+static void check_search_load_( unsigned int line, const char *name, DWORD flags, BOOL expect )
+{
+    HMODULE mod;
+
+    SetLastError( 0xdeadbeef );
+    mod = LoadLibraryExA( name, 0, flags );
+    if (expect)
+    {
+        ok_(__FILE__, line)( mod != NULL, "LoadLibrary failed err %lu\n", GetLastError() );
+        FreeLibrary( mod );
+    }
+    else
+    {
+        ok_(__FILE__, line)( !mod, "LoadLibrary succeeded\n" );
+        ok_(__FILE__, line)( GetLastError() == ERROR_MOD_NOT_FOUND, "wrong error %lu\n", GetLastError() );
+    }
+}
+
+/* a failed search must not hide a dll created later, or found through a new search path */
+static void test_search_path_changes(void)
+{
+    static const char dll_name[] = "winetestsearch.dll";
+    char base[MAX_PATH], dirs[3][MAX_PATH], path[MAX_PATH];
+    WCHAR pathW[MAX_PATH];
+    DLL_DIRECTORY_COOKIE cookie;
+    ULARGE_INTEGER time;
+    FILETIME old_time, write_time;
+    unsigned int i;
+    BOOL ret;
+
+    GetTempPathA( sizeof(path), path );
+    GetTempFileNameA( path, "tmp", 0, base );
+    DeleteFileA( base );
+    ret = CreateDirectoryA( base, NULL );
+    ok( ret, "CreateDirectory failed err %lu\n", GetLastError() );
+
+    /* directories last modified an hour ago, so that a loader can cache their contents */
+    GetSystemTimeAsFileTime( &old_time );
+    time.LowPart = old_time.dwLowDateTime;
+    time.HighPart = old_time.dwHighDateTime;
+    time.QuadPart -= (ULONGLONG)3600 * 10000000;
+    old_time.dwLowDateTime = time.LowPart;
+    old_time.dwHighDateTime = time.HighPart;
+    for (i = 0; i < ARRAY_SIZE(dirs); i++)
+    {
+        sprintf( dirs[i], "%s\%u", base, i );
+        ret = CreateDirectoryA( dirs[i], NULL );
+        ok( ret, "CreateDirectory failed err %lu\n", GetLastError() );
+    }
+    sprintf( path, "%s\%s", dirs[2], dll_name );
+    create_test_dll( path );
+    for (i = 0; i < ARRAY_SIZE(dirs); i++) set_dir_write_time( dirs[i], &old_time );
+
+    /* dll created after a failed search */
+    ret = SetDllDirectoryA( dirs[0] );
+    ok( ret, "SetDllDirectory failed err %lu\n", GetLastError() );
+    check_search_load( dll_name, 0, FALSE );
+    check_search_load( dll_name, 0, FALSE );
+    sprintf( path, "%s\%s", dirs[0], dll_name );
+    create_test_dll( path );
+    check_search_load( dll_name, 0, TRUE );
+    DeleteFileA( path );
+    set_dir_write_time( dirs[0], &old_time );
+    check_search_load( dll_name, 0, FALSE );
+
+    /* dll created without changing the write time of a recently modified directory */
+    sprintf( path, "%s\%s", dirs[1], dll_name );
+    create_test_dll( path );
+    DeleteFileA( path );
+    get_dir_write_time( dirs[1], &write_time );
+    ret = SetDllDirectoryA( dirs[1] );
+    ok( ret, "SetDllDirectory failed err %lu\n", GetLastError() );
+    check_search_load( dll_name, 0, FALSE );
+    create_test_dll( path );
+    set_dir_write_time( dirs[1], &write_time );
+    check_search_load( dll_name, 0, TRUE );
+    DeleteFileA( path );
+
+    /* SetDllDirectory switching to a directory that contains the dll */
+    ret = SetDllDirectoryA( dirs[0] );
+    ok( ret, "SetDllDirectory failed err %lu\n", GetLastError() );
+    check_search_load( dll_name, 0, FALSE );
+    ret = SetDllDirectoryA( dirs[2] );
+    ok( ret, "SetDllDirectory failed err %lu\n", GetLastError() );
+    check_search_load( dll_name, 0, TRUE );
+    ret = SetDllDirectoryA( NULL );
+    ok( ret, "SetDllDirectory failed err %lu\n", GetLastError() );
+    check_search_load( dll_name, 0, FALSE );
+
+    if (pAddDllDirectory && pRemoveDllDirectory)
+    {
+        /* AddDllDirectory and RemoveDllDirectory */
+        check_search_load( dll_name, LOAD_LIBRARY_SEARCH_USER_DIRS, FALSE );
+        MultiByteToWideChar( CP_ACP, 0, dirs[2], -1, pathW, ARRAY_SIZE(pathW) );
+        cookie = pAddDllDirectory( pathW );
+        ok( cookie != NULL, "AddDllDirectory failed err %lu\n", GetLastError() );
+        check_search_load( dll_name, LOAD_LIBRARY_SEARCH_USER_DIRS, TRUE );
+        ret = pRemoveDllDirectory( cookie );
+        ok( ret, "RemoveDllDirectory failed err %lu\n", GetLastError() );
+        check_search_load( dll_name, LOAD_LIBRARY_SEARCH_USER_DIRS, FALSE );
+    }
+    else win_skip( "AddDllDirectory not available\n" );
+
+    sprintf( path, "%s\%s", dirs[2], dll_name );
+    DeleteFileA( path );
+    for (i = 0; i < ARRAY_SIZE(dirs); i++) RemoveDirectoryA( dirs[i] );
+    RemoveDirectoryA( base );
+}
+
 static void test_SetDefaultDllDirectories(void)
 {
     HMODULE mod;
@@ -1751,6 +1884,7 @@ START_TEST(module)
     testK32GetModuleInformation();
     test_AddDllDirectory();
     test_SetDefaultDllDirectories();
+    test_search_path_changes();
     test_LdrGetDllHandleEx();
     test_LdrGetDllFullName();
     test_apisets();
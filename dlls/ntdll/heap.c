@@ -276,6 +276,26 @@ static inline struct group **bin_get_affinity_group( struct bin *bin, BYTE affin
     return bin->affinity_group_base + affinity * BLOCK_SIZE_BIN_COUNT;
 }
 
+/* number of bins, starting from the smallest, with per-thread cached blocks */
+#define BIN_CACHE_COUNT 0x30
+/* maximum number of blocks cached per thread and bin */
+#define BIN_CACHE_DEPTH 8
+
+/* a cache of recently freed LFH blocks, owned by a single thread of a given affinity.
+ *
+ * The owner thread is the only one accessing the cached blocks, which are taken and
+ * returned without any interlocked operation, and without touching the group free bits.
+ * Cached blocks are marked free, but still considered used by their group.
+ *
+ * The owner thread ids are stored after the bins affinity group pointers, followed by
+ * the caches, which are only reserved and get committed when first claimed.
+ */
+struct bin_cache
+{
+    BYTE count[BIN_CACHE_COUNT];
+    struct block *blocks[BIN_CACHE_COUNT][BIN_CACHE_DEPTH];
+};
+
 struct heap
 {                                  /* win32/win64 */
     DWORD_PTR        unknown1[2];   /* 0000/0000 */
@@ -1585,9 +1605,18 @@ HANDLE WINAPI RtlCreateHeap( ULONG flags, void *addr, SIZE_T total_size, SIZE_T
 
     if (heap->flags & HEAP_GROWABLE)
     {
-        SIZE_T size = (sizeof(struct bin) + sizeof(struct group *) * ARRAY_SIZE(affinity_mapping)) * BLOCK_SIZE_BIN_COUNT;
+        SIZE_T size = (sizeof(struct bin) + sizeof(struct group *) * ARRAY_SIZE(affinity_mapping)) * BLOCK_SIZE_BIN_COUNT
+                      + sizeof(LONG) * ARRAY_SIZE(affinity_mapping);
+        SIZE_T reserve_size = size + sizeof(struct bin_cache) * ARRAY_SIZE(affinity_mapping);
         NtAllocateVirtualMemory( NtCurrentProcess(), (void *)&heap->bins,
-                                 0, &size, MEM_COMMIT, PAGE_READWRITE );
+                                 0, &reserve_size, MEM_RESERVE, PAGE_READWRITE );
+        if (heap->bins && NtAllocateVirtualMemory( NtCurrentProcess(), (void *)&heap->bins,
+                                                   0, &size, MEM_COMMIT, PAGE_READWRITE ))
+        {
+            reserve_size = 0;
+            NtFreeVirtualMemory( NtCurrentProcess(), (void *)&heap->bins, &reserve_size, MEM_RELEASE );
+            heap->bins = NULL;
+        }
 
         for (i = 0; heap->bins && i < BLOCK_SIZE_BIN_COUNT; ++i)
         {
@@ -1870,6 +1899,58 @@ static inline ULONG heap_current_thread_affinity(void)
     return affinity;
 }
 
+static inline LONG *heap_get_bin_cache_owner( struct heap *heap, ULONG affinity )
+{
+    struct group **groups = (struct group **)(heap->bins + BLOCK_SIZE_BIN_COUNT);
+    LONG *owners = (LONG *)(groups + BLOCK_SIZE_BIN_COUNT * ARRAY_SIZE(affinity_mapping));
+    return owners + affinity;
+}
+
+static inline struct bin_cache *heap_get_bin_cache( struct heap *heap, ULONG affinity )
+{
+    struct bin_cache *caches = (struct bin_cache *)heap_get_bin_cache_owner( heap, ARRAY_SIZE(affinity_mapping) );
+    return caches + affinity;
+}
+
+static void heap_thread_detach_bin_cache( struct heap *heap, ULONG affinity );
+
+/* get the current thread bin cache, claiming the cache of its affinity if it isn't owned yet */
+static struct bin_cache *heap_current_thread_bin_cache( struct heap *heap )
+{
+    LONG owner, *owner_ptr, tid = HandleToULong( NtCurrentTeb()->ClientId.UniqueThread );
+    struct bin_cache *cache;
+    ULONG i, affinity;
+    SIZE_T size;
+    void *addr;
+
+    /* 0 is the id of unowned caches */
+    if (!tid) return NULL;
+    /* a thread with affinity 0 gets a new affinity on its next allocation */
+    if (!(affinity = heap_current_thread_affinity())) return NULL;
+    owner_ptr = heap_get_bin_cache_owner( heap, affinity );
+    cache = heap_get_bin_cache( heap, affinity );
+
+    if ((owner = ReadNoFence( owner_ptr )) == tid) return cache;
+    /* another thread with the same affinity owns it, fallback to the group free bits */
+    if (owner || InterlockedCompareExchange( owner_ptr, tid, 0 )) return NULL;
+
+    /* committing is a no-op if the cache was already used by a previous owner */
+    addr = cache;
+    size = sizeof(*cache);
+    if (NtAllocateVirtualMemory( NtCurrentProcess(), &addr, 0, &size, MEM_COMMIT, PAGE_READWRITE ))
+    {
+        WriteRelease( owner_ptr, 0 );
+        return NULL;
+    }
+
+    /* thread ids are unique among running threads, any other cache owned by our id was
+     * left by a thread terminated without running its detach code, and can be released */
+    for (i = 1; i < ARRAY_SIZE(affinity_mapping); ++i)
+        if (i != affinity) heap_thread_detach_bin_cache( heap, i );
+
+    return cache;
+}
+
 /* acquire a group from the bin, thread takes ownership of a shared group or allocates a new one */
 static struct group *heap_acquire_bin_group( struct heap *heap, ULONG flags, SIZE_T block_size, struct bin *bin )
 {
@@ -1936,7 +2017,9 @@ static NTSTATUS heap_allocate_block_lfh( struct heap *heap, ULONG flags, SIZE_T
                                          SIZE_T size, void **ret )
 {
     struct bin *bin, *last = heap->bins + BLOCK_SIZE_BIN_COUNT - 1;
+    struct bin_cache *cache;
     struct block *block;
+    UINT count;
 
     bin = heap->bins + BLOCK_SIZE_BIN( block_size );
     if (bin == last) return STATUS_UNSUCCESSFUL;
@@ -1946,7 +2029,15 @@ static NTSTATUS heap_allocate_block_lfh( struct heap *heap, ULONG flags, SIZE_T
 
     block_size = BLOCK_BIN_SIZE( BLOCK_SIZE_BIN( block_size ) );
 
-    if ((block = find_free_bin_block( heap, flags, block_size, bin )))
+    if (bin - heap->bins < BIN_CACHE_COUNT && (cache = heap_current_thread_bin_cache( heap ))
+        && (count = cache->count[bin - heap->bins]))
+    {
+        block = cache->blocks[bin - heap->bins][count - 1];
+        cache->count[bin - heap->bins] = count - 1;
+    }
+    else block = find_free_bin_block( heap, flags, block_size, bin );
+
+    if (block)
     {
         block_set_type( block, BLOCK_TYPE_USED );
         block_set_flags( block, (BYTE)~BLOCK_FLAG_LFH, BLOCK_USER_FLAGS( flags ) );
@@ -1959,33 +2050,50 @@ static NTSTATUS heap_allocate_block_lfh( struct heap *heap, ULONG flags, SIZE_T
     return block ? STATUS_SUCCESS : STATUS_NO_MEMORY;
 }
 
-static NTSTATUS heap_free_block_lfh( struct heap *heap, ULONG flags, struct block *block )
+/* release a free LFH block to its group, releasing the group if it was its last used block */
+static NTSTATUS group_release_block( struct heap *heap, ULONG flags, struct bin *bin, struct block *block )
 {
-    struct bin *bin, *last = heap->bins + BLOCK_SIZE_BIN_COUNT - 1;
-    SIZE_T i, block_size = block_get_size( block );
     struct group *group = block_get_group( block );
+    SIZE_T i = block_get_group_index( block );
     NTSTATUS status = STATUS_SUCCESS;
 
+    /* if this was the last used block in a group and GROUP_FLAG_FREE was set */
+    if (InterlockedOr( &group->free_bits, 1 << i ) == ~(1 << i))
+    {
+        /* thread now owns the group, and can release it to its bin */
+        group->free_bits = ~GROUP_FLAG_FREE;
+        status = heap_release_bin_group( heap, flags, bin, group );
+    }
+
+    return status;
+}
+
+static NTSTATUS heap_free_block_lfh( struct heap *heap, ULONG flags, struct block *block )
+{
+    struct bin *bin, *last = heap->bins + BLOCK_SIZE_BIN_COUNT - 1;
+    SIZE_T block_size = block_get_size( block );
+    struct bin_cache *cache;
+    UINT count;
+
     if (!(block_get_flags( block ) & BLOCK_FLAG_LFH)) return STATUS_UNSUCCESSFUL;
 
     bin = heap->bins + BLOCK_SIZE_BIN( block_size );
     if (bin == last) return STATUS_UNSUCCESSFUL;
 
-    i = block_get_group_index( block );
     valgrind_make_writable( block, sizeof(*block) );
     block_set_type( block, BLOCK_TYPE_FREE );
     block_set_flags( block, (BYTE)~BLOCK_FLAG_LFH, BLOCK_FLAG_FREE );
     mark_block_free( block + 1, (char *)block + block_size - (char *)(block + 1), flags );
 
-    /* if this was the last used block in a group and GROUP_FLAG_FREE was set */
-    if (InterlockedOr( &group->free_bits, 1 << i ) == ~(1 << i))
+    if (bin - heap->bins < BIN_CACHE_COUNT && (cache = heap_current_thread_bin_cache( heap ))
+        && (count = cache->count[bin - heap->bins]) < BIN_CACHE_DEPTH)
     {
-        /* thread now owns the group, and can release it to its bin */
-        group->free_bits = ~GROUP_FLAG_FREE;
-        status = heap_release_bin_group( heap, flags, bin, group );
+        cache->blocks[bin - heap->bins][count] = block;
+        cache->count[bin - heap->bins] = count + 1;
+        return STATUS_SUCCESS;
     }
 
-    return status;
+    return group_release_block( heap, flags, bin, block );
 }
 
 static void bin_try_enable( struct heap *heap, struct bin *bin )
@@ -2017,12 +2125,37 @@ static void bin_try_enable( struct heap *heap, struct bin *bin )
     WriteRelease( &bin->enabled, TRUE );
 }
 
+/* release the current thread cached blocks and its bin cache ownership */
+static void heap_thread_detach_bin_cache( struct heap *heap, ULONG affinity )
+{
+    LONG *owner_ptr, tid = HandleToULong( NtCurrentTeb()->ClientId.UniqueThread );
+    struct bin_cache *cache;
+    UINT i;
+
+    if (!tid) return;
+    owner_ptr = heap_get_bin_cache_owner( heap, affinity );
+    cache = heap_get_bin_cache( heap, affinity );
+
+    if (ReadNoFence( owner_ptr ) != tid) return;
+
+    for (i = 0; i < BIN_CACHE_COUNT; ++i)
+    {
+        while (cache->count[i])
+            group_release_block( heap, heap->flags, heap->bins + i, cache->blocks[i][--cache->count[i]] );
+    }
+
+    WriteRelease( owner_ptr, 0 );
+}
+
 static void heap_thread_detach_bin_groups( struct heap *heap )
 {
     ULONG i, affinity = NtCurrentTeb()->HeapVirtualAffinity;
 
     if (!heap->bins) return;
 
+    /* flush the cache first, as releasing blocks may give back groups to the thread affinity */
+    heap_thread_detach_bin_cache( heap, affinity );
+
     for (i = 0; i < BLOCK_SIZE_BIN_COUNT; ++i)
     {
         struct bin *bin = heap->bins + i;
@@ -134,12 +134,20 @@ struct file_id
 };
 
 /* internal representation of loaded modules */
+/* hash index of the exported names of a module, built on the first lookup by name */
+struct export_index
+{
+    DWORD                 mask;        /* number of buckets - 1 */
+    DWORD                 buckets[1];  /* index in the names table + 1, 0 if empty */
+};
+
 typedef struct _wine_modref
 {
     LDR_DATA_TABLE_ENTRY  ldr;
     struct file_id        id;
     ULONG                 CheckSum;
     BOOL                  system;
+    struct export_index  *export_index;
 } WINE_MODREF;
 
 static UINT tls_module_count;      /* number of modules with TLS directory */
@@ -1029,17 +1037,169 @@ static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY
 }
 
 
+static inline DWORD hash_export_name( const char *name )
+{
+    DWORD hash = 2166136261u;
+    while (*name) hash = (hash ^ (unsigned char)*name++) * 16777619;
+    return hash;
+}
+
+
+/* export indexes by module base address, for lookups without the loader_section.
+ * Slots of unloaded modules are left as tombstones so that probing goes past them,
+ * they are reused by later modules or emptied when the probe sequence ends there. */
+#define EXPORT_INDEX_SLOTS 1024
+#define EXPORT_INDEX_TOMBSTONE ((HMODULE)~(ULONG_PTR)0)
+
+static struct
+{
+    HMODULE volatile              module;
+    struct export_index * volatile index;
+} export_index_slots[EXPORT_INDEX_SLOTS];
+
+static inline unsigned int export_index_slot_pos( HMODULE module )
+{
+    return ((ULONG_PTR)module >> 16) % EXPORT_INDEX_SLOTS;
+}
+
+
+/*************************************************************************
+ *		set_export_index_slot
+ *
+ * Publish the export index of a module, or free its slot with a NULL index.
+ * The loader_section must be locked while calling this function.
+ */
+static void set_export_index_slot( HMODULE module, struct export_index *index )
+{
+    unsigned int i, pos = export_index_slot_pos( module ), free_pos = EXPORT_INDEX_SLOTS;
+    HMODULE slot_module;
+
+    for (i = 0; i < EXPORT_INDEX_SLOTS; i++, pos = (pos + 1) % EXPORT_INDEX_SLOTS)
+    {
+        if (!(slot_module = export_index_slots[pos].module)) break;
+        if (slot_module == EXPORT_INDEX_TOMBSTONE)
+        {
+            if (free_pos == EXPORT_INDEX_SLOTS) free_pos = pos;
+            continue;
+        }
+        if (slot_module != module) continue;
+
+        if (index)
+        {
+            InterlockedExchangePointer( (void * volatile *)&export_index_slots[pos].index, index );
+            return;
+        }
+        InterlockedExchangePointer( (void * volatile *)&export_index_slots[pos].index, NULL );
+        /* a probe sequence ending right after this slot doesn't need it as a tombstone */
+        if (export_index_slots[(pos + 1) % EXPORT_INDEX_SLOTS].module)
+        {
+            InterlockedExchangePointer( (void * volatile *)&export_index_slots[pos].module, EXPORT_INDEX_TOMBSTONE );
+            return;
+        }
+        for (i = 0; i < EXPORT_INDEX_SLOTS; i++, pos = (pos + EXPORT_INDEX_SLOTS - 1) % EXPORT_INDEX_SLOTS)
+        {
+            if (i && export_index_slots[pos].module != EXPORT_INDEX_TOMBSTONE) break;
+            InterlockedExchangePointer( (void * volatile *)&export_index_slots[pos].module, NULL );
+        }
+        return;
+    }
+
+    if (!index) return;
+    if (free_pos == EXPORT_INDEX_SLOTS)
+    {
+        if (i == EXPORT_INDEX_SLOTS) return;  /* table is full, lookups binary search the export table */
+        free_pos = pos;
+    }
+    InterlockedExchangePointer( (void * volatile *)&export_index_slots[free_pos].module, module );
+    InterlockedExchangePointer( (void * volatile *)&export_index_slots[free_pos].index, index );
+}
+
+
+/*************************************************************************
+ *		find_export_index_slot
+ *
+ * Get the published export index of a module, without locking.
+ */
+static const struct export_index *find_export_index_slot( HMODULE module )
+{
+    unsigned int i, pos = export_index_slot_pos( module );
+    struct export_index *index;
+    HMODULE slot_module;
+
+    for (i = 0; i < EXPORT_INDEX_SLOTS; i++, pos = (pos + 1) % EXPORT_INDEX_SLOTS)
+    {
+        if (!(slot_module = export_index_slots[pos].module)) break;
+        if (slot_module != module) continue;
+        index = export_index_slots[pos].index;
+        /* the slot may have been freed and reused while reading it */
+        if (export_index_slots[pos].module != module) break;
+        return index;
+    }
+    return NULL;
+}
+
+
+/*************************************************************************
+ *		get_export_index
+ *
+ * Get the export names hash index of a module, building it if needed.
+ * Small export tables are simply binary searched.
+ * The loader_section must be locked while calling this function.
+ */
+static const struct export_index *get_export_index( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports )
+{
+    const DWORD *names = get_rva( module, exports->AddressOfNames );
+    struct export_index *index;
+    WINE_MODREF *wm;
+    DWORD i, pos, size;
+
+    if (exports->NumberOfNames < 32 || exports->NumberOfNames > 0x1000000) return NULL;
+    if (!(wm = get_modref( module ))) return NULL;
+    if (wm->export_index) return wm->export_index;
+
+    for (size = 64; size < exports->NumberOfNames * 2; size *= 2) ;
+    if (!(index = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                   offsetof( struct export_index, buckets[size] ) )))
+        return NULL;
+
+    index->mask = size - 1;
+    for (i = 0; i < exports->NumberOfNames; i++)
+    {
+        pos = hash_export_name( get_rva( module, names[i] )) & index->mask;
+        while (index->buckets[pos]) pos = (pos + 1) & index->mask;
+        index->buckets[pos] = i + 1;
+    }
+    TRACE( "built export index for %s, %lu names\n",
+           debugstr_w(wm->ldr.BaseDllName.Buffer), exports->NumberOfNames );
+    set_export_index_slot( module, index );
+    return wm->export_index = index;
+}
+
+
 /*************************************************************************
  *		find_name_in_exports
  *
- * Helper for find_named_export.
+ * Helper for find_named_export. The names table is binary searched if index is NULL.
  */
-static int find_name_in_exports( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports, const char *name )
+static int find_name_in_exports( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
+                                 const struct export_index *index, const char *name )
 {
     const WORD *ordinals = get_rva( module, exports->AddressOfNameOrdinals );
     const DWORD *names = get_rva( module, exports->AddressOfNames );
     int min = 0, max = exports->NumberOfNames - 1;
 
+    if (index)
+    {
+        DWORD i, pos = hash_export_name( name ) & index->mask;
+
+        for ( ; index->buckets[pos]; pos = (pos + 1) & index->mask)
+        {
+            i = index->buckets[pos] - 1;
+            if (!strcmp( get_rva( module, names[i] ), name )) return ordinals[i];
+        }
+        return -1;
+    }
+
     while (min <= max)
     {
         int res, pos = (min + max) / 2;
@@ -1073,8 +1233,9 @@ static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *
             return find_ordinal_export( module, exports, exp_size, ordinals[hint], load_path );
     }
 
-    /* then do a binary search */
-    if ((ordinal = find_name_in_exports( module, exports, name )) == -1) return NULL;
+    /* then look it up in the names table */
+    if ((ordinal = find_name_in_exports( module, exports, get_export_index( module, exports ), name )) == -1)
+        return NULL;
     return find_ordinal_export( module, exports, exp_size, ordinal, load_path );
 
 }
@@ -1094,8 +1255,11 @@ void * WINAPI RtlFindExportedRoutineByName( HMODULE module, const char *name )
     exports = RtlImageDirectoryEntryToData( module, TRUE, IMAGE_DIRECTORY_ENTRY_EXPORT, &exp_size );
     if (!exports || exp_size < sizeof(*exports)) return NULL;
 
-    if ((ordinal = find_name_in_exports( module, exports, name )) == -1) return NULL;
-    if (ordinal >= exports->NumberOfFunctions) return NULL;
+    /* this may be called with other locks held, so don't take the loader_section,
+     * modules whose index hasn't been built yet are binary searched */
+    ordinal = find_name_in_exports( module, exports, find_export_index_slot( module ), name );
+
+    if (ordinal == -1 || ordinal >= exports->NumberOfFunctions) return NULL;
     functions = get_rva( module, exports->AddressOfFunctions );
     if (!functions[ordinal]) return NULL;
     proc = get_rva( module, functions[ordinal] );
@@ -3180,6 +3344,189 @@ done:
 }
 
 
+/* names of the dlls known to be missing from the directories of the search path */
+struct dll_search_dir
+{
+    struct dll_search_dir *next;        /* next directory in the same hash bucket */
+    struct list     entry;              /* entry in the least recently used list */
+    DWORD           hash;
+    ULONG           generation;         /* load generation the write time was last checked in */
+    LARGE_INTEGER   write_time;         /* last write time of the directory when the names were cached */
+    BOOL            stable;             /* directory was not modified just before the write time check */
+    struct rb_tree  missing;            /* names of the dlls not present in the directory */
+    ULONG           missing_count;
+    WCHAR           name[1];            /* absolute DOS path of the directory */
+};
+
+struct dll_search_name
+{
+    struct rb_entry entry;
+    WCHAR           name[1];
+};
+
+#define DLL_SEARCH_DIR_HASH_SIZE 32
+#define DLL_SEARCH_DIR_MAX       64    /* cached directories, least recently used ones are dropped */
+#define DLL_SEARCH_NAME_MAX      512   /* cached names per directory, all are dropped when reached */
+/* a dll created within the write time granularity would not change it */
+#define DLL_SEARCH_DIR_STABLE_TIME (2 * (LONGLONG)10000000)
+
+static struct dll_search_dir *dll_search_dir_hash[DLL_SEARCH_DIR_HASH_SIZE];
+static struct list dll_search_dir_lru = LIST_INIT( dll_search_dir_lru );
+static unsigned int dll_search_dir_count;
+static ULONG dll_search_generation;
+static unsigned int dll_search_probes, dll_search_skipped;
+
+static int compare_dll_search_names( const void *name, const struct rb_entry *entry )
+{
+    struct dll_search_name *search_name = RB_ENTRY_VALUE( entry, struct dll_search_name, entry );
+
+    return wcsicmp( name, search_name->name );
+}
+
+static void free_dll_search_name( struct rb_entry *entry, void *context )
+{
+    RtlFreeHeap( GetProcessHeap(), 0, RB_ENTRY_VALUE( entry, struct dll_search_name, entry ));
+}
+
+static DWORD hash_dll_search_dir( const WCHAR *dir, ULONG len )
+{
+    DWORD hash = 2166136261u;
+
+    for (; len; len--, dir++)
+        hash = (hash ^ ((*dir >= 'A' && *dir <= 'Z') ? *dir + 32 : *dir)) * 16777619;
+    return hash;
+}
+
+static void flush_dll_search_dir( struct dll_search_dir *search_dir )
+{
+    rb_destroy( &search_dir->missing, free_dll_search_name, NULL );
+    search_dir->missing_count = 0;
+}
+
+static void free_dll_search_dir( struct dll_search_dir *search_dir )
+{
+    struct dll_search_dir **bucket = &dll_search_dir_hash[search_dir->hash % DLL_SEARCH_DIR_HASH_SIZE];
+
+    while (*bucket != search_dir) bucket = &(*bucket)->next;
+    *bucket = search_dir->next;
+    list_remove( &search_dir->entry );
+    dll_search_dir_count--;
+    flush_dll_search_dir( search_dir );
+    RtlFreeHeap( GetProcessHeap(), 0, search_dir );
+}
+
+static LONGLONG get_dll_search_dir_write_time( const WCHAR *dir )
+{
+    FILE_BASIC_INFORMATION info;
+    OBJECT_ATTRIBUTES attr;
+    UNICODE_STRING nt_name;
+    NTSTATUS status;
+
+    if (RtlDosPathNameToNtPathName_U_WithStatus( dir, &nt_name, NULL, NULL )) return -1;
+    InitializeObjectAttributes( &attr, &nt_name, OBJ_CASE_INSENSITIVE, 0, NULL );
+    status = NtQueryAttributesFile( &attr, &info );
+    RtlFreeUnicodeString( &nt_name );
+    return status ? -1 : info.LastWriteTime.QuadPart;
+}
+
+static void update_dll_search_dir( struct dll_search_dir *search_dir )
+{
+    LARGE_INTEGER now;
+    LONGLONG write_time = get_dll_search_dir_write_time( search_dir->name );
+
+    if (write_time != search_dir->write_time.QuadPart && search_dir->missing_count)
+    {
+        TRACE( "%s changed, flushing cached names\n", debugstr_w(search_dir->name) );
+        flush_dll_search_dir( search_dir );
+    }
+    search_dir->write_time.QuadPart = write_time;
+    /* a missing directory stays stable, its creation changes the write time */
+    NtQuerySystemTime( &now );
+    search_dir->stable = write_time == -1 || write_time < now.QuadPart - DLL_SEARCH_DIR_STABLE_TIME;
+}
+
+
+/***********************************************************************
+ *	get_dll_search_dir
+ *
+ * Get the missing dlls cache of an absolute search path directory.
+ * The cache is flushed whenever the write time of the directory changes,
+ * which is checked once per top-level load, so that dlls created after a
+ * failed search are found by the next LdrLoadDll call. Names are not cached
+ * while the directory was modified in the last two seconds.
+ * The loader_section must be locked while calling this function.
+ */
+static struct dll_search_dir *get_dll_search_dir( const WCHAR *dir, ULONG len )
+{
+    struct dll_search_dir *search_dir;
+    DWORD hash;
+
+    switch (RtlDetermineDosPathNameType_U( dir ))
+    {
+    case ABSOLUTE_DRIVE_PATH:
+    case UNC_PATH:
+        break;
+    default:  /* relative to the current directory */
+        return NULL;
+    }
+
+    hash = hash_dll_search_dir( dir, len );
+    for (search_dir = dll_search_dir_hash[hash % DLL_SEARCH_DIR_HASH_SIZE]; search_dir; search_dir = search_dir->next)
+    {
+        if (search_dir->hash != hash || wcsnicmp( search_dir->name, dir, len ) || search_dir->name[len]) continue;
+        list_remove( &search_dir->entry );
+        list_add_head( &dll_search_dir_lru, &search_dir->entry );
+        if (search_dir->generation == dll_search_generation) return search_dir;
+
+        search_dir->generation = dll_search_generation;
+        update_dll_search_dir( search_dir );
+        return search_dir;
+    }
+
+    if (dll_search_dir_count >= DLL_SEARCH_DIR_MAX)
+        free_dll_search_dir( LIST_ENTRY( list_tail( &dll_search_dir_lru ), struct dll_search_dir, entry ));
+
+    if (!(search_dir = RtlAllocateHeap( GetProcessHeap(), 0, offsetof( struct dll_search_dir, name[len + 1] ))))
+        return NULL;
+    search_dir->hash = hash;
+    search_dir->generation = dll_search_generation;
+    rb_init( &search_dir->missing, compare_dll_search_names );
+    search_dir->missing_count = 0;
+    memcpy( search_dir->name, dir, len * sizeof(WCHAR) );
+    search_dir->name[len] = 0;
+    search_dir->write_time.QuadPart = -1;
+    update_dll_search_dir( search_dir );
+    search_dir->next = dll_search_dir_hash[hash % DLL_SEARCH_DIR_HASH_SIZE];
+    dll_search_dir_hash[hash % DLL_SEARCH_DIR_HASH_SIZE] = search_dir;
+    list_add_head( &dll_search_dir_lru, &search_dir->entry );
+    dll_search_dir_count++;
+    return search_dir;
+}
+
+
+/***********************************************************************
+ *	add_dll_search_name
+ *
+ * Remember that a dll is missing from a search path directory.
+ * The loader_section must be locked while calling this function.
+ */
+static void add_dll_search_name( struct dll_search_dir *search_dir, const WCHAR *name )
+{
+    struct dll_search_name *search_name;
+    ULONG len = wcslen( name ) + 1;
+
+    if (search_dir->missing_count >= DLL_SEARCH_NAME_MAX) flush_dll_search_dir( search_dir );
+
+    if (!(search_name = RtlAllocateHeap( GetProcessHeap(), 0, offsetof( struct dll_search_name, name[len] ))))
+        return;
+    memcpy( search_name->name, name, len * sizeof(WCHAR) );
+    if (rb_put( &search_dir->missing, search_name->name, &search_name->entry ))
+        RtlFreeHeap( GetProcessHeap(), 0, search_name );
+    else
+        search_dir->missing_count++;
+}
+
+
 /***********************************************************************
  *	search_dll_file
  *
@@ -3189,8 +3536,9 @@ static NTSTATUS search_dll_file( LPCWSTR paths, LPCWSTR search, UNICODE_STRING *
                                  WINE_MODREF **pwm, HANDLE *mapping, SECTION_IMAGE_INFORMATION *image_info,
                                  struct file_id *id )
 {
+    struct dll_search_dir *search_dir;
     WCHAR *name;
-    BOOL found_image = FALSE;
+    BOOL found_image = FALSE, use_cache = !wcschr( search, '\\' ) && !wcschr( search, '/' );
     NTSTATUS status = STATUS_DLL_NOT_FOUND;
     ULONG len;
 
@@ -3211,22 +3559,36 @@ static NTSTATUS search_dll_file( LPCWSTR paths, LPCWSTR search, UNICODE_STRING *
         len = ptr - paths;
         if (*ptr == ';') ptr++;
         memcpy( name, paths, len * sizeof(WCHAR) );
+        name[len] = 0;
+        paths = ptr;
+
+        search_dir = use_cache && len ? get_dll_search_dir( name, len ) : NULL;
+        if (search_dir && rb_get( &search_dir->missing, search ))
+        {
+            dll_search_skipped++;
+            status = STATUS_DLL_NOT_FOUND;
+            continue;
+        }
+
         if (len && name[len - 1] != '\\') name[len++] = '\\';
         wcscpy( name + len, search );
 
         nt_name->Buffer = NULL;
         if ((status = RtlDosPathNameToNtPathName_U_WithStatus( name, nt_name, NULL, NULL ))) goto done;
 
+        dll_search_probes++;
         status = open_dll_file( nt_name, pwm, mapping, image_info, id );
         if (status == STATUS_NOT_SUPPORTED) found_image = TRUE;
         else if (status != STATUS_DLL_NOT_FOUND) goto done;
+        else if (search_dir && search_dir->stable) add_dll_search_name( search_dir, search );
         RtlFreeUnicodeString( nt_name );
-        paths = ptr;
     }
 
     if (found_image) status = STATUS_NOT_SUPPORTED;
 
 done:
+    TRACE( "%s: %u probes, %u skipped as missing so far\n",
+           debugstr_w(search), dll_search_probes, dll_search_skipped );
     RtlFreeHeap( GetProcessHeap(), 0, name );
     return status;
 }
@@ -3505,6 +3867,8 @@ NTSTATUS WINAPI DECLSPEC_HOTPATCH LdrLoadDll(LPCWSTR path_name, DWORD flags,
 
     RtlEnterCriticalSection( &loader_section );
 
+    /* search directories changes are checked again once per load */
+    dll_search_generation++;
     nts = load_dll( path_name, dllname ? dllname : libname->Buffer, flags, &wm, FALSE );
 
     if (nts == STATUS_SUCCESS && !(wm->ldr.Flags & LDR_DONT_RESOLVE_REFS))
@@ -4074,9 +4438,11 @@ static void free_modref( WINE_MODREF *wm )
 
     free_tls_slot( &wm->ldr );
     RtlReleaseActivationContext( wm->ldr.ActivationContext );
+    if (wm->export_index) set_export_index_slot( wm->ldr.DllBase, NULL );
     NtUnmapViewOfSection( NtCurrentProcess(), wm->ldr.DllBase );
     if (cached_modref == wm) cached_modref = NULL;
     RtlFreeUnicodeString( &wm->ldr.FullDllName );
+    RtlFreeHeap( GetProcessHeap(), 0, wm->export_index );
     RtlFreeHeap( GetProcessHeap(), 0, wm );
 }
 
@@ -4432,6 +4798,34 @@ static void release_address_space(void)
 #endif
 }
 
+/***********************************************************************
+ *           uring_thread_proc
+ *
+ * Entry point of the thread reaping io_uring completions.
+ */
+static void CALLBACK uring_thread_proc( void *arg )
+{
+    RtlExitUserThread( WINE_UNIX_CALL( unix_uring_thread, arg ));
+}
+
+
+/***********************************************************************
+ *           start_uring_thread
+ *
+ * Start the io_uring completion thread if asynchronous file I/O is enabled.
+ */
+static void start_uring_thread(void)
+{
+    HANDLE thread;
+
+    if (NtCurrentTeb()->WowTebOffset) return;
+    if (WINE_UNIX_CALL( unix_uring_init, NULL )) return;
+    if (!NtCreateThreadEx( &thread, THREAD_ALL_ACCESS, NULL, GetCurrentProcess(), uring_thread_proc, NULL,
+                           THREAD_CREATE_FLAGS_SKIP_THREAD_ATTACH | THREAD_CREATE_FLAGS_HIDE_FROM_DEBUGGER,
+                           0, 0, 0, NULL ))
+        NtClose( thread );
+}
+
 /******************************************************************
  *		loader_init
  *
@@ -4539,6 +4933,7 @@ void loader_init( CONTEXT *context, void **entry )
     if (!attach_done)  /* first time around */
     {
         attach_done = 1;
+        start_uring_thread();
         if ((status = alloc_thread_tls()) != STATUS_SUCCESS)
         {
             ERR( "TLS init  failed when loading %s, status %lx\n",
@@ -142,6 +142,7 @@ static NTSTATUS (WINAPI * pNtQueryKey)(HANDLE,KEY_INFORMATION_CLASS,PVOID,ULONG,
 static NTSTATUS (WINAPI * pNtQueryLicenseValue)(const UNICODE_STRING *,ULONG *,PVOID,ULONG,ULONG *);
 static NTSTATUS (WINAPI * pNtQueryObject)(HANDLE, OBJECT_INFORMATION_CLASS, void *, ULONG, ULONG *);
 static NTSTATUS (WINAPI * pNtQueryValueKey)(HANDLE,const UNICODE_STRING *,KEY_VALUE_INFORMATION_CLASS,void *,DWORD,DWORD *);
+static NTSTATUS (WINAPI * pNtQueryMultipleValueKey)(HANDLE,KEY_MULTIPLE_VALUE_INFORMATION *,ULONG,void *,ULONG,ULONG *);
 static NTSTATUS (WINAPI * pNtSetValueKey)(HANDLE, const PUNICODE_STRING, ULONG,
                                ULONG, const void*, ULONG  );
 static NTSTATUS (WINAPI * pRtlFormatCurrentUserKeyPath)(PUNICODE_STRING);
@@ -197,6 +198,7 @@ static BOOL InitFunctionPtrs(void)
     NTDLL_GET_PROC(NtQueryKey)
     NTDLL_GET_PROC(NtQueryObject)
     NTDLL_GET_PROC(NtQueryValueKey)
+    NTDLL_GET_PROC(NtQueryMultipleValueKey)
     NTDLL_GET_PROC(NtSetValueKey)
     NTDLL_GET_PROC(NtOpenKey)
     NTDLL_GET_PROC(NtNotifyChangeKey)
@@ -927,6 +929,84 @@ static void test_NtQueryValueKey(void)
     pNtClose(key);
 }
 
+static void test_NtQueryMultipleValueKey(void)
+{
+    KEY_MULTIPLE_VALUE_INFORMATION info[3];
+    UNICODE_STRING names[3], missing;
+    OBJECT_ATTRIBUTES attr;
+    ULONG len, expected, end;
+    char buffer[256];
+    NTSTATUS status;
+    HANDLE key;
+    UINT i;
+
+    InitializeObjectAttributes(&attr, &winetestpath, 0, 0, 0);
+    status = pNtOpenKey(&key, KEY_READ, &attr);
+    ok(status == STATUS_SUCCESS, "NtOpenKey Failed: 0x%08lx\n", status);
+
+    pRtlInitUnicodeString(&names[0], L"deletetest");
+    pRtlInitUnicodeString(&names[1], L"custtest");
+    pRtlInitUnicodeString(&names[2], L"stringtest");
+    for (i = 0; i < ARRAY_SIZE(info); i++)
+    {
+        info[i].ValueName = &names[i];
+        info[i].DataLength = info[i].DataOffset = info[i].Type = 0xdeadbeef;
+    }
+
+    memset(buffer, 0xcc, sizeof(buffer));
+    len = 0xdeadbeef;
+    status = pNtQueryMultipleValueKey(key, info, ARRAY_SIZE(info), buffer, sizeof(buffer), &len);
+    ok(status == STATUS_SUCCESS, "got %#lx\n", status);
+    ok(info[0].Type == REG_DWORD, "got type %lu\n", info[0].Type);
+    ok(info[0].DataLength == sizeof(DWORD), "got length %lu\n", info[0].DataLength);
+    ok(info[1].Type == 0xff00ff00, "got type %#lx\n", info[1].Type);
+    ok(info[1].DataLength == 0, "got length %lu\n", info[1].DataLength);
+    ok(info[2].Type == REG_SZ, "got type %lu\n", info[2].Type);
+    ok(info[2].DataLength == STR_TRUNC_SIZE, "got length %lu\n", info[2].DataLength);
+    for (i = end = 0; i < ARRAY_SIZE(info); i++)
+    {
+        ok(info[i].DataOffset >= end, "%u: got offset %lu, previous value ends at %lu\n", i, info[i].DataOffset, end);
+        end = info[i].DataOffset + info[i].DataLength;
+    }
+    ok(len >= end && len < end + sizeof(ULONG_PTR), "got len %lu, data ends at %lu\n", len, end);
+    ok(*(DWORD *)(buffer + info[0].DataOffset) == 711, "got %#lx\n", *(DWORD *)(buffer + info[0].DataOffset));
+    ok(!memcmp(buffer + info[2].DataOffset, stringW, STR_TRUNC_SIZE), "got wrong string data\n");
+    expected = len;
+
+    len = 0xdeadbeef;
+    status = pNtQueryMultipleValueKey(key, info, ARRAY_SIZE(info), buffer, end - 1, &len);
+    ok(status == STATUS_BUFFER_OVERFLOW, "got %#lx\n", status);
+    ok(len == expected, "got len %lu, expected %lu\n", len, expected);
+
+    len = 0xdeadbeef;
+    status = pNtQueryMultipleValueKey(key, info, ARRAY_SIZE(info), NULL, 0, &len);
+    ok(status == STATUS_BUFFER_OVERFLOW, "got %#lx\n", status);
+    ok(len == expected, "got len %lu, expected %lu\n", len, expected);
+
+    len = 0xdeadbeef;
+    status = pNtQueryMultipleValueKey(key, info, 1, buffer, sizeof(buffer), &len);
+    ok(status == STATUS_SUCCESS, "got %#lx\n", status);
+    ok(info[0].DataOffset + sizeof(DWORD) <= len && len < info[0].DataOffset + sizeof(DWORD) + sizeof(ULONG_PTR),
+       "got len %lu, offset %lu\n", len, info[0].DataOffset);
+    ok(*(DWORD *)(buffer + info[0].DataOffset) == 711, "got %#lx\n", *(DWORD *)(buffer + info[0].DataOffset));
+
+    status = pNtQueryMultipleValueKey(key, info, 1, buffer, sizeof(buffer), NULL);
+    ok(status == STATUS_SUCCESS, "got %#lx\n", status);
+    ok(*(DWORD *)(buffer + info[0].DataOffset) == 711, "got %#lx\n", *(DWORD *)(buffer + info[0].DataOffset));
+
+    len = 0xdeadbeef;
+    status = pNtQueryMultipleValueKey(key, info, 0, buffer, sizeof(buffer), &len);
+    ok(status == STATUS_SUCCESS, "got %#lx\n", status);
+    ok(!len, "got len %lu\n", len);
+
+    pRtlInitUnicodeString(&missing, L"missingtest");
+    info[1].ValueName = &missing;
+    status = pNtQueryMultipleValueKey(key, info, ARRAY_SIZE(info), buffer, sizeof(buffer), &len);
+    ok(status == STATUS_OBJECT_NAME_NOT_FOUND, "got %#lx\n", status);
+
+    pNtClose(key);
+}
+
 static void test_NtDeleteKey(void)
 {
     UNICODE_STRING string;
@@ -2680,6 +2760,7 @@ START_TEST(reg)
     test_NtQueryKey();
     test_NtQueryLicenseKey();
     test_NtQueryValueKey();
+    test_NtQueryMultipleValueKey();
     test_long_value_name();
     test_notify();
     test_RtlCreateRegistryKey();
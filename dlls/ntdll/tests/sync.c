@@ -529,6 +529,141 @@ static void test_semaphore(void)
     NtClose( semaphore );
 }
 
+struct wait_multiple_args
+{
+    HANDLE objs[2];
+    BOOL all;
+};
+
+static DWORD WINAPI wait_multiple_thread( void *arg )
+{
+    struct wait_multiple_args *args = arg;
+
+    return WaitForMultipleObjects( 2, args->objs, args->all, 5000 );
+}
+
+static void test_wait_multiple(void)
+{
+    struct wait_multiple_args args;
+    EVENT_BASIC_INFORMATION event_info;
+    SEMAPHORE_BASIC_INFORMATION sem_info;
+    HANDLE event, semaphore, mutant, thread, objs[2];
+    NTSTATUS status;
+    DWORD ret;
+    LONG prev;
+
+    status = pNtCreateEvent( &event, EVENT_ALL_ACCESS, NULL, SynchronizationEvent, FALSE );
+    ok( status == STATUS_SUCCESS, "NtCreateEvent failed %08lx\n", status );
+    status = pNtCreateSemaphore( &semaphore, GENERIC_ALL, NULL, 0, 2 );
+    ok( status == STATUS_SUCCESS, "NtCreateSemaphore failed %08lx\n", status );
+    status = pNtCreateMutant( &mutant, GENERIC_ALL, NULL, FALSE );
+    ok( status == STATUS_SUCCESS, "NtCreateMutant failed %08lx\n", status );
+
+    objs[0] = event;
+    objs[1] = semaphore;
+    ret = WaitForMultipleObjects( 2, objs, FALSE, 0 );
+    ok( ret == WAIT_TIMEOUT, "got %lu\n", ret );
+
+    status = pNtReleaseSemaphore( semaphore, 1, NULL );
+    ok( status == STATUS_SUCCESS, "NtReleaseSemaphore failed %08lx\n", status );
+    ret = WaitForMultipleObjects( 2, objs, FALSE, 0 );
+    ok( ret == 1, "got %lu\n", ret );
+
+    /* the first signaled object is acquired, and only that one */
+    status = pNtSetEvent( event, NULL );
+    ok( status == STATUS_SUCCESS, "NtSetEvent failed %08lx\n", status );
+    status = pNtReleaseSemaphore( semaphore, 1, NULL );
+    ok( status == STATUS_SUCCESS, "NtReleaseSemaphore failed %08lx\n", status );
+    ret = WaitForMultipleObjects( 2, objs, FALSE, 0 );
+    ok( ret == 0, "got %lu\n", ret );
+    ret = WaitForMultipleObjects( 2, objs, FALSE, 0 );
+    ok( ret == 1, "got %lu\n", ret );
+    ret = WaitForMultipleObjects( 2, objs, FALSE, 0 );
+    ok( ret == WAIT_TIMEOUT, "got %lu\n", ret );
+
+    /* wait-all doesn't consume anything until all the objects are signaled */
+    status = pNtSetEvent( event, NULL );
+    ok( status == STATUS_SUCCESS, "NtSetEvent failed %08lx\n", status );
+    ret = WaitForMultipleObjects( 2, objs, TRUE, 0 );
+    ok( ret == WAIT_TIMEOUT, "got %lu\n", ret );
+    status = pNtQueryEvent( event, EventBasicInformation, &event_info, sizeof(event_info), NULL );
+    ok( status == STATUS_SUCCESS, "NtQueryEvent failed %08lx\n", status );
+    ok( event_info.EventState == 1, "got state %ld\n", event_info.EventState );
+
+    status = pNtReleaseSemaphore( semaphore, 2, NULL );
+    ok( status == STATUS_SUCCESS, "NtReleaseSemaphore failed %08lx\n", status );
+    ret = WaitForMultipleObjects( 2, objs, TRUE, 0 );
+    ok( ret == 0, "got %lu\n", ret );
+    status = pNtQueryEvent( event, EventBasicInformation, &event_info, sizeof(event_info), NULL );
+    ok( status == STATUS_SUCCESS, "NtQueryEvent failed %08lx\n", status );
+    ok( event_info.EventState == 0, "got state %ld\n", event_info.EventState );
+    status = pNtQuerySemaphore( semaphore, SemaphoreBasicInformation, &sem_info, sizeof(sem_info), NULL );
+    ok( status == STATUS_SUCCESS, "NtQuerySemaphore failed %08lx\n", status );
+    ok( sem_info.CurrentCount == 1, "got count %ld\n", sem_info.CurrentCount );
+    ret = WaitForSingleObject( semaphore, 0 );
+    ok( ret == WAIT_OBJECT_0, "got %lu\n", ret );
+
+    /* signaling an object wakes a waiter in another thread */
+    args.objs[0] = event;
+    args.objs[1] = semaphore;
+    args.all = FALSE;
+    thread = CreateThread( NULL, 0, wait_multiple_thread, &args, 0, NULL );
+    ret = WaitForSingleObject( thread, 100 );
+    ok( ret == WAIT_TIMEOUT, "got %lu\n", ret );
+    status = pNtSetEvent( event, NULL );
+    ok( status == STATUS_SUCCESS, "NtSetEvent failed %08lx\n", status );
+    ret = WaitForSingleObject( thread, 1000 );
+    ok( ret == WAIT_OBJECT_0, "got %lu\n", ret );
+    GetExitCodeThread( thread, &ret );
+    ok( ret == 0, "got %lu\n", ret );
+    CloseHandle( thread );
+    ret = WaitForSingleObject( event, 0 );
+    ok( ret == WAIT_TIMEOUT, "got %lu\n", ret );
+
+    /* a wait-all waiter only takes the event once the mutant is released */
+    ret = WaitForSingleObject( mutant, 0 );
+    ok( ret == WAIT_OBJECT_0, "got %lu\n", ret );
+    args.objs[1] = mutant;
+    args.all = TRUE;
+    thread = CreateThread( NULL, 0, wait_multiple_thread, &args, 0, NULL );
+    status = pNtSetEvent( event, NULL );
+    ok( status == STATUS_SUCCESS, "NtSetEvent failed %08lx\n", status );
+    ret = WaitForSingleObject( thread, 100 );
+    ok( ret == WAIT_TIMEOUT, "got %lu\n", ret );
+    status = pNtQueryEvent( event, EventBasicInformation, &event_info, sizeof(event_info), NULL );
+    ok( status == STATUS_SUCCESS, "NtQueryEvent failed %08lx\n", status );
+    ok( event_info.EventState == 1, "got state %ld\n", event_info.EventState );
+
+    prev = 0xdeadbeef;
+    status = pNtReleaseMutant( mutant, &prev );
+    ok( status == STATUS_SUCCESS, "NtReleaseMutant failed %08lx\n", status );
+    ok( prev == 0, "got %ld\n", prev );
+    ret = WaitForSingleObject( thread, 1000 );
+    ok( ret == WAIT_OBJECT_0, "got %lu\n", ret );
+    GetExitCodeThread( thread, &ret );
+    ok( ret == 0, "got %lu\n", ret );
+    CloseHandle( thread );
+    ret = WaitForSingleObject( event, 0 );
+    ok( ret == WAIT_TIMEOUT, "got %lu\n", ret );
+
+    /* the thread exited owning the mutant */
+    ret = WaitForSingleObject( mutant, 0 );
+    ok( ret == WAIT_ABANDONED_0, "got %lu\n", ret );
+    ret = WaitForSingleObject( mutant, 0 );
+    ok( ret == WAIT_OBJECT_0, "got %lu\n", ret );
+    prev = 0xdeadbeef;
+    status = pNtReleaseMutant( mutant, &prev );
+    ok( status == STATUS_SUCCESS, "NtReleaseMutant failed %08lx\n", status );
+    ok( prev == -1, "got %ld\n", prev );
+    status = pNtReleaseMutant( mutant, &prev );
+    ok( status == STATUS_SUCCESS, "NtReleaseMutant failed %08lx\n", status );
+    ok( prev == 0, "got %ld\n", prev );
+
+    NtClose( mutant );
+    NtClose( semaphore );
+    NtClose( event );
+}
+
 static void test_wait_on_address(void)
 {
     SIZE_T size;
@@ -901,6 +1036,204 @@ static void test_close_io_completion(void)
     CloseHandle( thread );
 }
 
+static LONG iocp_tokens;
+
+struct iocp_worker
+{
+    HANDLE       port;
+    unsigned int workers;
+    unsigned int count;
+};
+
+static DWORD WINAPI iocp_worker_proc( void *param )
+{
+    struct iocp_worker *worker = param;
+    IO_STATUS_BLOCK iosb;
+    ULONG_PTR key, value;
+    NTSTATUS status;
+    unsigned int i;
+
+    for (;;)
+    {
+        status = NtRemoveIoCompletion( worker->port, &key, &value, &iosb, NULL );
+        if (status || !key) break;
+        worker->count++;
+
+        /* pass the token on until it expires, the last one stops the workers */
+        if (value > 1) status = NtSetIoCompletion( worker->port, key, value - 1, STATUS_SUCCESS, 0 );
+        else if (!InterlockedDecrement( &iocp_tokens ))
+        {
+            for (i = 0; i < worker->workers; i++)
+                NtSetIoCompletion( worker->port, 0, 0, STATUS_SUCCESS, 0 );
+        }
+        if (status) break;
+    }
+    ok( !status, "got %#lx\n", status );
+    return 0;
+}
+
+static void test_io_completion_throughput(void)
+{
+    static const unsigned int tokens = 16, passes = 1000;
+    struct iocp_worker workers[8];
+    LARGE_INTEGER freq, start, end;
+    unsigned int i, count, nb_workers;
+    HANDLE threads[8], port;
+    NTSTATUS status;
+
+    QueryPerformanceFrequency( &freq );
+
+    for (nb_workers = 1; nb_workers <= ARRAY_SIZE(threads); nb_workers *= 2)
+    {
+        status = NtCreateIoCompletion( &port, IO_COMPLETION_ALL_ACCESS, NULL, 0 );
+        ok( !status, "got %#lx\n", status );
+
+        for (i = 0; i < nb_workers; i++)
+        {
+            workers[i].port = port;
+            workers[i].workers = nb_workers;
+            workers[i].count = 0;
+            threads[i] = CreateThread( NULL, 0, iocp_worker_proc, &workers[i], 0, NULL );
+            ok( !!threads[i], "failed to create thread, error %lu\n", GetLastError() );
+        }
+
+        QueryPerformanceCounter( &start );
+        iocp_tokens = tokens;
+        for (i = 0; i < tokens; i++)
+        {
+            status = NtSetIoCompletion( port, 1, passes, STATUS_SUCCESS, 0 );
+            ok( !status, "got %#lx\n", status );
+        }
+        WaitForMultipleObjects( nb_workers, threads, TRUE, INFINITE );
+        QueryPerformanceCounter( &end );
+
+        for (i = count = 0; i < nb_workers; i++)
+        {
+            count += workers[i].count;
+            CloseHandle( threads[i] );
+        }
+        ok( count == tokens * passes, "got %u completions\n", count );
+        trace( "%u workers: %.0f completions/s\n", nb_workers,
+               count * (double)freq.QuadPart / (end.QuadPart - start.QuadPart) );
+
+        NtClose( port );
+    }
+}
+
+struct sync_ping_pong
+{
+    HANDLE ping, pong;
+    unsigned int count;
+};
+
+static DWORD WINAPI sync_pong_proc( void *param )
+{
+    struct sync_ping_pong *args = param;
+    unsigned int i;
+
+    for (i = 0; i < args->count; i++)
+    {
+        WaitForSingleObject( args->ping, INFINITE );
+        pNtSetEvent( args->pong, NULL );
+    }
+    return 0;
+}
+
+static double sync_elapsed_ns( const LARGE_INTEGER *start, unsigned int count )
+{
+    LARGE_INTEGER freq, end;
+
+    QueryPerformanceCounter( &end );
+    QueryPerformanceFrequency( &freq );
+    return (end.QuadPart - start->QuadPart) * 1e9 / freq.QuadPart / count;
+}
+
+/* Traces the latency of common wait and signal operations. Compare the
+ * synchronization backends by running it with and without WINEESYNC or
+ * WINEFSYNC set, as the backend can't be changed within a wineserver. */
+static void benchmark_sync_latency(void)
+{
+    static const unsigned int count = 100000, round_trips = 20000;
+    struct sync_ping_pong args;
+    HANDLE event, semaphore, mutant, thread, events[8];
+    LARGE_INTEGER start;
+    unsigned int i;
+    NTSTATUS status;
+    DWORD ret;
+
+    status = pNtCreateEvent( &event, EVENT_ALL_ACCESS, NULL, SynchronizationEvent, FALSE );
+    ok( status == STATUS_SUCCESS, "NtCreateEvent failed %08lx\n", status );
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++)
+    {
+        pNtSetEvent( event, NULL );
+        ret = WaitForSingleObject( event, 0 );
+        ok( ret == WAIT_OBJECT_0, "got %lu\n", ret );
+    }
+    trace( "event set and wait: %.0f ns\n", sync_elapsed_ns( &start, count ) );
+
+    status = pNtCreateSemaphore( &semaphore, GENERIC_ALL, NULL, 0, 1 );
+    ok( status == STATUS_SUCCESS, "NtCreateSemaphore failed %08lx\n", status );
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++)
+    {
+        pNtReleaseSemaphore( semaphore, 1, NULL );
+        ret = WaitForSingleObject( semaphore, 0 );
+        ok( ret == WAIT_OBJECT_0, "got %lu\n", ret );
+    }
+    trace( "semaphore release and wait: %.0f ns\n", sync_elapsed_ns( &start, count ) );
+
+    status = pNtCreateMutant( &mutant, GENERIC_ALL, NULL, FALSE );
+    ok( status == STATUS_SUCCESS, "NtCreateMutant failed %08lx\n", status );
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++)
+    {
+        ret = WaitForSingleObject( mutant, 0 );
+        ok( ret == WAIT_OBJECT_0, "got %lu\n", ret );
+        pNtReleaseMutant( mutant, NULL );
+    }
+    trace( "mutant wait and release: %.0f ns\n", sync_elapsed_ns( &start, count ) );
+
+    for (i = 0; i < ARRAY_SIZE(events); i++)
+    {
+        status = pNtCreateEvent( &events[i], EVENT_ALL_ACCESS, NULL, SynchronizationEvent, FALSE );
+        ok( status == STATUS_SUCCESS, "NtCreateEvent failed %08lx\n", status );
+    }
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++)
+    {
+        pNtSetEvent( events[ARRAY_SIZE(events) - 1], NULL );
+        ret = WaitForMultipleObjects( ARRAY_SIZE(events), events, FALSE, 0 );
+        ok( ret == ARRAY_SIZE(events) - 1, "got %lu\n", ret );
+    }
+    trace( "wait for any of %u events: %.0f ns\n", (unsigned int)ARRAY_SIZE(events),
+           sync_elapsed_ns( &start, count ) );
+
+    /* wake up another thread and wait for it to answer */
+    args.ping = event;
+    args.count = round_trips;
+    status = pNtCreateEvent( &args.pong, EVENT_ALL_ACCESS, NULL, SynchronizationEvent, FALSE );
+    ok( status == STATUS_SUCCESS, "NtCreateEvent failed %08lx\n", status );
+    thread = CreateThread( NULL, 0, sync_pong_proc, &args, 0, NULL );
+    ok( !!thread, "failed to create thread, error %lu\n", GetLastError() );
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < round_trips; i++)
+    {
+        pNtSetEvent( args.ping, NULL );
+        ret = WaitForSingleObject( args.pong, INFINITE );
+        ok( ret == WAIT_OBJECT_0, "got %lu\n", ret );
+    }
+    trace( "cross-thread round trip: %.0f ns\n", sync_elapsed_ns( &start, round_trips ) );
+    WaitForSingleObject( thread, INFINITE );
+    CloseHandle( thread );
+
+    for (i = 0; i < ARRAY_SIZE(events); i++) NtClose( events[i] );
+    NtClose( args.pong );
+    NtClose( mutant );
+    NtClose( semaphore );
+    NtClose( event );
+}
+
 START_TEST(sync)
 {
     HMODULE module = GetModuleHandleA("ntdll.dll");
@@ -945,8 +1278,11 @@ START_TEST(sync)
     test_event();
     test_mutant();
     test_semaphore();
+    test_wait_multiple();
     test_keyed_events();
     test_resource();
     test_tid_alert( argv );
     test_close_io_completion();
+    if (winetest_interactive) test_io_completion_throughput();
+    if (winetest_interactive) benchmark_sync_latency();
 }
@@ -2387,6 +2387,188 @@ static void test_kernel32_tp_io(void)
     pTpReleasePool(pool);
 }
 
+#define STEAL_TASKS 1024
+
+struct steal_test
+{
+    TP_CALLBACK_ENVIRON_V3 environment;
+    LONG runs[2 * STEAL_TASKS];
+    LONG count;
+    LONG failures;
+    HANDLE done;
+};
+
+static struct steal_test *steal_test;
+
+static void CALLBACK steal_child_cb(TP_CALLBACK_INSTANCE *instance, void *userdata)
+{
+    InterlockedIncrement(&steal_test->runs[(ULONG_PTR)userdata]);
+    if (InterlockedIncrement(&steal_test->count) == ARRAY_SIZE(steal_test->runs))
+        SetEvent(steal_test->done);
+}
+
+static void CALLBACK steal_cb(TP_CALLBACK_INSTANCE *instance, void *userdata)
+{
+    ULONG_PTR index = (ULONG_PTR)userdata;
+
+    /* tasks posted from a worker thread go to the queue of that thread */
+    if (pTpSimpleTryPost(steal_child_cb, (void *)(index + STEAL_TASKS),
+                         (TP_CALLBACK_ENVIRON *)&steal_test->environment))
+        InterlockedIncrement(&steal_test->failures);
+    steal_child_cb(instance, userdata);
+}
+
+static DWORD CALLBACK steal_poster_proc(void *param)
+{
+    TP_CALLBACK_ENVIRON_V3 environment = steal_test->environment;
+    ULONG_PTR i;
+
+    for (i = (ULONG_PTR)param; i < STEAL_TASKS; i += 2)
+    {
+        environment.CallbackPriority = TP_CALLBACK_PRIORITY_HIGH + i % 3;
+        if (pTpSimpleTryPost(steal_cb, (void *)i, (TP_CALLBACK_ENVIRON *)&environment))
+            InterlockedIncrement(&steal_test->failures);
+    }
+    return 0;
+}
+
+static void test_tp_task_steal(void)
+{
+    struct steal_test test;
+    HANDLE threads[2];
+    unsigned int i;
+    NTSTATUS status;
+    TP_POOL *pool;
+    DWORD result;
+
+    /* all tasks of a poster go to the same queue, and idle worker threads have to
+     * steal them from there; every task must still run exactly once */
+    memset(&test, 0, sizeof(test));
+    test.done = CreateEventW(NULL, FALSE, FALSE, NULL);
+    ok(test.done != NULL, "CreateEvent failed with %lu\n", GetLastError());
+    steal_test = &test;
+
+    pool = NULL;
+    status = pTpAllocPool(&pool, NULL);
+    ok(!status, "TpAllocPool failed with status %lx\n", status);
+    ok(pool != NULL, "expected pool != NULL\n");
+    pTpSetPoolMaxThreads(pool, 4);
+
+    test.environment.Version = 3;
+    test.environment.Pool = pool;
+    test.environment.Size = sizeof(test.environment);
+
+    for (i = 0; i < ARRAY_SIZE(threads); i++)
+    {
+        threads[i] = CreateThread(NULL, 0, steal_poster_proc, (void *)(ULONG_PTR)i, 0, NULL);
+        ok(threads[i] != NULL, "CreateThread failed with %lu\n", GetLastError());
+    }
+    WaitForMultipleObjects(ARRAY_SIZE(threads), threads, TRUE, INFINITE);
+    for (i = 0; i < ARRAY_SIZE(threads); i++) CloseHandle(threads[i]);
+
+    result = WaitForSingleObject(test.done, 10000);
+    ok(result == WAIT_OBJECT_0, "WaitForSingleObject returned %lu\n", result);
+    pTpReleasePool(pool);
+
+    ok(!test.failures, "TpSimpleTryPost failed %lu times\n", test.failures);
+    ok(test.count == 2 * STEAL_TASKS, "expected %u tasks, got %lu\n", 2 * STEAL_TASKS, test.count);
+    for (i = 0; i < ARRAY_SIZE(test.runs); i++)
+        ok(test.runs[i] == 1, "task %u ran %lu times\n", i, test.runs[i]);
+
+    CloseHandle(test.done);
+}
+
+static LONG task_count, task_total;
+static HANDLE task_done_event;
+
+static void CALLBACK task_cb(TP_CALLBACK_INSTANCE *instance, void *userdata)
+{
+    if (InterlockedIncrement(&task_count) == task_total)
+        SetEvent(task_done_event);
+}
+
+struct task_poster
+{
+    TP_CALLBACK_ENVIRON *environment;
+    unsigned int tasks;
+    unsigned int failures;
+};
+
+static DWORD CALLBACK task_poster_proc(void *param)
+{
+    struct task_poster *poster = param;
+    unsigned int i;
+
+    for (i = 0; i < poster->tasks; i++)
+    {
+        if (pTpSimpleTryPost(task_cb, NULL, poster->environment))
+            poster->failures++;
+    }
+    return 0;
+}
+
+static void test_tp_task_throughput(void)
+{
+    static const unsigned int tasks = 20000;
+    LARGE_INTEGER freq, start, end;
+    TP_CALLBACK_ENVIRON environment;
+    struct task_poster posters[8];
+    unsigned int i, nb_posters;
+    HANDLE threads[8];
+    NTSTATUS status;
+    SYSTEM_INFO si;
+    TP_POOL *pool;
+    DWORD result;
+
+    GetSystemInfo(&si);
+    QueryPerformanceFrequency(&freq);
+    task_done_event = CreateEventW(NULL, FALSE, FALSE, NULL);
+    ok(task_done_event != NULL, "CreateEvent failed with %lu\n", GetLastError());
+
+    /* many short callbacks posted from several threads at once */
+    for (nb_posters = 1; nb_posters <= ARRAY_SIZE(threads); nb_posters *= 2)
+    {
+        pool = NULL;
+        status = pTpAllocPool(&pool, NULL);
+        ok(!status, "TpAllocPool failed with status %lx\n", status);
+        ok(pool != NULL, "expected pool != NULL\n");
+        pTpSetPoolMaxThreads(pool, si.dwNumberOfProcessors);
+
+        memset(&environment, 0, sizeof(environment));
+        environment.Version = 1;
+        environment.Pool = pool;
+
+        task_count = 0;
+        task_total = nb_posters * tasks;
+        QueryPerformanceCounter(&start);
+        for (i = 0; i < nb_posters; i++)
+        {
+            posters[i].environment = &environment;
+            posters[i].tasks = tasks;
+            posters[i].failures = 0;
+            threads[i] = CreateThread(NULL, 0, task_poster_proc, &posters[i], 0, NULL);
+            ok(threads[i] != NULL, "CreateThread failed with %lu\n", GetLastError());
+        }
+        WaitForMultipleObjects(nb_posters, threads, TRUE, INFINITE);
+        result = WaitForSingleObject(task_done_event, 30000);
+        QueryPerformanceCounter(&end);
+        ok(result == WAIT_OBJECT_0, "WaitForSingleObject returned %lu\n", result);
+
+        for (i = 0; i < nb_posters; i++)
+        {
+            ok(!posters[i].failures, "TpSimpleTryPost failed %u times\n", posters[i].failures);
+            CloseHandle(threads[i]);
+        }
+        ok(task_count == task_total, "expected %lu tasks, got %lu\n", task_total, task_count);
+        trace("%u posters, %lu threads: %.0f tasks/s\n", nb_posters, si.dwNumberOfProcessors,
+              task_count * (double)freq.QuadPart / (end.QuadPart - start.QuadPart));
+
+        pTpReleasePool(pool);
+    }
+
+    CloseHandle(task_done_event);
+}
+
 START_TEST(threadpool)
 {
     test_RtlQueueWorkItem();
@@ -2408,4 +2590,6 @@ START_TEST(threadpool)
     test_tp_multi_wait();
     test_tp_io();
     test_kernel32_tp_io();
+    test_tp_task_steal();
+    if (winetest_interactive) test_tp_task_throughput();
 }
@@ -2704,6 +2704,105 @@ static void test_query_image_information(void)
     NtClose( file );
 }
 
+struct virtual_bench_thread
+{
+    HANDLE start;
+    unsigned int mode;
+    void *addr;
+};
+
+static DWORD WINAPI virtual_bench_proc( void *arg )
+{
+    struct virtual_bench_thread *params = arg;
+    MEMORY_BASIC_INFORMATION info;
+    SIZE_T size = page_size;
+    NTSTATUS status;
+    unsigned int i;
+    ULONG old_prot;
+    void *addr;
+
+    WaitForSingleObject( params->start, INFINITE );
+    for (i = 0; i < 50000; i++)
+    {
+        switch (params->mode)
+        {
+        case 0:
+            status = NtQueryVirtualMemory( NtCurrentProcess(), params->addr, MemoryBasicInformation,
+                                           &info, sizeof(info), NULL );
+            break;
+        case 1:
+            addr = params->addr;
+            status = NtProtectVirtualMemory( NtCurrentProcess(), &addr, &size,
+                                             (i & 1) ? PAGE_READWRITE : PAGE_READONLY, &old_prot );
+            break;
+        default:
+            addr = NULL;
+            status = NtAllocateVirtualMemory( NtCurrentProcess(), &addr, 0, &size, MEM_COMMIT, PAGE_READWRITE );
+            if (!status)
+            {
+                size = 0;
+                status = NtFreeVirtualMemory( NtCurrentProcess(), &addr, &size, MEM_RELEASE );
+                size = page_size;
+            }
+            break;
+        }
+        if (status) break;
+    }
+    return status;
+}
+
+/* Traces the throughput of threads querying, protecting or allocating memory, which
+ * shows how much the virtual memory lock serializes them as the thread count grows. */
+static void benchmark_virtual_threads(void)
+{
+    static const char *names[] = { "query", "protect", "alloc/free" };
+    struct virtual_bench_thread params[8];
+    HANDLE threads[8], start;
+    LARGE_INTEGER freq, begin, end;
+    unsigned int i, mode, count;
+    NTSTATUS status;
+    SIZE_T size;
+    DWORD code;
+
+    QueryPerformanceFrequency( &freq );
+    for (mode = 0; mode < ARRAY_SIZE(names); mode++)
+    {
+        for (count = 1; count <= ARRAY_SIZE(threads); count *= 2)
+        {
+            start = CreateEventW( NULL, TRUE, FALSE, NULL );
+            for (i = 0; i < count; i++)
+            {
+                params[i].start = start;
+                params[i].mode = mode;
+                params[i].addr = NULL;
+                size = page_size;
+                status = NtAllocateVirtualMemory( NtCurrentProcess(), &params[i].addr, 0, &size,
+                                                  MEM_COMMIT, PAGE_READWRITE );
+                ok( !status, "NtAllocateVirtualMemory returned %08lx\n", status );
+                threads[i] = CreateThread( NULL, 0, virtual_bench_proc, &params[i], 0, NULL );
+                ok( !!threads[i], "CreateThread failed, error %lu\n", GetLastError() );
+            }
+
+            QueryPerformanceCounter( &begin );
+            SetEvent( start );
+            WaitForMultipleObjects( count, threads, TRUE, INFINITE );
+            QueryPerformanceCounter( &end );
+
+            for (i = 0; i < count; i++)
+            {
+                GetExitCodeThread( threads[i], &code );
+                ok( !code, "%s thread failed with %08lx\n", names[mode], code );
+                CloseHandle( threads[i] );
+                size = 0;
+                NtFreeVirtualMemory( NtCurrentProcess(), &params[i].addr, &size, MEM_RELEASE );
+            }
+            trace( "%s, %u threads: %.0f calls/s\n", names[mode], count,
+                   count * 50000 * (double)freq.QuadPart / (end.QuadPart - begin.QuadPart) );
+            CloseHandle( start );
+        }
+    }
+}
+
 START_TEST(virtual)
 {
     HMODULE mod;
@@ -2754,4 +2853,5 @@ START_TEST(virtual)
     test_syscalls();
     test_query_region_information();
     test_query_image_information();
+    if (winetest_interactive) benchmark_virtual_threads();
 }
@@ -99,6 +99,20 @@ struct timer_queue
 #define THREADPOOL_WORKER_TIMEOUT 5000
 #define MAXIMUM_WAITQUEUE_OBJECTS (MAXIMUM_WAIT_OBJECTS - 1)
 
+#define THREADPOOL_MAX_QUEUES 64
+/* number of tasks run from the queues before the pool list gets a turn */
+#define THREADPOOL_TASK_BURST 16
+
+/* Queue of simple and work callbacks. Every thread submits to the queue selected
+ * by its thread id, and worker threads steal from the other queues when their
+ * own queue is empty. Order matches TP_CALLBACK_PRIORITY - high, normal, low. */
+struct threadpool_queue
+{
+    RTL_SRWLOCK             lock;
+    struct list             objects[3];
+    unsigned int            burst;  /* tasks run while the pool list was waiting, only a hint */
+};
+
 /* internal threadpool representation */
 struct threadpool
 {
@@ -112,10 +126,15 @@ struct threadpool
     /* information about worker threads, locked via .cs */
     int                     max_workers;
     int                     min_workers;
-    int                     num_workers;
-    int                     num_busy_workers;
+    LONG                    num_workers;
+    LONG                    num_busy_workers;
+    LONG                    num_idle_workers;
     HANDLE                  compl_port;
     TP_POOL_STACK_INFORMATION stack_info;
+    /* task queues, each locked via its own .lock */
+    LONG                    num_queued[3];
+    unsigned int            num_queues;
+    struct threadpool_queue queues[1];
 };
 
 enum threadpool_objtype
@@ -161,6 +180,9 @@ struct threadpool_object
     LONG                    num_running_callbacks;
     LONG                    num_associated_callbacks;
     LONG                    update_serial;
+    /* information about the task queues, updated atomically */
+    LONG                    queued;
+    LONG                    num_waiters;
     /* arguments for callback */
     union
     {
@@ -1673,10 +1695,11 @@ static NTSTATUS tp_ioqueue_lock( struct threadpool_object *io, HANDLE file )
 static NTSTATUS tp_threadpool_alloc( struct threadpool **out )
 {
     IMAGE_NT_HEADERS *nt = RtlImageNtHeader( NtCurrentTeb()->Peb->ImageBaseAddress );
+    unsigned int num_queues = min( max( NtCurrentTeb()->Peb->NumberOfProcessors, 1 ), THREADPOOL_MAX_QUEUES );
     struct threadpool *pool;
-    unsigned int i;
+    unsigned int i, j;
 
-    pool = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*pool) );
+    pool = RtlAllocateHeap( GetProcessHeap(), 0, offsetof( struct threadpool, queues[num_queues] ) );
     if (!pool)
         return STATUS_NO_MEMORY;
 
@@ -1695,9 +1718,21 @@ static NTSTATUS tp_threadpool_alloc( struct threadpool **out )
     pool->min_workers             = 0;
     pool->num_workers             = 0;
     pool->num_busy_workers        = 0;
+    pool->num_idle_workers        = 0;
     pool->stack_info.StackReserve = nt->OptionalHeader.SizeOfStackReserve;
     pool->stack_info.StackCommit  = nt->OptionalHeader.SizeOfStackCommit;
 
+    for (i = 0; i < ARRAY_SIZE(pool->num_queued); ++i)
+        pool->num_queued[i] = 0;
+    pool->num_queues = num_queues;
+    for (i = 0; i < num_queues; ++i)
+    {
+        RtlInitializeSRWLock( &pool->queues[i].lock );
+        pool->queues[i].burst = 0;
+        for (j = 0; j < ARRAY_SIZE(pool->queues[i].objects); ++j)
+            list_init( &pool->queues[i].objects[j] );
+    }
+
     TRACE( "allocated threadpool %p\n", pool );
 
     *out = pool;
@@ -1726,7 +1761,7 @@ static void tp_threadpool_shutdown( struct threadpool *pool )
  */
 static BOOL tp_threadpool_release( struct threadpool *pool )
 {
-    unsigned int i;
+    unsigned int i, j;
 
     if (InterlockedDecrement( &pool->refcount ))
         return FALSE;
@@ -1736,7 +1771,13 @@ static BOOL tp_threadpool_release( struct threadpool *pool )
     assert( pool->shutdown );
     assert( !pool->objcount );
     for (i = 0; i < ARRAY_SIZE(pool->pools); ++i)
+    {
         assert( list_empty( &pool->pools[i] ) );
+        assert( !pool->num_queued[i] );
+    }
+    for (i = 0; i < pool->num_queues; ++i)
+        for (j = 0; j < ARRAY_SIZE(pool->queues[i].objects); ++j)
+            assert( list_empty( &pool->queues[i].objects[j] ) );
 
     pool->cs.DebugInfo->Spare[0] = 0;
     RtlDeleteCriticalSection( &pool->cs );
@@ -1796,24 +1837,27 @@ static NTSTATUS tp_threadpool_lock( struct threadpool **out, TP_CALLBACK_ENVIRON
         pool = default_threadpool;
     }
 
-    RtlEnterCriticalSection( &pool->cs );
-
-    /* Make sure that the threadpool has at least one thread. */
-    if (!pool->num_workers)
-        status = tp_new_worker_thread( pool );
-
     /* Keep a reference, and increment objcount to ensure that the
      * last thread doesn't terminate. */
-    if (status == STATUS_SUCCESS)
-    {
-        InterlockedIncrement( &pool->refcount );
-        pool->objcount++;
-    }
+    InterlockedIncrement( &pool->refcount );
+    InterlockedIncrement( &pool->objcount );
 
-    RtlLeaveCriticalSection( &pool->cs );
+    /* Make sure that the threadpool has at least one thread. A thread that
+     * is exiting checks objcount again after decrementing num_workers. */
+    if (!pool->num_workers)
+    {
+        RtlEnterCriticalSection( &pool->cs );
+        if (!pool->num_workers)
+            status = tp_new_worker_thread( pool );
+        RtlLeaveCriticalSection( &pool->cs );
 
-    if (status != STATUS_SUCCESS)
-        return status;
+        if (status != STATUS_SUCCESS)
+        {
+            InterlockedDecrement( &pool->objcount );
+            tp_threadpool_release( pool );
+            return status;
+        }
+    }
 
     *out = pool;
     return STATUS_SUCCESS;
@@ -1826,9 +1870,7 @@ static NTSTATUS tp_threadpool_lock( struct threadpool **out, TP_CALLBACK_ENVIRON
  */
 static void tp_threadpool_unlock( struct threadpool *pool )
 {
-    RtlEnterCriticalSection( &pool->cs );
-    pool->objcount--;
-    RtlLeaveCriticalSection( &pool->cs );
+    InterlockedDecrement( &pool->objcount );
     tp_threadpool_release( pool );
 }
 
@@ -1924,6 +1966,8 @@ static void tp_object_initialize( struct threadpool_object *object, struct threa
     object->num_running_callbacks   = 0;
     object->num_associated_callbacks = 0;
     object->update_serial           = 0;
+    object->queued                  = FALSE;
+    object->num_waiters             = 0;
 
     if (environment)
     {
@@ -1979,10 +2023,116 @@ static void tp_object_initialize( struct threadpool_object *object, struct threa
 
 static void tp_object_prio_queue( struct threadpool_object *object )
 {
-    ++object->pool->num_busy_workers;
+    InterlockedIncrement( &object->pool->num_busy_workers );
     list_add_tail( &object->pool->pools[object->priority], &object->pool_entry );
 }
 
+/* Simple and work callbacks are queued on the task queues, all other objects
+ * are queued on the pool itself. With a single queue there is nothing to steal
+ * from, and the pool list is cheaper. */
+static inline BOOL is_task_object( const struct threadpool_object *object )
+{
+    return (object->type == TP_OBJECT_TYPE_SIMPLE || object->type == TP_OBJECT_TYPE_WORK) &&
+           object->pool->num_queues > 1;
+}
+
+static inline struct threadpool_queue *get_thread_queue( struct threadpool *pool )
+{
+    return &pool->queues[(HandleToULong( NtCurrentTeb()->ClientId.UniqueThread ) >> 2) % pool->num_queues];
+}
+
+/***********************************************************************
+ *           tp_queue_push    (internal)
+ *
+ * Adds a task object to a task queue. The caller has to set object->queued
+ * and passes a reference to the queue entry.
+ */
+static void tp_queue_push( struct threadpool_queue *queue, struct threadpool_object *object )
+{
+    struct threadpool *pool = object->pool;
+
+    InterlockedIncrement( &pool->num_busy_workers );
+
+    RtlAcquireSRWLockExclusive( &queue->lock );
+    list_add_tail( &queue->objects[object->priority], &object->pool_entry );
+    RtlReleaseSRWLockExclusive( &queue->lock );
+
+    InterlockedIncrement( &pool->num_queued[object->priority] );
+}
+
+/***********************************************************************
+ *           tp_queue_pop    (internal)
+ *
+ * Removes the first task object of the given priority from a task queue.
+ * The reference of the queue entry is passed to the caller.
+ */
+static struct threadpool_object *tp_queue_pop( struct threadpool_queue *queue, unsigned int priority )
+{
+    struct threadpool_object *object = NULL;
+    struct list *ptr;
+
+    RtlAcquireSRWLockExclusive( &queue->lock );
+    if ((ptr = list_head( &queue->objects[priority] )))
+    {
+        object = LIST_ENTRY( ptr, struct threadpool_object, pool_entry );
+        list_remove( &object->pool_entry );
+        InterlockedExchange( &object->queued, FALSE );
+    }
+    RtlReleaseSRWLockExclusive( &queue->lock );
+
+    if (object) InterlockedDecrement( &object->pool->num_queued[priority] );
+    return object;
+}
+
+/***********************************************************************
+ *           tp_task_submit    (internal)
+ *
+ * Submits a simple or work callback. Only the queue of the current thread
+ * is locked; the pool lock is only needed to start or wake up a worker.
+ */
+static void tp_task_submit( struct threadpool_object *object )
+{
+    struct threadpool *pool = object->pool;
+    NTSTATUS status = STATUS_UNSUCCESSFUL;
+    BOOL new_thread;
+
+    /* Check if new worker threads are required, see tp_object_submit. */
+    new_thread = pool->num_busy_workers >= pool->num_workers &&
+                 pool->num_workers < pool->max_workers;
+
+    /* Increment refcount for the pending callback, and queue the object unless
+     * it is still queued. In that case the worker dequeuing it re-queues it. */
+    InterlockedIncrement( &object->refcount );
+    InterlockedIncrement( &object->num_pending_callbacks );
+    if (!InterlockedCompareExchange( &object->queued, TRUE, FALSE ))
+    {
+        InterlockedIncrement( &object->refcount );
+        tp_queue_push( get_thread_queue( pool ), object );
+    }
+
+    /* Idle workers check the queues again after incrementing num_idle_workers,
+     * and exiting workers after decrementing num_workers, so there's nothing to
+     * do if all of them are busy. tp_queue_push ends with an interlocked
+     * increment, so these reads aren't done before the task is queued. */
+    if (!new_thread && !pool->num_idle_workers && pool->num_workers)
+        return;
+
+    RtlEnterCriticalSection( &pool->cs );
+
+    if (pool->num_busy_workers >= pool->num_workers &&
+        pool->num_workers < pool->max_workers)
+        status = tp_new_worker_thread( pool );
+
+    /* No new thread started - wake up one existing thread. */
+    if (status != STATUS_SUCCESS)
+    {
+        assert( pool->num_workers > 0 );
+        RtlWakeConditionVariable( &pool->update_event );
+    }
+
+    RtlLeaveCriticalSection( &pool->cs );
+}
+
 /***********************************************************************
  *           tp_object_submit    (internal)
  *
@@ -1997,6 +2147,12 @@ static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
     assert( !object->shutdown );
     assert( !pool->shutdown );
 
+    if (is_task_object( object ))
+    {
+        tp_task_submit( object );
+        return;
+    }
+
     RtlEnterCriticalSection( &pool->cs );
 
     /* Start new worker threads if required. */
@@ -2034,11 +2190,11 @@ static void tp_object_cancel( struct threadpool_object *object )
     LONG pending_callbacks = 0;
 
     RtlEnterCriticalSection( &pool->cs );
-    if (object->num_pending_callbacks)
+    if ((pending_callbacks = InterlockedExchange( &object->num_pending_callbacks, 0 )))
     {
-        pending_callbacks = object->num_pending_callbacks;
-        object->num_pending_callbacks = 0;
-        list_remove( &object->pool_entry );
+        /* Task objects stay queued, the worker dequeuing them drops the entry. */
+        if (!is_task_object( object ))
+            list_remove( &object->pool_entry );
 
         if (object->type == TP_OBJECT_TYPE_WAIT)
             object->u.wait.signaled = 0;
@@ -2078,6 +2234,9 @@ static void tp_object_wait( struct threadpool_object *object, BOOL group_wait )
     struct threadpool *pool = object->pool;
 
     RtlEnterCriticalSection( &pool->cs );
+    /* Task workers update the callback counts without holding the pool lock,
+     * and only wake up the waiters they see, see tp_task_execute. */
+    InterlockedIncrement( &object->num_waiters );
     while (!object_is_finished( object, group_wait ))
     {
         if (group_wait)
@@ -2085,6 +2244,7 @@ static void tp_object_wait( struct threadpool_object *object, BOOL group_wait )
         else
             RtlSleepConditionVariableCS( &object->finished_event, &pool->cs, NULL );
     }
+    InterlockedDecrement( &object->num_waiters );
     RtlLeaveCriticalSection( &pool->cs );
 }
 
@@ -2162,67 +2322,29 @@ static BOOL tp_object_release( struct threadpool_object *object )
     return TRUE;
 }
 
-static struct list *threadpool_get_next_item( const struct threadpool *pool )
-{
-    struct list *ptr;
-    unsigned int i;
-
-    for (i = 0; i < ARRAY_SIZE(pool->pools); ++i)
-    {
-        if ((ptr = list_head( &pool->pools[i] )))
-            break;
-    }
-
-    return ptr;
-}
-
 /***********************************************************************
- *           tp_object_execute    (internal)
+ *           tp_object_call    (internal)
  *
- * Executes a threadpool object callback, object->pool->cs has to be
- * held.
+ * Runs a threadpool object callback, including the finalization callback
+ * and the cleanup tasks. No locks have to be held.
  */
-static void tp_object_execute( struct threadpool_object *object, BOOL wait_thread )
+static void tp_object_call( struct threadpool_object *object, struct threadpool_instance *instance,
+                            TP_WAIT_RESULT wait_result, struct io_completion *completion )
 {
-    TP_CALLBACK_INSTANCE *callback_instance;
-    struct threadpool_instance instance;
-    struct io_completion completion;
-    struct threadpool *pool = object->pool;
-    TP_WAIT_RESULT wait_result = 0;
+    TP_CALLBACK_INSTANCE *callback_instance = (TP_CALLBACK_INSTANCE *)instance;
     NTSTATUS status;
 
-    object->num_pending_callbacks--;
-
-    /* For wait objects check if they were signaled or have timed out. */
-    if (object->type == TP_OBJECT_TYPE_WAIT)
-    {
-        wait_result = object->u.wait.signaled ? WAIT_OBJECT_0 : WAIT_TIMEOUT;
-        if (wait_result == WAIT_OBJECT_0) object->u.wait.signaled--;
-    }
-    else if (object->type == TP_OBJECT_TYPE_IO)
-    {
-        assert( object->u.io.completion_count );
-        completion = object->u.io.completions[--object->u.io.completion_count];
-    }
-
-    /* Leave critical section and do the actual callback. */
-    object->num_associated_callbacks++;
-    object->num_running_callbacks++;
-    RtlLeaveCriticalSection( &pool->cs );
-    if (wait_thread) RtlLeaveCriticalSection( &waitqueue.cs );
-
     /* Initialize threadpool instance struct. */
-    callback_instance = (TP_CALLBACK_INSTANCE *)&instance;
-    instance.object                     = object;
-    instance.threadid                   = GetCurrentThreadId();
-    instance.associated                 = TRUE;
-    instance.may_run_long               = object->may_run_long;
-    instance.cleanup.critical_section   = NULL;
-    instance.cleanup.mutex              = NULL;
-    instance.cleanup.semaphore          = NULL;
-    instance.cleanup.semaphore_count    = 0;
-    instance.cleanup.event              = NULL;
-    instance.cleanup.library            = NULL;
+    instance->object                    = object;
+    instance->threadid                  = GetCurrentThreadId();
+    instance->associated                = TRUE;
+    instance->may_run_long              = object->may_run_long;
+    instance->cleanup.critical_section  = NULL;
+    instance->cleanup.mutex             = NULL;
+    instance->cleanup.semaphore         = NULL;
+    instance->cleanup.semaphore_count   = 0;
+    instance->cleanup.event             = NULL;
+    instance->cleanup.library           = NULL;
 
     switch (object->type)
     {
@@ -2266,9 +2388,9 @@ static void tp_object_execute( struct threadpool_object *object, BOOL wait_threa
         {
             TRACE( "executing I/O callback %p(%p, %p, %#Ix, %p, %p)\n",
                     object->u.io.callback, callback_instance, object->userdata,
-                    completion.cvalue, &completion.iosb, (TP_IO *)object );
+                    completion->cvalue, &completion->iosb, (TP_IO *)object );
             object->u.io.callback( callback_instance, object->userdata,
-                    (void *)completion.cvalue, &completion.iosb, (TP_IO *)object );
+                    (void *)completion->cvalue, &completion->iosb, (TP_IO *)object );
             TRACE( "callback %p returned\n", object->u.io.callback );
             break;
         }
@@ -2288,31 +2410,66 @@ static void tp_object_execute( struct threadpool_object *object, BOOL wait_threa
     }
 
     /* Execute cleanup tasks. */
-    if (instance.cleanup.critical_section)
+    if (instance->cleanup.critical_section)
+    {
+        RtlLeaveCriticalSection( instance->cleanup.critical_section );
+    }
+    if (instance->cleanup.mutex)
+    {
+        status = NtReleaseMutant( instance->cleanup.mutex, NULL );
+        if (status != STATUS_SUCCESS) return;
+    }
+    if (instance->cleanup.semaphore)
     {
-        RtlLeaveCriticalSection( instance.cleanup.critical_section );
+        status = NtReleaseSemaphore( instance->cleanup.semaphore, instance->cleanup.semaphore_count, NULL );
+        if (status != STATUS_SUCCESS) return;
     }
-    if (instance.cleanup.mutex)
+    if (instance->cleanup.event)
     {
-        status = NtReleaseMutant( instance.cleanup.mutex, NULL );
-        if (status != STATUS_SUCCESS) goto skip_cleanup;
+        status = NtSetEvent( instance->cleanup.event, NULL );
+        if (status != STATUS_SUCCESS) return;
     }
-    if (instance.cleanup.semaphore)
+    if (instance->cleanup.library)
     {
-        status = NtReleaseSemaphore( instance.cleanup.semaphore, instance.cleanup.semaphore_count, NULL );
-        if (status != STATUS_SUCCESS) goto skip_cleanup;
+        LdrUnloadDll( instance->cleanup.library );
     }
-    if (instance.cleanup.event)
+}
+
+/***********************************************************************
+ *           tp_object_execute    (internal)
+ *
+ * Executes a threadpool object callback, object->pool->cs has to be
+ * held.
+ */
+static void tp_object_execute( struct threadpool_object *object, BOOL wait_thread )
+{
+    struct threadpool_instance instance;
+    struct io_completion completion;
+    struct threadpool *pool = object->pool;
+    TP_WAIT_RESULT wait_result = 0;
+
+    object->num_pending_callbacks--;
+
+    /* For wait objects check if they were signaled or have timed out. */
+    if (object->type == TP_OBJECT_TYPE_WAIT)
     {
-        status = NtSetEvent( instance.cleanup.event, NULL );
-        if (status != STATUS_SUCCESS) goto skip_cleanup;
+        wait_result = object->u.wait.signaled ? WAIT_OBJECT_0 : WAIT_TIMEOUT;
+        if (wait_result == WAIT_OBJECT_0) object->u.wait.signaled--;
     }
-    if (instance.cleanup.library)
+    else if (object->type == TP_OBJECT_TYPE_IO)
     {
-        LdrUnloadDll( instance.cleanup.library );
+        assert( object->u.io.completion_count );
+        completion = object->u.io.completions[--object->u.io.completion_count];
     }
 
-skip_cleanup:
+    /* Leave critical section and do the actual callback. */
+    object->num_associated_callbacks++;
+    object->num_running_callbacks++;
+    RtlLeaveCriticalSection( &pool->cs );
+    if (wait_thread) RtlLeaveCriticalSection( &waitqueue.cs );
+
+    tp_object_call( object, &instance, wait_result, &completion );
+
     if (wait_thread) RtlEnterCriticalSection( &waitqueue.cs );
     RtlEnterCriticalSection( &pool->cs );
 
@@ -2335,58 +2492,244 @@ skip_cleanup:
     }
 }
 
+/***********************************************************************
+ *           tp_task_execute    (internal)
+ *
+ * Executes a callback of a task object dequeued from a task queue, without
+ * holding the pool lock. Releases the reference of the queue entry.
+ */
+static void tp_task_execute( struct threadpool_object *object, struct threadpool_queue *queue )
+{
+    struct threadpool_instance instance;
+    struct threadpool *pool = object->pool;
+    LONG pending;
+
+    /* The callback counts have to be incremented before claiming a pending
+     * callback, so that waiters never see the object as finished in between. */
+    InterlockedIncrement( &object->num_associated_callbacks );
+    InterlockedIncrement( &object->num_running_callbacks );
+    instance.associated = TRUE;
+
+    /* Claim one of the pending callbacks, unless they were cancelled. */
+    do
+    {
+        if (!(pending = object->num_pending_callbacks)) break;
+    }
+    while (InterlockedCompareExchange( &object->num_pending_callbacks, pending - 1, pending ) != pending);
+
+    /* If further callbacks are pending, queue the object again, behind the
+     * tasks that were queued after it. */
+    if (pending > 1 && !InterlockedCompareExchange( &object->queued, TRUE, FALSE ))
+    {
+        InterlockedIncrement( &object->refcount );
+        tp_queue_push( queue, object );
+    }
+
+    if (pending)
+    {
+        tp_object_call( object, &instance, 0, NULL );
+
+        /* Simple callbacks are automatically shutdown after execution. */
+        if (object->type == TP_OBJECT_TYPE_SIMPLE)
+        {
+            tp_object_prepare_shutdown( object );
+            object->shutdown = TRUE;
+        }
+    }
+
+    InterlockedDecrement( &object->num_running_callbacks );
+    if (instance.associated)
+        InterlockedDecrement( &object->num_associated_callbacks );
+
+    /* Waiters increment num_waiters before checking the callback counts. */
+    if (object->num_waiters)
+    {
+        RtlEnterCriticalSection( &pool->cs );
+        if (object_is_finished( object, TRUE ))
+            RtlWakeAllConditionVariable( &object->group_finished_event );
+        if (object_is_finished( object, FALSE ))
+            RtlWakeAllConditionVariable( &object->finished_event );
+        RtlLeaveCriticalSection( &pool->cs );
+    }
+
+    assert( pool->num_busy_workers );
+    InterlockedDecrement( &pool->num_busy_workers );
+
+    /* Release the reference of the pending callback and of the queue entry. */
+    if (pending) tp_object_release( object );
+    tp_object_release( object );
+}
+
+/***********************************************************************
+ *           tp_threadpool_has_work    (internal)
+ *
+ * Checks if a threadpool has queued work items, pool->cs has to be held.
+ */
+static BOOL tp_threadpool_has_work( const struct threadpool *pool )
+{
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_SIZE(pool->pools); ++i)
+    {
+        if (pool->num_queued[i] || !list_empty( &pool->pools[i] ))
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+/***********************************************************************
+ *           tp_threadpool_run_task    (internal)
+ *
+ * Executes a task object of the given priority, dequeued from the queue of
+ * the current thread first, then stolen from the other queues.
+ */
+static BOOL tp_threadpool_run_task( struct threadpool *pool, unsigned int start, unsigned int priority )
+{
+    struct threadpool_object *object;
+    struct threadpool_queue *queue;
+    unsigned int i;
+
+    if (!pool->num_queued[priority]) return FALSE;
+
+    for (i = 0; i < pool->num_queues; ++i)
+    {
+        queue = &pool->queues[(start + i) % pool->num_queues];
+        if ((object = tp_queue_pop( queue, priority )))
+        {
+            tp_task_execute( object, queue );
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/***********************************************************************
+ *           tp_threadpool_run_pool_object    (internal)
+ *
+ * Executes the first work item of the given priority in the pool list.
+ */
+static BOOL tp_threadpool_run_pool_object( struct threadpool *pool, unsigned int priority )
+{
+    struct threadpool_object *object;
+    struct list *ptr;
+
+    /* Checking the list without holding the lock is only a hint. */
+    if (list_empty( &pool->pools[priority] )) return FALSE;
+
+    RtlEnterCriticalSection( &pool->cs );
+    if ((ptr = list_head( &pool->pools[priority] )))
+    {
+        object = LIST_ENTRY( ptr, struct threadpool_object, pool_entry );
+        assert( object->num_pending_callbacks > 0 );
+
+        /* If further pending callbacks are queued, move the work item to
+         * the end of the pool list. Otherwise remove it from the pool. */
+        list_remove( &object->pool_entry );
+        if (object->num_pending_callbacks > 1)
+            tp_object_prio_queue( object );
+
+        tp_object_execute( object, FALSE );
+
+        assert( pool->num_busy_workers );
+        InterlockedDecrement( &pool->num_busy_workers );
+    }
+    RtlLeaveCriticalSection( &pool->cs );
+
+    if (!ptr) return FALSE;
+    tp_object_release( object );
+    return TRUE;
+}
+
+/***********************************************************************
+ *           tp_threadpool_run_next    (internal)
+ *
+ * Executes the next work item with the highest priority. Task objects are
+ * run before the work items of the pool list, but the pool list gets a turn
+ * every THREADPOOL_TASK_BURST tasks, so that a steady stream of tasks doesn't
+ * starve timer, wait and IO callbacks. Returns FALSE if no work item was found.
+ */
+static BOOL tp_threadpool_run_next( struct threadpool *pool, struct threadpool_queue *queue )
+{
+    unsigned int priority, start = queue - pool->queues;
+
+    for (priority = 0; priority < ARRAY_SIZE(pool->pools); ++priority)
+    {
+        if (!list_empty( &pool->pools[priority] ) && ++queue->burst >= THREADPOOL_TASK_BURST)
+        {
+            queue->burst = 0;
+            if (tp_threadpool_run_pool_object( pool, priority )) return TRUE;
+        }
+        if (tp_threadpool_run_task( pool, start, priority )) return TRUE;
+        if (tp_threadpool_run_pool_object( pool, priority ))
+        {
+            queue->burst = 0;
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
 /***********************************************************************
  *           threadpool_worker_proc    (internal)
  */
 static void CALLBACK threadpool_worker_proc( void *param )
 {
     struct threadpool *pool = param;
+    struct threadpool_queue *queue;
     LARGE_INTEGER timeout;
-    struct list *ptr;
 
     TRACE( "starting worker thread for pool %p\n", pool );
     set_thread_name(L"wine_threadpool_worker");
 
-    RtlEnterCriticalSection( &pool->cs );
+    queue = get_thread_queue( pool );
     for (;;)
     {
-        while ((ptr = threadpool_get_next_item( pool )))
-        {
-            struct threadpool_object *object = LIST_ENTRY( ptr, struct threadpool_object, pool_entry );
-            assert( object->num_pending_callbacks > 0 );
-
-            /* If further pending callbacks are queued, move the work item to
-             * the end of the pool list. Otherwise remove it from the pool. */
-            list_remove( &object->pool_entry );
-            if (object->num_pending_callbacks > 1)
-                tp_object_prio_queue( object );
+        if (tp_threadpool_run_next( pool, queue ))
+            continue;
 
-            tp_object_execute( object, FALSE );
+        /* Register as idle before checking for work again, tp_task_submit only
+         * takes the pool lock to wake up a thread when it sees idle threads. */
+        RtlEnterCriticalSection( &pool->cs );
+        InterlockedIncrement( &pool->num_idle_workers );
 
-            assert(pool->num_busy_workers);
-            pool->num_busy_workers--;
+        if (!tp_threadpool_has_work( pool ))
+        {
+            /* Shutdown worker thread if requested. */
+            if (pool->shutdown)
+            {
+                InterlockedDecrement( &pool->num_idle_workers );
+                InterlockedDecrement( &pool->num_workers );
+                break;
+            }
 
-            tp_object_release( object );
+            /* Wait for new tasks or until the timeout expires. A thread only terminates
+             * when no new tasks are available, and the number of threads can be
+             * decreased without violating the min_workers limit. An exception is when
+             * min_workers == 0, then objcount is used to detect if the last thread
+             * can be terminated. */
+            timeout.QuadPart = (ULONGLONG)THREADPOOL_WORKER_TIMEOUT * -10000;
+            if (RtlSleepConditionVariableCS( &pool->update_event, &pool->cs, &timeout ) == STATUS_TIMEOUT &&
+                !tp_threadpool_has_work( pool ) && (pool->num_workers > max( pool->min_workers, 1 ) ||
+                (!pool->min_workers && !pool->objcount)))
+            {
+                /* Tasks are queued and objcount is incremented without the pool lock,
+                 * and the worker counts are only read afterwards. Stop counting this
+                 * thread before checking them once more, so that either this thread
+                 * sees them, or the other thread sees that it has to start a worker. */
+                InterlockedDecrement( &pool->num_idle_workers );
+                InterlockedDecrement( &pool->num_workers );
+                if (!tp_threadpool_has_work( pool ) && (pool->num_workers || !pool->objcount))
+                    break;
+                InterlockedIncrement( &pool->num_workers );
+                InterlockedIncrement( &pool->num_idle_workers );
+            }
         }
 
-        /* Shutdown worker thread if requested. */
-        if (pool->shutdown)
-            break;
-
-        /* Wait for new tasks or until the timeout expires. A thread only terminates
-         * when no new tasks are available, and the number of threads can be
-         * decreased without violating the min_workers limit. An exception is when
-         * min_workers == 0, then objcount is used to detect if the last thread
-         * can be terminated. */
-        timeout.QuadPart = (ULONGLONG)THREADPOOL_WORKER_TIMEOUT * -10000;
-        if (RtlSleepConditionVariableCS( &pool->update_event, &pool->cs, &timeout ) == STATUS_TIMEOUT &&
-            !threadpool_get_next_item( pool ) && (pool->num_workers > max( pool->min_workers, 1 ) ||
-            (!pool->min_workers && !pool->objcount)))
-        {
-            break;
-        }
+        InterlockedDecrement( &pool->num_idle_workers );
+        RtlLeaveCriticalSection( &pool->cs );
     }
-    pool->num_workers--;
     RtlLeaveCriticalSection( &pool->cs );
 
     TRACE( "terminating worker thread for pool %p\n", pool );
@@ -2733,7 +3076,7 @@ VOID WINAPI TpDisassociateCallback( TP_CALLBACK_INSTANCE *instance )
     pool = object->pool;
     RtlEnterCriticalSection( &pool->cs );
 
-    object->num_associated_callbacks--;
+    InterlockedDecrement( &object->num_associated_callbacks );
     if (object_is_finished( object, FALSE ))
         RtlWakeAllConditionVariable( &object->finished_event );
 
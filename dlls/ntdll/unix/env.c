@@ -1291,32 +1291,31 @@ static void add_registry_environment( WCHAR **env, SIZE_T *pos, SIZE_T *size )
         '\\','M','i','c','r','o','s','o','f','t',
         '\\','W','i','n','d','o','w','s',
         '\\','C','u','r','r','e','n','t','V','e','r','s','i','o','n',0};
-    OBJECT_ATTRIBUTES attr;
-    UNICODE_STRING nameW;
+    struct open_key_info keys[] =
+    {
+        { syskeyW, NULL, KEY_READ },
+        { NULL, "Environment", KEY_ALL_ACCESS },
+        { NULL, "Volatile Environment", KEY_ALL_ACCESS },
+        { profileW, NULL, KEY_READ },
+        { curversionW, NULL, KEY_READ | KEY_WOW64_64KEY },
+        { computerW, NULL, KEY_READ },
+    };
+    unsigned int i;
     WCHAR *value;
     HANDLE key;
 
-    InitializeObjectAttributes( &attr, &nameW, 0, 0, NULL );
-    init_unicode_string( &nameW, syskeyW );
-    if (!NtOpenKey( &key, KEY_READ, &attr ))
-    {
-        add_registry_variables( env, pos, size, key );
-        NtClose( key );
-    }
-    if (!open_hkcu_key( "Environment", &key ))
-    {
-        add_registry_variables( env, pos, size, key );
-        NtClose( key );
-    }
-    if (!open_hkcu_key( "Volatile Environment", &key ))
+    /* open all the keys in a single server round-trip */
+    open_registry_keys( keys, ARRAY_SIZE(keys) );
+
+    for (i = 0; i < 3; i++)
     {
+        if (!(key = keys[i].key)) continue;
         add_registry_variables( env, pos, size, key );
         NtClose( key );
     }
 
     /* set the user profile variables */
-    init_unicode_string( &nameW, profileW );
-    if (!NtOpenKey( &key, KEY_READ, &attr ))
+    if ((key = keys[3].key))
     {
         static const WCHAR progdataW[] = {'P','r','o','g','r','a','m','D','a','t','a',0};
         static const WCHAR allusersW[] = {'A','L','L','U','S','E','R','S','P','R','O','F','I','L','E',0};
@@ -1336,8 +1335,7 @@ static void add_registry_environment( WCHAR **env, SIZE_T *pos, SIZE_T *size )
     }
 
     /* set the ProgramFiles variables */
-    init_unicode_string( &nameW, curversionW );
-    if (!NtOpenKey( &key, KEY_READ | KEY_WOW64_64KEY, &attr ))
+    if ((key = keys[4].key))
     {
         static const WCHAR progdirW[] = {'P','r','o','g','r','a','m','F','i','l','e','s','D','i','r',0};
         static const WCHAR progdirx86W[] = {'P','r','o','g','r','a','m','F','i','l','e','s','D','i','r',' ','(','x','8','6',')',0};
@@ -1381,8 +1379,7 @@ static void add_registry_environment( WCHAR **env, SIZE_T *pos, SIZE_T *size )
     }
 
     /* set the computer name */
-    init_unicode_string( &nameW, computerW );
-    if (!NtOpenKey( &key, KEY_READ, &attr ))
+    if ((key = keys[5].key))
     {
         static const WCHAR computernameW[] = {'C','O','M','P','U','T','E','R','N','A','M','E',0};
         if ((value = get_registry_value( *env, *pos, key, computernameW )))
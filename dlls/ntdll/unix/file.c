@@ -124,6 +124,7 @@
 #include "wine/list.h"
 #include "wine/debug.h"
 #include "unix_private.h"
+#include "uring.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(file);
 WINE_DECLARE_DEBUG_CHANNEL(winediag);
@@ -2720,6 +2721,329 @@ NTSTATUS WINAPI NtQueryDirectoryFile( HANDLE handle, HANDLE event, PIO_APC_ROUTI
 }
 
 
+/* case-insensitive index of the names of a Unix directory */
+
+struct dir_index_name
+{
+    struct dir_index_name *next_long;   /* next name in the long name hash chain */
+    struct dir_index_name *next_short;  /* next name in the short name hash chain */
+    const char            *unix_name;   /* Unix file name in host encoding */
+    unsigned int           long_len;    /* length of the long name */
+    unsigned int           short_len;   /* length of the hashed short name, 0 if none */
+    WCHAR                  short_name[12];
+    WCHAR                  long_name[1];
+};
+
+struct dir_index
+{
+    struct list             entry;      /* entry in dir_index_lru list */
+    struct file_identity    id;         /* directory file identity */
+    LARGE_INTEGER           mtime;      /* directory modification time when the index was built */
+    LARGE_INTEGER           ctime;      /* directory change time when the index was built */
+    unsigned int            count;      /* number of names */
+    unsigned int            size;       /* memory used by the index */
+    unsigned int            hash_mask;  /* size of the hash tables minus one */
+    struct dir_index_name **long_hash;  /* hash table of long names, NULL if too large to be indexed */
+    struct dir_index_name **short_hash; /* hash table of hashed short names */
+};
+
+static const unsigned int dir_index_max_count = 64;
+static const unsigned int dir_index_max_size = 4 * 1024 * 1024;  /* total memory used by the indexes */
+
+static struct list dir_index_lru = LIST_INIT( dir_index_lru );
+static unsigned int dir_index_count;
+static unsigned int dir_index_size;
+static unsigned int dir_index_hits, dir_index_misses, dir_index_scans;
+static pthread_mutex_t dir_index_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned int dir_index_hash( const WCHAR *name, unsigned int len )
+{
+    unsigned int i, hash = 0;
+
+    for (i = 0; i < len; i++) hash = hash * 31 + towupper( name[i] );
+    return hash ^ (hash >> 16);
+}
+
+static void free_dir_index_names( struct dir_index_name *list )
+{
+    struct dir_index_name *name;
+
+    while ((name = list))
+    {
+        list = name->next_long;
+        free( name );
+    }
+}
+
+static void free_dir_index( struct dir_index *index )
+{
+    unsigned int i;
+
+    if (index->long_hash)
+    {
+        for (i = 0; i <= index->hash_mask; i++) free_dir_index_names( index->long_hash[i] );
+        free( index->long_hash );
+    }
+    free( index );
+}
+
+/* remove an index from the LRU list, must be called with dir_index_mutex held */
+static void remove_dir_index( struct dir_index *index )
+{
+    list_remove( &index->entry );
+    dir_index_count--;
+    dir_index_size -= index->size;
+    free_dir_index( index );
+}
+
+/***********************************************************************
+ *           build_dir_index
+ *
+ * Scan a directory and build the hash tables of its long and short names.
+ * Names are inserted in readdir order, so the first of several case variants wins.
+ * Directories too large to fit in the cache get an index without any names.
+ */
+static NTSTATUS build_dir_index( const char *unix_name, const struct stat *st, struct dir_index **ret )
+{
+    WCHAR buffer[MAX_DIR_ENTRY_LEN];
+    struct dir_index_name *name, *list = NULL, **tail = &list;
+    struct dir_index *index;
+    LARGE_INTEGER atime, creation;
+    struct dirent *de;
+    unsigned int hash, size;
+    DIR *dir;
+    int len;
+
+    if (!(dir = opendir( unix_name ))) return errno_to_status( errno );
+    if (!(index = calloc( 1, sizeof(*index) )))
+    {
+        closedir( dir );
+        return STATUS_NO_MEMORY;
+    }
+    index->id.dev = st->st_dev;
+    index->id.ino = st->st_ino;
+    index->size = sizeof(*index);
+    get_file_times( st, &index->mtime, &index->ctime, &atime, &creation );
+
+    while ((de = readdir( dir )))
+    {
+        len = ntdll_umbstowcs( de->d_name, strlen(de->d_name), buffer, MAX_DIR_ENTRY_LEN );
+        size = offsetof( struct dir_index_name, long_name[len] ) + strlen( de->d_name ) + 1;
+        /* account for the two hash table slots of the name as well */
+        index->size += size + 2 * sizeof(*index->long_hash);
+        if (index->size > dir_index_max_size) break;
+        if (!(name = malloc( size ))) break;
+        memcpy( name->long_name, buffer, len * sizeof(WCHAR) );
+        name->long_len = len;
+        name->short_len = 0;
+        name->unix_name = (char *)(name->long_name + len);
+        strcpy( (char *)name->unix_name, de->d_name );
+        if (!is_legal_8dot3_name( buffer, len ))
+            name->short_len = hash_short_file_name( buffer, len, name->short_name );
+        name->next_long = NULL;
+        *tail = name;
+        tail = &name->next_long;
+        index->count++;
+    }
+    closedir( dir );
+
+    if (index->size > dir_index_max_size)
+    {
+        free_dir_index_names( list );
+        index->count = 0;
+        index->size = sizeof(*index);
+        *ret = index;
+        return STATUS_SUCCESS;
+    }
+
+    for (size = 16; size < index->count; size *= 2) ;
+    index->hash_mask = size - 1;
+    if (de || !(index->long_hash = calloc( 2 * size, sizeof(*index->long_hash) )))
+    {
+        free_dir_index_names( list );
+        free( index );
+        return STATUS_NO_MEMORY;
+    }
+    index->short_hash = index->long_hash + size;
+
+    /* append to the chains to preserve the readdir order */
+    while ((name = list))
+    {
+        struct dir_index_name **chain;
+
+        list = name->next_long;
+        name->next_long = name->next_short = NULL;
+        hash = dir_index_hash( name->long_name, name->long_len ) & index->hash_mask;
+        for (chain = &index->long_hash[hash]; *chain; chain = &(*chain)->next_long) ;
+        *chain = name;
+        if (!name->short_len) continue;
+        hash = dir_index_hash( name->short_name, name->short_len ) & index->hash_mask;
+        for (chain = &index->short_hash[hash]; *chain; chain = &(*chain)->next_short) ;
+        *chain = name;
+    }
+
+    *ret = index;
+    return STATUS_SUCCESS;
+}
+
+/***********************************************************************
+ *           find_dir_index_name
+ *
+ * Look up a name in a directory index. Must be called with dir_index_mutex held.
+ */
+static const struct dir_index_name *find_dir_index_name( const struct dir_index *index, const WCHAR *name,
+                                                        int length, BOOL short_names )
+{
+    unsigned int hash = dir_index_hash( name, length ) & index->hash_mask;
+    const struct dir_index_name *entry;
+
+    for (entry = index->long_hash[hash]; entry; entry = entry->next_long)
+        if (entry->long_len == length && !wcsnicmp( entry->long_name, name, length )) return entry;
+
+    if (!short_names) return NULL;
+
+    for (entry = index->short_hash[hash]; entry; entry = entry->next_short)
+        if (entry->short_len == length && !wcsnicmp( entry->short_name, name, length )) return entry;
+
+    return NULL;
+}
+
+/***********************************************************************
+ *           find_file_in_dir_scan
+ *
+ * Case-insensitive lookup of a file by reading its whole directory.
+ * unix_name contains the directory name; on success the file name found is
+ * appended at pos.
+ */
+static NTSTATUS find_file_in_dir_scan( char *unix_name, int pos, const WCHAR *name, int length,
+                                       BOOL short_names )
+{
+    WCHAR buffer[MAX_DIR_ENTRY_LEN];
+    struct dirent *de;
+    DIR *dir;
+    int ret;
+
+    if (!(dir = opendir( unix_name ))) return errno_to_status( errno );
+
+    unix_name[pos - 1] = '/';
+    while ((de = readdir( dir )))
+    {
+        ret = ntdll_umbstowcs( de->d_name, strlen(de->d_name), buffer, MAX_DIR_ENTRY_LEN );
+        if (ret == length && !wcsnicmp( buffer, name, ret ))
+        {
+            strcpy( unix_name + pos, de->d_name );
+            closedir( dir );
+            return STATUS_SUCCESS;
+        }
+
+        if (!short_names) continue;
+
+        if (!is_legal_8dot3_name( buffer, ret ))
+        {
+            WCHAR short_nameW[12];
+            ret = hash_short_file_name( buffer, ret, short_nameW );
+            if (ret == length && !wcsnicmp( short_nameW, name, length ))
+            {
+                strcpy( unix_name + pos, de->d_name );
+                closedir( dir );
+                return STATUS_SUCCESS;
+            }
+        }
+    }
+    closedir( dir );
+    return STATUS_OBJECT_NAME_NOT_FOUND;
+}
+
+/***********************************************************************
+ *           find_file_in_dir_index
+ *
+ * Case-insensitive lookup of a file through the cached index of its directory,
+ * rebuilding the index when the directory has changed since it was built.
+ * Indexes are shared by all threads of the process and kept in LRU order.
+ * Directories modified recently, or too large to be cached, are scanned instead.
+ * unix_name contains the directory name; on success the file name found is
+ * appended at pos.
+ */
+static NTSTATUS find_file_in_dir_index( char *unix_name, int pos, const WCHAR *name, int length,
+                                        BOOL short_names )
+{
+    const struct dir_index_name *entry = NULL;
+    struct dir_index *index, *new_index = NULL;
+    LARGE_INTEGER mtime, ctime, atime, creation;
+    struct stat st;
+    NTSTATUS status;
+    BOOL stable;
+
+    if (stat( unix_name, &st ) == -1) return errno_to_status( errno );
+    get_file_times( &st, &mtime, &ctime, &atime, &creation );
+    /* a name created within the timestamp granularity would not change the mtime,
+     * and a directory being filled would be indexed again on every lookup */
+    stable = st.st_mtime < time( NULL ) - 2;
+
+    for (;;)
+    {
+        mutex_lock( &dir_index_mutex );
+
+        LIST_FOR_EACH_ENTRY( index, &dir_index_lru, struct dir_index, entry )
+        {
+            if (!is_same_file( &index->id, &st )) continue;
+            if (new_index || !stable || index->mtime.QuadPart != mtime.QuadPart ||
+                index->ctime.QuadPart != ctime.QuadPart)
+            {
+                remove_dir_index( index );
+                break;
+            }
+            goto done;
+        }
+
+        if (new_index)
+        {
+            index = new_index;
+            while (dir_index_count && (dir_index_count >= dir_index_max_count ||
+                                       dir_index_size + index->size > dir_index_max_size))
+                remove_dir_index( LIST_ENTRY( list_tail( &dir_index_lru ), struct dir_index, entry ));
+            list_add_head( &dir_index_lru, &index->entry );
+            dir_index_count++;
+            dir_index_size += index->size;
+            goto done;
+        }
+
+        mutex_unlock( &dir_index_mutex );
+
+        if (!stable) return find_file_in_dir_scan( unix_name, pos, name, length, short_names );
+
+        /* scan the directory without holding the lock */
+        if ((status = build_dir_index( unix_name, &st, &new_index ))) return status;
+        dir_index_scans++;
+    }
+
+done:
+    if (index != new_index)
+    {
+        list_remove( &index->entry );
+        list_add_head( &dir_index_lru, &index->entry );
+    }
+    if (!index->long_hash)
+    {
+        mutex_unlock( &dir_index_mutex );
+        return find_file_in_dir_scan( unix_name, pos, name, length, short_names );
+    }
+    if ((entry = find_dir_index_name( index, name, length, short_names ))) dir_index_hits++;
+    else dir_index_misses++;
+    if (new_index)
+        TRACE( "scanned %s (%u names, %u bytes), lookups found %u not found %u, scans %u\n",
+               debugstr_a(unix_name), new_index->count, new_index->size, dir_index_hits,
+               dir_index_misses, dir_index_scans );
+    if (entry)
+    {
+        unix_name[pos - 1] = '/';
+        strcpy( unix_name + pos, entry->unix_name );
+    }
+    mutex_unlock( &dir_index_mutex );
+    return entry ? STATUS_SUCCESS : STATUS_OBJECT_NAME_NOT_FOUND;
+}
+
+
 /***********************************************************************
  *           find_file_in_dir
  *
@@ -2730,10 +3054,8 @@ NTSTATUS WINAPI NtQueryDirectoryFile( HANDLE handle, HANDLE event, PIO_APC_ROUTI
 static NTSTATUS find_file_in_dir( char *unix_name, int pos, const WCHAR *name, int length,
                                   BOOLEAN check_case )
 {
-    WCHAR buffer[MAX_DIR_ENTRY_LEN];
     BOOLEAN is_name_8_dot_3;
-    DIR *dir;
-    struct dirent *de;
+    NTSTATUS status;
     struct stat st;
     int ret;
 
@@ -2768,6 +3090,7 @@ static NTSTATUS find_file_in_dir( char *unix_name, int pos, const WCHAR *name, i
         int fd = open( unix_name, O_RDONLY | O_DIRECTORY );
         if (fd != -1)
         {
+            WCHAR buffer[MAX_DIR_ENTRY_LEN];
             KERNEL_DIRENT kde[2];
 
             if (ioctl( fd, VFAT_IOCTL_READDIR_BOTH, (long)kde ) != -1)
@@ -2810,34 +3133,8 @@ static NTSTATUS find_file_in_dir( char *unix_name, int pos, const WCHAR *name, i
     }
 #endif /* VFAT_IOCTL_READDIR_BOTH */
 
-    if (!(dir = opendir( unix_name ))) return errno_to_status( errno );
-
-    unix_name[pos - 1] = '/';
-    while ((de = readdir( dir )))
-    {
-        ret = ntdll_umbstowcs( de->d_name, strlen(de->d_name), buffer, MAX_DIR_ENTRY_LEN );
-        if (ret == length && !wcsnicmp( buffer, name, ret ))
-        {
-            strcpy( unix_name + pos, de->d_name );
-            closedir( dir );
-            return STATUS_SUCCESS;
-        }
-
-        if (!is_name_8_dot_3) continue;
-
-        if (!is_legal_8dot3_name( buffer, ret ))
-        {
-            WCHAR short_nameW[12];
-            ret = hash_short_file_name( buffer, ret, short_nameW );
-            if (ret == length && !wcsnicmp( short_nameW, name, length ))
-            {
-                strcpy( unix_name + pos, de->d_name );
-                closedir( dir );
-                return STATUS_SUCCESS;
-            }
-        }
-    }
-    closedir( dir );
+    status = find_file_in_dir_index( unix_name, pos, name, length, is_name_8_dot_3 );
+    if (status != STATUS_OBJECT_NAME_NOT_FOUND) return status;
 
 not_found:
     unix_name[pos - 1] = 0;
@@ -5850,6 +6147,14 @@ NTSTATUS WINAPI NtReadFile( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, vo
             goto err;
         }
 
+        if (async_read && length && event && !apc && do_uring() &&
+            uring_read_file( unix_handle, handle, event, cvalue, iosb_ptr,
+                             buffer, length, offset->QuadPart ) == STATUS_PENDING)
+        {
+            if (needs_close) close( unix_handle );
+            return STATUS_PENDING;
+        }
+
         if (offset && offset->QuadPart != FILE_USE_FILE_POINTER_POSITION)
         {
             /* async I/O doesn't make sense on regular files */
@@ -6147,6 +6452,13 @@ NTSTATUS WINAPI NtWriteFile( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, v
             offset_eof.QuadPart = FILE_WRITE_TO_END_OF_FILE;
             offset = &offset_eof;
         }
+        else if (async_write && length && event && !apc && offset->QuadPart >= 0 && do_uring() &&
+                 uring_write_file( unix_handle, handle, event, cvalue, iosb_ptr,
+                                   buffer, length, offset->QuadPart ) == STATUS_PENDING)
+        {
+            if (needs_close) close( unix_handle );
+            return STATUS_PENDING;
+        }
 
         if (offset && offset->QuadPart != FILE_USE_FILE_POINTER_POSITION)
         {
@@ -6655,25 +6967,29 @@ NTSTATUS WINAPI NtFlushBuffersFile( HANDLE handle, IO_STATUS_BLOCK *io )
  */
 NTSTATUS WINAPI NtCancelIoFile( HANDLE handle, IO_STATUS_BLOCK *io_status )
 {
-    unsigned int status;
+    unsigned int status, uring_status;
 
     TRACE( "%p %p\n", handle, io_status );
 
     if (ac_odyssey && !cancel_async_file_read( handle, NULL ))
         return (io_status->Status = STATUS_SUCCESS);
 
+    uring_status = do_uring() ? uring_cancel( handle, 0, TRUE ) : STATUS_NOT_FOUND;
+
     SERVER_START_REQ( cancel_async )
     {
         req->handle      = wine_server_obj_handle( handle );
         req->only_thread = TRUE;
-        if (!(status = wine_server_call( req )))
-        {
-            io_status->Status = status;
-            io_status->Information = 0;
-        }
+        status = wine_server_call( req );
     }
     SERVER_END_REQ;
 
+    if (status == STATUS_NOT_FOUND) status = uring_status;
+    if (!status)
+    {
+        io_status->Status = status;
+        io_status->Information = 0;
+    }
     return status;
 }
 
@@ -6683,25 +6999,29 @@ NTSTATUS WINAPI NtCancelIoFile( HANDLE handle, IO_STATUS_BLOCK *io_status )
  */
 NTSTATUS WINAPI NtCancelIoFileEx( HANDLE handle, IO_STATUS_BLOCK *io, IO_STATUS_BLOCK *io_status )
 {
-    unsigned int status;
+    unsigned int status, uring_status;
 
     TRACE( "%p %p %p\n", handle, io, io_status );
 
     if (ac_odyssey && !cancel_async_file_read( handle, io ))
         return (io_status->Status = STATUS_SUCCESS);
 
+    uring_status = do_uring() ? uring_cancel( handle, wine_server_client_ptr( io ), FALSE ) : STATUS_NOT_FOUND;
+
     SERVER_START_REQ( cancel_async )
     {
         req->handle = wine_server_obj_handle( handle );
         req->iosb   = wine_server_client_ptr( io );
-        if (!(status = wine_server_call( req )))
-        {
-            io_status->Status = status;
-            io_status->Information = 0;
-        }
+        status = wine_server_call( req );
     }
     SERVER_END_REQ;
 
+    if (status == STATUS_NOT_FOUND) status = uring_status;
+    if (!status)
+    {
+        io_status->Status = status;
+        io_status->Information = 0;
+    }
     return status;
 }
 
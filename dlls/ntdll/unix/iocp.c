@@ -0,0 +1,414 @@
+/*
+ * IO completion port rings shared with the server
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#if 0
+#pragma makedep unix
+#endif
+
+#include "config.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#include "windef.h"
+#include "winternl.h"
+#include "wine/server.h"
+#include "wine/debug.h"
+
+#include "unix_private.h"
+#include "iocp.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(sync);
+
+/* the ring fd is received over the server socket, so we need to hold the
+ * fd cache mutex around that request */
+extern pthread_mutex_t fd_cache_mutex;
+extern int receive_fd( obj_handle_t *handle );
+
+/* A completion port may have a ring of packets shared with the server, see
+ * server/completion.c. Packets are posted to and dequeued from the ring
+ * without a server call; the server is only needed to block on an empty
+ * port, to wake up the threads blocked on it, and while packets which did
+ * not fit in the ring are queued on the server. */
+
+int do_iocp_ring(void)
+{
+    static int do_iocp_ring_cached = -1;
+
+    if (do_iocp_ring_cached == -1)
+        do_iocp_ring_cached = getenv("WINEIOCPRING") && atoi(getenv("WINEIOCPRING"));
+
+    return do_iocp_ring_cached;
+}
+
+/* the rings are cached by handle, like the server fds */
+
+#define RING_LIST_BLOCK_SIZE  (65536 / sizeof(completion_ring_t *))
+#define RING_LIST_ENTRIES     256
+
+/* cached for handles which cannot use a ring */
+#define NO_RING ((completion_ring_t *)~(UINT_PTR)0)
+
+static completion_ring_t **ring_list[RING_LIST_ENTRIES];
+static completion_ring_t *ring_list_initial_block[RING_LIST_BLOCK_SIZE];
+
+/* ring of the handles closed by other processes, and how far we went through it */
+static const volatile struct closed_handle_ring *closed_handles;
+static unsigned int closed_handles_serial;
+
+/* Number of threads using a ring they looked up, from get_ring to put_ring.
+ * Rings dropped from the cache are only unmapped once it drops to zero, as
+ * threads which looked them up before may still be using them. */
+static LONG ring_users;
+
+struct deferred_ring
+{
+    struct deferred_ring *next;
+    completion_ring_t    *ring;
+};
+
+/* rings dropped from the cache while they may still be in use */
+static struct deferred_ring *deferred_rings;
+
+static void defer_rings( struct deferred_ring *list )
+{
+    struct deferred_ring *last = list;
+
+    while (last->next) last = last->next;
+    last->next = __atomic_load_n( &deferred_rings, __ATOMIC_SEQ_CST );
+    while (!__atomic_compare_exchange_n( &deferred_rings, &last->next, list, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST ));
+}
+
+/* unmap a ring dropped from the cache, or defer it until no thread uses any ring */
+static void release_ring( completion_ring_t *ring )
+{
+    struct deferred_ring *deferred;
+
+    if (ring == NO_RING) return;
+    if (!__atomic_load_n( &ring_users, __ATOMIC_SEQ_CST ))
+    {
+        munmap( (void *)ring, sizeof(*ring) );
+        return;
+    }
+    if (!(deferred = malloc( sizeof(*deferred) ))) return;
+    deferred->next = NULL;
+    deferred->ring = ring;
+    defer_rings( deferred );
+}
+
+/* stop using the ring returned by get_ring */
+static void put_ring(void)
+{
+    struct deferred_ring *list, *next;
+
+    if (__atomic_sub_fetch( &ring_users, 1, __ATOMIC_SEQ_CST )) return;
+    if (!__atomic_load_n( &deferred_rings, __ATOMIC_SEQ_CST )) return;
+    if (!(list = __atomic_exchange_n( &deferred_rings, NULL, __ATOMIC_SEQ_CST ))) return;
+
+    /* The rings were dropped from the cache before we took them from the list.
+     * If nobody uses a ring now, the threads which used them are gone, and the
+     * ones which came in since then couldn't find them. */
+    if (__atomic_load_n( &ring_users, __ATOMIC_SEQ_CST ))
+    {
+        defer_rings( list );
+        return;
+    }
+    for (; list; list = next)
+    {
+        next = list->next;
+        munmap( (void *)list->ring, sizeof(*list->ring) );
+        free( list );
+    }
+}
+
+static inline UINT_PTR handle_to_index( HANDLE handle, UINT_PTR *entry )
+{
+    UINT_PTR idx = (((UINT_PTR)handle) >> 2) - 1;
+    *entry = idx / RING_LIST_BLOCK_SIZE;
+    return idx % RING_LIST_BLOCK_SIZE;
+}
+
+static BOOL add_to_list( HANDLE handle, completion_ring_t *ring )
+{
+    UINT_PTR entry, idx = handle_to_index( handle, &entry );
+
+    if (!ring_list[entry])  /* do we need to allocate a new block of entries? */
+    {
+        if (!entry) ring_list[0] = ring_list_initial_block;
+        else
+        {
+            void *ptr = anon_mmap_alloc( RING_LIST_BLOCK_SIZE * sizeof(completion_ring_t *),
+                                         PROT_READ | PROT_WRITE );
+            if (ptr == MAP_FAILED) return FALSE;
+            ring_list[entry] = ptr;
+        }
+    }
+    __atomic_store_n( &ring_list[entry][idx], ring, __ATOMIC_RELEASE );
+    return TRUE;
+}
+
+/* Drop a ring from the cache, called with the fd cache mutex held. A lookup
+ * racing with the close either sees the ring or nothing, and the ring is
+ * unmapped once no thread may be using it anymore. */
+static void remove_from_list( HANDLE handle )
+{
+    UINT_PTR entry, idx = handle_to_index( handle, &entry );
+    completion_ring_t *ring;
+
+    if (entry >= RING_LIST_ENTRIES || !ring_list[entry]) return;
+    if (!(ring = __atomic_exchange_n( &ring_list[entry][idx], NULL, __ATOMIC_SEQ_CST ))) return;
+    TRACE( "dropping ring of %p\n", handle );
+    release_ring( ring );
+}
+
+/* Drops the cached rings of the handles of this process that another process
+ * closed with DUPLICATE_CLOSE_SOURCE, before their values get reused.
+ * Must be called with fd_cache_mutex held. */
+static void process_closed_handles(void)
+{
+    unsigned int pid = HandleToULong( NtCurrentTeb()->ClientId.UniqueProcess );
+    unsigned int serial, i, j;
+
+    if (!closed_handles) return;
+
+    serial = __atomic_load_n( &closed_handles->serial, __ATOMIC_ACQUIRE );
+    if (serial == closed_handles_serial) return;
+
+    if (serial - closed_handles_serial <= CLOSED_HANDLE_RING_SIZE)
+    {
+        for (i = closed_handles_serial; i != serial; i++)
+        {
+            const volatile struct closed_handle_entry *closed = &closed_handles->entries[i % CLOSED_HANDLE_RING_SIZE];
+            if (closed->pid == pid) remove_from_list( wine_server_ptr_handle( closed->handle ) );
+        }
+        /* make sure the entries weren't overwritten while we were reading them */
+        if (__atomic_load_n( &closed_handles->serial, __ATOMIC_ACQUIRE ) - closed_handles_serial
+                <= CLOSED_HANDLE_RING_SIZE)
+        {
+            closed_handles_serial = serial;
+            return;
+        }
+    }
+
+    /* we missed some entries, so drop the whole cache */
+    WARN( "closed handles ring overflowed, flushing the ring cache\n" );
+    for (i = 0; i < RING_LIST_ENTRIES; i++)
+    {
+        if (!ring_list[i]) continue;
+        for (j = 0; j < RING_LIST_BLOCK_SIZE; j++)
+        {
+            completion_ring_t *ring = __atomic_exchange_n( &ring_list[i][j], NULL, __ATOMIC_SEQ_CST );
+            if (ring) release_ring( ring );
+        }
+    }
+    closed_handles_serial = serial;
+}
+
+/* look up the ring of a port; the caller has to call put_ring once it's done with it */
+static completion_ring_t *get_ring( HANDLE handle )
+{
+    UINT_PTR entry, idx = handle_to_index( handle, &entry );
+    completion_ring_t *ring = NULL;
+    obj_handle_t fd_handle;
+    unsigned int status;
+    sigset_t sigset;
+    int fd, closed_fd;
+    void *ptr;
+
+    /* count ourselves before looking at the cache, see release_ring */
+    __atomic_add_fetch( &ring_users, 1, __ATOMIC_SEQ_CST );
+
+    if ((INT_PTR)handle <= 0 || entry >= RING_LIST_ENTRIES) return NULL;
+    if (ring_list[entry] && (ring = __atomic_load_n( &ring_list[entry][idx], __ATOMIC_SEQ_CST )) &&
+        (!closed_handles || __atomic_load_n( &closed_handles->serial, __ATOMIC_ACQUIRE ) == closed_handles_serial))
+        return ring == NO_RING ? NULL : ring;
+
+    /* the cache is also updated by NtClose, which holds the same mutex */
+    server_enter_uninterrupted_section( &fd_cache_mutex, &sigset );
+    process_closed_handles();
+    if (!ring_list[entry] || !(ring = ring_list[entry][idx]))
+    {
+        SERVER_START_REQ( get_completion_ring )
+        {
+            req->handle = wine_server_obj_handle( handle );
+            if (!(status = wine_server_call( req )))
+            {
+                fd = receive_fd( &fd_handle );
+                assert( wine_server_ptr_handle(fd_handle) == handle );
+                closed_fd = receive_fd( &fd_handle );
+                assert( !fd_handle );
+            }
+        }
+        SERVER_END_REQ;
+
+        if (!status)
+        {
+            if (!closed_handles)
+            {
+                ptr = mmap( NULL, sizeof(*closed_handles), PROT_READ, MAP_SHARED, closed_fd, 0 );
+                if (ptr != MAP_FAILED)
+                {
+                    closed_handles = ptr;
+                    closed_handles_serial = closed_handles->serial;
+                }
+            }
+            close( closed_fd );
+
+            /* without the closed handles ring we can't tell when a cached ring goes stale */
+            if (!closed_handles)
+            {
+                WARN( "failed to map the closed handles ring\n" );
+                ring = NO_RING;
+            }
+            else if ((ring = mmap( NULL, sizeof(*ring), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 )) == MAP_FAILED)
+            {
+                WARN( "failed to map the ring of %p\n", handle );
+                ring = NO_RING;
+            }
+            close( fd );
+        }
+        /* don't remember invalid handles, they may become valid ports later */
+        else if (status == STATUS_OBJECT_TYPE_MISMATCH || status == STATUS_ACCESS_DENIED) ring = NO_RING;
+
+        /* we still use it this time, if it can't be cached */
+        if (ring && !add_to_list( handle, ring )) release_ring( ring );
+    }
+    server_leave_uninterrupted_section( &fd_cache_mutex, &sigset );
+
+    TRACE( "handle %p -> ring %p\n", handle, ring );
+    return ring == NO_RING ? NULL : ring;
+}
+
+/* called with the fd cache mutex held */
+void iocp_ring_close( HANDLE handle )
+{
+    remove_from_list( handle );
+}
+
+/* bounded multi-producer multi-consumer queue, each slot sequence tells
+ * whether it is free or holds a packet for the current lap of the ring */
+
+/* fails if the ring is full, or if packets are queued on the server */
+static BOOL ring_push( completion_ring_t *ring, ULONG_PTR key, ULONG_PTR value, NTSTATUS status, SIZE_T count )
+{
+    volatile struct completion_ring_entry *entry;
+    unsigned __int64 tail = __atomic_load_n( &ring->tail, __ATOMIC_SEQ_CST );
+    unsigned int pos;
+    int diff;
+
+    for (;;)
+    {
+        /* the flag is part of the tail, so that it can't be set between our
+         * check and the push, which would put us ahead of the server packets */
+        if (tail & COMPLETION_RING_OVERFLOW) return FALSE;
+        pos = tail;
+        entry = &ring->entries[pos % COMPLETION_RING_SIZE];
+        diff = __atomic_load_n( &entry->seq, __ATOMIC_ACQUIRE ) - pos;
+        if (diff < 0) return FALSE;
+        if (!diff)
+        {
+            if (__atomic_compare_exchange_n( &ring->tail, &tail, (unsigned __int64)(pos + 1), 0,
+                                             __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST )) break;
+        }
+        else tail = __atomic_load_n( &ring->tail, __ATOMIC_SEQ_CST );
+    }
+
+    entry->ckey        = key;
+    entry->cvalue      = value;
+    entry->status      = status;
+    entry->information = count;
+    __atomic_store_n( &entry->seq, pos + 1, __ATOMIC_SEQ_CST );
+    return TRUE;
+}
+
+static BOOL ring_pop( completion_ring_t *ring, FILE_IO_COMPLETION_INFORMATION *info )
+{
+    volatile struct completion_ring_entry *entry;
+    unsigned int pos = __atomic_load_n( &ring->head, __ATOMIC_SEQ_CST );
+    int diff;
+
+    for (;;)
+    {
+        entry = &ring->entries[pos % COMPLETION_RING_SIZE];
+        diff = __atomic_load_n( &entry->seq, __ATOMIC_ACQUIRE ) - (pos + 1);
+        if (diff < 0) return FALSE;
+        if (!diff)
+        {
+            if (__atomic_compare_exchange_n( &ring->head, &pos, pos + 1, 0,
+                                             __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST )) break;
+        }
+        else pos = __atomic_load_n( &ring->head, __ATOMIC_SEQ_CST );
+    }
+
+    info->CompletionKey             = entry->ckey;
+    info->CompletionValue           = entry->cvalue;
+    info->IoStatusBlock.Status      = entry->status;
+    info->IoStatusBlock.Information = entry->information;
+    __atomic_store_n( &entry->seq, pos + COMPLETION_RING_SIZE, __ATOMIC_RELEASE );
+    return TRUE;
+}
+
+/* post a packet through the ring; returns STATUS_NOT_SUPPORTED if it has to go through the server */
+NTSTATUS iocp_ring_post( HANDLE handle, ULONG_PTR key, ULONG_PTR value, NTSTATUS status, SIZE_T count )
+{
+    completion_ring_t *ring = get_ring( handle );
+    unsigned int ret;
+    int waiters;
+
+    if (!ring || !ring_push( ring, key, value, status, count ))
+    {
+        put_ring();
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    /* the server counts a waiter before looking at the ring, so either it
+     * has seen our packet or we see the waiter here */
+    waiters = __atomic_load_n( &ring->waiters, __ATOMIC_SEQ_CST );
+    put_ring();
+    if (!waiters) return STATUS_SUCCESS;
+
+    SERVER_START_REQ( wake_completion )
+    {
+        req->handle = wine_server_obj_handle( handle );
+        ret = wine_server_call( req );
+    }
+    SERVER_END_REQ;
+    return ret;
+}
+
+/* dequeue a packet from the ring; returns STATUS_TIMEOUT if the port is empty,
+ * or STATUS_NOT_SUPPORTED if the server has to be asked */
+NTSTATUS iocp_ring_remove( HANDLE handle, FILE_IO_COMPLETION_INFORMATION *info )
+{
+    completion_ring_t *ring = get_ring( handle );
+    NTSTATUS status;
+
+    if (!ring) status = STATUS_NOT_SUPPORTED;
+    else if (ring_pop( ring, info )) status = STATUS_SUCCESS;
+    /* packets which did not fit in the ring are still queued on the server */
+    else if (__atomic_load_n( &ring->tail, __ATOMIC_SEQ_CST ) & COMPLETION_RING_OVERFLOW) status = STATUS_NOT_SUPPORTED;
+    else status = STATUS_TIMEOUT;
+    put_ring();
+    return status;
+}
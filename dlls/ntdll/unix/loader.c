@@ -90,6 +90,7 @@ extern char **environ;
 #include "unix_private.h"
 #include "esync.h"
 #include "fsync.h"
+#include "uring.h"
 #include "wine/list.h"
 #include "ntsyscalls.h"
 #include "wine/debug.h"
@@ -1201,6 +1202,8 @@ static const unixlib_entry_t unix_call_funcs[] =
     steamclient_setup_trampolines,
     is_pc_in_native_so,
     debugstr_pc,
+    uring_init,
+    uring_thread,
 };
 
 
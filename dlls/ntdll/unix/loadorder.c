@@ -300,27 +300,60 @@ static HANDLE open_app_key( const WCHAR *app_name )
 }
 
 
+/* registry load order values of the module names to look up, in order of priority */
+struct registry_values
+{
+    WCHAR         *names[3];     /* module names */
+    unsigned int   count;        /* number of module names */
+    BOOL           loaded;       /* whether the registry values have been retrieved */
+    enum loadorder app[3];       /* values from the per-application DllOverrides key */
+    enum loadorder std[3];       /* values from the standard DllOverrides key */
+};
+
+
 /***************************************************************************
- *	get_registry_value
+ *	get_registry_values
  *
- * Load the registry loadorder value for a given module.
+ * Load the registry loadorder values for all the module names in a single server round-trip.
  */
-static enum loadorder get_registry_value( HANDLE hkey, WCHAR *module )
+static void get_registry_values( HANDLE std_key, HANDLE app_key, struct registry_values *values )
 {
-    UNICODE_STRING valueW;
-    char buffer[80];
-    DWORD count;
+    struct __server_request_info reqs[2 * ARRAY_SIZE(values->names)];
+    WCHAR buffer[ARRAY_SIZE(reqs)][40];
+    enum loadorder *results[ARRAY_SIZE(reqs)];
+    unsigned int i, count = 0;
+    HANDLE keys[2] = { app_key, std_key };
+    enum loadorder *key_values[2] = { values->app, values->std };
+
+    values->loaded = TRUE;
+    for (i = 0; i < values->count; i++)
+    {
+        unsigned int j;
 
-    valueW.Length = wcslen( module ) * sizeof(WCHAR);
-    valueW.Buffer = module;
+        values->app[i] = values->std[i] = LO_INVALID;
+        for (j = 0; j < ARRAY_SIZE(keys); j++)
+        {
+            struct get_key_value_request *req;
+
+            if (!keys[j]) continue;
+            req = SERVER_BATCH_REQ( &reqs[count], get_key_value );
+            req->hkey = wine_server_obj_handle( keys[j] );
+            wine_server_add_data( req, values->names[i], wcslen( values->names[i] ) * sizeof(WCHAR) );
+            wine_server_set_reply( req, buffer[count], sizeof(buffer[count]) - sizeof(WCHAR) );
+            results[count++] = &key_values[j][i];
+        }
+    }
+    if (!count || server_call_batch( reqs, count )) return;
 
-    if (!NtQueryValueKey( hkey, &valueW, KeyValuePartialInformation,
-                                 buffer, sizeof(buffer), &count ))
+    for (i = 0; i < count; i++)
     {
-        WCHAR *str = (WCHAR *)((KEY_VALUE_PARTIAL_INFORMATION *)buffer)->Data;
-        return parse_load_order( str );
+        const struct get_key_value_reply *reply = &reqs[i].u.reply.get_key_value_reply;
+        data_size_t size = reqs[i].u.reply.reply_header.reply_size;
+
+        if (reqs[i].u.reply.reply_header.error || size < reply->total) continue;
+        buffer[i][size / sizeof(WCHAR)] = 0;
+        *results[i] = parse_load_order( buffer[i] );
     }
-    return LO_INVALID;
 }
 
 
@@ -332,8 +365,10 @@ static enum loadorder get_registry_value( HANDLE hkey, WCHAR *module )
  * 2. The per-application DllOverrides key
  * 3. The standard DllOverrides key
  */
-static enum loadorder get_load_order_value( HANDLE std_key, HANDLE app_key, WCHAR *module )
+static enum loadorder get_load_order_value( HANDLE std_key, HANDLE app_key,
+                                            struct registry_values *values, unsigned int index )
 {
+    WCHAR *module = values->names[index];
     enum loadorder ret;
 
     if ((ret = get_env_load_order( module )) != LO_INVALID)
@@ -342,13 +377,15 @@ static enum loadorder get_load_order_value( HANDLE std_key, HANDLE app_key, WCHA
         return ret;
     }
 
-    if (app_key && ((ret = get_registry_value( app_key, module )) != LO_INVALID))
+    if (!values->loaded) get_registry_values( std_key, app_key, values );
+
+    if ((ret = values->app[index]) != LO_INVALID)
     {
         TRACE( "got app defaults %s for %s\n", debugstr_loadorder(ret), debugstr_w(module) );
         return ret;
     }
 
-    if (std_key && ((ret = get_registry_value( std_key, module )) != LO_INVALID))
+    if ((ret = values->std[index]) != LO_INVALID)
     {
         TRACE( "got standard key %s for %s\n", debugstr_loadorder(ret), debugstr_w(module) );
         return ret;
@@ -401,7 +438,9 @@ enum loadorder get_load_order( const UNICODE_STRING *nt_name )
     enum loadorder ret = LO_INVALID;
     const WCHAR *path = nt_name->Buffer;
     const WCHAR *p;
+    struct registry_values values;
     WCHAR *module, *basename;
+    unsigned int i;
     int len;
 
     if (!init_done) init_load_order();
@@ -464,23 +503,39 @@ enum loadorder get_load_order( const UNICODE_STRING *nt_name )
     }
 
     if (!(len = wcslen(path))) return ret;
-    if (!(module = malloc( (len + 2) * sizeof(WCHAR) ))) return ret;
+    /* reserve room for the wildcard char and a copy of the basename */
+    if (!(module = malloc( (2 * len + 4) * sizeof(WCHAR) ))) return ret;
     wcscpy( module + 1, path );  /* reserve module[0] for the wildcard char */
     remove_dll_ext( module + 1 );
     basename = get_basename( module + 1 );
 
+    values.count = 0;
+    values.loaded = FALSE;
+
     /* first explicit module name */
-    if ((ret = get_load_order_value( std_key, app_key, module+1 )) != LO_INVALID)
-        goto done;
+    values.names[values.count++] = module + 1;
 
     /* then module basename preceded by '*' */
-    basename[-1] = '*';
-    if ((ret = get_load_order_value( std_key, app_key, basename-1 )) != LO_INVALID)
-        goto done;
+    if (basename == module + 1)
+    {
+        module[0] = '*';
+        values.names[values.count++] = module;
+    }
+    else
+    {
+        WCHAR *wildcard = module + wcslen( module + 1 ) + 2;
 
-    /* then module basename without '*' (only if explicit path) */
-    if (basename != module+1 && ((ret = get_load_order_value( std_key, app_key, basename )) != LO_INVALID))
-        goto done;
+        wildcard[0] = '*';
+        wcscpy( wildcard + 1, basename );
+        values.names[values.count++] = wildcard;
+
+        /* then module basename without '*' (only if explicit path) */
+        values.names[values.count++] = basename;
+    }
+
+    for (i = 0; i < values.count; i++)
+        if ((ret = get_load_order_value( std_key, app_key, &values, i )) != LO_INVALID)
+            goto done;
 
     /* if loading the main exe with an explicit path, try native first */
     if (!main_exe_loaded && basename != module+1)
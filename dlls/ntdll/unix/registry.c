@@ -44,26 +44,37 @@ WINE_DEFAULT_DEBUG_CHANNEL(reg);
 #define MAX_VALUE_LENGTH (16383 * sizeof(WCHAR))
 
 
-NTSTATUS open_hkcu_key( const char *path, HANDLE *key )
+/* format the registry path of the current user key */
+static NTSTATUS get_hkcu_name( char *buffer, DWORD size, DWORD *ret_len )
 {
     NTSTATUS status;
-    char buffer[256];
-    WCHAR bufferW[256];
     DWORD_PTR sid_data[(sizeof(TOKEN_USER) + SECURITY_MAX_SID_SIZE) / sizeof(DWORD_PTR)];
     DWORD i, len = sizeof(sid_data);
     SID *sid;
-    UNICODE_STRING name;
-    OBJECT_ATTRIBUTES attr;
 
     status = NtQueryInformationToken( GetCurrentThreadEffectiveToken(), TokenUser, sid_data, len, &len );
     if (status) return status;
 
     sid = ((TOKEN_USER *)sid_data)->User.Sid;
-    len = snprintf( buffer, sizeof(buffer), "\\Registry\\User\\S-%u-%u", sid->Revision,
+    len = snprintf( buffer, size, "\\Registry\\User\\S-%u-%u", sid->Revision,
                    (int)MAKELONG( MAKEWORD( sid->IdentifierAuthority.Value[5], sid->IdentifierAuthority.Value[4] ),
                                   MAKEWORD( sid->IdentifierAuthority.Value[3], sid->IdentifierAuthority.Value[2] )));
     for (i = 0; i < sid->SubAuthorityCount; i++)
-        len += snprintf( buffer + len, sizeof(buffer) - len, "-%u", (int)sid->SubAuthority[i] );
+        len += snprintf( buffer + len, size - len, "-%u", (int)sid->SubAuthority[i] );
+    *ret_len = len;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS open_hkcu_key( const char *path, HANDLE *key )
+{
+    NTSTATUS status;
+    char buffer[256];
+    WCHAR bufferW[256];
+    DWORD len;
+    UNICODE_STRING name;
+    OBJECT_ATTRIBUTES attr;
+
+    if ((status = get_hkcu_name( buffer, sizeof(buffer), &len ))) return status;
     len += snprintf( buffer + len, sizeof(buffer) - len, "\\%s", path );
 
     ascii_to_unicode( bufferW, buffer, len + 1 );
@@ -72,6 +83,68 @@ NTSTATUS open_hkcu_key( const char *path, HANDLE *key )
     return NtCreateKey( key, KEY_ALL_ACCESS, &attr, 0, NULL, 0, NULL );
 }
 
+/* open several keys in a single server round-trip; keys of the current user
+ * are created if needed, like with open_hkcu_key() */
+void open_registry_keys( struct open_key_info *keys, unsigned int count )
+{
+    struct __server_request_info *reqs;
+    struct object_attributes **objattr;
+    char buffer[256];
+    WCHAR bufferW[256];
+    DWORD hkcu_len = 0, len;
+    UNICODE_STRING name;
+    OBJECT_ATTRIBUTES attr;
+    unsigned int i, status;
+
+    for (i = 0; i < count; i++) keys[i].key = 0;
+    if (!(reqs = calloc( count, sizeof(*reqs) + sizeof(*objattr) ))) return;
+    objattr = (void *)(reqs + count);
+
+    for (i = 0; i < count; i++)
+    {
+        if (keys[i].hkcu_path)
+        {
+            struct create_key_request *req;
+            data_size_t size;
+
+            if (!hkcu_len && get_hkcu_name( buffer, sizeof(buffer), &hkcu_len )) break;
+            len = hkcu_len + snprintf( buffer + hkcu_len, sizeof(buffer) - hkcu_len, "\\%s", keys[i].hkcu_path );
+            ascii_to_unicode( bufferW, buffer, len + 1 );
+            init_unicode_string( &name, bufferW );
+            InitializeObjectAttributes( &attr, &name, OBJ_CASE_INSENSITIVE | OBJ_OPENIF, 0, NULL );
+            if (alloc_object_attributes( &attr, &objattr[i], &size )) break;
+
+            req = SERVER_BATCH_REQ( &reqs[i], create_key );
+            req->access = keys[i].access;
+            wine_server_add_data( req, objattr[i], size );
+        }
+        else
+        {
+            struct open_key_request *req = SERVER_BATCH_REQ( &reqs[i], open_key );
+
+            req->access     = keys[i].access;
+            req->attributes = OBJ_CASE_INSENSITIVE;
+            wine_server_add_data( req, keys[i].name, wcslen( keys[i].name ) * sizeof(WCHAR) );
+        }
+    }
+
+    if (i == count && !server_call_batch( reqs, count ))
+    {
+        for (i = 0; i < count; i++)
+        {
+            status = reqs[i].u.reply.reply_header.error;
+            if (status && status != STATUS_OBJECT_NAME_EXISTS) continue;
+            if (keys[i].hkcu_path)
+                keys[i].key = wine_server_ptr_handle( reqs[i].u.reply.create_key_reply.hkey );
+            else
+                keys[i].key = wine_server_ptr_handle( reqs[i].u.reply.open_key_reply.hkey );
+        }
+    }
+
+    for (i = 0; i < count; i++) free( objattr[i] );
+    free( reqs );
+}
+
 /* dump a Unicode string with proper escaping */
 int dump_strW( const WCHAR *str, data_size_t len, FILE *f, const char escape[2] )
 {
@@ -811,8 +884,85 @@ NTSTATUS WINAPI NtQueryValueKey( HANDLE handle, const UNICODE_STRING *name,
 NTSTATUS WINAPI NtQueryMultipleValueKey( HANDLE key, KEY_MULTIPLE_VALUE_INFORMATION *info,
                                          ULONG count, void *buffer, ULONG length, ULONG *retlen )
 {
-    FIXME( "(%p,%p,0x%08x,%p,0x%08x,%p) stub!\n", key, info, (int)count, buffer, (int)length, retlen );
-    return STATUS_SUCCESS;
+    struct __server_request_info *reqs;
+    struct { char *ptr; ULONG size; } *dst;
+    ULONG i, pos, slot;
+    unsigned int ret;
+    BOOL done;
+
+    TRACE( "(%p,%p,%u,%p,%u,%p)\n", key, info, (int)count, buffer, (int)length, retlen );
+
+    for (i = 0; i < count; i++)
+        if (info[i].ValueName->Length > MAX_VALUE_LENGTH) return STATUS_OBJECT_NAME_NOT_FOUND;
+
+    if (!count)
+    {
+        if (retlen) *retlen = 0;
+        return STATUS_SUCCESS;
+    }
+    if (!(reqs = malloc( count * (sizeof(*reqs) + sizeof(*dst) )))) return STATUS_NO_MEMORY;
+    dst = (void *)(reqs + count);
+
+    /* optimistically split the buffer between the values, so that small values
+     * are retrieved in a single round-trip, and compact the data afterwards */
+    slot = (length / count) & ~(sizeof(ULONG_PTR) - 1);
+    for (i = 0; i < count; i++)
+    {
+        dst[i].ptr = slot ? (char *)buffer + i * slot : NULL;
+        dst[i].size = slot;
+    }
+
+    for (;;)
+    {
+        for (i = 0; i < count; i++)
+        {
+            struct get_key_value_request *req = SERVER_BATCH_REQ( &reqs[i], get_key_value );
+            req->hkey = wine_server_obj_handle( key );
+            wine_server_add_data( req, info[i].ValueName->Buffer, info[i].ValueName->Length );
+            if (dst[i].size) wine_server_set_reply( req, dst[i].ptr, dst[i].size );
+        }
+        if ((ret = server_call_batch( reqs, count ))) break;
+
+        done = TRUE;
+        for (i = pos = 0; i < count; i++)
+        {
+            const struct get_key_value_reply *reply = &reqs[i].u.reply.get_key_value_reply;
+
+            if ((ret = reqs[i].u.reply.reply_header.error)) break;
+            pos = (pos + sizeof(ULONG_PTR) - 1) & ~(sizeof(ULONG_PTR) - 1);
+            info[i].Type = reply->type;
+            info[i].DataLength = reply->total;
+            info[i].DataOffset = pos;
+            if (reqs[i].u.reply.reply_header.reply_size != reply->total) done = FALSE;
+            pos += reply->total;
+        }
+        if (ret) break;
+
+        if (retlen) *retlen = pos;
+        if (pos > length)
+        {
+            ret = STATUS_BUFFER_OVERFLOW;
+            break;
+        }
+        if (done)
+        {
+            /* each value only moves towards the start of the buffer */
+            for (i = 0; i < count; i++)
+                if (info[i].DataLength)
+                    memmove( (char *)buffer + info[i].DataOffset, dst[i].ptr, info[i].DataLength );
+            break;
+        }
+
+        /* now that the sizes are known, retrieve the data at its final location */
+        for (i = 0; i < count; i++)
+        {
+            dst[i].ptr = (char *)buffer + info[i].DataOffset;
+            dst[i].size = info[i].DataLength;
+        }
+    }
+
+    free( reqs );
+    return ret;
 }
 
 
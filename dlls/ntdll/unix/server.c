@@ -81,6 +81,8 @@
 #include "unix_private.h"
 #include "esync.h"
 #include "fsync.h"
+#include "iocp.h"
+#include "uring.h"
 #include "ddk/wdm.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(server);
@@ -94,6 +96,10 @@ WINE_DECLARE_DEBUG_CHANNEL(ftrace);
 #define SOCKETNAME "socket"        /* name of the socket file */
 #define LOCKNAME   "lock"          /* name of the lock file */
 
+#define MAX_BATCH_REQUESTS 16       /* max number of requests sent to the server at once */
+#define BATCH_ALIGNMENT 8           /* alignment of the requests and replies in a batch */
+#define BATCH_ALIGN(size) (((size) + BATCH_ALIGNMENT - 1) & ~(BATCH_ALIGNMENT - 1))
+
 static const char *server_dir;
 
 unsigned int supported_machines_count = 0;
@@ -292,6 +298,99 @@ unsigned int CDECL wine_server_call( void *req_ptr )
 }
 
 
+/***********************************************************************
+ *           server_call_batch
+ *
+ * Perform several independent server calls in a single round-trip.
+ * The status of each call is returned in its reply header; the return
+ * value is the status of the batch itself.
+ */
+unsigned int server_call_batch( struct __server_request_info *reqs, unsigned int count )
+{
+    static const char padding[BATCH_ALIGNMENT];
+    struct iovec vec[1 + MAX_BATCH_REQUESTS * (__SERVER_MAX_DATA + 2)];
+    union generic_request header;
+    union generic_reply reply;
+    unsigned int i, j, n, done, nb_vec, ret = STATUS_SUCCESS;
+    data_size_t size, req_size, reply_size;
+    char buffer[BATCH_ALIGNMENT];
+    sigset_t old_set;
+    int res;
+
+    pthread_sigmask( SIG_BLOCK, &server_block_set, &old_set );
+    for (done = 0; done < count && !ret; done += n)
+    {
+        n = min( count - done, MAX_BATCH_REQUESTS );
+        if (n == 1)
+        {
+            if ((res = server_call_unlocked( &reqs[done] )) == STATUS_ACCESS_VIOLATION)
+                reqs[done].u.reply.reply_header.error = res;
+            continue;
+        }
+
+        memset( &header, 0, sizeof(header) );
+        header.request_header.req = REQ_batch_requests;
+        req_size = reply_size = 0;
+        nb_vec = 1;
+        for (i = done; i < done + n; i++)
+        {
+            size = reqs[i].u.req.request_header.request_size;
+            vec[nb_vec].iov_base = &reqs[i].u.req;
+            vec[nb_vec++].iov_len = sizeof(reqs[i].u.req);
+            for (j = 0; j < reqs[i].data_count; j++)
+            {
+                vec[nb_vec].iov_base = (void *)reqs[i].data[j].ptr;
+                vec[nb_vec++].iov_len = reqs[i].data[j].size;
+            }
+            if (BATCH_ALIGN( size ) != size)
+            {
+                vec[nb_vec].iov_base = (void *)padding;
+                vec[nb_vec++].iov_len = BATCH_ALIGN( size ) - size;
+            }
+            req_size += sizeof(reqs[i].u.req) + BATCH_ALIGN( size );
+            reply_size += sizeof(reqs[i].u.reply) + BATCH_ALIGN( reqs[i].u.req.request_header.reply_size );
+        }
+        header.request_header.request_size = req_size;
+        header.request_header.reply_size = reply_size;
+        vec[0].iov_base = &header;
+        vec[0].iov_len = sizeof(header);
+
+        TRACE_(client)( "batch of %u requests start\n", n );
+        if ((res = writev( ntdll_get_thread_data()->request_fd, vec, nb_vec )) != sizeof(header) + req_size)
+        {
+            if (res >= 0) server_protocol_error( "partial write %d\n", res );
+            if (errno == EPIPE) abort_thread(0);
+            if (errno != EFAULT) server_protocol_perror( "write" );
+            ret = STATUS_ACCESS_VIOLATION;
+            break;
+        }
+
+        read_reply_data( &reply, sizeof(reply) );
+        ret = reply.reply_header.error;
+        for (i = 0; i < n; i++)
+        {
+            struct __server_request_info *req = &reqs[done + i];
+
+            if (i < reply.batch_requests_reply.count)
+            {
+                read_reply_data( &req->u.reply, sizeof(req->u.reply) );
+                size = req->u.reply.reply_header.reply_size;
+                if (size) read_reply_data( req->reply_data, size );
+                if (BATCH_ALIGN( size ) != size) read_reply_data( buffer, BATCH_ALIGN( size ) - size );
+            }
+            else
+            {
+                memset( &req->u.reply, 0, sizeof(req->u.reply) );
+                req->u.reply.reply_header.error = ret ? ret : STATUS_INTERNAL_ERROR;
+            }
+        }
+        TRACE_(client)( "batch of %u requests end\n", n );
+    }
+    pthread_sigmask( SIG_SETMASK, &old_set, NULL );
+    return ret;
+}
+
+
 /***********************************************************************
  *           unixcall_wine_server_call
  *
@@ -1792,12 +1891,18 @@ NTSTATUS WINAPI NtDuplicateObject( HANDLE source_process, HANDLE source, HANDLE
         return result.dup_handle.status;
     }
 
+    if ((options & DUPLICATE_CLOSE_SOURCE) && do_uring())
+        uring_close( source );
+
     server_enter_uninterrupted_section( &fd_cache_mutex, &sigset );
 
     /* always remove the cached fd; if the server request fails we'll just
      * retrieve it again */
     if (options & DUPLICATE_CLOSE_SOURCE)
+    {
         fd = remove_fd_from_cache( source );
+        if (do_iocp_ring()) iocp_ring_close( source );
+    }
 
     SERVER_START_REQ( dup_handle )
     {
@@ -1853,6 +1958,10 @@ NTSTATUS WINAPI NtClose( HANDLE handle )
     if (HandleToLong( handle ) >= ~5 && HandleToLong( handle ) <= ~0)
         return STATUS_SUCCESS;
 
+    /* pending requests may need the handle, and fd_cache_mutex, to complete */
+    if (do_uring())
+        uring_close( handle );
+
     server_enter_uninterrupted_section( &fd_cache_mutex, &sigset );
 
     /* always remove the cached fd; if the server request fails we'll just
@@ -1865,6 +1974,9 @@ NTSTATUS WINAPI NtClose( HANDLE handle )
     if (do_esync())
         esync_close( handle );
 
+    if (do_iocp_ring())
+        iocp_ring_close( handle );
+
     SERVER_START_REQ( close_handle )
     {
         req->handle = wine_server_obj_handle( handle );
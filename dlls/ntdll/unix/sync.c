@@ -68,6 +68,7 @@
 #include "unix_private.h"
 #include "esync.h"
 #include "fsync.h"
+#include "iocp.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(sync);
 
@@ -2007,6 +2008,9 @@ NTSTATUS WINAPI NtSetIoCompletion( HANDLE handle, ULONG_PTR key, ULONG_PTR value
 
     TRACE( "(%p, %lx, %lx, %x, %lx)\n", handle, key, value, (int)status, count );
 
+    if (do_iocp_ring() && (ret = iocp_ring_post( handle, key, value, status, count )) != STATUS_NOT_SUPPORTED)
+        return ret;
+
     SERVER_START_REQ( add_completion )
     {
         req->handle      = wine_server_obj_handle( handle );
@@ -2027,6 +2031,7 @@ NTSTATUS WINAPI NtSetIoCompletion( HANDLE handle, ULONG_PTR key, ULONG_PTR value
 NTSTATUS WINAPI NtRemoveIoCompletion( HANDLE handle, ULONG_PTR *key, ULONG_PTR *value,
                                       IO_STATUS_BLOCK *io, LARGE_INTEGER *timeout )
 {
+    FILE_IO_COMPLETION_INFORMATION info;
     unsigned int status;
     int waited = 0;
 
@@ -2034,6 +2039,19 @@ NTSTATUS WINAPI NtRemoveIoCompletion( HANDLE handle, ULONG_PTR *key, ULONG_PTR *
 
     for (;;)
     {
+        if (do_iocp_ring() && (status = iocp_ring_remove( handle, &info )) != STATUS_NOT_SUPPORTED)
+        {
+            if (!status)
+            {
+                *key   = info.CompletionKey;
+                *value = info.CompletionValue;
+                *io    = info.IoStatusBlock;
+                return status;
+            }
+            /* the port is empty, only go to the server if we are going to wait */
+            if (timeout && !timeout->QuadPart) return status;
+        }
+
         SERVER_START_REQ( remove_completion )
         {
             req->handle = wine_server_obj_handle( handle );
@@ -2071,6 +2089,22 @@ NTSTATUS WINAPI NtRemoveIoCompletionEx( HANDLE handle, FILE_IO_COMPLETION_INFORM
     {
         while (i < count)
         {
+            if (do_iocp_ring() && (status = iocp_ring_remove( handle, &info[i] )) != STATUS_NOT_SUPPORTED)
+            {
+                if (!status)
+                {
+                    ++i;
+                    continue;
+                }
+                /* the port is empty, only go to the server if we are going to wait */
+                if (i)
+                {
+                    status = STATUS_PENDING;
+                    break;
+                }
+                if (timeout && !timeout->QuadPart && !alertable) break;
+            }
+
             SERVER_START_REQ( remove_completion )
             {
                 req->handle = wine_server_obj_handle( handle );
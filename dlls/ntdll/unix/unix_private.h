@@ -103,6 +103,7 @@ struct ntdll_thread_data
     PRTL_THREAD_START_ROUTINE start;  /* thread entry point */
     void              *param;         /* thread entry point parameter */
     void              *jmp_buf;       /* setjmp buffer for exception handling */
+    BOOL               virtual_shared; /* whether the thread holds the virtual lock shared */
 };
 
 C_ASSERT( sizeof(struct ntdll_thread_data) <= sizeof(((TEB *)0)->GdiTebBatch) );
@@ -208,6 +209,7 @@ extern NTSTATUS load_start_exe( WCHAR **image, void **module );
 extern void start_server( BOOL debug );
 
 extern unsigned int server_call_unlocked( void *req_ptr );
+extern unsigned int server_call_batch( struct __server_request_info *reqs, unsigned int count );
 extern void server_enter_uninterrupted_section( pthread_mutex_t *mutex, sigset_t *sigset );
 extern void server_leave_uninterrupted_section( pthread_mutex_t *mutex, sigset_t *sigset );
 extern unsigned int server_select( const select_op_t *select_op, data_size_t size, UINT flags,
@@ -328,6 +330,17 @@ extern NTSTATUS set_thread_wow64_context( HANDLE handle, const void *ctx, ULONG
 extern void fill_vm_counters( VM_COUNTERS_EX *pvmi, int unix_pid );
 extern NTSTATUS open_hkcu_key( const char *path, HANDLE *key );
 
+/* key to open with open_registry_keys */
+struct open_key_info
+{
+    const WCHAR *name;       /* full path of the key */
+    const char  *hkcu_path;  /* or path of a key of the current user */
+    ACCESS_MASK  access;     /* desired access */
+    HANDLE       key;        /* opened key, 0 on failure */
+};
+
+extern void open_registry_keys( struct open_key_info *keys, unsigned int count );
+
 extern NTSTATUS cdrom_DeviceIoControl( HANDLE device, HANDLE event, PIO_APC_ROUTINE apc, void *apc_user,
                                        IO_STATUS_BLOCK *io, UINT code, void *in_buffer,
                                        UINT in_size, void *out_buffer, UINT out_size );
@@ -450,6 +463,20 @@ static inline async_data_t server_async( HANDLE handle, struct async_fileio *use
     return async;
 }
 
+/* initialize a request to be sent with server_call_batch */
+#define SERVER_BATCH_REQ(info,type) \
+    ((struct type##_request *)init_batch_request( (info), REQ_##type, #type ))
+
+static inline void *init_batch_request( struct __server_request_info *info, enum request type, const char *name )
+{
+    memset( &info->u.req, 0, sizeof(info->u.req) );
+    info->name = name;
+    info->u.req.request_header.req = type;
+    info->data_count = 0;
+    info->reply_data = NULL;
+    return &info->u.req;
+}
+
 static inline NTSTATUS wait_async( HANDLE handle, BOOL alertable )
 {
     return NtWaitForSingleObject( handle, alertable, NULL );
@@ -0,0 +1,531 @@
+/*
+ * io_uring-based asynchronous file I/O
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#if 0
+#pragma makedep unix
+#endif
+
+#include "config.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#ifdef HAVE_LINUX_IO_URING_H
+# include <linux/io_uring.h>
+#endif
+#include <unistd.h>
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#include "windef.h"
+#include "winternl.h"
+#include "wine/list.h"
+#include "wine/server.h"
+#include "wine/debug.h"
+
+#include "unix_private.h"
+#include "uring.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(file);
+
+#if defined(HAVE_LINUX_IO_URING_H) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+
+/* Overlapped reads and writes on regular files are queued to a per-process
+ * ring instead of being performed synchronously by the calling thread, so that
+ * many requests can be in flight at once. Completions are reaped by a hidden
+ * thread, which fills the IOSB, signals the event and posts the completion
+ * packet exactly like the synchronous path would have done. Requests use the
+ * caller's handles; when the file or the event handle of a pending request is
+ * closed, the request takes a duplicate of it, like the kernel keeps the file
+ * and event objects alive until the I/O is done. Only requests with an event
+ * are queued, since completing them here doesn't signal the file object,
+ * which callers without an event may wait on. */
+
+#define URING_ENTRIES 256
+
+struct uring_request
+{
+    struct list   entry;    /* entry in pending list */
+    HANDLE        handle;   /* file handle passed by the caller, or its duplicate */
+    HANDLE        event;    /* event to signal on completion, its duplicate, or 0 */
+    ULONG_PTR     cvalue;   /* completion port value, or 0 */
+    client_ptr_t  iosb;     /* I/O status block */
+    void         *buffer;   /* user buffer */
+    ULONG         length;   /* buffer length */
+    ULONGLONG     offset;   /* file offset */
+    DWORD         tid;      /* thread that queued the request */
+    BOOL          write;    /* is this a write request? */
+    BOOL          reaped;   /* the result was reaped, the request is being completed */
+    BOOL          cancelled; /* a cancel request was submitted for it */
+    BOOL          own_file;  /* the file handle is a duplicate owned by the request */
+    BOOL          own_event; /* the event handle is a duplicate owned by the request */
+};
+
+static struct
+{
+    int                  fd;
+    unsigned int         entries;   /* number of completion entries */
+    unsigned int        *sq_head;
+    unsigned int        *sq_tail;
+    unsigned int        *sq_mask;
+    unsigned int        *sq_array;
+    struct io_uring_sqe *sqes;
+    unsigned int        *cq_head;
+    unsigned int        *cq_tail;
+    unsigned int        *cq_mask;
+    struct io_uring_cqe *cqes;
+} ring = { -1 };
+
+static pthread_mutex_t ring_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t request_done = PTHREAD_COND_INITIALIZER;  /* signaled when requests are completed */
+static struct list pending_requests = LIST_INIT( pending_requests );
+static unsigned int inflight;  /* number of submitted entries not reaped yet */
+static int uring_enabled;      /* set once the completion thread is running */
+
+static int uring_setup( unsigned int entries, struct io_uring_params *params )
+{
+    return syscall( __NR_io_uring_setup, entries, params );
+}
+
+static int uring_enter( unsigned int to_submit, unsigned int min_complete, unsigned int flags )
+{
+    return syscall( __NR_io_uring_enter, ring.fd, to_submit, min_complete, flags, NULL, 0 );
+}
+
+/* create and map the ring; returns TRUE on success */
+static BOOL init_ring(void)
+{
+    struct io_uring_params params;
+    size_t sq_size, cq_size;
+    char *sq_ptr, *cq_ptr;
+    int fd;
+
+    memset( &params, 0, sizeof(params) );
+    if ((fd = uring_setup( URING_ENTRIES, &params )) == -1)
+    {
+        WARN( "io_uring_setup failed: %s\n", strerror( errno ));
+        return FALSE;
+    }
+    /* we need IORING_OP_READ/WRITE and no dropped completions */
+    if (!(params.features & IORING_FEAT_NODROP) || !(params.features & IORING_FEAT_RW_CUR_POS))
+    {
+        WARN( "io_uring is too old, features %#x\n", params.features );
+        close( fd );
+        return FALSE;
+    }
+
+    sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) sq_size = cq_size = max( sq_size, cq_size );
+
+    sq_ptr = mmap( NULL, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING );
+    if (sq_ptr == MAP_FAILED) goto failed;
+    if (params.features & IORING_FEAT_SINGLE_MMAP) cq_ptr = sq_ptr;
+    else
+    {
+        cq_ptr = mmap( NULL, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING );
+        if (cq_ptr == MAP_FAILED) goto failed;
+    }
+    ring.sqes = mmap( NULL, params.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES );
+    if (ring.sqes == MAP_FAILED) goto failed;
+
+    ring.sq_head  = (unsigned int *)(sq_ptr + params.sq_off.head);
+    ring.sq_tail  = (unsigned int *)(sq_ptr + params.sq_off.tail);
+    ring.sq_mask  = (unsigned int *)(sq_ptr + params.sq_off.ring_mask);
+    ring.sq_array = (unsigned int *)(sq_ptr + params.sq_off.array);
+    ring.cq_head  = (unsigned int *)(cq_ptr + params.cq_off.head);
+    ring.cq_tail  = (unsigned int *)(cq_ptr + params.cq_off.tail);
+    ring.cq_mask  = (unsigned int *)(cq_ptr + params.cq_off.ring_mask);
+    ring.cqes     = (struct io_uring_cqe *)(cq_ptr + params.cq_off.cqes);
+    ring.entries  = min( params.sq_entries, params.cq_entries );
+    ring.fd       = fd;
+    TRACE( "initialized ring with %u entries\n", ring.entries );
+    return TRUE;
+
+failed:
+    WARN( "failed to map the ring: %s\n", strerror( errno ));
+    close( fd );
+    return FALSE;
+}
+
+int do_uring(void)
+{
+    return __atomic_load_n( &uring_enabled, __ATOMIC_ACQUIRE );
+}
+
+/***********************************************************************
+ *           uring_init
+ *
+ * Create the ring if enabled. On success, the caller starts the completion
+ * thread, and requests are queued to the ring once it runs.
+ */
+NTSTATUS uring_init( void *args )
+{
+    /* the completion thread only knows about native IOSBs */
+    if (!getenv("WINEURING") || !atoi(getenv("WINEURING")) || is_wow64()) return STATUS_NOT_SUPPORTED;
+    if (ring.fd == -1 && !init_ring()) return STATUS_NOT_SUPPORTED;
+    return STATUS_SUCCESS;
+}
+
+/* the caller must hold ring_mutex */
+static struct io_uring_sqe *get_sqe(void)
+{
+    unsigned int tail = *ring.sq_tail, index = tail & *ring.sq_mask;
+    struct io_uring_sqe *sqe = &ring.sqes[index];
+
+    memset( sqe, 0, sizeof(*sqe) );
+    ring.sq_array[index] = index;
+    return sqe;
+}
+
+/* the caller must hold ring_mutex */
+static BOOL submit_sqe(void)
+{
+    unsigned int tail = *ring.sq_tail;
+    int ret;
+
+    __atomic_store_n( ring.sq_tail, tail + 1, __ATOMIC_RELEASE );
+    /* submit right away, so that the kernel holds its own reference to the file */
+    while ((ret = uring_enter( 1, 0, 0 )) == -1 && errno == EINTR);
+    if (ret == 1)
+    {
+        inflight++;
+        return TRUE;
+    }
+    WARN( "io_uring_enter failed: %s\n", ret == -1 ? strerror( errno ) : "no entry consumed" );
+    __atomic_store_n( ring.sq_tail, tail, __ATOMIC_RELEASE );
+    return FALSE;
+}
+
+static NTSTATUS queue_request( int fd, HANDLE handle, HANDLE event, ULONG_PTR cvalue, client_ptr_t iosb,
+                               void *buffer, ULONG length, ULONGLONG offset, BOOL write )
+{
+    struct uring_request *req;
+    struct io_uring_sqe *sqe;
+    BOOL ret;
+
+    if (!(req = malloc( sizeof(*req) ))) return STATUS_NOT_SUPPORTED;
+    req->handle = handle;
+    req->event  = event;
+    req->cvalue = cvalue;
+    req->iosb   = iosb;
+    req->buffer = buffer;
+    req->length = length;
+    req->offset = offset;
+    req->tid    = GetCurrentThreadId();
+    req->write  = write;
+    req->reaped = FALSE;
+    req->cancelled = FALSE;
+    req->own_file = FALSE;
+    req->own_event = FALSE;
+
+    if (event) NtResetEvent( event, NULL );
+
+    pthread_mutex_lock( &ring_mutex );
+    /* leave room for cancel requests, the completion queue must never overflow */
+    if (inflight >= ring.entries / 2) ret = FALSE;
+    else
+    {
+        sqe = get_sqe();
+        sqe->opcode    = write ? IORING_OP_WRITE : IORING_OP_READ;
+        sqe->fd        = fd;
+        sqe->addr      = (ULONG_PTR)buffer;
+        sqe->len       = length;
+        sqe->off       = offset;
+        sqe->user_data = (ULONG_PTR)req;
+        list_add_tail( &pending_requests, &req->entry );
+        if (!(ret = submit_sqe())) list_remove( &req->entry );
+    }
+    pthread_mutex_unlock( &ring_mutex );
+
+    if (!ret)
+    {
+        free( req );
+        return STATUS_NOT_SUPPORTED;
+    }
+    TRACE( "queued %s %p handle %p len %u offset %s\n", write ? "write" : "read",
+           req, handle, (int)length, wine_dbgstr_longlong( offset ));
+    return STATUS_PENDING;
+}
+
+/***********************************************************************
+ *           uring_read_file
+ *
+ * Queue an overlapped read on a regular file. Returns STATUS_NOT_SUPPORTED
+ * if the request couldn't be queued and the caller needs to fall back to the
+ * synchronous path.
+ */
+NTSTATUS uring_read_file( int fd, HANDLE handle, HANDLE event, ULONG_PTR cvalue, client_ptr_t iosb,
+                          void *buffer, ULONG length, ULONGLONG offset )
+{
+    return queue_request( fd, handle, event, cvalue, iosb, buffer, length, offset, FALSE );
+}
+
+/***********************************************************************
+ *           uring_write_file
+ */
+NTSTATUS uring_write_file( int fd, HANDLE handle, HANDLE event, ULONG_PTR cvalue, client_ptr_t iosb,
+                           const void *buffer, ULONG length, ULONGLONG offset )
+{
+    return queue_request( fd, handle, event, cvalue, iosb, (void *)buffer, length, offset, TRUE );
+}
+
+/* the caller must hold ring_mutex */
+static unsigned int cancel_requests( HANDLE handle, client_ptr_t iosb, BOOL only_thread )
+{
+    DWORD tid = GetCurrentThreadId();
+    struct uring_request *req;
+    struct io_uring_sqe *sqe;
+    unsigned int count = 0;
+
+    LIST_FOR_EACH_ENTRY( req, &pending_requests, struct uring_request, entry )
+    {
+        if (req->handle != handle || req->reaped) continue;
+        if (iosb && req->iosb != iosb) continue;
+        if (only_thread && req->tid != tid) continue;
+
+        /* a request is cancelled only once, so that with at most half of the
+         * entries used by requests the completion queue can't overflow */
+        if (!req->cancelled)
+        {
+            if (inflight >= ring.entries) break;
+            sqe = get_sqe();
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->addr   = (ULONG_PTR)req;
+            if (!(req->cancelled = submit_sqe())) continue;
+        }
+        count++;
+    }
+
+    TRACE( "handle %p iosb %s cancelled %u requests\n", handle, wine_dbgstr_longlong( iosb ), count );
+    return count;
+}
+
+/***********************************************************************
+ *           uring_cancel
+ *
+ * Cancel the requests queued on a handle, either for a given IOSB or all of
+ * those queued by the current thread. Returns STATUS_NOT_FOUND if there were
+ * none; the cancelled requests complete with STATUS_CANCELLED, unless they
+ * were already done.
+ */
+NTSTATUS uring_cancel( HANDLE handle, client_ptr_t iosb, BOOL only_thread )
+{
+    unsigned int count;
+
+    pthread_mutex_lock( &ring_mutex );
+    count = cancel_requests( handle, iosb, only_thread );
+    pthread_mutex_unlock( &ring_mutex );
+    return count ? STATUS_SUCCESS : STATUS_NOT_FOUND;
+}
+
+/* replace a handle of a request by a duplicate; the caller must hold ring_mutex */
+static BOOL duplicate_request_handle( HANDLE *handle, BOOL *owned )
+{
+    HANDLE dup;
+
+    if (NtDuplicateObject( NtCurrentProcess(), *handle, NtCurrentProcess(), &dup, 0, 0, DUPLICATE_SAME_ACCESS ))
+        return FALSE;
+    *handle = dup;
+    *owned = TRUE;
+    return TRUE;
+}
+
+/***********************************************************************
+ *           uring_close
+ *
+ * Cancel the requests queued through a file handle that is being closed, and
+ * make the pending requests using the handle, either as their file or their
+ * event, hold a duplicate of it instead. Only requests which are being
+ * completed, or whose handle can't be duplicated, are waited for.
+ * Must be called before taking fd_cache_mutex, which completions may need.
+ */
+void uring_close( HANDLE handle )
+{
+    struct uring_request *req;
+    sigset_t sigset;
+    BOOL busy;
+
+    server_enter_uninterrupted_section( &ring_mutex, &sigset );
+    cancel_requests( handle, 0, FALSE );
+    do
+    {
+        busy = FALSE;
+        LIST_FOR_EACH_ENTRY( req, &pending_requests, struct uring_request, entry )
+        {
+            /* the completion thread only reads the handles once the request is reaped */
+            if (!req->reaped && req->handle == handle &&
+                duplicate_request_handle( &req->handle, &req->own_file ))
+                TRACE( "request %p now uses file handle %p\n", req, req->handle );
+            if (!req->reaped && req->event == handle &&
+                duplicate_request_handle( &req->event, &req->own_event ))
+                TRACE( "request %p now uses event %p\n", req, req->event );
+            if ((busy = (req->handle == handle || req->event == handle))) break;
+        }
+        if (busy) pthread_cond_wait( &request_done, &ring_mutex );
+    } while (busy);
+    server_leave_uninterrupted_section( &ring_mutex, &sigset );
+}
+
+/* retry a read on memory with write watches, which the kernel refused to touch */
+static NTSTATUS retry_read( struct uring_request *req, ULONG *total )
+{
+    int fd, needs_close, ret;
+    NTSTATUS status;
+
+    if ((status = server_get_unix_fd( req->handle, FILE_READ_DATA, &fd, &needs_close, NULL, NULL )))
+        return status;
+    while ((ret = virtual_locked_pread( fd, req->buffer, req->length, req->offset )) == -1 && errno == EINTR);
+    if (ret == -1) status = errno_to_status( errno );
+    else
+    {
+        *total = ret;
+        status = (ret || !req->length) ? STATUS_SUCCESS : STATUS_END_OF_FILE;
+    }
+    if (needs_close) close( fd );
+    return status;
+}
+
+static void complete_request( struct uring_request *req, int res )
+{
+    NTSTATUS status;
+    ULONG total = 0;
+
+    if (res >= 0)
+    {
+        total = res;
+        status = (total || req->write || !req->length) ? STATUS_SUCCESS : STATUS_END_OF_FILE;
+    }
+    else if (res == -ECANCELED || res == -EINTR) status = STATUS_CANCELLED;
+    else if (res == -EFAULT && req->write) status = STATUS_INVALID_USER_BUFFER;
+    else if (res == -EFAULT) status = retry_read( req, &total );
+    else status = errno_to_status( -res );
+
+    TRACE( "completed %p status %#x total %u\n", req, (int)status, (int)total );
+
+    set_async_iosb( req->iosb, status, total );
+    if (req->event) NtSetEvent( req->event, NULL );
+    if (req->cvalue) add_completion( req->handle, req->cvalue, status, total, TRUE );
+
+    /* the handles may be closed now */
+    pthread_mutex_lock( &ring_mutex );
+    list_remove( &req->entry );
+    pthread_cond_broadcast( &request_done );
+    pthread_mutex_unlock( &ring_mutex );
+    if (req->own_event) NtClose( req->event );
+    if (req->own_file) NtClose( req->handle );
+    free( req );
+}
+
+static void reap_completions(void)
+{
+    struct uring_request *req;
+    struct io_uring_cqe *cqe;
+    unsigned int head;
+    int res;
+
+    for (;;)
+    {
+        pthread_mutex_lock( &ring_mutex );
+        head = *ring.cq_head;
+        if (head == __atomic_load_n( ring.cq_tail, __ATOMIC_ACQUIRE ))
+        {
+            pthread_mutex_unlock( &ring_mutex );
+            return;
+        }
+        cqe = &ring.cqes[head & *ring.cq_mask];
+        req = (struct uring_request *)(ULONG_PTR)cqe->user_data;
+        res = cqe->res;
+        __atomic_store_n( ring.cq_head, head + 1, __ATOMIC_RELEASE );
+        inflight--;
+        /* cancel requests don't have a user_data, and their result doesn't matter */
+        if (req) req->reaped = TRUE;
+        pthread_mutex_unlock( &ring_mutex );
+
+        if (req) complete_request( req, res );
+    }
+}
+
+/***********************************************************************
+ *           uring_thread
+ *
+ * Body of the completion thread, started by the PE side of ntdll once
+ * uring_init() succeeded.
+ */
+NTSTATUS uring_thread( void *args )
+{
+    if (ring.fd == -1) return STATUS_NOT_SUPPORTED;
+    __atomic_store_n( &uring_enabled, 1, __ATOMIC_RELEASE );
+    for (;;)
+    {
+        if (uring_enter( 0, 1, IORING_ENTER_GETEVENTS ) == -1 && errno != EINTR)
+        {
+            ERR( "io_uring_enter failed: %s\n", strerror( errno ));
+            break;
+        }
+        reap_completions();
+    }
+    __atomic_store_n( &uring_enabled, 0, __ATOMIC_RELEASE );
+    return STATUS_UNSUCCESSFUL;
+}
+
+#else  /* HAVE_LINUX_IO_URING_H */
+
+int do_uring(void)
+{
+    return 0;
+}
+
+NTSTATUS uring_read_file( int fd, HANDLE handle, HANDLE event, ULONG_PTR cvalue, client_ptr_t iosb,
+                          void *buffer, ULONG length, ULONGLONG offset )
+{
+    return STATUS_NOT_SUPPORTED;
+}
+
+NTSTATUS uring_write_file( int fd, HANDLE handle, HANDLE event, ULONG_PTR cvalue, client_ptr_t iosb,
+                           const void *buffer, ULONG length, ULONGLONG offset )
+{
+    return STATUS_NOT_SUPPORTED;
+}
+
+NTSTATUS uring_cancel( HANDLE handle, client_ptr_t iosb, BOOL only_thread )
+{
+    return STATUS_NOT_FOUND;
+}
+
+void uring_close( HANDLE handle )
+{
+}
+
+NTSTATUS uring_init( void *args )
+{
+    return STATUS_NOT_SUPPORTED;
+}
+
+NTSTATUS uring_thread( void *args )
+{
+    return STATUS_NOT_SUPPORTED;
+}
+
+#endif  /* HAVE_LINUX_IO_URING_H */
@@ -0,0 +1,28 @@
+/*
+ * io_uring-based asynchronous file I/O
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+extern int do_uring(void);
+
+extern NTSTATUS uring_read_file( int fd, HANDLE handle, HANDLE event, ULONG_PTR cvalue, client_ptr_t iosb,
+                                 void *buffer, ULONG length, ULONGLONG offset );
+extern NTSTATUS uring_write_file( int fd, HANDLE handle, HANDLE event, ULONG_PTR cvalue, client_ptr_t iosb,
+                                  const void *buffer, ULONG length, ULONGLONG offset );
+extern NTSTATUS uring_cancel( HANDLE handle, client_ptr_t iosb, BOOL only_thread );
+extern void uring_close( HANDLE handle );
+extern NTSTATUS uring_init( void *args );
+extern NTSTATUS uring_thread( void *args );
@@ -281,6 +281,15 @@ static const BYTE VIRTUAL_Win32Flags[16] =
 
 static struct wine_rb_tree views_tree;
 static pthread_mutex_t virtual_mutex;
+/* held exclusively together with virtual_mutex, or shared by read-only queries and faults;
+ * writers are preferred, so that a stream of queries can't starve them */
+#ifdef PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP
+static pthread_rwlock_t virtual_rwlock = PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP;
+#else
+static pthread_rwlock_t virtual_rwlock = PTHREAD_RWLOCK_INITIALIZER;
+#endif
+static pthread_t virtual_lock_owner;  /* accessed atomically, as it is checked without the lock */
+static unsigned int virtual_lock_count;
 
 static const UINT page_shift = 12;
 static const UINT_PTR page_mask = 0xfff;
@@ -362,6 +371,122 @@ static struct range_entry *free_ranges;
 static struct range_entry *free_ranges_end;
 
 
+/***********************************************************************
+ *           virtual_lock
+ *
+ * Acquire exclusive access to the views and page protections. This is
+ * recursive, and can be used from inside a signal handler.
+ */
+static void virtual_lock(void)
+{
+    if (process_exiting) return;
+    /* the shared lock can't be upgraded, this would deadlock */
+    assert( !NtCurrentTeb() || !ntdll_get_thread_data()->virtual_shared );
+    pthread_mutex_lock( &virtual_mutex );
+    if (!virtual_lock_count++)
+    {
+        pthread_rwlock_wrlock( &virtual_rwlock );
+        __atomic_store_n( &virtual_lock_owner, pthread_self(), __ATOMIC_RELAXED );
+    }
+}
+
+
+/***********************************************************************
+ *           virtual_unlock
+ */
+static void virtual_unlock(void)
+{
+    if (process_exiting) return;
+    if (!--virtual_lock_count)
+    {
+        __atomic_store_n( &virtual_lock_owner, 0, __ATOMIC_RELAXED );
+        pthread_rwlock_unlock( &virtual_rwlock );
+    }
+    pthread_mutex_unlock( &virtual_mutex );
+}
+
+
+/***********************************************************************
+ *           virtual_lock_shared
+ *
+ * Acquire read-only access to the views and page protections, unless the
+ * current thread already owns them exclusively. Returns TRUE if the lock
+ * was taken. This is not recursive, and can be used from inside a signal
+ * handler.
+ */
+static BOOL virtual_lock_shared(void)
+{
+    if (process_exiting) return FALSE;
+    if (pthread_equal( __atomic_load_n( &virtual_lock_owner, __ATOMIC_RELAXED ), pthread_self() )) return FALSE;
+    /* with writers preferred, a nested read lock would deadlock behind a waiting writer;
+     * this also catches faults taken while holding the lock shared */
+    if (NtCurrentTeb())
+    {
+        assert( !ntdll_get_thread_data()->virtual_shared );
+        ntdll_get_thread_data()->virtual_shared = TRUE;
+    }
+    pthread_rwlock_rdlock( &virtual_rwlock );
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           virtual_unlock_shared
+ */
+static void virtual_unlock_shared( BOOL locked )
+{
+    if (!locked) return;
+    pthread_rwlock_unlock( &virtual_rwlock );
+    if (NtCurrentTeb()) ntdll_get_thread_data()->virtual_shared = FALSE;
+}
+
+
+/***********************************************************************
+ *           enter_exclusive_section
+ */
+static void enter_exclusive_section( sigset_t *sigset )
+{
+    pthread_sigmask( SIG_BLOCK, &server_block_set, sigset );
+    virtual_lock();
+}
+
+
+/***********************************************************************
+ *           leave_exclusive_section
+ */
+static void leave_exclusive_section( sigset_t *sigset )
+{
+    virtual_unlock();
+    pthread_sigmask( SIG_SETMASK, sigset, NULL );
+}
+
+
+/***********************************************************************
+ *           enter_shared_section
+ *
+ * Acquire read-only access to the views, allowing concurrent queries from
+ * other threads. The caller must not modify the views, and must not touch
+ * any memory that could fault into virtual_handle_fault() while the section
+ * is held. Returns TRUE if the lock was actually taken, i.e. the current
+ * thread doesn't already own it exclusively.
+ */
+static BOOL enter_shared_section( sigset_t *sigset )
+{
+    pthread_sigmask( SIG_BLOCK, &server_block_set, sigset );
+    return virtual_lock_shared();
+}
+
+
+/***********************************************************************
+ *           leave_shared_section
+ */
+static void leave_shared_section( sigset_t *sigset, BOOL locked )
+{
+    virtual_unlock_shared( locked );
+    pthread_sigmask( SIG_SETMASK, sigset, NULL );
+}
+
+
 static inline BOOL is_beyond_limit( const void *addr, size_t size, const void *limit )
 {
     return (addr >= limit || (const char *)addr + size > (const char *)limit);
@@ -998,7 +1123,7 @@ void *get_builtin_so_handle( void *module )
     void *ret = NULL;
     struct builtin_module *builtin;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    enter_exclusive_section( &sigset );
     LIST_FOR_EACH_ENTRY( builtin, &builtin_modules, struct builtin_module, entry )
     {
         if (builtin->module != module) continue;
@@ -1006,7 +1131,7 @@ void *get_builtin_so_handle( void *module )
         if (ret) builtin->refcount++;
         break;
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_exclusive_section( &sigset );
     return ret;
 }
 
@@ -1021,7 +1146,7 @@ static NTSTATUS get_builtin_unix_funcs( void *module, BOOL wow, const void **fun
     NTSTATUS status = STATUS_DLL_NOT_FOUND;
     struct builtin_module *builtin;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    enter_exclusive_section( &sigset );
     LIST_FOR_EACH_ENTRY( builtin, &builtin_modules, struct builtin_module, entry )
     {
         if (builtin->module != module) continue;
@@ -1034,7 +1159,7 @@ static NTSTATUS get_builtin_unix_funcs( void *module, BOOL wow, const void **fun
         }
         break;
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_exclusive_section( &sigset );
     return status;
 }
 
@@ -1048,7 +1173,7 @@ NTSTATUS load_builtin_unixlib( void *module, const char *name )
     NTSTATUS status = STATUS_SUCCESS;
     struct builtin_module *builtin;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    enter_exclusive_section( &sigset );
     LIST_FOR_EACH_ENTRY( builtin, &builtin_modules, struct builtin_module, entry )
     {
         if (builtin->module != module) continue;
@@ -1057,7 +1182,7 @@ NTSTATUS load_builtin_unixlib( void *module, const char *name )
         if (!builtin->unix_handle) builtin->unix_handle = dlopen( builtin->unix_path, RTLD_NOW );
         break;
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_exclusive_section( &sigset );
     return status;
 }
 
@@ -1547,12 +1672,12 @@ static void VIRTUAL_Dump(void)
     struct file_view *view;
 
     TRACE( "Dump of all virtual memory views:\n" );
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    enter_exclusive_section( &sigset );
     WINE_RB_FOR_EACH_ENTRY( view, &views_tree, struct file_view, entry )
     {
         dump_view( view );
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_exclusive_section( &sigset );
 }
 #endif
 
@@ -3514,7 +3639,7 @@ static NTSTATUS virtual_map_image( HANDLE mapping, void **addr_ptr, SIZE_T *size
         SERVER_END_REQ;
     }
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    enter_exclusive_section( &sigset );
 
     status = map_image_view( &view, image_info, size, limit_low, limit_high, alloc_type );
     if (status) goto done;
@@ -3543,7 +3668,7 @@ static NTSTATUS virtual_map_image( HANDLE mapping, void **addr_ptr, SIZE_T *size
     else delete_view( view );
 
 done:
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_exclusive_section( &sigset );
     if (needs_close) close( unix_fd );
     if (shared_needs_close) close( shared_fd );
     return status;
@@ -3638,7 +3763,7 @@ static unsigned int virtual_map_section( HANDLE handle, PVOID *addr_ptr, ULONG_P
 
     if ((res = server_get_unix_fd( handle, 0, &unix_handle, &needs_close, NULL, NULL ))) return res;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    enter_exclusive_section( &sigset );
 
     res = map_view( &view, base, size, alloc_type, vprot, limit_low, limit_high, 0 );
     if (res) goto done;
@@ -3669,7 +3794,7 @@ static unsigned int virtual_map_section( HANDLE handle, PVOID *addr_ptr, ULONG_P
     else delete_view( view );
 
 done:
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_exclusive_section( &sigset );
     if (needs_close) close( unix_handle );
     TRACE("status %#x.\n", res);
     return res;
@@ -3942,7 +4067,7 @@ NTSTATUS virtual_create_builtin_view( void *module, const UNICODE_STRING *nt_nam
     void *base = wine_server_get_ptr( info->base );
     int i;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    enter_exclusive_section( &sigset );
     status = create_view( &view, base, size, SEC_IMAGE | SEC_FILE | VPROT_SYSTEM |
                           VPROT_COMMITTED | VPROT_READ | VPROT_WRITECOPY | VPROT_EXEC );
     if (!status)
@@ -3979,7 +4104,7 @@ NTSTATUS virtual_create_builtin_view( void *module, const UNICODE_STRING *nt_nam
         }
         else delete_view( view );
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_exclusive_section( &sigset );
 
     return status;
 }
@@ -4150,7 +4275,7 @@ NTSTATUS virtual_alloc_teb( TEB **ret_teb )
     NTSTATUS status = STATUS_SUCCESS;
     SIZE_T block_size = signal_stack_mask + 1;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    enter_exclusive_section( &sigset );
     if (next_free_teb)
     {
         ptr = next_free_teb;
@@ -4166,7 +4291,7 @@ NTSTATUS virtual_alloc_teb( TEB **ret_teb )
             if ((status = NtAllocateVirtualMemory( NtCurrentProcess(), &ptr, user_space_wow_limit,
                                                    &total, MEM_RESERVE, PAGE_READWRITE )))
             {
-                server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+                leave_exclusive_section( &sigset );
                 return status;
             }
             teb_block = ptr;
@@ -4177,14 +4302,14 @@ NTSTATUS virtual_alloc_teb( TEB **ret_teb )
                                  MEM_COMMIT, PAGE_READWRITE );
     }
     *ret_teb = teb = init_teb( ptr, is_wow64() );
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_exclusive_section( &sigset );
 
     if ((status = signal_alloc_thread( teb )))
     {
-        server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+        enter_exclusive_section( &sigset );
         *(void **)ptr = next_free_teb;
         next_free_teb = ptr;
-        server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+        leave_exclusive_section( &sigset );
     }
     return status;
 }
@@ -4218,13 +4343,13 @@ void virtual_free_teb( TEB *teb )
         NtFreeVirtualMemory( GetCurrentProcess(), &ptr, &size, MEM_RELEASE );
     }
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    enter_exclusive_section( &sigset );
     list_remove( &thread_data->entry );
     ptr = teb;
     if (!is_win64) ptr = (char *)ptr - teb_offset;
     *(void **)ptr = next_free_teb;
     next_free_teb = ptr;
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_exclusive_section( &sigset );
 }
 
 
@@ -4238,7 +4363,7 @@ NTSTATUS virtual_clear_tls_index( ULONG index )
 
     if (index < TLS_MINIMUM_AVAILABLE)
     {
-        server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+        enter_exclusive_section( &sigset );
         LIST_FOR_EACH_ENTRY( thread_data, &teb_list, struct ntdll_thread_data, entry )
         {
             TEB *teb = CONTAINING_RECORD( thread_data, TEB, GdiTebBatch );
@@ -4249,14 +4374,14 @@ NTSTATUS virtual_clear_tls_index( ULONG index )
 #endif
             teb->TlsSlots[index] = 0;
         }
-        server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+        leave_exclusive_section( &sigset );
     }
     else
     {
         index -= TLS_MINIMUM_AVAILABLE;
         if (index >= 8 * sizeof(peb->TlsExpansionBitmapBits)) return STATUS_INVALID_PARAMETER;
 
-        server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+        enter_exclusive_section( &sigset );
         LIST_FOR_EACH_ENTRY( thread_data, &teb_list, struct ntdll_thread_data, entry )
         {
             TEB *teb = CONTAINING_RECORD( thread_data, TEB, GdiTebBatch );
@@ -4271,7 +4396,7 @@ NTSTATUS virtual_clear_tls_index( ULONG index )
 #endif
             if (teb->TlsExpansionSlots) teb->TlsExpansionSlots[index] = 0;
         }
-        server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+        leave_exclusive_section( &sigset );
     }
     return STATUS_SUCCESS;
 }
@@ -4295,7 +4420,7 @@ NTSTATUS virtual_alloc_thread_stack( INITIAL_TEB *stack, ULONG_PTR limit_low, UL
     if (size < 1024 * 1024) size = 1024 * 1024;  /* Xlib needs a large stack */
     size = (size + 0xffff) & ~0xffff;  /* round to 64K boundary */
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    enter_exclusive_section( &sigset );
 
     status = map_view( &view, NULL, size, 0, VPROT_READ | VPROT_WRITE | VPROT_COMMITTED,
                        limit_low, limit_high, 0 );
@@ -4328,7 +4453,7 @@ NTSTATUS virtual_alloc_thread_stack( INITIAL_TEB *stack, ULONG_PTR limit_low, UL
     stack->StackBase = (char *)view->base + view->size;
     stack->StackLimit = (char *)view->base + (guard_page ? 2 * page_size : 0);
 done:
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_exclusive_section( &sigset );
     return status;
 }
 
@@ -4444,9 +4569,12 @@ NTSTATUS virtual_handle_fault( void *addr, DWORD err, void *stack )
 {
     NTSTATUS ret = STATUS_ACCESS_VIOLATION;
     char *page = ROUND_ADDR( addr, page_mask );
+    BOOL locked, exclusive = FALSE;
     BYTE vprot;
 
-    mutex_lock( &virtual_mutex );  /* no need for signal masking inside signal handler */
+    /* Only take the exclusive lock for faults which change the page protections,
+     * so that the other ones don't block concurrent queries. */
+    locked = virtual_lock_shared();  /* no need for signal masking inside signal handler */
     vprot = get_page_vprot( page );
 
 #ifdef __APPLE__
@@ -4458,6 +4586,22 @@ NTSTATUS virtual_handle_fault( void *addr, DWORD err, void *stack )
     }
 #endif
 
+    if (!is_inside_signal_stack( stack ) && (vprot & VPROT_GUARD)) exclusive = TRUE;
+    else if (!use_kernel_writewatch && err & EXCEPTION_WRITE_FAULT)
+    {
+        if (vprot & VPROT_WRITEWATCH) exclusive = TRUE;
+        /* ignore fault if page is writable now */
+        else if ((get_unix_prot( vprot ) & PROT_WRITE) && is_write_watch_range( page, page_size ))
+            ret = STATUS_SUCCESS;
+    }
+    else if (!err && (get_unix_prot( vprot ) & PROT_READ) && is_system_range( page, page_size )) exclusive = TRUE;
+    virtual_unlock_shared( locked );
+    if (!exclusive) return ret;
+
+    virtual_lock();
+    /* the protections may have been changed by another thread in the meantime */
+    vprot = get_page_vprot( page );
+
     if (!is_inside_signal_stack( stack ) && (vprot & VPROT_GUARD))
     {
         struct thread_stack_info stack_info;
@@ -4498,7 +4642,7 @@ NTSTATUS virtual_handle_fault( void *addr, DWORD err, void *stack )
         else
             set_page_vprot_bits( page, page_size, 0, VPROT_READ | VPROT_EXEC );
     }
-    mutex_unlock( &virtual_mutex );
+    virtual_unlock();
     return ret;
 }
 
@@ -4536,14 +4680,14 @@ void *virtual_setup_exception( void *stack_ptr, size_t size, EXCEPTION_RECORD *r
     }
     else if (stack < stack_info.limit)
     {
-        mutex_lock( &virtual_mutex );  /* no need for signal masking inside signal handler */
+        virtual_lock();  /* no need for signal masking inside signal handler */
         if ((get_page_vprot( stack ) & VPROT_GUARD) &&
             grow_thread_stack( ROUND_ADDR( stack, page_mask ), &stack_info ))
         {
             rec->ExceptionCode = STATUS_STACK_OVERFLOW;
             rec->NumberParameters = 0;
         }
-        mutex_unlock( &virtual_mutex );
+        virtual_unlock();
     }
 #if defined(VALGRIND_MAKE_MEM_UNDEFINED)
     VALGRIND_MAKE_MEM_UNDEFINED( stack, size );
@@ -4592,14 +4736,14 @@ unsigned int virtual_locked_server_call( void *req_ptr )
 
     if (!size) return wine_server_call( req_ptr );
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    enter_exclusive_section( &sigset );
     if (!(ret = check_write_access( addr, size, &has_write_watch )))
     {
         ret = server_call_unlocked( req );
         if (has_write_watch) update_write_watches( addr, size, wine_server_reply_size( req ));
     }
     else memset( &req->u.reply, 0, sizeof(req->u.reply) );
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_exclusive_section( &sigset );
     return ret;
 }
 
@@ -4616,14 +4760,14 @@ ssize_t virtual_locked_read( int fd, void *addr, size_t size )
     ssize_t ret = read( fd, addr, size );
     if (ret != -1 || use_kernel_writewatch || errno != EFAULT) return ret;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    enter_exclusive_section( &sigset );
     if (!check_write_access( addr, size, &has_write_watch ))
     {
         ret = read( fd, addr, size );
         err = errno;
         if (has_write_watch) update_write_watches( addr, size, max( 0, ret ));
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_exclusive_section( &sigset );
     errno = err;
     return ret;
 }
@@ -4641,14 +4785,14 @@ ssize_t virtual_locked_pread( int fd, void *addr, size_t size, off_t offset )
     ssize_t ret = pread( fd, addr, size, offset );
     if (ret != -1 || use_kernel_writewatch || errno != EFAULT) return ret;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    enter_exclusive_section( &sigset );
     if (!check_write_access( addr, size, &has_write_watch ))
     {
         ret = pread( fd, addr, size, offset );
         err = errno;
         if (has_write_watch) update_write_watches( addr, size, max( 0, ret ));
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_exclusive_section( &sigset );
     errno = err;
     return ret;
 }
@@ -4667,7 +4811,7 @@ ssize_t virtual_locked_recvmsg( int fd, struct msghdr *hdr, int flags )
     ssize_t ret = recvmsg( fd, hdr, flags );
     if (ret != -1 || use_kernel_writewatch || errno != EFAULT) return ret;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    enter_exclusive_section( &sigset );
     for (i = 0; i < hdr->msg_iovlen; i++)
         if (check_write_access( hdr->msg_iov[i].iov_base, hdr->msg_iov[i].iov_len, &has_write_watch ))
             break;
@@ -4679,7 +4823,7 @@ ssize_t virtual_locked_recvmsg( int fd, struct msghdr *hdr, int flags )
     if (has_write_watch)
         while (i--) update_write_watches( hdr->msg_iov[i].iov_base, hdr->msg_iov[i].iov_len, 0 );
 
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_exclusive_section( &sigset );
     errno = err;
     return ret;
 }
@@ -4693,11 +4837,12 @@ BOOL virtual_is_valid_code_address( const void *addr, SIZE_T size )
     struct file_view *view;
     BOOL ret = FALSE;
     sigset_t sigset;
+    BOOL locked;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    locked = enter_shared_section( &sigset );
     if ((view = find_view( addr, size )))
         ret = !(view->protect & VPROT_SYSTEM);  /* system views are not visible to the app */
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_shared_section( &sigset, locked );
     return ret;
 }
 
@@ -4784,7 +4929,7 @@ SIZE_T virtual_uninterrupted_read_memory( const void *addr, void *buffer, SIZE_T
 
     if (!size) return 0;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    enter_exclusive_section( &sigset );
     if ((view = find_view( addr, size )))
     {
         if (!(view->protect & VPROT_SYSTEM))
@@ -4800,7 +4945,7 @@ SIZE_T virtual_uninterrupted_read_memory( const void *addr, void *buffer, SIZE_T
             }
         }
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_exclusive_section( &sigset );
     return bytes_read;
 }
 
@@ -4820,13 +4965,13 @@ NTSTATUS virtual_uninterrupted_write_memory( void *addr, const void *buffer, SIZ
 
     if (!size) return STATUS_SUCCESS;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    enter_exclusive_section( &sigset );
     if (!(ret = check_write_access( addr, size, &has_write_watch )))
     {
         memcpy( addr, buffer, size );
         if (has_write_watch) update_write_watches( addr, size, size );
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_exclusive_section( &sigset );
     return ret;
 }
 
@@ -4841,7 +4986,7 @@ void virtual_set_force_exec( BOOL enable )
     struct file_view *view;
     sigset_t sigset;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    enter_exclusive_section( &sigset );
     if (!force_exec_prot != !enable)  /* change all existing views */
     {
         force_exec_prot = enable;
@@ -4859,7 +5004,7 @@ void virtual_set_force_exec( BOOL enable )
             mprotect_range( view->base, view->size, commit, 0 );
         }
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_exclusive_section( &sigset );
 }
 
 /* free reserved areas within a given range */
@@ -5009,7 +5154,7 @@ static NTSTATUS allocate_virtual_memory( void **ret, SIZE_T *size_ptr, ULONG typ
 
     /* Reserve the memory */
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    enter_exclusive_section( &sigset );
 
     if ((type & MEM_RESERVE) || !base)
     {
@@ -5063,7 +5208,7 @@ static NTSTATUS allocate_virtual_memory( void **ret, SIZE_T *size_ptr, ULONG typ
         dump_memory_statistics();
     }
 
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_exclusive_section( &sigset );
 
     if (status == STATUS_SUCCESS)
     {
@@ -5317,7 +5462,7 @@ NTSTATUS WINAPI NtFreeVirtualMemory( HANDLE process, PVOID *addr_ptr, SIZE_T *si
     if (size) size = ROUND_SIZE( addr, size );
     base = ROUND_ADDR( addr, page_mask );
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    enter_exclusive_section( &sigset );
 
     /* avoid freeing the DOS area when a broken app passes a NULL pointer */
     if (!base)
@@ -5364,7 +5509,7 @@ NTSTATUS WINAPI NtFreeVirtualMemory( HANDLE process, PVOID *addr_ptr, SIZE_T *si
     }
 
     dump_memory_statistics();
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_exclusive_section( &sigset );
     return status;
 }
 
@@ -5418,7 +5563,7 @@ NTSTATUS WINAPI NtProtectVirtualMemory( HANDLE process, PVOID *addr_ptr, SIZE_T
     size = ROUND_SIZE( addr, size );
     base = ROUND_ADDR( addr, page_mask );
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    enter_exclusive_section( &sigset );
 
     if ((view = find_view( base, size )))
     {
@@ -5461,7 +5606,7 @@ NTSTATUS WINAPI NtProtectVirtualMemory( HANDLE process, PVOID *addr_ptr, SIZE_T
 
     if (!status) VIRTUAL_DEBUG_DUMP_VIEW( view );
 
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_exclusive_section( &sigset );
 
     if (status == STATUS_SUCCESS)
     {
@@ -5478,6 +5623,7 @@ static unsigned int fill_basic_memory_info( const void *addr, MEMORY_BASIC_INFOR
     char *base, *alloc_base = 0, *alloc_end = working_set_limit;
     struct wine_rb_entry *ptr;
     struct file_view *view;
+    BOOL locked, exclusive = FALSE;
     sigset_t sigset;
 
     base = ROUND_ADDR( addr, page_mask );
@@ -5486,7 +5632,8 @@ static unsigned int fill_basic_memory_info( const void *addr, MEMORY_BASIC_INFOR
 
     /* Find the view containing the address */
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    locked = enter_shared_section( &sigset );
+retry:
     ptr = views_tree.root;
     while (ptr)
     {
@@ -5571,6 +5718,18 @@ static unsigned int fill_basic_memory_info( const void *addr, MEMORY_BASIC_INFOR
     {
         BYTE vprot;
 
+        /* the committed state of SEC_RESERVE pages gets cached in the page protections */
+        if ((view->protect & SEC_RESERVE) && locked)
+        {
+            virtual_unlock_shared( locked );
+            locked = FALSE;
+            virtual_lock();
+            exclusive = TRUE;
+            alloc_base = 0;
+            alloc_end = working_set_limit;
+            goto retry;
+        }
+
         info->AllocationBase = alloc_base;
         info->RegionSize = get_committed_size( view, base, &vprot, ~VPROT_WRITEWATCH );
         info->State = (vprot & VPROT_COMMITTED) ? MEM_COMMIT : MEM_RESERVE;
@@ -5580,7 +5739,8 @@ static unsigned int fill_basic_memory_info( const void *addr, MEMORY_BASIC_INFOR
         else if (view->protect & (SEC_FILE | SEC_RESERVE | SEC_COMMIT)) info->Type = MEM_MAPPED;
         else info->Type = MEM_PRIVATE;
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    if (exclusive) virtual_unlock();
+    leave_shared_section( &sigset, locked );
 
     return STATUS_SUCCESS;
 }
@@ -5590,6 +5750,7 @@ static unsigned int get_basic_memory_info( HANDLE process, LPCVOID addr,
                                            MEMORY_BASIC_INFORMATION *info,
                                            SIZE_T len, SIZE_T *res_len )
 {
+    MEMORY_BASIC_INFORMATION basic_info;
     unsigned int status;
 
     if (len < sizeof(*info))
@@ -5623,8 +5784,10 @@ static unsigned int get_basic_memory_info( HANDLE process, LPCVOID addr,
         return result.virtual_query.status;
     }
 
-    if ((status = fill_basic_memory_info( addr, info ))) return status;
+    /* don't write to the caller buffer while holding the lock, it could be a write watch page */
+    if ((status = fill_basic_memory_info( addr, &basic_info ))) return status;
 
+    *info = basic_info;
     if (res_len) *res_len = sizeof(*info);
     return STATUS_SUCCESS;
 }
@@ -5690,7 +5853,7 @@ static NTSTATUS get_working_set_ex( HANDLE process, LPCVOID addr,
         if (vmentries == NULL)
             WARN( "couldn't get process vmmap, errno %d\n", errno );
 
-        server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+        enter_exclusive_section( &sigset );
         for (p = info; (UINT_PTR)(p + 1) <= (UINT_PTR)info + len; p++)
         {
              int i;
@@ -5717,7 +5880,7 @@ static NTSTATUS get_working_set_ex( HANDLE process, LPCVOID addr,
                      p->VirtualAttributes.Win32Protection = get_win32_prot( vprot, view->protect );
              }
         }
-        server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+        leave_exclusive_section( &sigset );
 
         if (vmentries)
             procstat_freevmmap( pstat, vmentries );
@@ -5727,7 +5890,7 @@ static NTSTATUS get_working_set_ex( HANDLE process, LPCVOID addr,
             procstat_close( pstat );
     }
 #else
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    enter_exclusive_section( &sigset );
     if (pagemap_fd == -2)
     {
 #ifdef O_CLOEXEC
@@ -5766,7 +5929,7 @@ static NTSTATUS get_working_set_ex( HANDLE process, LPCVOID addr,
                 p->VirtualAttributes.Win32Protection = get_win32_prot( vprot, view->protect );
         }
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_exclusive_section( &sigset );
 #endif
 
     if (res_len)
@@ -6219,7 +6382,7 @@ static NTSTATUS unmap_view_of_section( HANDLE process, PVOID addr, ULONG flags )
         return status;
     }
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    enter_exclusive_section( &sigset );
     if (!(view = find_view( addr, 0 )) || is_view_valloc( view )) goto done;
 
     if (flags & MEM_PRESERVE_PLACEHOLDER && !(view->protect & VPROT_PLACEHOLDER))
@@ -6238,7 +6401,7 @@ static NTSTATUS unmap_view_of_section( HANDLE process, PVOID addr, ULONG flags )
             {
                 TRACE( "not freeing in-use builtin %p\n", view->base );
                 builtin->refcount--;
-                server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+                leave_exclusive_section( &sigset );
                 return STATUS_SUCCESS;
             }
         }
@@ -6262,7 +6425,7 @@ static NTSTATUS unmap_view_of_section( HANDLE process, PVOID addr, ULONG flags )
     }
     else FIXME( "failed to unmap %p %x\n", view->base, status );
 done:
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_exclusive_section( &sigset );
     return status;
 }
 
@@ -6414,7 +6577,7 @@ NTSTATUS WINAPI NtFlushVirtualMemory( HANDLE process, LPCVOID *addr_ptr,
         return result.virtual_flush.status;
     }
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    enter_exclusive_section( &sigset );
     if (!(view = find_view( addr, *size_ptr ))) status = STATUS_INVALID_PARAMETER;
     else
     {
@@ -6424,7 +6587,7 @@ NTSTATUS WINAPI NtFlushVirtualMemory( HANDLE process, LPCVOID *addr_ptr,
         if (msync( addr, *size_ptr, MS_ASYNC )) status = STATUS_NOT_MAPPED_DATA;
 #endif
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_exclusive_section( &sigset );
     return status;
 }
 
@@ -6451,7 +6614,7 @@ NTSTATUS WINAPI NtGetWriteWatch( HANDLE process, ULONG flags, PVOID base, SIZE_T
     TRACE( "%p %x %p-%p %p %lu\n", process, (int)flags, base, (char *)base + size,
            addresses, *count );
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    enter_exclusive_section( &sigset );
 
     if (is_write_watch_range( base, size ))
     {
@@ -6478,7 +6641,7 @@ NTSTATUS WINAPI NtGetWriteWatch( HANDLE process, ULONG flags, PVOID base, SIZE_T
     else status = STATUS_INVALID_PARAMETER;
 
 done:
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_exclusive_section( &sigset );
     return status;
 }
 
@@ -6499,14 +6662,14 @@ NTSTATUS WINAPI NtResetWriteWatch( HANDLE process, PVOID base, SIZE_T size )
 
     if (!size) return STATUS_INVALID_PARAMETER;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    enter_exclusive_section( &sigset );
 
     if (is_write_watch_range( base, size ))
         reset_write_watches( base, size );
     else
         status = STATUS_INVALID_PARAMETER;
 
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_exclusive_section( &sigset );
     return status;
 }
 
@@ -6632,10 +6795,11 @@ NTSTATUS WINAPI NtAreMappedFilesTheSame(PVOID addr1, PVOID addr2)
     struct file_view *view1, *view2;
     unsigned int status;
     sigset_t sigset;
+    BOOL locked;
 
     TRACE("%p %p\n", addr1, addr2);
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    locked = enter_shared_section( &sigset );
 
     view1 = find_view( addr1, 0 );
     view2 = find_view( addr2, 0 );
@@ -6659,7 +6823,7 @@ NTSTATUS WINAPI NtAreMappedFilesTheSame(PVOID addr1, PVOID addr2)
         SERVER_END_REQ;
     }
 
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    leave_shared_section( &sigset, locked );
     return status;
 }
 
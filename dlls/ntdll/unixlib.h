@@ -92,6 +92,8 @@ enum ntdll_unix_funcs
     unix_steamclient_setup_trampolines,
     unix_is_pc_in_native_so,
     unix_debugstr_pc,
+    unix_uring_init,
+    unix_uring_thread,
 };
 
 extern unixlib_handle_t __wine_unixlib_handle;
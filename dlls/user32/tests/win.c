@@ -12851,6 +12851,129 @@ static void test_other_process_window(const char *argv0)
     DestroyWindow(hwnd);
 }
 
+static void other_process_info_proc(HWND owner, HWND hwnd, HWND child)
+{
+    HANDLE window_ready_event, test_done_event;
+    RECT rect;
+    HWND ret;
+    DWORD res;
+
+    window_ready_event = OpenEventA(EVENT_ALL_ACCESS, FALSE, "test_opi_window");
+    ok(!!window_ready_event, "OpenEvent failed.\n");
+    test_done_event = OpenEventA(EVENT_ALL_ACCESS, FALSE, "test_opi_test");
+    ok(!!test_done_event, "OpenEvent failed.\n");
+
+    /* initial state */
+    res = WaitForSingleObject(window_ready_event, 5000);
+    ok(res == WAIT_OBJECT_0, "Unexpected res %lx.\n", res);
+    ok(IsWindow(hwnd), "Expected a window.\n");
+    GetWindowRect(hwnd, &rect);
+    ok(EqualRect(&rect, &(RECT){10, 20, 110, 70}), "Unexpected rect %s.\n", wine_dbgstr_rect(&rect));
+    GetWindowRect(child, &rect);
+    ok(EqualRect(&rect, &(RECT){105, 106, 135, 146}), "Unexpected rect %s.\n", wine_dbgstr_rect(&rect));
+    ret = GetParent(hwnd);
+    ok(ret == owner, "Unexpected parent %p.\n", ret);
+    ret = GetParent(child);
+    ok(ret == owner, "Unexpected parent %p.\n", ret);
+    res = GetWindowLongW(child, GWLP_ID);
+    ok(res == 0x1234, "Unexpected id %#lx.\n", res);
+    res = GetWindowLongW(hwnd, GWLP_USERDATA);
+    ok(!res, "Unexpected user data %#lx.\n", res);
+    res = GetWindowLongW(hwnd, GWL_STYLE);
+    ok((res & (WS_POPUP | WS_VISIBLE | WS_DISABLED)) == WS_POPUP, "Unexpected style %#lx.\n", res);
+    SetEvent(test_done_event);
+
+    /* the changes are visible as soon as the calls making them return */
+    res = WaitForSingleObject(window_ready_event, 5000);
+    ok(res == WAIT_OBJECT_0, "Unexpected res %lx.\n", res);
+    GetWindowRect(hwnd, &rect);
+    ok(EqualRect(&rect, &(RECT){30, 40, 90, 110}), "Unexpected rect %s.\n", wine_dbgstr_rect(&rect));
+    GetWindowRect(child, &rect);
+    ok(EqualRect(&rect, &(RECT){35, 46, 65, 86}), "Unexpected rect %s.\n", wine_dbgstr_rect(&rect));
+    ret = GetParent(child);
+    ok(ret == hwnd, "Unexpected parent %p.\n", ret);
+    res = GetWindowLongW(child, GWLP_ID);
+    ok(res == 0x4321, "Unexpected id %#lx.\n", res);
+    res = GetWindowLongW(hwnd, GWLP_USERDATA);
+    ok(res == 0xdeadbeef, "Unexpected user data %#lx.\n", res);
+    res = GetWindowLongW(hwnd, GWL_STYLE);
+    ok((res & (WS_POPUP | WS_VISIBLE | WS_DISABLED)) == (WS_POPUP | WS_DISABLED), "Unexpected style %#lx.\n", res);
+    SetEvent(test_done_event);
+
+    /* destroyed windows */
+    res = WaitForSingleObject(window_ready_event, 5000);
+    ok(res == WAIT_OBJECT_0, "Unexpected res %lx.\n", res);
+    ok(!IsWindow(child), "Expected no window.\n");
+    SetLastError(0xdeadbeef);
+    ret = GetParent(child);
+    ok(!ret, "Unexpected parent %p.\n", ret);
+    ok(GetLastError() == ERROR_INVALID_WINDOW_HANDLE, "Unexpected error %lu.\n", GetLastError());
+    SetLastError(0xdeadbeef);
+    res = GetWindowLongW(child, GWL_STYLE);
+    ok(!res, "Unexpected style %#lx.\n", res);
+    ok(GetLastError() == ERROR_INVALID_WINDOW_HANDLE, "Unexpected error %lu.\n", GetLastError());
+    ok(IsWindow(hwnd), "Expected a window.\n");
+    SetEvent(test_done_event);
+
+    CloseHandle(window_ready_event);
+    CloseHandle(test_done_event);
+}
+
+static void test_other_process_window_info(const char *argv0)
+{
+    HANDLE window_ready_event, test_done_event;
+    PROCESS_INFORMATION info;
+    STARTUPINFOA startup;
+    char cmd[MAX_PATH];
+    HWND owner, hwnd, child;
+    DWORD ret;
+
+    owner = CreateWindowExA(0, "static", NULL, WS_POPUP, 100, 100, 200, 200, 0, 0, NULL, NULL);
+    ok(!!owner, "CreateWindowEx failed.\n");
+    hwnd = CreateWindowExA(0, "static", NULL, WS_POPUP, 10, 20, 100, 50, owner, 0, NULL, NULL);
+    ok(!!hwnd, "CreateWindowEx failed.\n");
+    child = CreateWindowExA(0, "static", NULL, WS_CHILD, 5, 6, 30, 40, owner, (HMENU)0x1234, NULL, NULL);
+    ok(!!child, "CreateWindowEx failed.\n");
+
+    window_ready_event = CreateEventA(NULL, FALSE, FALSE, "test_opi_window");
+    ok(!!window_ready_event, "CreateEvent failed.\n");
+    test_done_event = CreateEventA(NULL, FALSE, FALSE, "test_opi_test");
+    ok(!!test_done_event, "CreateEvent failed.\n");
+
+    sprintf(cmd, "%s win test_other_process_window_info %p %p %p", argv0, owner, hwnd, child);
+    memset(&startup, 0, sizeof(startup));
+    startup.cb = sizeof(startup);
+
+    ok(CreateProcessA(NULL, cmd, NULL, NULL, FALSE, 0, NULL, NULL,
+            &startup, &info), "CreateProcess failed.\n");
+
+    SetEvent(window_ready_event);
+    ret = WaitForSingleObject(test_done_event, 5000);
+    ok(ret == WAIT_OBJECT_0, "Unexpected ret %lx.\n", ret);
+
+    SetWindowPos(hwnd, 0, 30, 40, 60, 70, SWP_NOZORDER | SWP_NOACTIVATE);
+    SetParent(child, hwnd);
+    SetWindowLongW(child, GWLP_ID, 0x4321);
+    SetWindowLongW(hwnd, GWLP_USERDATA, 0xdeadbeef);
+    EnableWindow(hwnd, FALSE);
+    SetEvent(window_ready_event);
+    ret = WaitForSingleObject(test_done_event, 5000);
+    ok(ret == WAIT_OBJECT_0, "Unexpected ret %lx.\n", ret);
+
+    DestroyWindow(child);
+    SetEvent(window_ready_event);
+    ret = WaitForSingleObject(test_done_event, 5000);
+    ok(ret == WAIT_OBJECT_0, "Unexpected ret %lx.\n", ret);
+
+    wait_child_process(info.hProcess);
+    CloseHandle(window_ready_event);
+    CloseHandle(test_done_event);
+    CloseHandle(info.hProcess);
+    CloseHandle(info.hThread);
+    DestroyWindow(hwnd);
+    DestroyWindow(owner);
+}
+
 static void test_cancel_mode(void)
 {
     HWND hwnd1, hwnd2, child;
@@ -13177,6 +13300,17 @@ START_TEST(win)
         }
     }
 
+    if (argc == 6 && !strcmp(argv[2], "test_other_process_window_info"))
+    {
+        HWND owner, hwnd, child;
+
+        sscanf(argv[3], "%p", &owner);
+        sscanf(argv[4], "%p", &hwnd);
+        sscanf(argv[5], "%p", &child);
+        other_process_info_proc(owner, hwnd, child);
+        return;
+    }
+
     if (argc == 3 && !strcmp(argv[2], "winproc_limit"))
     {
         test_winproc_limit();
@@ -13313,6 +13447,7 @@ START_TEST(win)
     test_window_placement();
     test_arrange_iconic_windows();
     test_other_process_window(argv[0]);
+    test_other_process_window_info(argv[0]);
     test_SC_SIZE();
     test_cancel_mode();
     test_DragDetect();
@@ -1494,6 +1494,87 @@ static HRESULT fill_array_desc(compile_ctx_t *ctx, dim_decl_t *dim_decl, array_d
     return S_OK;
 }
 
+static BOOL lookup_local(function_t *func, const WCHAR *name, int *ret)
+{
+    unsigned i;
+
+    /* The function name refers to its return value, leave it to the runtime lookup. */
+    if(!wcsicmp(name, func->name))
+        return FALSE;
+
+    for(i = 0; i < func->var_cnt; i++) {
+        if(!wcsicmp(func->vars[i].name, name)) {
+            *ret = i;
+            return TRUE;
+        }
+    }
+
+    for(i = 0; i < func->arg_cnt; i++) {
+        if(!wcsicmp(func->args[i].name, name)) {
+            *ret = -(int)i - 1;
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/*
+ * Local variables and arguments always take precedence over anything else
+ * lookup_identifier() could find, so once the function is compiled and its
+ * variables are known, references to them can be bound to their slots.
+ */
+static void bind_locals(compile_ctx_t *ctx, function_t *func)
+{
+    instr_t *instr, *end = ctx->code->instrs + ctx->instr_cnt;
+    int ref;
+
+    if(func->type == FUNC_GLOBAL)
+        return;
+
+    for(instr = ctx->code->instrs + func->code_off; instr < end; instr++) {
+        switch(instr->op) {
+        case OP_icall:
+            if(instr->arg2.uint)
+                break;
+            /* fall through */
+        case OP_ident:
+            if(lookup_local(func, instr->arg1.bstr, &ref)) {
+                instr->op = OP_local;
+                instr->arg1.lng = ref;
+                instr->arg2.uint = 0;
+            }
+            break;
+        case OP_assign_ident:
+            if(lookup_local(func, instr->arg1.bstr, &ref)) {
+                instr->op = OP_assign_local;
+                instr->arg1.lng = ref;
+            }
+            break;
+        case OP_set_ident:
+            if(lookup_local(func, instr->arg1.bstr, &ref)) {
+                instr->op = OP_set_local;
+                instr->arg1.lng = ref;
+            }
+            break;
+        case OP_step:
+            if(lookup_local(func, instr->arg2.bstr, &ref)) {
+                instr->op = OP_step_local;
+                instr->arg2.lng = ref;
+            }
+            break;
+        case OP_incc:
+            if(lookup_local(func, instr->arg1.bstr, &ref)) {
+                instr->op = OP_incc_local;
+                instr->arg1.lng = ref;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
 static HRESULT compile_func(compile_ctx_t *ctx, statement_t *stat, function_t *func)
 {
     HRESULT hres;
@@ -1563,6 +1644,8 @@ static HRESULT compile_func(compile_ctx_t *ctx, statement_t *stat, function_t *f
         assert(i == func->var_cnt);
     }
 
+    bind_locals(ctx, func);
+
     if(func->array_cnt) {
         unsigned array_id = 0;
         dim_decl_t *dim_decl;
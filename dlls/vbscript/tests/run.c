@@ -3137,16 +3137,12 @@ static void run_from_file(const char *filename)
     ok(hres == S_OK, "parse_script failed: %08lx\n", hres);
 }
 
-static void run_from_res(const char *name)
+static BSTR load_res(const char *name)
 {
     const char *data;
     DWORD size, len;
     BSTR str;
     HRSRC src;
-    HRESULT hres;
-
-    strict_dispid_check = FALSE;
-    test_name = name;
 
     src = FindResourceA(NULL, name, (LPCSTR)40);
     ok(src != NULL, "Could not find resource %s\n", name);
@@ -3158,13 +3154,51 @@ static void run_from_res(const char *name)
     str = SysAllocStringLen(NULL, len);
     MultiByteToWideChar(CP_ACP, 0, data, size, str, len);
 
+    return str;
+}
+
+static void run_from_res(const char *name)
+{
+    BSTR str;
+    HRESULT hres;
+
+    strict_dispid_check = FALSE;
+    test_name = name;
+
+    str = load_res(name);
+
+    SET_EXPECT(global_success_d);
+    SET_EXPECT(global_success_i);
+    hres = parse_script(SCRIPTITEM_GLOBALMEMBERS, str, NULL);
+    CHECK_CALLED(global_success_d);
+    CHECK_CALLED(global_success_i);
+
+    ok(hres == S_OK, "parse_script failed: %08lx\n", hres);
+    SysFreeString(str);
+    test_name = "";
+}
+
+static void run_benchmark(const char *name)
+{
+    DWORD start, end;
+    BSTR str;
+    HRESULT hres;
+
+    strict_dispid_check = FALSE;
+    test_name = name;
+
+    str = load_res(name);
+
     SET_EXPECT(global_success_d);
     SET_EXPECT(global_success_i);
+    start = GetTickCount();
     hres = parse_script(SCRIPTITEM_GLOBALMEMBERS, str, NULL);
+    end = GetTickCount();
     CHECK_CALLED(global_success_d);
     CHECK_CALLED(global_success_i);
 
     ok(hres == S_OK, "parse_script failed: %08lx\n", hres);
+    trace("%s ran in %lu ms\n", name, end-start);
     SysFreeString(str);
     test_name = "";
 }
@@ -3429,6 +3463,8 @@ static void run_tests(void)
     run_from_res("api.vbs");
     run_from_res("regexp.vbs");
     run_from_res("error.vbs");
+    if(winetest_interactive)
+        run_benchmark("benchmark.vbs");
 
     test_procedures();
     test_gc();
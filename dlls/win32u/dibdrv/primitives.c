@@ -4624,44 +4624,49 @@ static inline BYTE blend_color(BYTE dst, BYTE src, DWORD alpha)
     return (src * alpha + dst * (255 - alpha) + 127) / 255;
 }
 
+/* The blend_argb helpers process the blue/red and green/alpha channels in pairs, in the
+ * low and high 16 bits of a DWORD. For each channel value v <= 255 * 255 this computes
+ * (v + 127) / 255, with the same result as the per-channel division. */
+static inline DWORD div255_pair( DWORD v )
+{
+    v += 0x00800080;
+    return ((v + ((v >> 8) & 0x00ff00ff)) >> 8) & 0x00ff00ff;
+}
+
 static inline DWORD blend_argb_constant_alpha( DWORD dst, DWORD src, DWORD alpha )
 {
-    return (blend_color( dst, src, alpha ) |
-            blend_color( dst >> 8, src >> 8, alpha ) << 8 |
-            blend_color( dst >> 16, src >> 16, alpha ) << 16 |
-            blend_color( dst >> 24, src >> 24, alpha ) << 24);
+    DWORD rb = div255_pair( (src & 0x00ff00ff) * alpha + (dst & 0x00ff00ff) * (255 - alpha) );
+    DWORD ag = div255_pair( ((src >> 8) & 0x00ff00ff) * alpha + ((dst >> 8) & 0x00ff00ff) * (255 - alpha) );
+    return rb | ag << 8;
 }
 
 static inline DWORD blend_argb_no_src_alpha( DWORD dst, DWORD src, DWORD alpha )
 {
-    return (blend_color( dst, src, alpha ) |
-            blend_color( dst >> 8, src >> 8, alpha ) << 8 |
-            blend_color( dst >> 16, src >> 16, alpha ) << 16 |
-            blend_color( dst >> 24, 255, alpha ) << 24);
+    return blend_argb_constant_alpha( dst, src | 0xff000000, alpha );
+}
+
+/* add the premultiplied source pairs to the destination scaled by the inverse source alpha;
+ * channel overflows on invalid premultiplied data are kept as in a per-channel computation */
+static inline DWORD blend_argb_pairs( DWORD dst, DWORD src_rb, DWORD src_ag )
+{
+    DWORD alpha = src_ag >> 16;
+    DWORD rb = src_rb + div255_pair( (dst & 0x00ff00ff) * (255 - alpha) );
+    DWORD ag = src_ag + div255_pair( ((dst >> 8) & 0x00ff00ff) * (255 - alpha) );
+    return rb | ag << 8;
 }
 
 static inline DWORD blend_argb( DWORD dst, DWORD src )
 {
-    BYTE b = (BYTE)src;
-    BYTE g = (BYTE)(src >> 8);
-    BYTE r = (BYTE)(src >> 16);
-    DWORD alpha  = (BYTE)(src >> 24);
-    return ((b     + ((BYTE)dst         * (255 - alpha) + 127) / 255) |
-            (g     + ((BYTE)(dst >> 8)  * (255 - alpha) + 127) / 255) << 8 |
-            (r     + ((BYTE)(dst >> 16) * (255 - alpha) + 127) / 255) << 16 |
-            (alpha + ((BYTE)(dst >> 24) * (255 - alpha) + 127) / 255) << 24);
+    if (src >= 0xff000000) return src;  /* opaque */
+    if (!src) return dst;  /* fully transparent */
+    return blend_argb_pairs( dst, src & 0x00ff00ff, (src >> 8) & 0x00ff00ff );
 }
 
 static inline DWORD blend_argb_alpha( DWORD dst, DWORD src, DWORD alpha )
 {
-    BYTE b = ((BYTE)src         * alpha + 127) / 255;
-    BYTE g = ((BYTE)(src >> 8)  * alpha + 127) / 255;
-    BYTE r = ((BYTE)(src >> 16) * alpha + 127) / 255;
-    alpha  = ((BYTE)(src >> 24) * alpha + 127) / 255;
-    return ((b     + ((BYTE)dst         * (255 - alpha) + 127) / 255) |
-            (g     + ((BYTE)(dst >> 8)  * (255 - alpha) + 127) / 255) << 8 |
-            (r     + ((BYTE)(dst >> 16) * (255 - alpha) + 127) / 255) << 16 |
-            (alpha + ((BYTE)(dst >> 24) * (255 - alpha) + 127) / 255) << 24);
+    if (!src) return dst;
+    return blend_argb_pairs( dst, div255_pair( (src & 0x00ff00ff) * alpha ),
+                             div255_pair( ((src >> 8) & 0x00ff00ff) * alpha ));
 }
 
 static inline DWORD blend_rgb( BYTE dst_r, BYTE dst_g, BYTE dst_b, DWORD src, BLENDFUNCTION blend )
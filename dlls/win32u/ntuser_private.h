@@ -152,6 +152,8 @@ struct user_thread_info
     const queue_shm_t            *queue_shm;              /* Ptr to server's thread queue shared memory */
     const input_shm_t            *input_shm;              /* Ptr to server's thread input shared memory */
     const input_shm_t            *foreground_shm;         /* Ptr to server's foreground thread input shared memory */
+    const window_shm_t           *windows_shm;            /* Ptr to server's desktop windows shared memory */
+    BOOL                          windows_shm_failed;     /* Desktop windows shared memory couldn't be mapped */
 };
 
 C_ASSERT( sizeof(struct user_thread_info) <= sizeof(((TEB *)0)->Win32ClientInfo) );
@@ -280,6 +282,7 @@ extern const desktop_shm_t *get_desktop_shared_memory(void);
 extern const queue_shm_t *get_queue_shared_memory(void);
 extern const input_shm_t *get_input_shared_memory(void);
 extern const input_shm_t *get_foreground_shared_memory(void);
+extern const window_shm_t *get_window_shared_memory( HWND hwnd );
 
 static inline UINT win_get_flags( HWND hwnd )
 {
@@ -289,6 +292,7 @@ static inline UINT win_get_flags( HWND hwnd )
 WND *get_win_ptr( HWND hwnd );
 BOOL is_child( HWND parent, HWND child );
 BOOL is_window( HWND hwnd );
+BOOL get_shared_window_info( HWND hwnd, struct window_shared_memory *info );
 
 #if defined(__i386__) || defined(__x86_64__)
 #define __SHARED_READ_SEQ( x )  (x)
@@ -6248,6 +6248,13 @@ static void thread_detach(void)
         thread_info->desktop_shm = NULL;
     }
 
+    if (thread_info->windows_shm)
+    {
+        NtUnmapViewOfSection( GetCurrentProcess(), (void *)thread_info->windows_shm );
+        thread_info->windows_shm = NULL;
+    }
+    thread_info->windows_shm_failed = FALSE;
+
     if (thread_info->queue_shm)
     {
         NtUnmapViewOfSection( GetCurrentProcess(), (void *)thread_info->queue_shm );
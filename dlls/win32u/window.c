@@ -286,9 +286,35 @@ HWND is_current_process_window( HWND hwnd )
     return ret;
 }
 
+/***********************************************************************
+ *           get_shared_window_info
+ *
+ * Retrieve the state of a window of another process from the server shared memory,
+ * without any server round-trip.
+ */
+BOOL get_shared_window_info( HWND hwnd, struct window_shared_memory *info )
+{
+    const window_shm_t *shared = get_window_shared_memory( hwnd );
+    UINT handle = HandleToUlong( hwnd );
+    BOOL ret = FALSE;
+
+    if (!shared) return FALSE;
+
+    SHARED_READ_BEGIN( shared, window_shm_t )
+    {
+        ret = shared->handle && (shared->handle == handle ||
+              ((!HIWORD(handle) || HIWORD(handle) == 0xffff) && LOWORD(shared->handle) == LOWORD(handle)));
+        if (ret) *info = *(const struct window_shared_memory *)shared;
+    }
+    SHARED_READ_END
+
+    return ret;
+}
+
 /* see IsWindow */
 BOOL is_window( HWND hwnd )
 {
+    struct window_shared_memory info;
     WND *win;
     BOOL ret;
 
@@ -302,6 +328,7 @@ BOOL is_window( HWND hwnd )
     }
 
     /* check other processes */
+    if (get_shared_window_info( hwnd, &info )) return TRUE;
     SERVER_START_REQ( get_window_info )
     {
         req->handle = wine_server_user_handle( hwnd );
@@ -314,6 +341,7 @@ BOOL is_window( HWND hwnd )
 /* see GetWindowThreadProcessId */
 DWORD get_window_thread( HWND hwnd, DWORD *process )
 {
+    struct window_shared_memory info;
     WND *ptr;
     DWORD tid = 0;
 
@@ -333,6 +361,11 @@ DWORD get_window_thread( HWND hwnd, DWORD *process )
     }
 
     /* check other processes */
+    if (ptr == WND_OTHER_PROCESS && get_shared_window_info( hwnd, &info ))
+    {
+        if (process) *process = info.pid;
+        return info.tid;
+    }
     SERVER_START_REQ( get_window_info )
     {
         req->handle = wine_server_user_handle( hwnd );
@@ -360,7 +393,16 @@ HWND get_parent( HWND hwnd )
     if (win == WND_DESKTOP) return 0;
     if (win == WND_OTHER_PROCESS)
     {
-        LONG style = get_window_long( hwnd, GWL_STYLE );
+        struct window_shared_memory info;
+        LONG style;
+
+        if (get_shared_window_info( hwnd, &info ))
+        {
+            if (info.style & WS_POPUP) retval = wine_server_ptr_handle( info.owner );
+            else if (info.style & WS_CHILD) retval = wine_server_ptr_handle( info.parent );
+            return retval;
+        }
+        style = get_window_long( hwnd, GWL_STYLE );
         if (style & (WS_POPUP | WS_CHILD))
         {
             SERVER_START_REQ( get_window_tree )
@@ -574,7 +616,31 @@ static HWND *list_window_parents( HWND hwnd )
         }
     }
 
-    /* at least one parent belongs to another process, have to query the server */
+    /* at least one parent belongs to another process, try the shared memory first */
+
+    for (;;)
+    {
+        struct window_shared_memory info;
+
+        if (!get_shared_window_info( current, &info )) break;
+        if (!info.parent)
+        {
+            if (!pos) goto empty;
+            list[pos] = 0;
+            return list;
+        }
+        list[pos] = current = wine_server_ptr_handle( info.parent );
+        if (++pos == size - 1)
+        {
+            /* need to grow the list */
+            HWND *new_list = realloc( list, (size + 16) * sizeof(HWND) );
+            if (!new_list) goto empty;
+            list = new_list;
+            size += 16;
+        }
+    }
+
+    /* have to query the server */
 
     for (;;)
     {
@@ -941,6 +1007,9 @@ UINT get_dpi_for_window( HWND hwnd )
     }
     else
     {
+        struct window_shared_memory info;
+
+        if (get_shared_window_info( hwnd, &info ) && info.dpi) return info.dpi;
         SERVER_START_REQ( get_window_info )
         {
             req->handle = wine_server_user_handle( hwnd );
@@ -1045,11 +1114,24 @@ static LONG_PTR get_window_long_size( HWND hwnd, INT offset, UINT size, BOOL ans
 
     if (win == WND_OTHER_PROCESS)
     {
+        struct window_shared_memory info;
+
         if (offset == GWLP_WNDPROC)
         {
             RtlSetLastWin32Error( ERROR_ACCESS_DENIED );
             return 0;
         }
+        if (offset < 0 && get_shared_window_info( hwnd, &info ))
+        {
+            switch (offset)
+            {
+            case GWL_STYLE:      return info.style;
+            case GWL_EXSTYLE:    return info.ex_style;
+            case GWLP_ID:        return info.id;
+            case GWLP_HINSTANCE: return (ULONG_PTR)wine_server_get_ptr( info.instance );
+            case GWLP_USERDATA:  return info.user_data;
+            }
+        }
         SERVER_START_REQ( set_window_info )
         {
             req->handle = wine_server_user_handle( hwnd );
@@ -1588,6 +1670,73 @@ static void mirror_rect( const RECT *window_rect, RECT *rect )
     rect->right = width - tmp;
 }
 
+static inline RECT rect_from_shared( const rectangle_t *rect )
+{
+    RECT ret = { rect->left, rect->top, rect->right, rect->bottom };
+    return ret;
+}
+
+/***********************************************************************
+ *           get_shared_window_rects
+ *
+ * Get the rectangles of a window of another process from the shared memory,
+ * computed the same way as the get_window_rectangles server request.
+ */
+static BOOL get_shared_window_rects( HWND hwnd, enum coords_relative relative, RECT *window_rect,
+                                     RECT *client_rect, UINT dpi )
+{
+    struct window_shared_memory info, parent;
+    RECT window, client, rect;
+
+    if (!get_shared_window_info( hwnd, &info )) return FALSE;
+    /* per-monitor DPI is only known to the server */
+    if (!info.dpi != !dpi) return FALSE;
+
+    window = rect_from_shared( &info.window_rect );
+    client = rect_from_shared( &info.client_rect );
+
+    switch (relative)
+    {
+    case COORDS_CLIENT:
+        OffsetRect( &window, -info.client_rect.left, -info.client_rect.top );
+        OffsetRect( &client, -info.client_rect.left, -info.client_rect.top );
+        rect = rect_from_shared( &info.client_rect );
+        if (info.ex_style & WS_EX_LAYOUTRTL) mirror_rect( &rect, &window );
+        break;
+    case COORDS_WINDOW:
+        OffsetRect( &window, -info.window_rect.left, -info.window_rect.top );
+        OffsetRect( &client, -info.window_rect.left, -info.window_rect.top );
+        rect = rect_from_shared( &info.window_rect );
+        if (info.ex_style & WS_EX_LAYOUTRTL) mirror_rect( &rect, &client );
+        break;
+    case COORDS_PARENT:
+        if (!info.parent) break;
+        if (!get_shared_window_info( wine_server_ptr_handle( info.parent ), &parent )) return FALSE;
+        if (parent.ex_style & WS_EX_LAYOUTRTL)
+        {
+            rect = rect_from_shared( &parent.client_rect );
+            mirror_rect( &rect, &window );
+            mirror_rect( &rect, &client );
+        }
+        break;
+    case COORDS_SCREEN:
+        for (parent = info; parent.parent;)
+        {
+            if (!get_shared_window_info( wine_server_ptr_handle( parent.parent ), &parent )) return FALSE;
+            if (!parent.parent) break;  /* desktop window */
+            OffsetRect( &window, parent.client_rect.left, parent.client_rect.top );
+            OffsetRect( &client, parent.client_rect.left, parent.client_rect.top );
+        }
+        break;
+    default:
+        return FALSE;
+    }
+
+    if (window_rect) *window_rect = map_dpi_rect( window, info.dpi, dpi );
+    if (client_rect) *client_rect = map_dpi_rect( client, info.dpi, dpi );
+    return TRUE;
+}
+
 /***********************************************************************
  *           get_window_rects
  *
@@ -1698,6 +1847,7 @@ BOOL get_window_rects( HWND hwnd, enum coords_relative relative, RECT *window_re
     }
 
 other_process:
+    if (get_shared_window_rects( hwnd, relative, window_rect, client_rect, dpi )) return TRUE;
     SERVER_START_REQ( get_window_rectangles )
     {
         req->handle = wine_server_user_handle( hwnd );
@@ -273,6 +273,12 @@ BOOL WINAPI NtUserSetThreadDesktop( HDESK handle )
             NtUnmapViewOfSection( GetCurrentProcess(), (void *)thread_info->desktop_shm );
             thread_info->desktop_shm = NULL;
         }
+        if (thread_info->windows_shm)
+        {
+            NtUnmapViewOfSection( GetCurrentProcess(), (void *)thread_info->windows_shm );
+            thread_info->windows_shm = NULL;
+        }
+        thread_info->windows_shm_failed = FALSE;
     }
     return ret;
 }
@@ -710,24 +716,19 @@ volatile struct global_shared_memory *get_global_shared_memory( void )
     return ret;
 }
 
-const desktop_shm_t *get_desktop_shared_memory(void)
+/* map a section named after the current window station and thread desktop in a given directory */
+static volatile void *map_thread_desktop_section( const WCHAR *dir, SIZE_T size )
 {
-    static const WCHAR dir_desktop_maps[] =
-    {
-        '_','_','w','i','n','e','_','d','e','s','k','t','o','p','_','m','a','p','p','i','n','g','s','\\',0
-    };
-    struct user_thread_info *thread_info = get_user_thread_info();
     HANDLE root, handles[2];
     WCHAR buf[MAX_PATH], *ptr;
+    volatile void *ret;
     DWORD i, needed;
 
-    if (thread_info->desktop_shm) return thread_info->desktop_shm;
-
     handles[0] = NtUserGetProcessWindowStation();
     handles[1] = NtUserGetThreadDesktop( GetCurrentThreadId() );
 
-    memcpy( buf, dir_desktop_maps, wcslen(dir_desktop_maps) * sizeof(WCHAR) );
-    ptr = buf + wcslen(dir_desktop_maps);
+    memcpy( buf, dir, wcslen(dir) * sizeof(WCHAR) );
+    ptr = buf + wcslen(dir);
 
     for (i = 0; i < 2; i++)
     {
@@ -737,9 +738,23 @@ const desktop_shm_t *get_desktop_shared_memory(void)
     }
 
     root = get_winstations_dir_handle();
-    thread_info->desktop_shm = map_shared_memory_section( buf, sizeof(*thread_info->desktop_shm), root );
+    ret = map_shared_memory_section( buf, size, root );
     NtClose( root );
 
+    return ret;
+}
+
+const desktop_shm_t *get_desktop_shared_memory(void)
+{
+    static const WCHAR dir_desktop_maps[] =
+    {
+        '_','_','w','i','n','e','_','d','e','s','k','t','o','p','_','m','a','p','p','i','n','g','s','\\',0
+    };
+    struct user_thread_info *thread_info = get_user_thread_info();
+
+    if (thread_info->desktop_shm) return thread_info->desktop_shm;
+
+    thread_info->desktop_shm = map_thread_desktop_section( dir_desktop_maps, sizeof(*thread_info->desktop_shm) );
     return thread_info->desktop_shm;
 }
 
@@ -758,6 +773,30 @@ const queue_shm_t *get_queue_shared_memory(void)
     return thread_info->queue_shm;
 }
 
+/* get the shared memory slot of a window, only windows of the thread desktop are exposed */
+const window_shm_t *get_window_shared_memory( HWND hwnd )
+{
+    static const WCHAR dir_window_maps[] =
+    {
+        '_','_','w','i','n','e','_','w','i','n','d','o','w','_','m','a','p','p','i','n','g','s','\\',0
+    };
+    struct user_thread_info *thread_info = get_user_thread_info();
+    UINT index = USER_HANDLE_INDEX( HandleToUlong( hwnd ));
+
+    if (index >= MAX_USER_HANDLES) return NULL;
+    if (thread_info->windows_shm) return thread_info->windows_shm + index;
+    /* don't retry a failed mapping on every call, callers fall back to server requests */
+    if (thread_info->windows_shm_failed) return NULL;
+
+    if (!(thread_info->windows_shm = map_thread_desktop_section( dir_window_maps,
+                                                                MAX_USER_HANDLES * sizeof(*thread_info->windows_shm) )))
+    {
+        thread_info->windows_shm_failed = TRUE;
+        return NULL;
+    }
+    return thread_info->windows_shm + index;
+}
+
 static const input_shm_t *get_thread_input_shared_memory( UINT tid, const input_shm_t *input_shm )
 {
     WCHAR bufferW[MAX_PATH];
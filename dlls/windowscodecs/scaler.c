@@ -18,6 +18,7 @@
  */
 
 #include <stdarg.h>
+#include <math.h>
 
 #define COBJMACROS
 
@@ -31,6 +32,17 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(wincodecs);
 
+/* filter weights are 2.14 fixed point, intermediate rows keep 7 fractional bits */
+#define FILTER_BITS 14
+#define ROW_BITS    7
+
+struct scaler_filter
+{
+    UINT taps;      /* number of source pixels contributing to a destination pixel */
+    UINT *start;    /* first contributing source pixel for each destination pixel */
+    SHORT *weights; /* taps weights for each destination pixel */
+};
+
 typedef struct BitmapScaler {
     IWICBitmapScaler IWICBitmapScaler_iface;
     LONG ref;
@@ -42,6 +54,8 @@ typedef struct BitmapScaler {
     UINT bpp;
     void (*fn_get_required_source_rect)(struct BitmapScaler*,UINT,UINT,WICRect*);
     void (*fn_copy_scanline)(struct BitmapScaler*,UINT,UINT,UINT,BYTE**,UINT,UINT,BYTE*);
+    struct scaler_filter filter_x, filter_y;
+    INT *row; /* vertically filtered source row */
     CRITICAL_SECTION lock; /* must be held when initialized */
 } BitmapScaler;
 
@@ -106,6 +120,11 @@ static ULONG WINAPI BitmapScaler_Release(IWICBitmapScaler *iface)
         This->lock.DebugInfo->Spare[0] = 0;
         DeleteCriticalSection(&This->lock);
         if (This->source) IWICBitmapSource_Release(This->source);
+        free(This->filter_x.start);
+        free(This->filter_x.weights);
+        free(This->filter_y.start);
+        free(This->filter_y.weights);
+        free(This->row);
         free(This);
     }
 
@@ -203,6 +222,187 @@ static void NearestNeighbor_CopyScanline(BitmapScaler *This,
     }
 }
 
+static float cubic_kernel(float x)
+{
+    /* Keys cubic convolution with a = -0.5 */
+    x = fabsf(x);
+    if (x < 1.0f) return (1.5f * x - 2.5f) * x * x + 1.0f;
+    if (x < 2.0f) return ((-0.5f * x + 2.5f) * x - 4.0f) * x + 2.0f;
+    return 0.0f;
+}
+
+static float filter_weight(WICBitmapInterpolationMode mode, float x, float scale)
+{
+    float left, right;
+
+    switch (mode)
+    {
+    case WICBitmapInterpolationModeLinear:
+        x = fabsf(x);
+        return x < 1.0f ? 1.0f - x : 0.0f;
+    case WICBitmapInterpolationModeCubic:
+        return cubic_kernel(x);
+    case WICBitmapInterpolationModeHighQualityCubic:
+        return cubic_kernel(x / scale);
+    case WICBitmapInterpolationModeFant:
+    default:
+        /* coverage of the source pixel by the destination pixel area */
+        left = max(x - 0.5f, -scale / 2);
+        right = min(x + 0.5f, scale / 2);
+        return right > left ? right - left : 0.0f;
+    }
+}
+
+/* Compute the contributions of source pixels to each destination pixel along one axis.
+ * Contributions falling outside of the source are folded onto the edge pixels, so that
+ * a destination pixel always reads taps pixels from start. */
+static HRESULT init_scaler_filter(struct scaler_filter *filter, WICBitmapInterpolationMode mode,
+    UINT src_size, UINT dst_size)
+{
+    float scale = (float)src_size / dst_size, support, center, sum, *weights;
+    UINT i, j, taps;
+    INT first, pos;
+
+    /* Linear and Cubic sample the source without prefiltering when downscaling */
+    if (mode == WICBitmapInterpolationModeLinear)
+        support = 1.0f;
+    else if (mode == WICBitmapInterpolationModeCubic)
+        support = 2.0f;
+    else if (mode == WICBitmapInterpolationModeHighQualityCubic)
+        support = 2.0f * max(scale, 1.0f);
+    else
+        support = max(scale, 1.0f) / 2 + 0.5f;
+    if (mode == WICBitmapInterpolationModeHighQualityCubic || mode == WICBitmapInterpolationModeFant)
+        scale = max(scale, 1.0f);
+
+    taps = min(2 * (UINT)ceilf(support) + 1, src_size);
+
+    filter->taps = taps;
+    filter->start = malloc(dst_size * sizeof(*filter->start));
+    filter->weights = malloc(dst_size * taps * sizeof(*filter->weights));
+    if (!filter->start || !filter->weights || !(weights = malloc(taps * sizeof(*weights))))
+        return E_OUTOFMEMORY;
+
+    for (i = 0; i < dst_size; i++)
+    {
+        SHORT *dst_weights = filter->weights + i * taps;
+        INT total = 0, largest = 0;
+
+        center = (i + 0.5f) * src_size / dst_size - 0.5f;
+        first = floorf(center - support) + 1;
+        if (first < 0) first = 0;
+        if (first > (INT)(src_size - taps)) first = src_size - taps;
+        filter->start[i] = first;
+
+        memset(weights, 0, taps * sizeof(*weights));
+        sum = 0.0f;
+        for (pos = floorf(center - support) + 1; pos <= center + support; pos++)
+        {
+            float w = filter_weight(mode, pos - center, scale);
+            INT idx = max(0, min(pos, (INT)src_size - 1)) - first;
+
+            if (!w) continue;
+            if (idx < 0) idx = 0;
+            if (idx >= (INT)taps) idx = taps - 1;
+            weights[idx] += w;
+            sum += w;
+        }
+        if (!sum)
+        {
+            /* no overlap, fall back to the nearest source pixel */
+            pos = floorf(center + 0.5f);
+            weights[min(max(pos, first), first + (INT)taps - 1) - first] = 1.0f;
+            sum = 1.0f;
+        }
+
+        for (j = 0; j < taps; j++)
+        {
+            dst_weights[j] = floorf(weights[j] / sum * (1 << FILTER_BITS) + 0.5f);
+            total += dst_weights[j];
+            if (dst_weights[j] > dst_weights[largest]) largest = j;
+        }
+        /* make sure the weights add up to exactly one */
+        dst_weights[largest] += (1 << FILTER_BITS) - total;
+    }
+
+    free(weights);
+    return S_OK;
+}
+
+static void Filter_GetRequiredSourceRect(BitmapScaler *This,
+    UINT x, UINT y, WICRect *src_rect)
+{
+    src_rect->X = This->filter_x.start[x];
+    src_rect->Y = This->filter_y.start[y];
+    src_rect->Width = This->filter_x.taps;
+    src_rect->Height = This->filter_y.taps;
+}
+
+/* Separable filter on 8-bit channels: filter the needed source columns vertically into
+ * an intermediate row, then filter the row horizontally. The inner loops only use
+ * integer multiply-adds so that they can be vectorized by the compiler. */
+static void Filter_CopyScanline(BitmapScaler *This,
+    UINT dst_x, UINT dst_y, UINT dst_width,
+    BYTE **src_data, UINT src_data_x, UINT src_data_y, BYTE *pbBuffer)
+{
+    const struct scaler_filter *fx = &This->filter_x, *fy = &This->filter_y;
+    const SHORT *weights = fy->weights + dst_y * fy->taps;
+    UINT channels = This->bpp / 8;
+    UINT first = fx->start[dst_x], last = fx->start[dst_x + dst_width - 1] + fx->taps;
+    UINT count = (last - first) * channels, src_offset = (first - src_data_x) * channels;
+    BYTE **src_rows = src_data + fy->start[dst_y] - src_data_y;
+    INT *row = This->row;
+    UINT i, j, c;
+
+    memset(row, 0, count * sizeof(*row));
+    for (j = 0; j < fy->taps; j++)
+    {
+        const BYTE *src = src_rows[j] + src_offset;
+        INT weight = weights[j];
+
+        if (!weight) continue;
+        for (i = 0; i < count; i++) row[i] += weight * src[i];
+    }
+    for (i = 0; i < count; i++)
+        row[i] = (row[i] + (1 << (FILTER_BITS - ROW_BITS - 1))) >> (FILTER_BITS - ROW_BITS);
+
+    for (i = 0; i < dst_width; i++)
+    {
+        const INT *src = row + (fx->start[dst_x + i] - first) * channels;
+
+        weights = fx->weights + (dst_x + i) * fx->taps;
+        for (c = 0; c < channels; c++)
+        {
+            INT sum = 1 << (FILTER_BITS + ROW_BITS - 1);
+
+            for (j = 0; j < fx->taps; j++) sum += weights[j] * src[j * channels + c];
+            sum >>= FILTER_BITS + ROW_BITS;
+            pbBuffer[i * channels + c] = sum < 0 ? 0 : sum > 255 ? 255 : sum;
+        }
+    }
+}
+
+static BOOL is_filterable_format(const WICPixelFormatGUID *format)
+{
+    static const WICPixelFormatGUID *formats[] =
+    {
+        &GUID_WICPixelFormat8bppGray,
+        &GUID_WICPixelFormat24bppBGR,
+        &GUID_WICPixelFormat24bppRGB,
+        &GUID_WICPixelFormat32bppBGR,
+        &GUID_WICPixelFormat32bppBGRA,
+        &GUID_WICPixelFormat32bppPBGRA,
+        &GUID_WICPixelFormat32bppRGB,
+        &GUID_WICPixelFormat32bppRGBA,
+        &GUID_WICPixelFormat32bppPRGBA,
+    };
+    UINT i;
+
+    for (i = 0; i < ARRAY_SIZE(formats); i++)
+        if (IsEqualGUID(format, formats[i])) return TRUE;
+    return FALSE;
+}
+
 static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
     const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
 {
@@ -243,6 +443,12 @@ static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
         goto end;
     }
 
+    if (!dest_rect.Width || !dest_rect.Height)
+    {
+        hr = S_OK;
+        goto end;
+    }
+
     bytesperrow = ((This->bpp * dest_rect.Width)+7)/8;
 
     if (cbStride < bytesperrow)
@@ -351,10 +557,24 @@ static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
     {
         switch (mode)
         {
+        case WICBitmapInterpolationModeNearestNeighbor:
+            break;
+        case WICBitmapInterpolationModeLinear:
+        case WICBitmapInterpolationModeCubic:
+        case WICBitmapInterpolationModeFant:
+        case WICBitmapInterpolationModeHighQualityCubic:
+            if (is_filterable_format(&src_pixelformat)) break;
+            FIXME("mode %i not supported for format %s\n", mode, debugstr_guid(&src_pixelformat));
+            mode = WICBitmapInterpolationModeNearestNeighbor;
+            break;
         default:
             FIXME("unsupported mode %i\n", mode);
-            /* fall-through */
-        case WICBitmapInterpolationModeNearestNeighbor:
+            mode = WICBitmapInterpolationModeNearestNeighbor;
+            break;
+        }
+
+        if (mode == WICBitmapInterpolationModeNearestNeighbor)
+        {
             if ((This->bpp % 8) == 0)
             {
                 IWICBitmapSource_AddRef(pISource);
@@ -368,7 +588,31 @@ static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
             }
             This->fn_get_required_source_rect = NearestNeighbor_GetRequiredSourceRect;
             This->fn_copy_scanline = NearestNeighbor_CopyScanline;
-            break;
+        }
+        else
+        {
+            hr = init_scaler_filter(&This->filter_x, mode, This->src_width, This->width);
+            if (SUCCEEDED(hr))
+                hr = init_scaler_filter(&This->filter_y, mode, This->src_height, This->height);
+            if (SUCCEEDED(hr) && !(This->row = malloc(This->src_width * (This->bpp / 8) * sizeof(*This->row))))
+                hr = E_OUTOFMEMORY;
+
+            if (SUCCEEDED(hr))
+            {
+                IWICBitmapSource_AddRef(pISource);
+                This->source = pISource;
+                This->fn_get_required_source_rect = Filter_GetRequiredSourceRect;
+                This->fn_copy_scanline = Filter_CopyScanline;
+            }
+            else
+            {
+                free(This->filter_x.start);
+                free(This->filter_x.weights);
+                free(This->filter_y.start);
+                free(This->filter_y.weights);
+                memset(&This->filter_x, 0, sizeof(This->filter_x));
+                memset(&This->filter_y, 0, sizeof(This->filter_y));
+            }
         }
     }
 
@@ -527,6 +771,9 @@ HRESULT BitmapScaler_Create(IWICBitmapScaler **scaler)
     This->src_height = 0;
     This->mode = 0;
     This->bpp = 0;
+    memset(&This->filter_x, 0, sizeof(This->filter_x));
+    memset(&This->filter_y, 0, sizeof(This->filter_y));
+    This->row = NULL;
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": BitmapScaler.lock");
 
@@ -1315,6 +1315,196 @@ static void test_bitmap_scaler(void)
     IWICBitmap_Release(bitmap);
 }
 
+static void check_scaled_row(const DWORD *row, const DWORD *expected, int first, int count)
+{
+    int i;
+
+    for (i = first; i < first + count; i++)
+        ok(row[i - first] == expected[i], "Unexpected pixel %u %08lx, expected %08lx.\n",
+                i, row[i - first], expected[i]);
+}
+
+static void test_bitmap_scaler_interpolation(void)
+{
+    static const WICBitmapInterpolationMode modes[] =
+    {
+        WICBitmapInterpolationModeNearestNeighbor,
+        WICBitmapInterpolationModeLinear,
+        WICBitmapInterpolationModeCubic,
+        WICBitmapInterpolationModeFant,
+        WICBitmapInterpolationModeHighQualityCubic,
+    };
+    /* Each destination pixel of the gradient scaled from 8 to 4 pixels covers two source pixels, and
+     * its center falls halfway between them. The nearest neighbor picks the first one. Linear and
+     * Fant only weigh these two pixels, and give back their average. The cubic filters are Keys'
+     * with a = -0.5, which also weigh in the source clamped on its edges: on the first and last
+     * pixels, Cubic is off the average by 7/16 - 1/2 of the 0x20 gradient step, that is by 2, while
+     * HighQualityCubic, widened by the scale factor, is off by less than half a level. */
+    static const DWORD scaled[][4] =
+    {
+        { 0xffe08000, 0xffa08040, 0xff608080, 0xff2080c0 },
+        { 0xffd08010, 0xff908050, 0xff508090, 0xff1080d0 },
+        { 0xffd2800e, 0xff908050, 0xff508090, 0xff0e80d2 },
+        { 0xffd08010, 0xff908050, 0xff508090, 0xff1080d0 },
+        { 0xffd08010, 0xff908050, 0xff508090, 0xff1080d0 },
+    };
+    static const BYTE color[4] = { 0x10, 0x80, 0xf0, 0xff };
+    WICPixelFormatGUID pixel_format;
+    IWICBitmapScaler *scaler;
+    IWICBitmap *bitmap;
+    BYTE src[8 * 8 * 4], dst[5 * 3 * 4];
+    DWORD gradient[8 * 2], row[4];
+    WICRect rc;
+    HRESULT hr;
+    UINT i, j;
+
+    for (i = 0; i < 8 * 8; i++) memcpy(src + i * 4, color, sizeof(color));
+
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 8, 8, &GUID_WICPixelFormat32bppBGRA,
+        8 * 4, sizeof(src), src, &bitmap);
+    ok(hr == S_OK, "Failed to create a bitmap, hr %#lx.\n", hr);
+
+    for (i = 0; i < ARRAY_SIZE(modes); i++)
+    {
+        winetest_push_context("mode %u", modes[i]);
+
+        hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+        ok(hr == S_OK, "Failed to create bitmap scaler, hr %#lx.\n", hr);
+
+        hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, 5, 3, modes[i]);
+        ok(hr == S_OK, "Failed to initialize bitmap scaler, hr %#lx.\n", hr);
+
+        hr = IWICBitmapScaler_GetPixelFormat(scaler, &pixel_format);
+        ok(hr == S_OK, "Failed to get pixel format, hr %#lx.\n", hr);
+        ok(IsEqualGUID(&pixel_format, &GUID_WICPixelFormat32bppBGRA), "Unexpected pixel format %s.\n",
+            wine_dbgstr_guid(&pixel_format));
+
+        memset(dst, 0, sizeof(dst));
+        hr = IWICBitmapScaler_CopyPixels(scaler, NULL, 5 * 4, sizeof(dst), dst);
+        ok(hr == S_OK, "Failed to copy pixels, hr %#lx.\n", hr);
+        for (j = 0; j < 5 * 3; j++)
+            ok(!memcmp(dst + j * 4, color, sizeof(color)), "Unexpected pixel %u %08lx.\n", j, *(DWORD *)(dst + j * 4));
+
+        rc.X = 1;
+        rc.Y = 1;
+        rc.Width = 3;
+        rc.Height = 2;
+        memset(dst, 0, sizeof(dst));
+        hr = IWICBitmapScaler_CopyPixels(scaler, &rc, 3 * 4, sizeof(dst), dst);
+        ok(hr == S_OK, "Failed to copy pixels, hr %#lx.\n", hr);
+        for (j = 0; j < 3 * 2; j++)
+            ok(!memcmp(dst + j * 4, color, sizeof(color)), "Unexpected pixel %u %08lx.\n", j, *(DWORD *)(dst + j * 4));
+
+        rc.Width = 0;
+        hr = IWICBitmapScaler_CopyPixels(scaler, &rc, 3 * 4, sizeof(dst), dst);
+        ok(hr == S_OK, "Failed to copy pixels, hr %#lx.\n", hr);
+        rc.Width = 3;
+        rc.Height = 0;
+        hr = IWICBitmapScaler_CopyPixels(scaler, &rc, 3 * 4, sizeof(dst), dst);
+        ok(hr == S_OK, "Failed to copy pixels, hr %#lx.\n", hr);
+
+        IWICBitmapScaler_Release(scaler);
+
+        winetest_pop_context();
+    }
+
+    IWICBitmap_Release(bitmap);
+
+    for (i = 0; i < ARRAY_SIZE(gradient); i++)
+        gradient[i] = 0xff008000 | ((0xe0 - (i % 8) * 0x20) << 16) | (i % 8) * 0x20;
+
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 8, 2, &GUID_WICPixelFormat32bppBGRA,
+        8 * 4, sizeof(gradient), (BYTE *)gradient, &bitmap);
+    ok(hr == S_OK, "Failed to create a bitmap, hr %#lx.\n", hr);
+
+    for (i = 0; i < ARRAY_SIZE(modes); i++)
+    {
+        winetest_push_context("mode %u", modes[i]);
+
+        hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+        ok(hr == S_OK, "Failed to create bitmap scaler, hr %#lx.\n", hr);
+
+        hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, 4, 1, modes[i]);
+        ok(hr == S_OK, "Failed to initialize bitmap scaler, hr %#lx.\n", hr);
+
+        memset(row, 0, sizeof(row));
+        hr = IWICBitmapScaler_CopyPixels(scaler, NULL, sizeof(row), sizeof(row), (BYTE *)row);
+        ok(hr == S_OK, "Failed to copy pixels, hr %#lx.\n", hr);
+        check_scaled_row(row, scaled[i], 0, 4);
+
+        rc.X = 1;
+        rc.Y = 0;
+        rc.Width = 2;
+        rc.Height = 1;
+        memset(row, 0, sizeof(row));
+        hr = IWICBitmapScaler_CopyPixels(scaler, &rc, sizeof(row), sizeof(row), (BYTE *)row);
+        ok(hr == S_OK, "Failed to copy pixels, hr %#lx.\n", hr);
+        check_scaled_row(row, scaled[i], 1, 2);
+
+        IWICBitmapScaler_Release(scaler);
+
+        winetest_pop_context();
+    }
+
+    IWICBitmap_Release(bitmap);
+}
+
+static void benchmark_bitmap_scaler(void)
+{
+    static const WICBitmapInterpolationMode modes[] =
+    {
+        WICBitmapInterpolationModeNearestNeighbor,
+        WICBitmapInterpolationModeLinear,
+        WICBitmapInterpolationModeCubic,
+        WICBitmapInterpolationModeFant,
+        WICBitmapInterpolationModeHighQualityCubic,
+    };
+    static const UINT sizes[][2] = { {1024, 768}, {512, 384}, {256, 192}, {1600, 1200} };
+    LARGE_INTEGER freq, start, end;
+    IWICBitmapScaler *scaler;
+    IWICBitmap *bitmap;
+    BYTE *src, *dst;
+    UINT i, j, k;
+    HRESULT hr;
+
+    /* scale a 1024x768 picture down and up, and trace the destination pixels per second */
+    src = malloc(1024 * 768 * 4);
+    dst = malloc(1600 * 1200 * 4);
+    for (i = 0; i < 1024 * 768 * 4; i++) src[i] = i * 7 + (i >> 12);
+
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 1024, 768, &GUID_WICPixelFormat32bppBGRA,
+        1024 * 4, 1024 * 768 * 4, src, &bitmap);
+    ok(hr == S_OK, "Failed to create a bitmap, hr %#lx.\n", hr);
+
+    QueryPerformanceFrequency(&freq);
+    for (i = 0; i < ARRAY_SIZE(modes); i++)
+    {
+        for (j = 0; j < ARRAY_SIZE(sizes); j++)
+        {
+            hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+            ok(hr == S_OK, "Failed to create bitmap scaler, hr %#lx.\n", hr);
+            hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, sizes[j][0], sizes[j][1], modes[i]);
+            ok(hr == S_OK, "Failed to initialize bitmap scaler, hr %#lx.\n", hr);
+
+            QueryPerformanceCounter(&start);
+            for (k = 0; k < 5; k++)
+            {
+                hr = IWICBitmapScaler_CopyPixels(scaler, NULL, sizes[j][0] * 4, sizes[j][0] * sizes[j][1] * 4, dst);
+                ok(hr == S_OK, "Failed to copy pixels, hr %#lx.\n", hr);
+            }
+            QueryPerformanceCounter(&end);
+
+            trace("mode %u, 1024x768 to %ux%u: %.1f MPix/s\n", modes[i], sizes[j][0], sizes[j][1],
+                  5.0 * sizes[j][0] * sizes[j][1] * freq.QuadPart / (end.QuadPart - start.QuadPart) / 1e6);
+            IWICBitmapScaler_Release(scaler);
+        }
+    }
+
+    IWICBitmap_Release(bitmap);
+    free(dst);
+    free(src);
+}
+
 static LONG obj_refcount(void *obj)
 {
     IUnknown_AddRef((IUnknown *)obj);
@@ -1485,6 +1675,8 @@ START_TEST(bitmap)
     test_CreateBitmapFromHBITMAP();
     test_clipper();
     test_bitmap_scaler();
+    test_bitmap_scaler_interpolation();
+    if (winetest_interactive) benchmark_bitmap_scaler();
 
     IWICImagingFactory_Release(factory);
 
@@ -453,10 +453,14 @@ static HRESULT adapter_vk_create_device(struct wined3d *wined3d, const struct wi
         goto fail;
     }
 
+    device_vk->disk_cache = wined3d_disk_cache_open("vulkan");
+    wined3d_device_vk_create_pipeline_cache(device_vk, adapter_vk);
+
     if (FAILED(hr = wined3d_device_init(&device_vk->d, wined3d, adapter->ordinal, device_type, focus_window,
             flags, surface_alignment, levels, level_count, vk_info->supported, device_parent)))
     {
         WARN("Failed to initialize device, hr %#lx.\n", hr);
+        wined3d_device_vk_destroy_pipeline_cache(device_vk, adapter_vk);
         wined3d_allocator_cleanup(&device_vk->allocator);
         goto fail;
     }
@@ -479,6 +483,7 @@ static void adapter_vk_destroy_device(struct wined3d_device *device)
     const struct wined3d_vk_info *vk_info = &device_vk->vk_info;
 
     wined3d_device_cleanup(&device_vk->d);
+    wined3d_device_vk_destroy_pipeline_cache(device_vk, wined3d_adapter_vk(device->adapter));
     wined3d_allocator_cleanup(&device_vk->allocator);
 
     wined3d_lock_cleanup(&device_vk->allocator_cs);
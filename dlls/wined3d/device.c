@@ -910,6 +910,101 @@ void wined3d_device_vk_destroy_null_views(struct wined3d_device_vk *device_vk, s
     wined3d_context_vk_destroy_vk_buffer_view(context_vk, v->vk_view_buffer_uint, id);
 }
 
+/* Pipeline cache data is only usable with the same device and driver. */
+struct wined3d_pipeline_cache_key_vk
+{
+    char name[16];
+    uint32_t vendor_id;
+    uint32_t device_id;
+    uint32_t driver_version;
+    uint8_t uuid[VK_UUID_SIZE];
+};
+
+static void wined3d_pipeline_cache_key_vk_init(struct wined3d_pipeline_cache_key_vk *key,
+        const struct wined3d_adapter_vk *adapter_vk)
+{
+    const struct wined3d_vk_info *vk_info = &adapter_vk->vk_info;
+    VkPhysicalDeviceProperties properties;
+
+    VK_CALL(vkGetPhysicalDeviceProperties(adapter_vk->physical_device, &properties));
+
+    memset(key, 0, sizeof(*key));
+    strcpy(key->name, "pipeline_cache");
+    key->vendor_id = properties.vendorID;
+    key->device_id = properties.deviceID;
+    key->driver_version = properties.driverVersion;
+    memcpy(key->uuid, properties.pipelineCacheUUID, sizeof(key->uuid));
+}
+
+void wined3d_device_vk_create_pipeline_cache(struct wined3d_device_vk *device_vk,
+        const struct wined3d_adapter_vk *adapter_vk)
+{
+    const struct wined3d_vk_info *vk_info = &device_vk->vk_info;
+    struct wined3d_pipeline_cache_key_vk key;
+    VkPipelineCacheCreateInfo create_info;
+    size_t data_size = 0;
+    void *data = NULL;
+    VkResult vr;
+
+    if (!device_vk->disk_cache)
+        return;
+
+    wined3d_pipeline_cache_key_vk_init(&key, adapter_vk);
+    wined3d_disk_cache_get(device_vk->disk_cache, &key, sizeof(key), &data, &data_size);
+
+    create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    create_info.pNext = NULL;
+    create_info.flags = 0;
+    create_info.initialDataSize = data_size;
+    create_info.pInitialData = data;
+    if ((vr = VK_CALL(vkCreatePipelineCache(device_vk->vk_device,
+            &create_info, NULL, &device_vk->vk_pipeline_cache))) < 0 && data)
+    {
+        WARN("Failed to create pipeline cache from cached data, vr %s.\n", wined3d_debug_vkresult(vr));
+        wined3d_disk_cache_remove(device_vk->disk_cache, &key, sizeof(key));
+        create_info.initialDataSize = 0;
+        create_info.pInitialData = NULL;
+        vr = VK_CALL(vkCreatePipelineCache(device_vk->vk_device, &create_info, NULL, &device_vk->vk_pipeline_cache));
+    }
+    heap_free(data);
+
+    if (vr < 0)
+    {
+        WARN("Failed to create pipeline cache, vr %s.\n", wined3d_debug_vkresult(vr));
+        device_vk->vk_pipeline_cache = VK_NULL_HANDLE;
+        return;
+    }
+
+    TRACE("Created pipeline cache 0x%s, initial size %Iu.\n",
+            wine_dbgstr_longlong(device_vk->vk_pipeline_cache), data_size);
+}
+
+void wined3d_device_vk_destroy_pipeline_cache(struct wined3d_device_vk *device_vk,
+        const struct wined3d_adapter_vk *adapter_vk)
+{
+    const struct wined3d_vk_info *vk_info = &device_vk->vk_info;
+    struct wined3d_pipeline_cache_key_vk key;
+    size_t data_size;
+    void *data;
+
+    if (!device_vk->vk_pipeline_cache)
+        return;
+
+    if (!VK_CALL(vkGetPipelineCacheData(device_vk->vk_device, device_vk->vk_pipeline_cache, &data_size, NULL))
+            && data_size && (data = heap_alloc(data_size)))
+    {
+        if (!VK_CALL(vkGetPipelineCacheData(device_vk->vk_device, device_vk->vk_pipeline_cache, &data_size, data)))
+        {
+            wined3d_pipeline_cache_key_vk_init(&key, adapter_vk);
+            wined3d_disk_cache_put(device_vk->disk_cache, &key, sizeof(key), data, data_size);
+        }
+        heap_free(data);
+    }
+
+    VK_CALL(vkDestroyPipelineCache(device_vk->vk_device, device_vk->vk_pipeline_cache, NULL));
+    device_vk->vk_pipeline_cache = VK_NULL_HANDLE;
+}
+
 HRESULT CDECL wined3d_device_acquire_focus_window(struct wined3d_device *device, HWND window)
 {
     unsigned int screensaver_active;
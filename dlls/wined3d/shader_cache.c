@@ -0,0 +1,576 @@
+/*
+ * On-disk cache for translated shaders and pipeline caches
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "wined3d_private.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(d3d_shader);
+
+#define WINED3D_DISK_CACHE_MAGIC    0x43443357u /* "W3DC" */
+#define WINED3D_DISK_CACHE_VERSION  1
+
+/* Each cache entry is stored in its own file, named after the hash of its
+ * key. The full key is stored along with the data, and compared on lookup,
+ * so hash collisions only result in cache misses. */
+struct wined3d_disk_cache_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key_size;
+    uint64_t data_size;
+};
+
+struct wined3d_disk_cache_entry
+{
+    struct wine_rb_entry entry;
+    struct list lru_entry;
+    uint64_t hash;
+    uint64_t size;
+    FILETIME access_time;
+};
+
+struct wined3d_disk_cache
+{
+    struct list entry;
+    char name[16];
+
+    CRITICAL_SECTION lock;
+    WCHAR path[MAX_PATH];
+
+    /* entries, by hash and in least recently used first order */
+    struct wine_rb_tree entries;
+    struct list lru;
+    uint64_t size, max_size;
+
+    unsigned int hits, misses, stores, evictions;
+};
+
+/* Caches are shared by all devices, and live until the DLL is unloaded, so
+ * that the cache directories are only scanned once per process. */
+static struct list wined3d_disk_caches = LIST_INIT(wined3d_disk_caches);
+static CRITICAL_SECTION wined3d_disk_cache_cs;
+static CRITICAL_SECTION_DEBUG wined3d_disk_cache_cs_debug =
+{
+    0, 0, &wined3d_disk_cache_cs,
+    {&wined3d_disk_cache_cs_debug.ProcessLocksList,
+    &wined3d_disk_cache_cs_debug.ProcessLocksList},
+    0, 0, {(DWORD_PTR)(__FILE__ ": wined3d_disk_cache_cs")}
+};
+static CRITICAL_SECTION wined3d_disk_cache_cs = {&wined3d_disk_cache_cs_debug, -1, 0, 0, 0, 0};
+
+static int wined3d_disk_cache_entry_compare(const void *key, const struct wine_rb_entry *entry)
+{
+    const struct wined3d_disk_cache_entry *e = WINE_RB_ENTRY_VALUE(entry, struct wined3d_disk_cache_entry, entry);
+    uint64_t hash = *(const uint64_t *)key;
+
+    return (hash > e->hash) - (hash < e->hash);
+}
+
+static void wined3d_disk_cache_free_entry(struct wine_rb_entry *entry, void *ctx)
+{
+    heap_free(WINE_RB_ENTRY_VALUE(entry, struct wined3d_disk_cache_entry, entry));
+}
+
+/* FNV-1a */
+static uint64_t wined3d_disk_cache_hash(const void *key, size_t key_size)
+{
+    const uint8_t *p = key;
+    uint64_t hash = 0xcbf29ce484222325ull;
+    size_t i;
+
+    for (i = 0; i < key_size; ++i)
+    {
+        hash ^= p[i];
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+static bool wined3d_disk_cache_get_file_path(const struct wined3d_disk_cache *cache,
+        uint64_t hash, const WCHAR *suffix, WCHAR *path)
+{
+    return swprintf(path, MAX_PATH, L"%s\\%08x%08x%s", cache->path,
+            (unsigned int)(hash >> 32), (unsigned int)hash, suffix) > 0;
+}
+
+static bool wined3d_disk_cache_parse_file_name(const WCHAR *name, uint64_t *hash)
+{
+    unsigned int i;
+
+    *hash = 0;
+    for (i = 0; i < 16; ++i)
+    {
+        *hash <<= 4;
+        if (name[i] >= '0' && name[i] <= '9')
+            *hash |= name[i] - '0';
+        else if (name[i] >= 'a' && name[i] <= 'f')
+            *hash |= name[i] - 'a' + 10;
+        else
+            return false;
+    }
+
+    return !name[i];
+}
+
+/* Temporary files are named "<hash>.<pid>.<tid>.tmp", see wined3d_disk_cache_put(). */
+static bool wined3d_disk_cache_parse_tmp_file_name(const WCHAR *name, DWORD *pid)
+{
+    WCHAR hash[17], *end;
+    size_t len;
+    uint64_t h;
+
+    if ((len = wcslen(name)) <= 16 || name[16] != '.' || wcscmp(name + len - 4, L".tmp"))
+        return false;
+    memcpy(hash, name, 16 * sizeof(*hash));
+    hash[16] = 0;
+    if (!wined3d_disk_cache_parse_file_name(hash, &h))
+        return false;
+    *pid = wcstoul(name + 17, &end, 16);
+    return *end == '.' && end != name + 17;
+}
+
+/* Whether a temporary file was left behind by a process which doesn't exist anymore. */
+static bool wined3d_disk_cache_is_stale_tmp_file(const WCHAR *name)
+{
+    DWORD pid, exit_code;
+    HANDLE process;
+    bool ret;
+
+    if (!wined3d_disk_cache_parse_tmp_file_name(name, &pid) || pid == GetCurrentProcessId())
+        return false;
+    if (!(process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid)))
+        return GetLastError() == ERROR_INVALID_PARAMETER;
+    ret = GetExitCodeProcess(process, &exit_code) && exit_code != STILL_ACTIVE;
+    CloseHandle(process);
+    return ret;
+}
+
+/* Move an entry to the most recently used end of the list. */
+static void wined3d_disk_cache_touch_entry(struct wined3d_disk_cache *cache,
+        struct wined3d_disk_cache_entry *entry, const FILETIME *time)
+{
+    entry->access_time = *time;
+    list_remove(&entry->lru_entry);
+    list_add_tail(&cache->lru, &entry->lru_entry);
+}
+
+static void wined3d_disk_cache_add_entry(struct wined3d_disk_cache *cache,
+        uint64_t hash, uint64_t size, const FILETIME *time)
+{
+    struct wined3d_disk_cache_entry *entry;
+    struct wine_rb_entry *rb_entry;
+
+    if ((rb_entry = wine_rb_get(&cache->entries, &hash)))
+    {
+        entry = WINE_RB_ENTRY_VALUE(rb_entry, struct wined3d_disk_cache_entry, entry);
+        cache->size = cache->size - entry->size + size;
+        entry->size = size;
+        wined3d_disk_cache_touch_entry(cache, entry, time);
+        return;
+    }
+
+    if (!(entry = heap_alloc(sizeof(*entry))))
+        return;
+    entry->hash = hash;
+    entry->size = size;
+    entry->access_time = *time;
+    wine_rb_put(&cache->entries, &entry->hash, &entry->entry);
+    list_add_tail(&cache->lru, &entry->lru_entry);
+    cache->size += size;
+}
+
+static void wined3d_disk_cache_remove_entry(struct wined3d_disk_cache *cache,
+        struct wined3d_disk_cache_entry *entry, struct list *removed)
+{
+    cache->size -= entry->size;
+    list_remove(&entry->lru_entry);
+    wine_rb_remove(&cache->entries, &entry->entry);
+    list_add_tail(removed, &entry->lru_entry);
+}
+
+/* Move the least recently used entries to the "evicted" list, until the cache
+ * fits in its size limit. Their files are deleted by
+ * wined3d_disk_cache_delete_entries(), outside of the cache lock. */
+static void wined3d_disk_cache_evict(struct wined3d_disk_cache *cache, struct list *evicted)
+{
+    struct wined3d_disk_cache_entry *entry;
+    struct list *head;
+
+    while (cache->size > cache->max_size && (head = list_head(&cache->lru)))
+    {
+        entry = LIST_ENTRY(head, struct wined3d_disk_cache_entry, lru_entry);
+
+        TRACE("Evicting entry %s, size %s.\n", wine_dbgstr_longlong(entry->hash), wine_dbgstr_longlong(entry->size));
+        wined3d_disk_cache_remove_entry(cache, entry, evicted);
+        ++cache->evictions;
+    }
+}
+
+static void wined3d_disk_cache_delete_entries(struct wined3d_disk_cache *cache, struct list *entries)
+{
+    struct wined3d_disk_cache_entry *entry, *next;
+    WCHAR path[MAX_PATH];
+
+    LIST_FOR_EACH_ENTRY_SAFE(entry, next, entries, struct wined3d_disk_cache_entry, lru_entry)
+    {
+        if (wined3d_disk_cache_get_file_path(cache, entry->hash, L"", path))
+            DeleteFileW(path);
+        heap_free(entry);
+    }
+}
+
+static int __cdecl wined3d_disk_cache_entry_time_compare(const void *a, const void *b)
+{
+    const struct wined3d_disk_cache_entry *e1 = *(struct wined3d_disk_cache_entry * const *)a;
+    const struct wined3d_disk_cache_entry *e2 = *(struct wined3d_disk_cache_entry * const *)b;
+
+    return CompareFileTime(&e1->access_time, &e2->access_time);
+}
+
+/* Build the initial least recently used list from the cache directory,
+ * using the file modification times. Temporary files of writers that died
+ * before renaming them are deleted. */
+static void wined3d_disk_cache_scan(struct wined3d_disk_cache *cache)
+{
+    struct wined3d_disk_cache_entry **sorted, *entry;
+    WIN32_FIND_DATAW data;
+    WCHAR path[MAX_PATH];
+    SIZE_T count, i;
+    uint64_t hash;
+    HANDLE find;
+
+    if (swprintf(path, ARRAY_SIZE(path), L"%s\\*", cache->path) < 0)
+        return;
+    if ((find = FindFirstFileW(path, &data)) == INVALID_HANDLE_VALUE)
+        return;
+    do
+    {
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            continue;
+        if (!wined3d_disk_cache_parse_file_name(data.cFileName, &hash))
+        {
+            if (wined3d_disk_cache_is_stale_tmp_file(data.cFileName)
+                    && swprintf(path, ARRAY_SIZE(path), L"%s\\%s", cache->path, data.cFileName) > 0)
+            {
+                TRACE("Deleting stale temporary file %s.\n", debugstr_w(path));
+                DeleteFileW(path);
+            }
+            continue;
+        }
+        wined3d_disk_cache_add_entry(cache, hash,
+                ((uint64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow, &data.ftLastWriteTime);
+    } while (FindNextFileW(find, &data));
+    FindClose(find);
+
+    if (!(count = list_count(&cache->lru)) || !(sorted = heap_calloc(count, sizeof(*sorted))))
+        return;
+
+    i = 0;
+    LIST_FOR_EACH_ENTRY(entry, &cache->lru, struct wined3d_disk_cache_entry, lru_entry)
+        sorted[i++] = entry;
+    qsort(sorted, count, sizeof(*sorted), wined3d_disk_cache_entry_time_compare);
+
+    list_init(&cache->lru);
+    for (i = 0; i < count; ++i)
+        list_add_tail(&cache->lru, &sorted[i]->lru_entry);
+    heap_free(sorted);
+}
+
+static bool wined3d_disk_cache_create_directory(WCHAR *path)
+{
+    WCHAR *p;
+
+    /* create the intermediate directories, skipping the drive or server name */
+    for (p = path + 3; *p; ++p)
+    {
+        if (*p != '\\')
+            continue;
+        *p = 0;
+        CreateDirectoryW(path, NULL);
+        *p = '\\';
+    }
+
+    return CreateDirectoryW(path, NULL) || GetLastError() == ERROR_ALREADY_EXISTS;
+}
+
+static struct wined3d_disk_cache *wined3d_disk_cache_create(const char *name)
+{
+    struct list evicted = LIST_INIT(evicted);
+    struct wined3d_disk_cache *cache;
+    WCHAR base[MAX_PATH];
+    DWORD len;
+
+    if (!wined3d_settings.shader_cache_size)
+        return NULL;
+
+    if (wined3d_settings.shader_cache_path)
+    {
+        if (!MultiByteToWideChar(CP_ACP, 0, wined3d_settings.shader_cache_path, -1, base, ARRAY_SIZE(base)))
+            return NULL;
+    }
+    else
+    {
+        if (!(len = GetEnvironmentVariableW(L"LOCALAPPDATA", base, ARRAY_SIZE(base))) || len >= ARRAY_SIZE(base))
+            return NULL;
+        if (wcslen(base) + wcslen(L"\\wine\\wined3d") >= ARRAY_SIZE(base))
+            return NULL;
+        wcscat(base, L"\\wine\\wined3d");
+    }
+
+    if (!(cache = heap_alloc_zero(sizeof(*cache))))
+        return NULL;
+
+    if (swprintf(cache->path, ARRAY_SIZE(cache->path), L"%s\\%S", base, name) < 0
+            || !wined3d_disk_cache_create_directory(cache->path))
+    {
+        WARN("Failed to create cache directory %s.\n", debugstr_w(cache->path));
+        heap_free(cache);
+        return NULL;
+    }
+
+    strcpy(cache->name, name);
+    wined3d_lock_init(&cache->lock, "wined3d_disk_cache.lock");
+    wine_rb_init(&cache->entries, wined3d_disk_cache_entry_compare);
+    list_init(&cache->lru);
+    cache->max_size = (uint64_t)wined3d_settings.shader_cache_size * 1024 * 1024;
+
+    wined3d_disk_cache_scan(cache);
+    wined3d_disk_cache_evict(cache, &evicted);
+    wined3d_disk_cache_delete_entries(cache, &evicted);
+
+    TRACE("Created cache %p, path %s, %u entries, size %s.\n", cache, debugstr_w(cache->path),
+            list_count(&cache->lru), wine_dbgstr_longlong(cache->size));
+
+    return cache;
+}
+
+/* Get the process wide cache of the given name, creating it on first use. */
+struct wined3d_disk_cache *wined3d_disk_cache_open(const char *name)
+{
+    struct wined3d_disk_cache *cache;
+
+    if (!wined3d_settings.shader_cache_size || strlen(name) >= ARRAY_SIZE(cache->name))
+        return NULL;
+
+    EnterCriticalSection(&wined3d_disk_cache_cs);
+    LIST_FOR_EACH_ENTRY(cache, &wined3d_disk_caches, struct wined3d_disk_cache, entry)
+    {
+        if (!strcmp(cache->name, name))
+            goto done;
+    }
+    if ((cache = wined3d_disk_cache_create(name)))
+        list_add_tail(&wined3d_disk_caches, &cache->entry);
+done:
+    LeaveCriticalSection(&wined3d_disk_cache_cs);
+
+    return cache;
+}
+
+static void wined3d_disk_cache_destroy(struct wined3d_disk_cache *cache)
+{
+    TRACE("Destroying cache %p, %u hits, %u misses, %u stores, %u evictions, size %s.\n",
+            cache, cache->hits, cache->misses, cache->stores, cache->evictions, wine_dbgstr_longlong(cache->size));
+
+    wine_rb_destroy(&cache->entries, wined3d_disk_cache_free_entry, NULL);
+    wined3d_lock_cleanup(&cache->lock);
+    heap_free(cache);
+}
+
+void wined3d_disk_cache_cleanup(void)
+{
+    struct wined3d_disk_cache *cache, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE(cache, next, &wined3d_disk_caches, struct wined3d_disk_cache, entry)
+    {
+        list_remove(&cache->entry);
+        wined3d_disk_cache_destroy(cache);
+    }
+    DeleteCriticalSection(&wined3d_disk_cache_cs);
+}
+
+static bool wined3d_disk_cache_read(HANDLE file, const void *key, size_t key_size, void **data, size_t *data_size)
+{
+    struct wined3d_disk_cache_header header;
+    LARGE_INTEGER file_size;
+    void *file_key;
+    DWORD size;
+    bool ret;
+
+    if (!GetFileSizeEx(file, &file_size))
+        return false;
+    if (!ReadFile(file, &header, sizeof(header), &size, NULL) || size != sizeof(header))
+        return false;
+    if (header.magic != WINED3D_DISK_CACHE_MAGIC || header.version != WINED3D_DISK_CACHE_VERSION
+            || header.key_size != key_size || header.data_size > UINT_MAX
+            || file_size.QuadPart != sizeof(header) + header.key_size + header.data_size)
+        return false;
+
+    if (!(file_key = heap_alloc(key_size)))
+        return false;
+    ret = ReadFile(file, file_key, key_size, &size, NULL) && size == key_size && !memcmp(file_key, key, key_size);
+    heap_free(file_key);
+    if (!ret)
+        return false;
+
+    if (!(*data = heap_alloc(header.data_size)))
+        return false;
+    if (!ReadFile(file, *data, header.data_size, &size, NULL) || size != header.data_size)
+    {
+        heap_free(*data);
+        return false;
+    }
+    *data_size = header.data_size;
+
+    return true;
+}
+
+/* On success, the returned data should be freed with heap_free(). The file is
+ * read without holding the cache lock, the lock only protects the entry list. */
+bool wined3d_disk_cache_get(struct wined3d_disk_cache *cache, const void *key, size_t key_size,
+        void **data, size_t *data_size)
+{
+    uint64_t hash = wined3d_disk_cache_hash(key, key_size);
+    struct wine_rb_entry *rb_entry;
+    WCHAR path[MAX_PATH];
+    FILETIME time;
+    HANDLE file;
+    bool ret;
+
+    if (!cache || !wined3d_disk_cache_get_file_path(cache, hash, L"", path))
+        return false;
+
+    if ((file = CreateFileW(path, GENERIC_READ | FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_DELETE,
+            NULL, OPEN_EXISTING, 0, NULL)) == INVALID_HANDLE_VALUE)
+    {
+        ret = false;
+    }
+    else
+    {
+        if ((ret = wined3d_disk_cache_read(file, key, key_size, data, data_size)))
+        {
+            /* update the modification time, for eviction in subsequent runs */
+            GetSystemTimeAsFileTime(&time);
+            SetFileTime(file, NULL, NULL, &time);
+        }
+        CloseHandle(file);
+    }
+
+    EnterCriticalSection(&cache->lock);
+    if (ret)
+    {
+        if ((rb_entry = wine_rb_get(&cache->entries, &hash)))
+            wined3d_disk_cache_touch_entry(cache,
+                    WINE_RB_ENTRY_VALUE(rb_entry, struct wined3d_disk_cache_entry, entry), &time);
+        else
+            wined3d_disk_cache_add_entry(cache, hash, sizeof(struct wined3d_disk_cache_header)
+                    + key_size + *data_size, &time);
+        ++cache->hits;
+    }
+    else
+    {
+        ++cache->misses;
+    }
+    LeaveCriticalSection(&cache->lock);
+
+    TRACE("cache %p, hash %s, ret %#x.\n", cache, wine_dbgstr_longlong(hash), ret);
+
+    return ret;
+}
+
+/* Remove an entry returned by wined3d_disk_cache_get(), which turned out to be unusable. */
+void wined3d_disk_cache_remove(struct wined3d_disk_cache *cache, const void *key, size_t key_size)
+{
+    uint64_t hash = wined3d_disk_cache_hash(key, key_size);
+    struct list removed = LIST_INIT(removed);
+    struct wine_rb_entry *rb_entry;
+
+    if (!cache)
+        return;
+
+    TRACE("cache %p, hash %s.\n", cache, wine_dbgstr_longlong(hash));
+
+    EnterCriticalSection(&cache->lock);
+    if ((rb_entry = wine_rb_get(&cache->entries, &hash)))
+    {
+        wined3d_disk_cache_remove_entry(cache,
+                WINE_RB_ENTRY_VALUE(rb_entry, struct wined3d_disk_cache_entry, entry), &removed);
+        ++cache->evictions;
+    }
+    LeaveCriticalSection(&cache->lock);
+
+    wined3d_disk_cache_delete_entries(cache, &removed);
+}
+
+void wined3d_disk_cache_put(struct wined3d_disk_cache *cache, const void *key, size_t key_size,
+        const void *data, size_t data_size)
+{
+    uint64_t hash = wined3d_disk_cache_hash(key, key_size);
+    struct wined3d_disk_cache_header header;
+    WCHAR path[MAX_PATH], tmp_path[MAX_PATH];
+    struct list evicted = LIST_INIT(evicted);
+    WCHAR suffix[32];
+    FILETIME time;
+    DWORD size;
+    HANDLE file;
+    bool ret;
+
+    if (!cache)
+        return;
+
+    header.magic = WINED3D_DISK_CACHE_MAGIC;
+    header.version = WINED3D_DISK_CACHE_VERSION;
+    header.key_size = key_size;
+    header.data_size = data_size;
+    if (sizeof(header) + key_size + data_size > cache->max_size)
+        return;
+
+    /* write to a temporary file first, other processes and threads may be reading the same entry */
+    swprintf(suffix, ARRAY_SIZE(suffix), L".%lx.%lx.tmp", GetCurrentProcessId(), GetCurrentThreadId());
+    if (!wined3d_disk_cache_get_file_path(cache, hash, L"", path)
+            || !wined3d_disk_cache_get_file_path(cache, hash, suffix, tmp_path))
+        return;
+
+    if ((file = CreateFileW(tmp_path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL)) == INVALID_HANDLE_VALUE)
+    {
+        WARN("Failed to create %s, error %lu.\n", debugstr_w(tmp_path), GetLastError());
+        return;
+    }
+    ret = WriteFile(file, &header, sizeof(header), &size, NULL) && size == sizeof(header)
+            && WriteFile(file, key, key_size, &size, NULL) && size == key_size
+            && WriteFile(file, data, data_size, &size, NULL) && size == data_size;
+    CloseHandle(file);
+
+    if (!ret || !MoveFileExW(tmp_path, path, MOVEFILE_REPLACE_EXISTING))
+    {
+        WARN("Failed to write cache entry %s.\n", debugstr_w(path));
+        DeleteFileW(tmp_path);
+        return;
+    }
+
+    GetSystemTimeAsFileTime(&time);
+
+    EnterCriticalSection(&cache->lock);
+    wined3d_disk_cache_add_entry(cache, hash, sizeof(header) + key_size + data_size, &time);
+    wined3d_disk_cache_evict(cache, &evicted);
+    ++cache->stores;
+    LeaveCriticalSection(&cache->lock);
+
+    wined3d_disk_cache_delete_entries(cache, &evicted);
+
+    TRACE("cache %p, hash %s, data_size %Iu.\n", cache, wine_dbgstr_longlong(hash), data_size);
+}
@@ -227,6 +227,69 @@ static void shader_spirv_init_shader_interface_vk(struct wined3d_shader_spirv_sh
     iface->vkd3d_interface.uav_counter_count = b->uav_counter_count;
 }
 
+static VkShaderModule shader_spirv_create_module(struct wined3d_device_vk *device_vk,
+        const struct vkd3d_shader_code *spirv)
+{
+    const struct wined3d_vk_info *vk_info = &device_vk->vk_info;
+    VkShaderModuleCreateInfo shader_create_info;
+    VkShaderModule module;
+    VkResult vr;
+
+    shader_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    shader_create_info.pNext = NULL;
+    shader_create_info.flags = 0;
+    shader_create_info.codeSize = spirv->size;
+    shader_create_info.pCode = spirv->code;
+    if ((vr = VK_CALL(vkCreateShaderModule(device_vk->vk_device, &shader_create_info, NULL, &module))) < 0)
+    {
+        WARN("Failed to create Vulkan shader module, vr %s.\n", wined3d_debug_vkresult(vr));
+        return VK_NULL_HANDLE;
+    }
+
+    return module;
+}
+
+static void *shader_spirv_append_key(void *ptr, const void *data, size_t size)
+{
+    if (size)
+        memcpy(ptr, data, size);
+    return (uint8_t *)ptr + size;
+}
+
+/* Build the disk cache key of a shader variant, from everything affecting its translation. Shaders
+ * using stream output reference the output element names indirectly, and aren't cached. */
+static void *shader_spirv_get_cache_key(const struct wined3d_shader_desc *shader_desc,
+        enum wined3d_shader_type shader_type, const struct shader_spirv_compile_arguments *args,
+        const struct shader_spirv_resource_bindings *bindings, size_t *key_size)
+{
+    static const struct shader_spirv_compile_arguments default_args;
+    const char *version = vkd3d_shader_get_version(NULL, NULL);
+    uint32_t type = shader_type;
+    void *key, *ptr;
+
+    if (!args)
+        args = &default_args;
+
+    *key_size = strlen(version) + 1 + sizeof(type) + sizeof(*args)
+            + sizeof(bindings->binding_count) + bindings->binding_count * sizeof(*bindings->bindings)
+            + sizeof(bindings->uav_counter_count) + bindings->uav_counter_count * sizeof(*bindings->uav_counters)
+            + shader_desc->byte_code_size;
+    if (!(key = heap_alloc(*key_size)))
+        return NULL;
+
+    ptr = shader_spirv_append_key(key, version, strlen(version) + 1);
+    ptr = shader_spirv_append_key(ptr, &type, sizeof(type));
+    ptr = shader_spirv_append_key(ptr, args, sizeof(*args));
+    ptr = shader_spirv_append_key(ptr, &bindings->binding_count, sizeof(bindings->binding_count));
+    ptr = shader_spirv_append_key(ptr, bindings->bindings, bindings->binding_count * sizeof(*bindings->bindings));
+    ptr = shader_spirv_append_key(ptr, &bindings->uav_counter_count, sizeof(bindings->uav_counter_count));
+    ptr = shader_spirv_append_key(ptr, bindings->uav_counters,
+            bindings->uav_counter_count * sizeof(*bindings->uav_counters));
+    shader_spirv_append_key(ptr, shader_desc->byte_code, shader_desc->byte_code_size);
+
+    return key;
+}
+
 static VkShaderModule shader_spirv_compile_shader(struct wined3d_context_vk *context_vk,
         const struct wined3d_shader_desc *shader_desc, enum wined3d_shader_type shader_type,
         const struct shader_spirv_compile_arguments *args, const struct shader_spirv_resource_bindings *bindings,
@@ -234,16 +297,35 @@ static VkShaderModule shader_spirv_compile_shader(struct wined3d_context_vk *con
 {
     struct wined3d_shader_spirv_compile_args compile_args;
     struct wined3d_shader_spirv_shader_interface iface;
-    VkShaderModuleCreateInfo shader_create_info;
     struct vkd3d_shader_compile_info info;
-    const struct wined3d_vk_info *vk_info;
     struct wined3d_device_vk *device_vk;
     struct vkd3d_shader_code spirv;
+    void *key = NULL, *cached;
     VkShaderModule module;
+    size_t key_size;
     char *messages;
-    VkResult vr;
     int ret;
 
+    device_vk = wined3d_device_vk(context_vk->c.device);
+
+    if (device_vk->disk_cache && !so_desc
+            && (key = shader_spirv_get_cache_key(shader_desc, shader_type, args, bindings, &key_size))
+            && wined3d_disk_cache_get(device_vk->disk_cache, key, key_size, &cached, &spirv.size))
+    {
+        spirv.code = cached;
+        module = spirv.size % sizeof(uint32_t) ? VK_NULL_HANDLE : shader_spirv_create_module(device_vk, &spirv);
+        heap_free(cached);
+        if (module)
+        {
+            heap_free(key);
+            return module;
+        }
+
+        /* Treat an unusable entry as a miss, and replace it below. */
+        WARN("Failed to use cached SPIR-V, compiling it again.\n");
+        wined3d_disk_cache_remove(device_vk->disk_cache, key, key_size);
+    }
+
     shader_spirv_init_shader_interface_vk(&iface, bindings, so_desc);
     shader_spirv_init_compile_args(&compile_args, &iface.vkd3d_interface,
             VKD3D_SHADER_SPIRV_ENVIRONMENT_VULKAN_1_0, shader_type, args);
@@ -278,24 +360,17 @@ static VkShaderModule shader_spirv_compile_shader(struct wined3d_context_vk *con
     if (ret < 0)
     {
         ERR("Failed to compile DXBC, ret %d.\n", ret);
+        heap_free(key);
         return VK_NULL_HANDLE;
     }
 
-    device_vk = wined3d_device_vk(context_vk->c.device);
-    vk_info = &device_vk->vk_info;
-
-    shader_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    shader_create_info.pNext = NULL;
-    shader_create_info.flags = 0;
-    shader_create_info.codeSize = spirv.size;
-    shader_create_info.pCode = spirv.code;
-    if ((vr = VK_CALL(vkCreateShaderModule(device_vk->vk_device, &shader_create_info, NULL, &module))) < 0)
+    if (key)
     {
-        vkd3d_shader_free_shader_code(&spirv);
-        WARN("Failed to create Vulkan shader module, vr %s.\n", wined3d_debug_vkresult(vr));
-        return VK_NULL_HANDLE;
+        wined3d_disk_cache_put(device_vk->disk_cache, key, key_size, spirv.code, spirv.size);
+        heap_free(key);
     }
 
+    module = shader_spirv_create_module(device_vk, &spirv);
     vkd3d_shader_free_shader_code(&spirv);
 
     return module;
@@ -398,7 +473,7 @@ static struct shader_spirv_compute_program_vk *shader_spirv_find_compute_program
     pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
     pipeline_info.basePipelineIndex = -1;
     if ((vr = VK_CALL(vkCreateComputePipelines(device_vk->vk_device,
-            VK_NULL_HANDLE, 1, &pipeline_info, NULL, &program->vk_pipeline))) < 0)
+            device_vk->vk_pipeline_cache, 1, &pipeline_info, NULL, &program->vk_pipeline))) < 0)
     {
         ERR("Failed to create Vulkan compute pipeline, vr %s.\n", wined3d_debug_vkresult(vr));
         VK_CALL(vkDestroyShaderModule(device_vk->vk_device, program->vk_module, NULL));
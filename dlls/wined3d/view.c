@@ -1866,6 +1866,7 @@ static VkPipeline create_uav_pipeline(struct wined3d_context_vk *context_vk,
 {
     VkComputePipelineCreateInfo pipeline_info;
     struct wined3d_shader_desc shader_desc;
+    struct wined3d_device_vk *device_vk;
     const struct wined3d_vk_info *vk_info;
     struct wined3d_context *context;
     VkShaderModule shader_module;
@@ -1901,9 +1902,11 @@ static VkPipeline create_uav_pipeline(struct wined3d_context_vk *context_vk,
     pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
     pipeline_info.basePipelineIndex = -1;
 
-    vk_device = wined3d_device_vk(context->device)->vk_device;
+    device_vk = wined3d_device_vk(context->device);
+    vk_device = device_vk->vk_device;
 
-    if ((vr = VK_CALL(vkCreateComputePipelines(vk_device, VK_NULL_HANDLE, 1, &pipeline_info, NULL, &result))) < 0)
+    if ((vr = VK_CALL(vkCreateComputePipelines(vk_device,
+            device_vk->vk_pipeline_cache, 1, &pipeline_info, NULL, &result))) < 0)
     {
         ERR("Failed to create Vulkan compute pipeline, vr %s.\n", wined3d_debug_vkresult(vr));
         return VK_NULL_HANDLE;
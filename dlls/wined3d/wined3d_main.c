@@ -480,6 +480,17 @@ static BOOL wined3d_dll_init(HINSTANCE hInstDLL)
             TRACE("Forcing all constant buffers to be write-mappable.\n");
             wined3d_settings.cb_access_map_w = TRUE;
         }
+        if (!get_config_key_dword(hkey, appkey, env, "shader_cache_size", &wined3d_settings.shader_cache_size))
+            TRACE("Setting shader cache size to %u MiB.\n", wined3d_settings.shader_cache_size);
+        if (!get_config_key(hkey, appkey, env, "shader_cache_path", buffer, size))
+        {
+            size_t len = strlen(buffer) + 1;
+
+            if (!(wined3d_settings.shader_cache_path = heap_alloc(len)))
+                ERR("Failed to allocate shader cache path memory.\n");
+            else
+                memcpy(wined3d_settings.shader_cache_path, buffer, len);
+        }
     }
 
     if (appkey) RegCloseKey( appkey );
@@ -538,7 +549,9 @@ static BOOL wined3d_dll_destroy(HINSTANCE hInstDLL)
     }
     heap_free(swapchain_state_table.hooks);
 
+    wined3d_disk_cache_cleanup();
     heap_free(wined3d_settings.logo);
+    heap_free(wined3d_settings.shader_cache_path);
     UnregisterClassA(WINED3D_OPENGL_WINDOW_CLASS_NAME, hInstDLL);
 
     DeleteCriticalSection(&wined3d_command_cs);
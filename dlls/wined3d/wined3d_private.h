@@ -485,10 +485,20 @@ struct wined3d_settings
     enum wined3d_renderer renderer;
     enum wined3d_shader_backend shader_backend;
     BOOL cb_access_map_w;
+    unsigned int shader_cache_size;
+    char *shader_cache_path;
 };
 
 extern struct wined3d_settings wined3d_settings;
 
+struct wined3d_disk_cache *wined3d_disk_cache_open(const char *name);
+void wined3d_disk_cache_cleanup(void);
+bool wined3d_disk_cache_get(struct wined3d_disk_cache *cache, const void *key, size_t key_size,
+        void **data, size_t *data_size);
+void wined3d_disk_cache_remove(struct wined3d_disk_cache *cache, const void *key, size_t key_size);
+void wined3d_disk_cache_put(struct wined3d_disk_cache *cache, const void *key, size_t key_size,
+        const void *data, size_t data_size);
+
 enum wined3d_shader_resource_type
 {
     WINED3D_SHADER_RESOURCE_NONE,
@@ -800,6 +800,9 @@ struct wined3d_device_vk
     struct wined3d_allocator allocator;
 
     struct wined3d_uav_clear_state_vk uav_clear_state;
+
+    struct wined3d_disk_cache *disk_cache;
+    VkPipelineCache vk_pipeline_cache;
 };
 
 static inline struct wined3d_device_vk *wined3d_device_vk(struct wined3d_device *device)
@@ -834,6 +837,11 @@ void wined3d_device_vk_destroy_null_views(struct wined3d_device_vk *device_vk,
 void wined3d_device_vk_uav_clear_state_init(struct wined3d_device_vk *device_vk);
 void wined3d_device_vk_uav_clear_state_cleanup(struct wined3d_device_vk *device_vk);
 
+void wined3d_device_vk_create_pipeline_cache(struct wined3d_device_vk *device_vk,
+        const struct wined3d_adapter_vk *adapter_vk);
+void wined3d_device_vk_destroy_pipeline_cache(struct wined3d_device_vk *device_vk,
+        const struct wined3d_adapter_vk *adapter_vk);
+
 struct wined3d_texture_vk
 {
     struct wined3d_texture t;
@@ -367,14 +367,31 @@ NTSTATUS WINAPI wow64_NtQueryKey( UINT *args )
 NTSTATUS WINAPI wow64_NtQueryMultipleValueKey( UINT *args )
 {
     HANDLE handle = get_handle( &args );
-    KEY_MULTIPLE_VALUE_INFORMATION *info = get_ptr( &args );
+    KEY_MULTIPLE_VALUE_INFORMATION32 *info32 = get_ptr( &args );
     ULONG count = get_ulong( &args );
     void *ptr = get_ptr( &args );
     ULONG len = get_ulong( &args );
     ULONG *retlen = get_ptr( &args );
 
-    FIXME( "%p %p %lu %p %lu %p: stub\n", handle, info, count, ptr, len, retlen );
-    return STATUS_SUCCESS;
+    KEY_MULTIPLE_VALUE_INFORMATION *info = Wow64AllocateTemp( count * (sizeof(*info) + sizeof(UNICODE_STRING)) );
+    UNICODE_STRING *names = (UNICODE_STRING *)(info + count);
+    NTSTATUS status;
+    ULONG i;
+
+    for (i = 0; i < count; i++)
+        info[i].ValueName = unicode_str_32to64( &names[i], ULongToPtr( info32[i].ValueName ));
+
+    status = NtQueryMultipleValueKey( handle, info, count, ptr, len, retlen );
+    if (!status || status == STATUS_BUFFER_OVERFLOW)
+    {
+        for (i = 0; i < count; i++)
+        {
+            info32[i].DataLength = info[i].DataLength;
+            info32[i].DataOffset = info[i].DataOffset;
+            info32[i].Type       = info[i].Type;
+        }
+    }
+    return status;
 }
 
 
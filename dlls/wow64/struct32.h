@@ -154,6 +154,14 @@ typedef struct
     LONG  CompletionPort;
 } JOBOBJECT_ASSOCIATE_COMPLETION_PORT32;
 
+typedef struct
+{
+    ULONG ValueName;
+    ULONG DataLength;
+    ULONG DataOffset;
+    ULONG Type;
+} KEY_MULTIPLE_VALUE_INFORMATION32;
+
 typedef struct
 {
     ULONG    BaseAddress;
@@ -24,6 +24,14 @@
  *    + threads are awaken FIFO and not LIFO as native does
  *    + "max concurrent active threads" parameter not used
  *    + completion handle is waitable, while native isn't
+ *
+ * Clients may ask for a ring shared with the server, through which they post
+ * and dequeue packets without a server call. Once a port has a ring the server
+ * queues packets there as well, and only keeps them in its own list while the
+ * ring is full. Meanwhile the overflow flag is set in the ring tail, which
+ * makes the clients post through the server, and packets are moved to the
+ * ring in order. The server counts the threads blocking on the port in the
+ * ring, so that clients know when a packet they posted requires a wake up.
  */
 
 #include "config.h"
@@ -31,6 +39,7 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
 #include "windef.h"
@@ -67,6 +76,9 @@ struct completion_wait
     unsigned int       depth;
     int                esync_fd;
     unsigned int       fsync_idx;
+    unsigned int       waiters;     /* threads counted as waiters */
+    int                ring_fd;     /* unix fd of the shared packet ring */
+    completion_ring_t *ring;        /* shared packet ring, created on demand */
 };
 
 struct completion
@@ -164,6 +176,12 @@ static void completion_wait_destroy( struct object *obj)
         close( wait->esync_fd );
 
     if (wait->fsync_idx) fsync_free_shm_idx( wait->fsync_idx );
+
+    if (wait->ring)
+    {
+        munmap( (void *)wait->ring, sizeof(*wait->ring) );
+        close( wait->ring_fd );
+    }
 }
 
 static void completion_wait_dump( struct object *obj, int verbose )
@@ -174,12 +192,168 @@ static void completion_wait_dump( struct object *obj, int verbose )
     fprintf( stderr, "Completion depth=%u\n", wait->depth );
 }
 
+/* queue a packet to the ring, whether the overflow flag is set or not; fails if it is full */
+static int ring_push( completion_ring_t *ring, apc_param_t ckey, apc_param_t cvalue,
+                      unsigned int status, apc_param_t information )
+{
+    volatile struct completion_ring_entry *entry;
+    unsigned __int64 tail;
+    unsigned int pos, retries;
+    int diff;
+
+    tail = __atomic_load_n( &ring->tail, __ATOMIC_SEQ_CST );
+    /* the ring is writable by clients, don't spin forever if one corrupts it */
+    for (retries = 0; retries < COMPLETION_RING_SIZE; retries++)
+    {
+        pos = tail;
+        entry = &ring->entries[pos % COMPLETION_RING_SIZE];
+        diff = __atomic_load_n( &entry->seq, __ATOMIC_ACQUIRE ) - pos;
+        if (diff < 0) return 0;
+        if (!diff)
+        {
+            if (!__atomic_compare_exchange_n( &ring->tail, &tail, (tail & COMPLETION_RING_OVERFLOW) | (pos + 1), 0,
+                                              __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST )) continue;
+            entry->ckey        = ckey;
+            entry->cvalue      = cvalue;
+            entry->status      = status;
+            entry->information = information;
+            __atomic_store_n( &entry->seq, pos + 1, __ATOMIC_SEQ_CST );
+            return 1;
+        }
+        tail = __atomic_load_n( &ring->tail, __ATOMIC_SEQ_CST );
+    }
+    return 0;
+}
+
+/* dequeue the oldest packet of the ring; fails if it is empty */
+static int ring_pop( completion_ring_t *ring, struct comp_msg *msg )
+{
+    volatile struct completion_ring_entry *entry;
+    unsigned int pos, retries;
+    int diff;
+
+    pos = __atomic_load_n( &ring->head, __ATOMIC_SEQ_CST );
+    for (retries = 0; retries < COMPLETION_RING_SIZE; retries++)
+    {
+        entry = &ring->entries[pos % COMPLETION_RING_SIZE];
+        diff = __atomic_load_n( &entry->seq, __ATOMIC_ACQUIRE ) - (pos + 1);
+        if (diff < 0) return 0;
+        if (!diff)
+        {
+            if (!__atomic_compare_exchange_n( &ring->head, &pos, pos + 1, 0,
+                                              __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST )) continue;
+            msg->ckey        = entry->ckey;
+            msg->cvalue      = entry->cvalue;
+            msg->status      = entry->status;
+            msg->information = entry->information;
+            __atomic_store_n( &entry->seq, pos + COMPLETION_RING_SIZE, __ATOMIC_RELEASE );
+            return 1;
+        }
+        pos = __atomic_load_n( &ring->head, __ATOMIC_SEQ_CST );
+    }
+    return 0;
+}
+
+static int ring_has_packets( completion_ring_t *ring )
+{
+    unsigned int pos = __atomic_load_n( &ring->head, __ATOMIC_SEQ_CST );
+
+    return __atomic_load_n( &ring->entries[pos % COMPLETION_RING_SIZE].seq, __ATOMIC_ACQUIRE ) == pos + 1;
+}
+
+static unsigned int ring_depth( completion_ring_t *ring )
+{
+    int depth = (unsigned int)ring->tail - ring->head;
+
+    return min( max( depth, 0 ), COMPLETION_RING_SIZE );
+}
+
+/* move the packets queued on the server to the ring, as far as it has room */
+static void flush_overflow( struct completion_wait *wait )
+{
+    struct comp_msg *msg, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE( msg, next, &wait->queue, struct comp_msg, queue_entry )
+    {
+        if (!ring_push( wait->ring, msg->ckey, msg->cvalue, msg->status, msg->information )) break;
+        list_remove( &msg->queue_entry );
+        wait->depth--;
+        free( msg );
+    }
+    if (list_empty( &wait->queue ))
+        __atomic_fetch_and( &wait->ring->tail, ~COMPLETION_RING_OVERFLOW, __ATOMIC_SEQ_CST );
+    else
+        __atomic_fetch_or( &wait->ring->tail, COMPLETION_RING_OVERFLOW, __ATOMIC_SEQ_CST );
+}
+
+static int create_completion_ring( struct completion_wait *wait )
+{
+    completion_ring_t *ring;
+    unsigned int i;
+    int fd;
+
+    if ((fd = create_temp_file( sizeof(*ring) )) == -1) return 0;
+    ring = mmap( NULL, sizeof(*ring), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    if (ring == MAP_FAILED)
+    {
+        file_set_error();
+        close( fd );
+        return 0;
+    }
+    for (i = 0; i < COMPLETION_RING_SIZE; i++) ring->entries[i].seq = i;
+    ring->waiters = wait->waiters;
+    wait->ring_fd = fd;
+    wait->ring = ring;
+    flush_overflow( wait );
+    return 1;
+}
+
+/* dequeue the oldest packet of the port */
+static int dequeue_completion( struct completion_wait *wait, struct comp_msg *ret )
+{
+    struct list *entry;
+    struct comp_msg *msg;
+
+    if (wait->ring)
+    {
+        flush_overflow( wait );
+        return ring_pop( wait->ring, ret );
+    }
+
+    if (!(entry = list_head( &wait->queue ))) return 0;
+    list_remove( entry );
+    wait->depth--;
+    msg = LIST_ENTRY( entry, struct comp_msg, queue_entry );
+    *ret = *msg;
+    free( msg );
+    return 1;
+}
+
+static void add_completion_waiter( struct thread *thread, struct completion_wait *wait )
+{
+    thread->completion_waiter = grab_object( wait );
+    wait->waiters++;
+    if (wait->ring) __atomic_store_n( &wait->ring->waiters, wait->waiters, __ATOMIC_SEQ_CST );
+}
+
+/* stop counting the thread as a waiter on the port it last found empty */
+void release_completion_waiter( struct thread *thread )
+{
+    struct completion_wait *wait = (struct completion_wait *)thread->completion_waiter;
+
+    if (!wait) return;
+    thread->completion_waiter = NULL;
+    wait->waiters--;
+    if (wait->ring) __atomic_store_n( &wait->ring->waiters, wait->waiters, __ATOMIC_SEQ_CST );
+    release_object( wait );
+}
+
 static int completion_wait_signaled( struct object *obj, struct wait_queue_entry *entry )
 {
     struct completion_wait *wait = (struct completion_wait *)obj;
 
     assert( obj->ops == &completion_wait_ops );
-    return !wait->completion || !list_empty( &wait->queue );
+    return !wait->completion || !list_empty( &wait->queue ) || (wait->ring && ring_has_packets( wait->ring ));
 }
 
 static int completion_wait_get_esync_fd( struct object *obj, enum esync_type *type )
@@ -283,6 +457,9 @@ static struct completion *create_completion( struct object *root, const struct u
     list_init( &completion->wait->queue );
     completion->wait->depth = 0;
     completion->wait->fsync_idx = 0;
+    completion->wait->waiters = 0;
+    completion->wait->ring_fd = -1;
+    completion->wait->ring = NULL;
 
     if (do_fsync())
         completion->wait->fsync_idx = fsync_alloc_shm( 0, 0 );
@@ -301,20 +478,27 @@ struct completion *get_completion_obj( struct process *process, obj_handle_t han
 void add_completion( struct completion *completion, apc_param_t ckey, apc_param_t cvalue,
                      unsigned int status, apc_param_t information )
 {
-    struct comp_msg *msg = mem_alloc( sizeof( *msg ) );
-
-    if (!msg)
-        return;
-
-    msg->ckey = ckey;
-    msg->cvalue = cvalue;
-    msg->status = status;
-    msg->information = information;
+    struct completion_wait *wait = completion->wait;
+    struct comp_msg *msg;
 
-    list_add_tail( &completion->wait->queue, &msg->queue_entry );
-    completion->wait->depth++;
+    if (!wait->ring || !list_empty( &wait->queue ) || !ring_push( wait->ring, ckey, cvalue, status, information ))
+    {
+        if (!(msg = mem_alloc( sizeof( *msg ) )))
+            return;
+
+        msg->ckey = ckey;
+        msg->cvalue = cvalue;
+        msg->status = status;
+        msg->information = information;
+
+        list_add_tail( &wait->queue, &msg->queue_entry );
+        wait->depth++;
+        /* clients can't push to the ring anymore once the flag is set, so the
+         * packets posted after this one are queued behind it */
+        if (wait->ring) __atomic_fetch_or( &wait->ring->tail, COMPLETION_RING_OVERFLOW, __ATOMIC_SEQ_CST );
+    }
 
-    wake_up( &completion->wait->obj, 1 );
+    wake_up( &wait->obj, 1 );
 }
 
 /* create a completion */
@@ -364,8 +548,10 @@ DECL_HANDLER(remove_completion)
 {
     struct completion* completion;
     struct completion_wait *wait;
-    struct list *entry;
-    struct comp_msg *msg;
+    struct comp_msg msg;
+    int found;
+
+    release_completion_waiter( current );
 
     if (req->waited && (wait = (struct completion_wait *)current->locked_completion))
         current->locked_completion = NULL;
@@ -385,39 +571,40 @@ DECL_HANDLER(remove_completion)
 
     assert( wait->obj.ops == &completion_wait_ops );
 
-    entry = list_head( &wait->queue );
-    if (!entry)
+    if (!(found = dequeue_completion( wait, &msg )) && wait->completion)
+    {
+        /* count ourselves as a waiter before looking at the ring again, so that
+         * a client posting a packet there in the meantime asks for a wake up */
+        add_completion_waiter( current, wait );
+        if (wait->ring && (found = ring_pop( wait->ring, &msg ))) release_completion_waiter( current );
+    }
+
+    if (found)
+    {
+        reply->ckey = msg.ckey;
+        reply->cvalue = msg.cvalue;
+        reply->status = msg.status;
+        reply->information = msg.information;
+    }
+    else if (wait->completion)
     {
-        if (wait->completion)
+        if (do_fsync() || do_esync())
         {
-            if (do_fsync() || do_esync())
-            {
-                /* completion_wait_satisfied is not called, so lock completion here. */
-                current->locked_completion = grab_object( wait );
-            }
-            set_error( STATUS_PENDING );
+            /* completion_wait_satisfied is not called, so lock completion here. */
+            current->locked_completion = grab_object( wait );
         }
-        else set_error( STATUS_ABANDONED_WAIT_0 );
+        set_error( STATUS_PENDING );
     }
-    else
-    {
-        list_remove( entry );
-        wait->depth--;
-        msg = LIST_ENTRY( entry, struct comp_msg, queue_entry );
-        reply->ckey = msg->ckey;
-        reply->cvalue = msg->cvalue;
-        reply->status = msg->status;
-        reply->information = msg->information;
-        free( msg );
+    else set_error( STATUS_ABANDONED_WAIT_0 );
 
-        if (!completion_wait_signaled( &wait->obj, NULL ))
-        {
-            if (do_fsync())
-                fsync_clear( &wait->obj );
+    /* clients dequeue from the ring without telling us, so clear a stale signal here too */
+    if (!completion_wait_signaled( &wait->obj, NULL ))
+    {
+        if (do_fsync())
+            fsync_clear( &wait->obj );
 
-            if (do_esync())
-                esync_clear( wait->esync_fd );
-        }
+        if (do_esync())
+            esync_clear( wait->esync_fd );
     }
 
     release_object( wait );
@@ -431,6 +618,37 @@ DECL_HANDLER(query_completion)
     if (!completion) return;
 
     reply->depth = completion->wait->depth;
+    if (completion->wait->ring) reply->depth += ring_depth( completion->wait->ring );
+
+    release_object( completion );
+}
+
+/* get the shared packet ring of a completion port */
+DECL_HANDLER(get_completion_ring)
+{
+    struct completion *completion = get_completion_obj( current->process, req->handle, IO_COMPLETION_MODIFY_STATE );
+    int closed_handles_fd;
+
+    if (!completion) return;
+
+    if ((closed_handles_fd = get_closed_handles_fd()) == -1) set_error( STATUS_NO_MEMORY );
+    else if (completion->wait->ring || create_completion_ring( completion->wait ))
+    {
+        send_client_fd( current->process, completion->wait->ring_fd, req->handle );
+        send_client_fd( current->process, closed_handles_fd, 0 );
+    }
+
+    release_object( completion );
+}
+
+/* wake the threads waiting on a completion port after a packet was queued to its ring */
+DECL_HANDLER(wake_completion)
+{
+    struct completion *completion = get_completion_obj( current->process, req->handle, IO_COMPLETION_MODIFY_STATE );
+
+    if (!completion) return;
+
+    wake_up( &completion->wait->obj, 1 );
 
     release_object( completion );
 }
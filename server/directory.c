@@ -282,22 +282,37 @@ struct object *get_directory_obj( struct process *process, obj_handle_t handle )
     return get_handle_obj( process, handle, 0, &directory_ops );
 }
 
-struct object *create_desktop_map_directory( struct winstation *winstation )
+static struct object *create_winstation_map_directory( struct winstation *winstation,
+                                                       const struct unicode_str *dir_name )
 {
-    static const WCHAR dir_desktop_mapsW[] = {'_','_','w','i','n','e','_','d','e','s','k','t','o','p','_','m','a','p','p','i','n','g','s'};
-    static const struct unicode_str dir_desktop_maps_str = {dir_desktop_mapsW, sizeof(dir_desktop_mapsW)};
     struct object *root;
     struct directory *mapping_root, *ret;
     const struct unicode_str winsta_name = {winstation->obj.name->name, winstation->obj.name->len};
 
     root = winstation->obj.name->parent;
-    mapping_root = create_directory( root, &dir_desktop_maps_str, OBJ_OPENIF, HASH_SIZE, NULL );
+    mapping_root = create_directory( root, dir_name, OBJ_OPENIF, HASH_SIZE, NULL );
     ret = create_directory( &mapping_root->obj, &winsta_name, OBJ_OPENIF, HASH_SIZE, NULL );
     release_object( &mapping_root->obj );
 
     return &ret->obj;
 }
 
+struct object *create_desktop_map_directory( struct winstation *winstation )
+{
+    static const WCHAR dir_desktop_mapsW[] = {'_','_','w','i','n','e','_','d','e','s','k','t','o','p','_','m','a','p','p','i','n','g','s'};
+    static const struct unicode_str dir_desktop_maps_str = {dir_desktop_mapsW, sizeof(dir_desktop_mapsW)};
+
+    return create_winstation_map_directory( winstation, &dir_desktop_maps_str );
+}
+
+struct object *create_window_map_directory( struct winstation *winstation )
+{
+    static const WCHAR dir_window_mapsW[] = {'_','_','w','i','n','e','_','w','i','n','d','o','w','_','m','a','p','p','i','n','g','s'};
+    static const struct unicode_str dir_window_maps_str = {dir_window_mapsW, sizeof(dir_window_mapsW)};
+
+    return create_winstation_map_directory( winstation, &dir_window_maps_str );
+}
+
 struct object *create_thread_map_directory( void )
 {
     static const WCHAR dir_kernelW[] = {'K','e','r','n','e','l','O','b','j','e','c','t','s'};
@@ -165,6 +165,7 @@ extern const char *get_timeout_str( timeout_t timeout );
 /* directory functions */
 
 extern struct object *create_desktop_map_directory( struct winstation *winstation );
+extern struct object *create_window_map_directory( struct winstation *winstation );
 extern struct object *create_thread_map_directory( void );
 
 /* file functions */
@@ -197,6 +198,7 @@ extern const pe_image_info_t *get_view_image_info( const struct memory_view *vie
 extern int get_view_nt_name( const struct memory_view *view, struct unicode_str *name );
 extern void free_mapped_views( struct process *process );
 extern int get_page_size(void);
+extern int create_temp_file( file_pos_t size );
 extern struct mapping *create_fd_mapping( struct object *root, const struct unicode_str *name, struct fd *fd,
                                           unsigned int attr, const struct security_descriptor *sd );
 extern struct object *create_shared_mapping( struct object *root, const struct unicode_str *name, mem_size_t size,
@@ -230,6 +232,7 @@ extern struct dir *get_dir_obj( struct process *process, obj_handle_t handle, un
 extern struct completion *get_completion_obj( struct process *process, obj_handle_t handle, unsigned int access );
 extern void add_completion( struct completion *completion, apc_param_t ckey, apc_param_t cvalue,
                             unsigned int status, apc_param_t information );
+extern void release_completion_waiter( struct thread *thread );
 
 /* serial port functions */
 
@@ -26,7 +26,9 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/mman.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -38,6 +40,7 @@
 #include "thread.h"
 #include "security.h"
 #include "request.h"
+#include "file.h"
 
 struct handle_entry
 {
@@ -57,6 +60,9 @@ struct handle_table
 
 static struct handle_table *global_table;
 
+static struct closed_handle_ring *closed_handles;
+static int closed_handles_fd = -1;
+
 /* reserved handle access rights */
 #define RESERVED_SHIFT         26
 #define RESERVED_INHERIT       (HANDLE_FLAG_INHERIT << RESERVED_SHIFT)
@@ -656,6 +662,40 @@ unsigned int get_handle_table_count( struct process *process )
     return process->handles->count;
 }
 
+/* get the fd of the ring of handles closed by another process, creating it on first use */
+int get_closed_handles_fd(void)
+{
+    void *ptr;
+    int fd;
+
+    if (closed_handles_fd != -1) return closed_handles_fd;
+
+    if ((fd = create_temp_file( sizeof(*closed_handles) )) == -1) return -1;
+    ptr = mmap( NULL, sizeof(*closed_handles), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    if (ptr == MAP_FAILED)
+    {
+        close( fd );
+        return -1;
+    }
+    closed_handles = ptr;
+    return closed_handles_fd = fd;
+}
+
+/* record a handle of another process closed by the current one, the owner process */
+/* may still have a completion ring cached for it, which it needs to drop before the */
+/* handle value gets reused */
+static void record_closed_handle( struct process *process, obj_handle_t handle )
+{
+    unsigned int serial;
+
+    if (!closed_handles) return;
+
+    serial = closed_handles->serial;
+    closed_handles->entries[serial % CLOSED_HANDLE_RING_SIZE].pid = process->id;
+    closed_handles->entries[serial % CLOSED_HANDLE_RING_SIZE].handle = handle;
+    __atomic_store_n( &closed_handles->serial, serial + 1, __ATOMIC_RELEASE );
+}
+
 /* close a handle */
 DECL_HANDLER(close_handle)
 {
@@ -690,7 +730,10 @@ DECL_HANDLER(dup_handle)
         }
         /* close the handle no matter what happened */
         if ((req->options & DUPLICATE_CLOSE_SOURCE) && (src != dst || req->src_handle != reply->handle))
-            close_handle( src, req->src_handle );
+        {
+            if (!close_handle( src, req->src_handle ) && src != current->process)
+                record_closed_handle( src, req->src_handle );
+        }
         release_object( src );
     }
 }
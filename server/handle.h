@@ -55,5 +55,6 @@ extern struct handle_table *copy_handle_table( struct process *process, struct p
                                                const obj_handle_t *handles, unsigned int handle_count,
                                                const obj_handle_t *std_handles );
 extern unsigned int get_handle_table_count( struct process *process);
+extern int get_closed_handles_fd(void);
 
 #endif  /* __WINE_SERVER_HANDLE_H */
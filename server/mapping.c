@@ -334,7 +334,7 @@ static int check_current_dir_for_exec(void)
 #endif
 
 /* create a temp file for anonymous mappings */
-static int create_temp_file( file_pos_t size )
+int create_temp_file( file_pos_t size )
 {
 #ifdef HAVE_MEMFD_CREATE
     int fd = memfd_create( "wine-mapping", MFD_ALLOW_SEALING );
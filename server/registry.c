@@ -33,6 +33,7 @@
 #include <stdarg.h>
 #include <string.h>
 #include <stdlib.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -74,6 +75,21 @@ struct type_descr key_type =
     },
 };
 
+/* hash index over the names of the subkeys or values of a key */
+struct index_slot
+{
+    unsigned int      hash;        /* hash of the name */
+    unsigned int      pos;         /* array position + 1, 0 if the slot is free */
+};
+
+struct name_index
+{
+    unsigned int       size;       /* number of slots, a power of 2 */
+    unsigned int       count;      /* number of used slots */
+    struct index_slot *slots;      /* slots array, NULL if not indexed */
+    unsigned int       delay;      /* insertions left before indexing again, once the index was dropped */
+};
+
 /* a registry key */
 struct key
 {
@@ -83,10 +99,14 @@ struct key
     int               last_subkey; /* last in use subkey */
     int               nb_subkeys;  /* count of allocated subkeys */
     struct key      **subkeys;     /* subkeys array */
+    int               sorted_subkeys; /* count of subkeys at the start of the array in sorted order */
+    struct name_index subkey_index;   /* index of subkey names, for keys with many subkeys */
     struct key       *wow6432node; /* Wow6432Node subkey */
     int               last_value;  /* last in use value */
     int               nb_values;   /* count of allocated values in array */
     struct key_value *values;      /* values array */
+    int               sorted_values;  /* count of values at the start of the array in sorted order */
+    struct name_index value_index;    /* index of value names, for keys with many values */
     unsigned int      flags;       /* flags */
     timeout_t         modif;       /* last modification time */
     struct list       notify_list; /* list of notifications */
@@ -100,6 +120,7 @@ struct key
 #define KEY_SYMLINK  0x0008  /* key is a symbolic link */
 #define KEY_WOWSHARE 0x0010  /* key is a Wow64 shared key (used for Software\Classes) */
 #define KEY_PREDEF   0x0020  /* key is marked as predefined */
+#define KEY_KEEP     0x0040  /* key is kept while replaying a snapshot journal */
 
 #define OBJ_KEY_WOW64 0x100000 /* magic flag added to attributes for WoW64 redirection */
 
@@ -115,6 +136,7 @@ struct key_value
 
 #define MIN_SUBKEYS  8   /* min. number of allocated subkeys per key */
 #define MIN_VALUES   8   /* min. number of allocated values per key */
+#define MIN_INDEXED  64  /* min. number of subkeys or values to index their names */
 
 #define MAX_NAME_LEN  256    /* max. length of a key name */
 #define MAX_VALUE_LEN 16383  /* max. length of a value name */
@@ -138,6 +160,11 @@ struct save_branch_info
 {
     struct key  *key;
     const char  *path;
+    int          snapshot_valid;  /* the snapshot file matches the branch contents */
+    int          snapshot_loaded; /* the branch was loaded from a snapshot file */
+    int          text_dirty;      /* the text file is older than the snapshot */
+    data_size_t  snapshot_size;   /* size of the key records in the snapshot */
+    data_size_t  journal_size;    /* size of the journal appended to the snapshot */
 };
 
 #define MAX_SAVE_BRANCH_INFO 3
@@ -287,12 +314,279 @@ static void dump_value( const struct key_value *value, FILE *f )
     fputc( '\n', f );
 }
 
+static inline unsigned int hash_name( const WCHAR *name, data_size_t len )
+{
+    return hash_strW( name, len, ~0u );
+}
+
+static inline int compare_names( const WCHAR *name1, data_size_t len1, const WCHAR *name2, data_size_t len2 )
+{
+    int res = memicmp_strW( name1, name2, min( len1, len2 ));
+    if (!res) res = len1 - len2;
+    return res;
+}
+
+static int compare_subkeys( const void *p1, const void *p2 )
+{
+    const struct object_name *name1 = (*(struct key * const *)p1)->obj.name;
+    const struct object_name *name2 = (*(struct key * const *)p2)->obj.name;
+
+    return compare_names( name1->name, name1->len, name2->name, name2->len );
+}
+
+static int compare_values( const void *p1, const void *p2 )
+{
+    const struct key_value *value1 = p1, *value2 = p2;
+
+    return compare_names( value1->name, value1->namelen, value2->name, value2->namelen );
+}
+
+static void free_name_index( struct name_index *index )
+{
+    free( index->slots );
+    index->slots = NULL;
+    index->size  = 0;
+    index->count = 0;
+}
+
+/* add an array position to a name index, growing it as needed; return 1 if OK, 0 on error */
+static int add_name_index( struct name_index *index, unsigned int hash, unsigned int pos )
+{
+    unsigned int i, mask;
+
+    if ((index->count + 1) * 2 > index->size)
+    {
+        struct index_slot *old_slots = index->slots;
+        unsigned int old_size = index->size, size = max( 2 * MIN_INDEXED, 2 * old_size );
+
+        if (!(index->slots = calloc( size, sizeof(*index->slots) )))
+        {
+            index->slots = old_slots;
+            return 0;
+        }
+        index->size  = size;
+        index->count = 0;
+        for (i = 0; i < old_size; i++)
+            if (old_slots[i].pos) add_name_index( index, old_slots[i].hash, old_slots[i].pos - 1 );
+        free( old_slots );
+    }
+
+    mask = index->size - 1;
+    for (i = hash & mask; index->slots[i].pos; i = (i + 1) & mask) ;
+    index->slots[i].hash = hash;
+    index->slots[i].pos  = pos + 1;
+    index->count++;
+    return 1;
+}
+
+/* remove the last array position from a name index */
+static void remove_name_index( struct name_index *index, unsigned int hash, unsigned int pos )
+{
+    unsigned int i, j, home, mask = index->size - 1;
+
+    for (i = hash & mask; index->slots[i].pos != pos + 1; i = (i + 1) & mask) assert( index->slots[i].pos );
+
+    /* move back the following entries of the probe sequence */
+    for (j = (i + 1) & mask; index->slots[j].pos; j = (j + 1) & mask)
+    {
+        home = index->slots[j].hash & mask;
+        if (((j - home) & mask) < ((j - i) & mask)) continue;
+        index->slots[i] = index->slots[j];
+        i = j;
+    }
+    index->slots[i].pos = 0;
+    index->count--;
+}
+
+/* build the hash index of a key with many subkeys; the array must be sorted */
+static void build_subkey_index( struct key *key )
+{
+    const struct object_name *name;
+    int i;
+
+    free_name_index( &key->subkey_index );
+    for (i = 0; i <= key->last_subkey; i++)
+    {
+        name = key->subkeys[i]->obj.name;
+        if (add_name_index( &key->subkey_index, hash_name( name->name, name->len ), i )) continue;
+        free_name_index( &key->subkey_index );
+        break;
+    }
+}
+
+/* build the hash index of a key with many values; the array must be sorted */
+static void build_value_index( struct key *key )
+{
+    int i;
+
+    free_name_index( &key->value_index );
+    for (i = 0; i <= key->last_value; i++)
+    {
+        if (add_name_index( &key->value_index, hash_name( key->values[i].name, key->values[i].namelen ), i ))
+            continue;
+        free_name_index( &key->value_index );
+        break;
+    }
+}
+
+/* sort the subkeys appended to an indexed key, merging them with the sorted ones */
+static void sort_subkeys( struct key *key )
+{
+    int count = key->last_subkey + 1, tail_count = count - key->sorted_subkeys, i, j, k;
+    struct key **tail;
+
+    if (!tail_count) return;
+
+    qsort( key->subkeys + key->sorted_subkeys, tail_count, sizeof(*key->subkeys), compare_subkeys );
+    if ((tail = malloc( tail_count * sizeof(*tail) )))
+    {
+        memcpy( tail, key->subkeys + key->sorted_subkeys, tail_count * sizeof(*tail) );
+        for (i = key->sorted_subkeys - 1, j = tail_count - 1, k = count - 1; j >= 0; k--)
+        {
+            if (i >= 0 && compare_subkeys( &key->subkeys[i], &tail[j] ) > 0) key->subkeys[k] = key->subkeys[i--];
+            else key->subkeys[k] = tail[j--];
+        }
+        free( tail );
+    }
+    else qsort( key->subkeys, count, sizeof(*key->subkeys), compare_subkeys );
+
+    key->sorted_subkeys = count;
+    if (key->subkey_index.slots) build_subkey_index( key );
+}
+
+/* sort the values appended to an indexed key, merging them with the sorted ones */
+static void sort_values( struct key *key )
+{
+    int count = key->last_value + 1, tail_count = count - key->sorted_values, i, j, k;
+    struct key_value *tail;
+
+    if (!tail_count) return;
+
+    qsort( key->values + key->sorted_values, tail_count, sizeof(*key->values), compare_values );
+    if ((tail = malloc( tail_count * sizeof(*tail) )))
+    {
+        memcpy( tail, key->values + key->sorted_values, tail_count * sizeof(*tail) );
+        for (i = key->sorted_values - 1, j = tail_count - 1, k = count - 1; j >= 0; k--)
+        {
+            if (i >= 0 && compare_values( &key->values[i], &tail[j] ) > 0) key->values[k] = key->values[i--];
+            else key->values[k] = tail[j--];
+        }
+        free( tail );
+    }
+    else qsort( key->values, count, sizeof(*key->values), compare_values );
+
+    key->sorted_values = count;
+    if (key->value_index.slots) build_value_index( key );
+}
+
+/* Removing an entry other than the last one from an indexed array would mean renumbering
+ * the whole index, so the array goes back to being sorted instead. It is only indexed
+ * again after MIN_INDEXED insertions without any removal in between. */
+static void drop_subkey_index( struct key *key )
+{
+    free_name_index( &key->subkey_index );
+    sort_subkeys( key );
+    key->subkey_index.delay = MIN_INDEXED;
+}
+
+static void drop_value_index( struct key *key )
+{
+    free_name_index( &key->value_index );
+    sort_values( key );
+    key->value_index.delay = MIN_INDEXED;
+}
+
+/* sort the subkeys and values of a whole branch before saving it */
+static void sort_branch( struct key *key )
+{
+    int i;
+
+    if (key->flags & KEY_VOLATILE) return;
+    sort_subkeys( key );
+    sort_values( key );
+    for (i = 0; i <= key->last_subkey; i++) sort_branch( key->subkeys[i] );
+}
+
+/* update the ordering and the index once a subkey has been inserted at a given position */
+static void add_subkey_index( struct key *key, int index )
+{
+    const struct object_name *name = key->subkeys[index]->obj.name;
+
+    if (!key->subkey_index.slots)
+    {
+        /* not indexed, so it has been inserted in order */
+        key->sorted_subkeys++;
+        if (key->subkey_index.delay) key->subkey_index.delay--;
+        else if (key->last_subkey + 1 >= MIN_INDEXED) build_subkey_index( key );
+        return;
+    }
+
+    /* subkeys appended in order don't need to be sorted later */
+    if (index == key->sorted_subkeys && (!index || compare_subkeys( &key->subkeys[index - 1], &key->subkeys[index] ) < 0))
+        key->sorted_subkeys++;
+    if (add_name_index( &key->subkey_index, hash_name( name->name, name->len ), index )) return;
+
+    /* fall back to a sorted array */
+    free_name_index( &key->subkey_index );
+    qsort( key->subkeys, key->last_subkey + 1, sizeof(*key->subkeys), compare_subkeys );
+    key->sorted_subkeys = key->last_subkey + 1;
+}
+
+/* remove a subkey from the array of its parent, updating the ordering and the index */
+static void remove_subkey( struct key *parent, struct key *key, const struct object_name *name )
+{
+    int i = -1;
+
+    if (parent->subkey_index.slots)
+    {
+        /* the object name may already be cleared, so look for the key itself */
+        const struct name_index *idx = &parent->subkey_index;
+        unsigned int pos, hash = hash_name( name->name, name->len ), mask = idx->size - 1;
+
+        for (pos = hash & mask; idx->slots[pos].pos; pos = (pos + 1) & mask)
+            if (parent->subkeys[idx->slots[pos].pos - 1] == key) break;
+        i = idx->slots[pos].pos - 1;
+        if (i == parent->last_subkey) remove_name_index( &parent->subkey_index, hash, i );
+        else
+        {
+            drop_subkey_index( parent );
+            i = -1;
+        }
+    }
+    else if (parent->subkey_index.delay) parent->subkey_index.delay = MIN_INDEXED;
+
+    if (i == -1) for (i = 0; i <= parent->last_subkey; i++) if (parent->subkeys[i] == key) break;
+    assert( i >= 0 && i <= parent->last_subkey && parent->subkeys[i] == key );
+    if (i < parent->sorted_subkeys) parent->sorted_subkeys--;
+    for ( ; i < parent->last_subkey; i++) parent->subkeys[i] = parent->subkeys[i + 1];
+    parent->last_subkey--;
+}
+
 /* find the named child of a given key and return its index */
 static struct key *find_subkey( const struct key *key, const struct unicode_str *name, int *index )
 {
     int i, min, max, res;
     data_size_t len;
 
+    if (key->subkey_index.slots)
+    {
+        const struct name_index *idx = &key->subkey_index;
+        unsigned int pos, hash = hash_name( name->str, name->len ), mask = idx->size - 1;
+        struct key *subkey;
+
+        for (pos = hash & mask; idx->slots[pos].pos; pos = (pos + 1) & mask)
+        {
+            if (idx->slots[pos].hash != hash) continue;
+            subkey = key->subkeys[idx->slots[pos].pos - 1];
+            if (subkey->obj.name->len != name->len) continue;
+            if (memicmp_strW( subkey->obj.name->name, name->str, name->len )) continue;
+            *index = idx->slots[pos].pos - 1;
+            return subkey;
+        }
+        *index = key->last_subkey + 1;  /* new subkeys are appended to indexed keys */
+        return NULL;
+    }
+
     min = 0;
     max = key->last_subkey;
     while (min <= max)
@@ -606,6 +900,9 @@ static int key_link_name( struct object *obj, struct object_name *name, struct o
     for (i = ++parent_key->last_subkey; i > index; i--)
         parent_key->subkeys[i] = parent_key->subkeys[i - 1];
     parent_key->subkeys[index] = (struct key *)grab_object( key );
+    /* the name index needs the name, which create_object() only sets after linking */
+    key->obj.name = name;
+    add_subkey_index( parent_key, index );
     if (is_wow6432node( name->name, name->len ) &&
         !is_wow6432node( parent_key->obj.name->name, parent_key->obj.name->len ))
         parent_key->wow6432node = key;
@@ -617,7 +914,7 @@ static void key_unlink_name( struct object *obj, struct object_name *name )
 {
     struct key *key = (struct key *)obj;
     struct key *parent = (struct key *)name->parent;
-    int i, nb_subkeys;
+    int nb_subkeys;
 
     if (!parent) return;
 
@@ -627,10 +924,7 @@ static void key_unlink_name( struct object *obj, struct object_name *name )
         return;
     }
 
-    for (i = 0; i <= parent->last_subkey; i++) if (parent->subkeys[i] == key) break;
-    assert( i <= parent->last_subkey );
-    for ( ; i < parent->last_subkey; i++) parent->subkeys[i] = parent->subkeys[i + 1];
-    parent->last_subkey--;
+    remove_subkey( parent, key, name );
     name->parent = NULL;
     if (parent->wow6432node == key) parent->wow6432node = NULL;
     release_object( key );
@@ -671,12 +965,14 @@ static void key_destroy( struct object *obj )
         free( key->values[i].data );
     }
     free( key->values );
+    free_name_index( &key->value_index );
     for (i = 0; i <= key->last_subkey; i++)
     {
         key->subkeys[i]->obj.name->parent = NULL;
         release_object( key->subkeys[i] );
     }
     free( key->subkeys );
+    free_name_index( &key->subkey_index );
     /* unconditionally notify everything waiting on this key */
     while ((ptr = list_head( &key->notify_list )))
     {
@@ -705,10 +1001,14 @@ static struct key *create_key_object( struct object *parent, const struct unicod
             key->last_subkey = -1;
             key->nb_subkeys  = 0;
             key->subkeys     = NULL;
+            key->sorted_subkeys = 0;
             key->wow6432node = NULL;
             key->nb_values   = 0;
             key->last_value  = -1;
             key->values      = NULL;
+            key->sorted_values = 0;
+            memset( &key->subkey_index, 0, sizeof(key->subkey_index) );
+            memset( &key->value_index, 0, sizeof(key->value_index) );
             key->modif       = modif;
             key->timestamp_counter = 0;
             list_init( &key->notify_list );
@@ -752,6 +1052,17 @@ static void make_clean( struct key *key, abstime_t timestamp_counter )
     for (i = 0; i <= key->last_subkey; i++) make_clean( key->subkeys[i], timestamp_counter );
 }
 
+/* mark a key and all its subkeys as dirty, after the key has been moved */
+static void make_subtree_dirty( struct key *key )
+{
+    int i;
+
+    if (key->flags & KEY_VOLATILE) return;
+    key->flags |= KEY_DIRTY;
+    key->timestamp_counter = change_timestamp_counter;
+    for (i = 0; i <= key->last_subkey; i++) make_subtree_dirty( key->subkeys[i] );
+}
+
 /* go through all the notifications and send them if necessary */
 static void check_notify( struct key *key, unsigned int change, int not_subtree )
 {
@@ -928,6 +1239,7 @@ static void enum_key( struct key *key, int index, int info_class, struct enum_ke
             set_error( STATUS_NO_MORE_ENTRIES );
             return;
         }
+        sort_subkeys( key );
         key = key->subkeys[index];
     }
 
@@ -1008,7 +1320,7 @@ static void rename_key( struct key *key, const struct unicode_str *new_name )
     struct object_name *new_name_ptr;
     struct key *subkey, *parent = get_parent( key );
     data_size_t len;
-    int i, index, cur_index;
+    int i, index;
 
     /* changing to a path is not allowed */
     len = get_path_element( new_name->str, new_name->len );
@@ -1039,25 +1351,20 @@ static void rename_key( struct key *key, const struct unicode_str *new_name )
     new_name_ptr->parent = &parent->obj;
     memcpy( new_name_ptr->name, new_name->str, new_name->len );
 
-    for (cur_index = 0; cur_index <= parent->last_subkey; cur_index++)
-        if (parent->subkeys[cur_index] == key) break;
-
-    if (cur_index < index && (index - cur_index) > 1)
-    {
-        --index;
-        for (i = cur_index; i < index; ++i) parent->subkeys[i] = parent->subkeys[i+1];
-    }
-    else if (cur_index > index)
-    {
-        for (i = cur_index; i > index; --i) parent->subkeys[i] = parent->subkeys[i-1];
-    }
+    /* remove the key from the array and insert it again with the new name */
+    remove_subkey( parent, key, key->obj.name );
+    find_subkey( parent, new_name, &index );
+    for (i = ++parent->last_subkey; i > index; i--) parent->subkeys[i] = parent->subkeys[i - 1];
     parent->subkeys[index] = key;
 
     free( key->obj.name );
     key->obj.name = new_name_ptr;
+    add_subkey_index( parent, index );
 
     if (debug_level > 1) dump_operation( key, NULL, "Rename" );
     touch_key( key, REG_NOTIFY_CHANGE_NAME );
+    /* the whole subtree moved to a new path */
+    for (i = 0; i <= key->last_subkey; i++) make_subtree_dirty( key->subkeys[i] );
 }
 
 /* delete a key and its values */
@@ -1127,6 +1434,25 @@ static struct key_value *find_value( const struct key *key, const struct unicode
     int i, min, max, res;
     data_size_t len;
 
+    if (key->value_index.slots)
+    {
+        const struct name_index *idx = &key->value_index;
+        unsigned int pos, hash = hash_name( name->str, name->len ), mask = idx->size - 1;
+        struct key_value *value;
+
+        for (pos = hash & mask; idx->slots[pos].pos; pos = (pos + 1) & mask)
+        {
+            if (idx->slots[pos].hash != hash) continue;
+            value = &key->values[idx->slots[pos].pos - 1];
+            if (value->namelen != name->len) continue;
+            if (memicmp_strW( value->name, name->str, name->len )) continue;
+            *index = idx->slots[pos].pos - 1;
+            return value;
+        }
+        *index = key->last_value + 1;  /* new values are appended to indexed keys */
+        return NULL;
+    }
+
     min = 0;
     max = key->last_value;
     while (min <= max)
@@ -1170,6 +1496,27 @@ static struct key_value *insert_value( struct key *key, const struct unicode_str
     value->namelen = name->len;
     value->len     = 0;
     value->data    = NULL;
+
+    if (!key->value_index.slots)
+    {
+        /* not indexed, so it has been inserted in order */
+        key->sorted_values++;
+        if (key->value_index.delay) key->value_index.delay--;
+        else if (key->last_value + 1 >= MIN_INDEXED) build_value_index( key );
+        return value;
+    }
+
+    /* values appended in order don't need to be sorted later */
+    if (index == key->sorted_values && (!index || compare_values( &key->values[index - 1], value ) < 0))
+        key->sorted_values++;
+    if (!add_name_index( &key->value_index, hash_name( name->str, name->len ), index ))
+    {
+        /* fall back to a sorted array */
+        free_name_index( &key->value_index );
+        qsort( key->values, key->last_value + 1, sizeof(*key->values), compare_values );
+        key->sorted_values = key->last_value + 1;
+        value = find_value( key, name, &index );
+    }
     return value;
 }
 
@@ -1270,6 +1617,7 @@ static void enum_value( struct key *key, int i, int info_class, struct enum_key_
         void *data;
         data_size_t namelen, maxlen;
 
+        sort_values( key );
         value = &key->values[i];
         reply->type = value->type;
         namelen = value->namelen;
@@ -1328,6 +1676,18 @@ static void delete_value( struct key *key, const struct unicode_str *name )
         return;
     }
     if (debug_level > 1) dump_operation( key, value, "Delete" );
+    if (key->value_index.slots)
+    {
+        if (index == key->last_value)
+            remove_name_index( &key->value_index, hash_name( value->name, value->namelen ), index );
+        else
+        {
+            drop_value_index( key );
+            value = find_value( key, name, &index );
+        }
+    }
+    else if (key->value_index.delay) key->value_index.delay = MIN_INDEXED;
+    if (index < key->sorted_values) key->sorted_values--;
     free( value->name );
     free( value->data );
     for (i = index; i < key->last_value; i++) key->values[i] = key->values[i + 1];
@@ -1810,12 +2170,597 @@ static void load_registry( struct key *key, obj_handle_t handle )
     }
 }
 
+/* Binary registry snapshots
+ *
+ * When WINEREGSNAPSHOT is set, each branch is also stored in a binary
+ * <file>.snapshot next to its text file. The snapshot can be loaded without
+ * any parsing, and flushing a branch only appends the dirty keys to a journal
+ * at the end of it; the text file is rewritten at most every TEXT_SAVE_PERIOD
+ * after that, and when the server exits. A snapshot records the inode, size
+ * and modification time of the text file it supersedes, as they were when the
+ * server wrote it, and is ignored as soon as that file is written by anything
+ * else. A matching snapshot is always loaded, even without WINEREGSNAPSHOT,
+ * since its journal may hold flushed keys that the text file doesn't have
+ * yet; the text file is then rewritten and the snapshot deleted. */
+
+#define SNAPSHOT_VERSION      3
+#define SNAPSHOT_TEXT_CURRENT 0x0001      /* the text file has the same contents */
+#define SNAPSHOT_MIN_JOURNAL  0x10000     /* journal size always allowed before compacting */
+#define JOURNAL_MAGIC         0x4c4e524a  /* "JRNL" */
+#define TEXT_SAVE_PERIOD      (30 * -TICKS_PER_SEC)  /* delay before rewriting the flushed text files */
+
+static const char snapshot_magic[8] = {'W','I','N','E','R','E','G','B'};
+
+/* metadata of a text file, which changes whenever the file is written */
+struct snapshot_text_stamp
+{
+    unsigned long long ino;          /* inode number */
+    unsigned long long size;         /* file size */
+    long long          mtime;        /* modification time */
+    unsigned int       mtime_nsec;   /* nanoseconds of the modification time, if available */
+    unsigned int       __pad;
+};
+
+struct snapshot_header
+{
+    char               magic[8];     /* snapshot_magic */
+    unsigned int       version;      /* SNAPSHOT_VERSION */
+    unsigned int       header_size;  /* size of this structure */
+    unsigned int       prefix_type;  /* prefix type when the snapshot was written */
+    unsigned int       flags;        /* SNAPSHOT_* flags */
+    data_size_t        base_size;    /* size of the key records following the header */
+    unsigned int       __pad;
+    struct snapshot_text_stamp text; /* stamp of the text file superseded by the snapshot */
+};
+
+/* a batch of key records appended to the snapshot */
+struct snapshot_journal
+{
+    unsigned int       magic;        /* JOURNAL_MAGIC */
+    data_size_t        size;         /* size of the key records following */
+};
+
+/* a key record, followed by the path, class, values and subkey names, each padded to 4 bytes */
+struct snapshot_key
+{
+    timeout_t          modif;        /* last modification time */
+    data_size_t        path_len;     /* length of the path relative to the branch */
+    data_size_t        class_len;    /* length of the key class */
+    unsigned int       flags;        /* key flags */
+    unsigned int       value_count;  /* number of values */
+    int                subkey_count; /* number of subkey names, or -1 to keep the existing subkeys */
+    unsigned int       __pad;
+};
+
+/* a value record, followed by the name and the data, each padded to 4 bytes */
+struct snapshot_value
+{
+    data_size_t        name_len;     /* length of the value name */
+    unsigned int       type;         /* value type */
+    data_size_t        len;          /* length of the value data */
+};
+
+static int use_registry_snapshot(void)
+{
+    static int enabled = -1;
+
+    if (enabled == -1) enabled = getenv( "WINEREGSNAPSHOT" ) && atoi( getenv( "WINEREGSNAPSHOT" ) );
+    return enabled;
+}
+
+static char *get_snapshot_path( const char *path, const char *suffix )
+{
+    char *ret;
+
+    if ((ret = malloc( strlen(path) + sizeof(".snapshot") + strlen(suffix) )))
+        sprintf( ret, "%s.snapshot%s", path, suffix );
+    return ret;
+}
+
+/* store some data in a snapshot buffer, padded to 4 bytes */
+static data_size_t put_snapshot_data( char *buf, data_size_t pos, const void *data, data_size_t len )
+{
+    data_size_t end = (pos + len + 3) & ~3;
+
+    if (buf)
+    {
+        if (len) memcpy( buf + pos, data, len );
+        memset( buf + pos + len, 0, end - pos - len );
+    }
+    return end;
+}
+
+/* length of the path of a key relative to the branch */
+static data_size_t get_snapshot_path_len( const struct key *key, const struct key *base )
+{
+    data_size_t len = 0;
+
+    for ( ; key != base; key = get_parent( key ))
+        len += key->obj.name->len + (len ? sizeof(WCHAR) : 0);
+    return len;
+}
+
+static void put_snapshot_path( WCHAR *dst, const struct key *key, const struct key *base, data_size_t len )
+{
+    WCHAR *p = dst + len / sizeof(WCHAR);
+
+    for ( ; key != base; key = get_parent( key ))
+    {
+        p -= key->obj.name->len / sizeof(WCHAR);
+        memcpy( p, key->obj.name->name, key->obj.name->len );
+        if (p > dst) *--p = '\\';
+    }
+}
+
+/* store a key record, optionally with the names of its subkeys */
+static data_size_t snapshot_key_record( const struct key *key, const struct key *base, int with_subkeys, char *buf )
+{
+    struct snapshot_key rec;
+    struct snapshot_value val;
+    data_size_t pos = sizeof(rec), end;
+    int i;
+
+    rec.modif        = key->modif;
+    rec.path_len     = get_snapshot_path_len( key, base );
+    rec.class_len    = key->classlen;
+    rec.flags        = key->flags & KEY_SYMLINK;
+    rec.value_count  = key->last_value + 1;
+    rec.subkey_count = -1;
+    rec.__pad        = 0;
+
+    if (buf) put_snapshot_path( (WCHAR *)(buf + pos), key, base, rec.path_len );
+    pos = put_snapshot_data( buf, pos + rec.path_len, NULL, 0 );
+    pos = put_snapshot_data( buf, pos, key->class, key->classlen );
+
+    for (i = 0; i <= key->last_value; i++)
+    {
+        val.name_len = key->values[i].namelen;
+        val.type     = key->values[i].type;
+        val.len      = key->values[i].len;
+        pos = put_snapshot_data( buf, pos, &val, sizeof(val) );
+        pos = put_snapshot_data( buf, pos, key->values[i].name, val.name_len );
+        pos = put_snapshot_data( buf, pos, key->values[i].data, val.len );
+    }
+
+    if (with_subkeys)
+    {
+        rec.subkey_count = 0;
+        for (i = 0; i <= key->last_subkey; i++)
+        {
+            const struct object_name *name = key->subkeys[i]->obj.name;
+
+            if (key->subkeys[i]->flags & KEY_VOLATILE) continue;
+            pos = put_snapshot_data( buf, pos, &name->len, sizeof(name->len) );
+            pos = put_snapshot_data( buf, pos, name->name, name->len );
+            rec.subkey_count++;
+        }
+    }
+
+    /* keep the records aligned for the timestamp */
+    end = (pos + 7) & ~7;
+    if (buf)
+    {
+        memcpy( buf, &rec, sizeof(rec) );
+        memset( buf + pos, 0, end - pos );
+    }
+    return end;
+}
+
+/* store a key and all its subkeys */
+static data_size_t snapshot_branch( const struct key *key, const struct key *base, char *buf )
+{
+    data_size_t size;
+    int i;
+
+    if (key->flags & KEY_VOLATILE) return 0;
+
+    size = snapshot_key_record( key, base, 0, buf );
+    for (i = 0; i <= key->last_subkey; i++)
+        size += snapshot_branch( key->subkeys[i], base, buf ? buf + size : NULL );
+    return size;
+}
+
+/* store the keys modified since the last flush */
+static data_size_t snapshot_dirty_keys( const struct key *key, const struct key *base, char *buf )
+{
+    data_size_t size;
+    int i;
+
+    if ((key->flags & KEY_VOLATILE) || !(key->flags & KEY_DIRTY)) return 0;
+
+    size = snapshot_key_record( key, base, 1, buf );
+    for (i = 0; i <= key->last_subkey; i++)
+        size += snapshot_dirty_keys( key->subkeys[i], base, buf ? buf + size : NULL );
+    return size;
+}
+
+static void get_snapshot_text_stamp( const struct stat *st, struct snapshot_text_stamp *stamp )
+{
+    memset( stamp, 0, sizeof(*stamp) );
+    stamp->ino   = st->st_ino;
+    stamp->size  = st->st_size;
+    stamp->mtime = st->st_mtime;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    stamp->mtime_nsec = st->st_mtim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC)
+    stamp->mtime_nsec = st->st_mtimespec.tv_nsec;
+#endif
+}
+
+static int write_snapshot_data( int fd, const char *buf, size_t size )
+{
+    ssize_t ret;
+
+    while (size)
+    {
+        if ((ret = write( fd, buf, size )) == -1)
+        {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        buf += ret;
+        size -= ret;
+    }
+    return 1;
+}
+
+/* write a complete snapshot of a branch, superseding the current text file */
+static int save_snapshot( struct save_branch_info *info, int text_current )
+{
+    struct snapshot_header header;
+    struct stat st;
+    char *buf, *path = NULL, *tmp = NULL;
+    data_size_t size;
+    int fd, ret = 0;
+
+    info->snapshot_valid = 0;
+    if (stat( info->path, &st ) == -1) return 0;
+
+    sort_branch( info->key );
+    size = snapshot_branch( info->key, info->key, NULL );
+    if (!(buf = malloc( sizeof(header) + size ))) return 0;
+
+    memset( &header, 0, sizeof(header) );
+    memcpy( header.magic, snapshot_magic, sizeof(header.magic) );
+    header.version     = SNAPSHOT_VERSION;
+    header.header_size = sizeof(header);
+    header.prefix_type = prefix_type;
+    header.flags       = text_current ? SNAPSHOT_TEXT_CURRENT : 0;
+    header.base_size   = size;
+    get_snapshot_text_stamp( &st, &header.text );
+    memcpy( buf, &header, sizeof(header) );
+    snapshot_branch( info->key, info->key, buf + sizeof(header) );
+
+    if (!(path = get_snapshot_path( info->path, "" )) || !(tmp = get_snapshot_path( info->path, ".tmp" )))
+        goto done;
+    if ((fd = open( tmp, O_CREAT | O_TRUNC | O_WRONLY, 0666 )) == -1) goto done;
+    ret = write_snapshot_data( fd, buf, sizeof(header) + size );
+    if (close( fd )) ret = 0;
+    if (ret) ret = !rename( tmp, path );
+    if (!ret) unlink( tmp );
+
+    if (ret)
+    {
+        info->snapshot_valid = 1;
+        info->snapshot_size  = size;
+        info->journal_size   = 0;
+    }
+    if (debug_level > 1) fprintf( stderr, "%s: saved snapshot, %u bytes\n", info->path, size );
+
+done:
+    free( buf );
+    free( path );
+    free( tmp );
+    return ret;
+}
+
+/* delete the snapshot of a branch once its text file is current, when snapshots are disabled */
+static void delete_snapshot( struct save_branch_info *info )
+{
+    char *path;
+
+    if ((path = get_snapshot_path( info->path, "" ))) unlink( path );
+    free( path );
+    info->snapshot_loaded = 0;
+    info->snapshot_valid  = 0;
+}
+
+/* append the keys modified since the last flush to the snapshot journal */
+static int append_snapshot_journal( struct save_branch_info *info )
+{
+    struct snapshot_journal journal;
+    char *buf, *path;
+    data_size_t size;
+    int fd, ret = 0;
+
+    size = snapshot_dirty_keys( info->key, info->key, NULL );
+    if (!(buf = malloc( sizeof(journal) + size ))) return 0;
+
+    journal.magic = JOURNAL_MAGIC;
+    journal.size  = size;
+    memcpy( buf, &journal, sizeof(journal) );
+    snapshot_dirty_keys( info->key, info->key, buf + sizeof(journal) );
+
+    if ((path = get_snapshot_path( info->path, "" )) && (fd = open( path, O_WRONLY | O_APPEND )) != -1)
+    {
+        ret = write_snapshot_data( fd, buf, sizeof(journal) + size );
+        if (close( fd )) ret = 0;
+    }
+
+    /* a torn journal is ignored when loading, but nothing may be appended after it */
+    if (ret) info->journal_size += sizeof(journal) + size;
+    else info->snapshot_valid = 0;
+    if (debug_level > 1) fprintf( stderr, "%s: appended %u bytes to snapshot journal\n", info->path, size );
+
+    free( buf );
+    free( path );
+    return ret;
+}
+
+static struct timeout_user *text_save_timeout;
+
+static int save_branch( struct save_branch_info *info );
+
+/* rewrite the text files of the branches flushed to their snapshot */
+static void save_text_files( void *arg )
+{
+    int i;
+
+    text_save_timeout = NULL;
+    if (fchdir( config_dir_fd ) == -1) return;
+    for (i = 0; i < save_branch_count; i++)
+    {
+        if (save_branch_info[i].text_dirty && !save_branch( &save_branch_info[i] ))
+        {
+            fprintf( stderr, "wineserver: could not save registry branch to %s",
+                     save_branch_info[i].path );
+            perror( " " );
+        }
+    }
+    if (fchdir( server_dir_fd ) == -1) fatal_error( "chdir to server dir: %s\n", strerror( errno ));
+}
+
+/* flush a dirty branch to its snapshot; the text file is written later */
+static int flush_snapshot( struct save_branch_info *info )
+{
+    timeout_t start = monotonic_counter();
+    int ret;
+
+    if (!(info->key->flags & KEY_DIRTY)) return 1;
+
+    if (info->snapshot_valid && info->journal_size < max( info->snapshot_size, SNAPSHOT_MIN_JOURNAL ))
+        ret = append_snapshot_journal( info );
+    else
+        ret = save_snapshot( info, 0 );
+
+    if (ret)
+    {
+        make_clean( info->key, change_timestamp_counter );
+        info->text_dirty = 1;
+        if (!text_save_timeout) text_save_timeout = add_timeout_user( TEXT_SAVE_PERIOD, save_text_files, NULL );
+    }
+    if (debug_level) fprintf( stderr, "%s: flushed snapshot in %u us\n", info->path,
+                              (unsigned int)((monotonic_counter() - start) / 10) );
+    return ret;
+}
+
+static const void *get_snapshot_data( const char **pos, const char *end, data_size_t len )
+{
+    const char *ret = *pos;
+    data_size_t padded = (len + 3) & ~3;
+
+    if (padded < len || end - ret < padded) return NULL;
+    *pos = ret + padded;
+    return ret;
+}
+
+static void free_key_values( struct key *key )
+{
+    int i;
+
+    for (i = 0; i <= key->last_value; i++)
+    {
+        free( key->values[i].name );
+        free( key->values[i].data );
+    }
+    key->last_value = -1;
+    key->sorted_values = 0;
+    free_name_index( &key->value_index );
+}
+
+/* load a value from a snapshot record */
+static void load_snapshot_value( struct key *key, const struct snapshot_value *val,
+                                 const WCHAR *name_str, const void *data )
+{
+    struct unicode_str name = { name_str, val->name_len };
+    struct key_value *value;
+    int index;
+
+    if (!(value = find_value( key, &name, &index )) && !(value = insert_value( key, &name, index )))
+        return;
+    free( value->data );
+    value->data = val->len ? memdup( data, val->len ) : NULL;
+    value->len  = value->data ? val->len : 0;
+    value->type = val->type;
+}
+
+/* delete the subkeys which aren't listed in a journal record */
+static void prune_snapshot_subkeys( struct key *key, const char *pos, const char *end, int count )
+{
+    const data_size_t *len;
+    struct unicode_str name;
+    struct key *subkey;
+    int i, index;
+
+    for (i = 0; i < count; i++)
+    {
+        len = get_snapshot_data( &pos, end, sizeof(*len) );
+        name.len = *len;
+        name.str = get_snapshot_data( &pos, end, name.len );
+        if ((subkey = find_subkey( key, &name, &index ))) subkey->flags |= KEY_KEEP;
+    }
+
+    for (i = key->last_subkey; i >= 0; i--)
+    {
+        subkey = key->subkeys[i];
+        if (subkey->flags & (KEY_KEEP | KEY_VOLATILE)) subkey->flags &= ~KEY_KEEP;
+        else delete_key( subkey, 1 );
+    }
+}
+
+/* parse the key records of a snapshot, checking their layout or applying them to the branch */
+static int load_snapshot_keys( struct key *branch, const char *pos, data_size_t size, int apply )
+{
+    const char *end = pos + size;
+
+    while (pos < end)
+    {
+        const char *start = pos, *subkeys;
+        const struct snapshot_key *rec;
+        const struct snapshot_value *val;
+        const WCHAR *path, *name;
+        const void *class, *data;
+        const data_size_t *len;
+        struct key *key = NULL;
+        unsigned int i;
+
+        if (!(rec = get_snapshot_data( &pos, end, sizeof(*rec) ))) return 0;
+        if (rec->path_len % sizeof(WCHAR)) return 0;
+        if (!(path = get_snapshot_data( &pos, end, rec->path_len ))) return 0;
+        if (!(class = get_snapshot_data( &pos, end, rec->class_len ))) return 0;
+
+        if (apply)
+        {
+            struct unicode_str str = { path, rec->path_len };
+
+            if (!rec->path_len) key = (struct key *)grab_object( branch );
+            else if (!(key = create_key_recursive( branch, &str, rec->modif ))) return 0;
+
+            key->modif = rec->modif;
+            key->flags = (key->flags & ~KEY_SYMLINK) | (rec->flags & KEY_SYMLINK);
+            free( key->class );
+            key->class = rec->class_len ? memdup( class, rec->class_len ) : NULL;
+            key->classlen = key->class ? rec->class_len : 0;
+            free_key_values( key );
+        }
+
+        for (i = 0; i < rec->value_count; i++)
+        {
+            if (!(val = get_snapshot_data( &pos, end, sizeof(*val) )) ||
+                !(name = get_snapshot_data( &pos, end, val->name_len )) ||
+                !(data = get_snapshot_data( &pos, end, val->len )))
+                goto error;
+            if (key) load_snapshot_value( key, val, name, data );
+        }
+
+        subkeys = pos;
+        for (i = 0; rec->subkey_count > 0 && i < (unsigned int)rec->subkey_count; i++)
+        {
+            if (!(len = get_snapshot_data( &pos, end, sizeof(*len) )) ||
+                !get_snapshot_data( &pos, end, *len ))
+                goto error;
+        }
+        if (key && rec->subkey_count >= 0) prune_snapshot_subkeys( key, subkeys, pos, rec->subkey_count );
+
+        if (key) release_object( key );
+        pos = start + (((pos - start) + 7) & ~7);
+        if (pos > end) return 0;
+        continue;
+
+    error:
+        if (key) release_object( key );
+        return 0;
+    }
+    return 1;
+}
+
+/* load a branch from its snapshot, if it still supersedes the text file */
+static int load_snapshot( struct save_branch_info *info, const char *filename, struct key *key )
+{
+    const struct snapshot_header *header;
+    const struct snapshot_journal *journal;
+    struct snapshot_text_stamp text;
+    const char *data, *pos, *end;
+    struct stat st, text_st;
+    void *ptr;
+    char *path;
+    int fd, ret = 0;
+
+    if (stat( filename, &text_st ) == -1) return 0;
+    if (!(path = get_snapshot_path( filename, "" ))) return 0;
+    fd = open( path, O_RDONLY );
+    free( path );
+    if (fd == -1) return 0;
+    if (fstat( fd, &st ) == -1 || st.st_size < sizeof(*header) || st.st_size > INT_MAX)
+    {
+        close( fd );
+        return 0;
+    }
+    ptr = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+    if (ptr == MAP_FAILED) return 0;
+
+    header = ptr;
+    data = (const char *)(header + 1);
+    end = (const char *)ptr + st.st_size;
+
+    if (memcmp( header->magic, snapshot_magic, sizeof(header->magic) ) ||
+        header->version != SNAPSHOT_VERSION ||
+        header->header_size != sizeof(*header) ||
+        header->base_size > end - data)
+        goto done;
+    if (prefix_type != PREFIX_UNKNOWN && header->prefix_type != prefix_type) goto done;
+    get_snapshot_text_stamp( &text_st, &text );
+    if (memcmp( &header->text, &text, sizeof(text) )) goto done;
+
+    /* check everything before touching the branch, so that we can still fall back to the text file */
+    if (!load_snapshot_keys( key, data, header->base_size, 0 )) goto done;
+    for (pos = data + header->base_size; end - pos >= sizeof(*journal); pos += sizeof(*journal) + journal->size)
+    {
+        journal = (const struct snapshot_journal *)pos;
+        if (journal->magic != JOURNAL_MAGIC || journal->size > end - pos - sizeof(*journal)) break;
+        if (!load_snapshot_keys( key, (const char *)(journal + 1), journal->size, 0 )) break;
+    }
+
+    load_snapshot_keys( key, data, header->base_size, 1 );
+    for (end = pos, pos = data + header->base_size; pos < end; pos += sizeof(*journal) + journal->size)
+    {
+        journal = (const struct snapshot_journal *)pos;
+        load_snapshot_keys( key, (const char *)(journal + 1), journal->size, 1 );
+    }
+
+    if (prefix_type == PREFIX_UNKNOWN) prefix_type = header->prefix_type;
+    make_clean( key, change_timestamp_counter );
+
+    info->snapshot_valid = (end == (const char *)ptr + st.st_size);
+    info->snapshot_size  = header->base_size;
+    info->journal_size   = end - (data + header->base_size);
+    info->text_dirty     = info->journal_size || !(header->flags & SNAPSHOT_TEXT_CURRENT);
+    info->snapshot_loaded = 1;
+    if (debug_level) fprintf( stderr, "%s: loaded snapshot, %u bytes, %u bytes of journal\n",
+                              filename, info->snapshot_size, info->journal_size );
+    ret = 1;
+
+done:
+    munmap( ptr, st.st_size );
+    return ret;
+}
+
 /* load one of the initial registry files */
 static int load_init_registry_from_file( const char *filename, struct key *key )
 {
-    FILE *f;
+    timeout_t start = monotonic_counter();
+    struct save_branch_info *info;
+    FILE *f = NULL;
+    int ret;
+
+    assert( save_branch_count < MAX_SAVE_BRANCH_INFO );
+
+    info = &save_branch_info[save_branch_count];
+    memset( info, 0, sizeof(*info) );
 
-    if ((f = fopen( filename, "r" )))
+    if (!(ret = load_snapshot( info, filename, key )) &&
+        (f = fopen( filename, "r" )))
     {
         load_keys( key, filename, f, 0 );
         fclose( f );
@@ -1824,14 +2769,18 @@ static int load_init_registry_from_file( const char *filename, struct key *key )
             fprintf( stderr, "%s is not a valid registry file\n", filename );
             return 1;
         }
+        ret = 1;
     }
+    if (ret && debug_level) fprintf( stderr, "%s: loaded in %u ms\n", filename,
+                                     (unsigned int)((monotonic_counter() - start) / 10000) );
 
-    assert( save_branch_count < MAX_SAVE_BRANCH_INFO );
-
-    save_branch_info[save_branch_count].path = filename;
-    save_branch_info[save_branch_count++].key = (struct key *)grab_object( key );
+    info->path = filename;
+    info->key = (struct key *)grab_object( key );
+    /* the text file is current, so a disabled snapshot is no longer needed */
+    if (info->snapshot_loaded && !info->text_dirty && !use_registry_snapshot()) delete_snapshot( info );
+    save_branch_count++;
     make_object_permanent( &key->obj );
-    return (f != NULL);
+    return ret;
 }
 
 static WCHAR *format_user_registry_path( const struct sid *sid, struct unicode_str *path )
@@ -2004,6 +2953,7 @@ void init_registry(void)
 static void save_all_subkeys( struct key *key, FILE *f )
 {
     /* Registry format in ntdll/registry.c:save_all_subkeys() should match. */
+    sort_branch( key );
     fprintf( f, "WINE REGISTRY Version 2\n" );
     fprintf( f, ";; All keys relative to " );
     dump_path( key, NULL, f );
@@ -2123,14 +3073,17 @@ static data_size_t save_registry( const struct key *key, char *buf )
 }
 
 /* save a registry branch to a file */
-static int save_branch( struct key *key, const char *path )
+static int save_branch( struct save_branch_info *info )
 {
+    timeout_t start = monotonic_counter();
+    struct key *key = info->key;
+    const char *path = info->path;
     struct stat st;
     char *p, *tmp = NULL;
     int fd, count = 0, ret = 0;
     FILE *f;
 
-    if (!(key->flags & KEY_DIRTY))
+    if (!(key->flags & KEY_DIRTY) && !info->text_dirty)
     {
         if (debug_level > 1) dump_operation( key, NULL, "Not saving clean" );
         return 1;
@@ -2192,7 +3145,15 @@ static int save_branch( struct key *key, const char *path )
 
 done:
     free( tmp );
-    if (ret) make_clean( key, key->timestamp_counter );
+    if (ret)
+    {
+        make_clean( key, key->timestamp_counter );
+        info->text_dirty = 0;
+        if (use_registry_snapshot()) save_snapshot( info, 1 );
+        else if (info->snapshot_loaded) delete_snapshot( info );
+        if (debug_level) fprintf( stderr, "%s: saved in %u ms\n", path,
+                                  (unsigned int)((monotonic_counter() - start) / 10000) );
+    }
     return ret;
 }
 
@@ -2204,7 +3165,7 @@ void flush_registry(void)
     if (fchdir( config_dir_fd ) == -1) return;
     for (i = 0; i < save_branch_count; i++)
     {
-        if (!save_branch( save_branch_info[i].key, save_branch_info[i].path ))
+        if (!save_branch( &save_branch_info[i] ))
         {
             fprintf( stderr, "wineserver: could not save registry branch to %s",
                      save_branch_info[i].path );
@@ -2329,11 +3290,22 @@ DECL_HANDLER(flush_key)
         find_branches_for_key( key, branches, &branch_count );
     release_object( key );
 
+    if (branch_count && use_registry_snapshot())
+    {
+        /* append to the snapshot journals ourselves, the client only gets what couldn't be saved */
+        if (fchdir( config_dir_fd ) != -1)
+        {
+            for (i = 0; i < branch_count; ++i) flush_snapshot( &save_branch_info[branches[i]] );
+            if (fchdir( server_dir_fd ) == -1) fatal_error( "chdir to server dir: %s\n", strerror( errno ));
+        }
+    }
+
     reply->timestamp_counter = change_timestamp_counter;
     for (i = 0; i < branch_count; ++i)
     {
         if (!(save_branch_info[branches[i]].key->flags & KEY_DIRTY)) continue;
         ++reply->branch_count;
+        sort_branch( save_branch_info[branches[i]].key );
         path_len = strlen( save_branch_info[branches[i]].path ) + 1;
         reply->total += sizeof(int) + sizeof(int) + path_len + save_registry( save_branch_info[branches[i]].key, NULL );
     }
@@ -2507,6 +3479,7 @@ DECL_HANDLER(save_registry)
 
     if ((key = get_hkey_obj( req->hkey, 0 )))
     {
+        sort_branch( key );
         reply->total = save_registry( key, NULL );
         if (reply->total <= get_reply_max_size())
         {
@@ -68,6 +68,10 @@
 #define SCM_RIGHTS 1
 #endif
 
+/* request data buffers are kept across requests unless they grow larger than this */
+#define MIN_REQUEST_BUFFER_SIZE  1024
+#define MAX_REQUEST_BUFFER_SIZE  16384
+
 /* path names for server master Unix socket */
 static const char * const server_socket_name = "socket";   /* name of the socket file */
 static const char * const server_lock_name = "lock";       /* name of the server lock file */
@@ -326,25 +330,69 @@ static void call_req_handler( struct thread *thread )
     current = NULL;
 }
 
-/* read a request from a thread */
+/* make sure the request data buffer of a thread is large enough for the current request */
+static int grow_request_buffer( struct thread *thread, data_size_t size )
+{
+    void *data;
+
+    if (size <= thread->req_data_size) return 1;
+    size = max( size, MIN_REQUEST_BUFFER_SIZE );
+    if (!(data = realloc( thread->req_data, size ))) return 0;
+    thread->req_data = data;
+    thread->req_data_size = size;
+    return 1;
+}
+
+/* handle a fully read request, and release the request data buffer if it grew too large */
+static void handle_request( struct thread *thread )
+{
+    call_req_handler( thread );
+    if (thread->req_data_size > MAX_REQUEST_BUFFER_SIZE)
+    {
+        free( thread->req_data );
+        thread->req_data = NULL;
+        thread->req_data_size = 0;
+    }
+}
+
+/* read a request from a thread
+ *
+ * Requests are read and handled one at a time from the main loop, even read-only ones:
+ * objects, handles and the current error aren't thread safe. */
 void read_request( struct thread *thread )
 {
     int ret;
 
     if (!thread->req_toread)  /* no pending request */
     {
-        if ((ret = read( get_unix_fd( thread->request_fd ), &thread->req,
-                         sizeof(thread->req) )) != sizeof(thread->req)) goto error;
-        if (!(thread->req_toread = thread->req.request_header.request_size))
+        struct iovec vec[2];
+
+        /* clients send the header and data in a single write and wait for the reply,
+         * so try to read everything at once into the buffer kept from the previous request */
+        vec[0].iov_base = &thread->req;
+        vec[0].iov_len  = sizeof(thread->req);
+        vec[1].iov_base = thread->req_data;
+        vec[1].iov_len  = thread->req_data_size;
+
+        if ((ret = readv( get_unix_fd( thread->request_fd ), vec, thread->req_data ? 2 : 1 )) <
+            (int)sizeof(thread->req)) goto error;
+        ret -= sizeof(thread->req);
+        if (ret > thread->req.request_header.request_size)
+        {
+            fatal_protocol_error( thread, "request %d data overrun %d\n",
+                                  thread->req.request_header.req, ret );
+            return;
+        }
+        if (!(thread->req_toread = thread->req.request_header.request_size - ret))
         {
-            /* no data, handle request at once */
-            call_req_handler( thread );
+            /* no data or all data already read, handle request at once */
+            handle_request( thread );
             return;
         }
-        if (!(thread->req_data = malloc( thread->req_toread )))
+        if (!grow_request_buffer( thread, thread->req.request_header.request_size ))
         {
             fatal_protocol_error( thread, "no memory for %u bytes request %d\n",
-                                  thread->req_toread, thread->req.request_header.req );
+                                  thread->req.request_header.request_size, thread->req.request_header.req );
             return;
         }
     }
@@ -359,9 +407,7 @@ void read_request( struct thread *thread )
         if (ret <= 0) break;
         if (!(thread->req_toread -= ret))
         {
-            call_req_handler( thread );
-            free( thread->req_data );
-            thread->req_data = NULL;
+            handle_request( thread );
             return;
         }
     }
@@ -960,3 +1006,118 @@ void close_master_socket( timeout_t timeout )
 
     master_timeout = add_timeout_user( timeout, close_socket_timeout, NULL );
 }
+
+/* alignment of the requests and replies packed in a batch */
+#define BATCH_ALIGN(size) (((size) + 7) & ~7)
+
+/* check if a request can be executed inside a batch; it must not block or transfer fds */
+static int is_batchable_request( enum request req )
+{
+    switch (req)
+    {
+    case REQ_create_key:
+    case REQ_open_key:
+    case REQ_get_key_value:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/* execute several independent requests in a single round-trip */
+DECL_HANDLER(batch_requests)
+{
+    const char *data = get_req_data();
+    data_size_t size = get_req_data_size(), max_size = get_reply_max_size();
+    data_size_t pos = 0, reply_pos = 0;
+    union generic_request batch_req = current->req;
+    void *req_data = current->req_data;
+    unsigned int status = STATUS_SUCCESS, count = 0;
+    char *replies = NULL;
+
+    /* the sub-requests are unpacked over current->req, which is restored below */
+
+    while (pos < size)
+    {
+        union generic_reply sub_reply;
+        enum request type;
+        data_size_t req_size, reply_size, reserved;
+        char *ptr;
+
+        if (size - pos < sizeof(current->req))
+        {
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+        memcpy( &current->req, data + pos, sizeof(current->req) );
+        pos += sizeof(current->req);
+        type = current->req.request_header.req;
+        req_size = current->req.request_header.request_size;
+        reply_size = current->req.request_header.reply_size;
+        if (req_size > size - pos)
+        {
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+        /* check against the aligned down space left, BATCH_ALIGN would wrap around for huge sizes */
+        if (max_size - reply_pos < sizeof(sub_reply) ||
+            reply_size > ((max_size - reply_pos - sizeof(sub_reply)) & ~7))
+        {
+            status = STATUS_BUFFER_OVERFLOW;
+            break;
+        }
+        reserved = BATCH_ALIGN( reply_size );
+        if (!(ptr = realloc( replies, reply_pos + sizeof(sub_reply) + reserved )))
+        {
+            status = STATUS_NO_MEMORY;
+            break;
+        }
+        replies = ptr;
+
+        current->req_data = (void *)(data + pos);
+        current->reply_data = NULL;
+        current->reply_size = 0;
+        clear_error();
+        memset( &sub_reply, 0, sizeof(sub_reply) );
+
+        if (debug_level) trace_request();
+
+        if (type < REQ_NB_REQUESTS && is_batchable_request( type ))
+            req_handlers[type]( &current->req, &sub_reply );
+        else
+            set_error( STATUS_NOT_SUPPORTED );
+
+        /* never copy more than the space reserved for this reply */
+        if (current->reply_size > reply_size)
+        {
+            free( current->reply_data );
+            current->reply_data = NULL;
+            current->reply_size = 0;
+            set_error( STATUS_INTERNAL_ERROR );
+        }
+
+        sub_reply.reply_header.error = current->error;
+        sub_reply.reply_header.reply_size = current->reply_size;
+        if (debug_level) trace_reply( type, &sub_reply );
+
+        memcpy( replies + reply_pos, &sub_reply, sizeof(sub_reply) );
+        reply_pos += sizeof(sub_reply);
+        if (current->reply_size) memcpy( replies + reply_pos, current->reply_data, current->reply_size );
+        memset( replies + reply_pos + current->reply_size, 0,
+                BATCH_ALIGN( current->reply_size ) - current->reply_size );
+        reply_pos += BATCH_ALIGN( current->reply_size );
+        free( current->reply_data );
+
+        pos += BATCH_ALIGN( req_size );
+        count++;
+    }
+
+    current->req = batch_req;
+    current->req_data = req_data;
+    current->reply_data = NULL;
+    current->reply_size = 0;
+    set_error( status );
+    reply->count = count;
+    if (reply_pos) set_reply_data_ptr( replies, reply_pos );
+    else free( replies );
+}
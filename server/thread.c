@@ -276,6 +276,7 @@ static inline void init_thread_structure( struct thread *thread )
     thread->wait            = NULL;
     thread->error           = 0;
     thread->req_data        = NULL;
+    thread->req_data_size   = 0;
     thread->req_toread      = 0;
     thread->reply_data      = NULL;
     thread->reply_towrite   = 0;
@@ -299,6 +300,7 @@ static inline void init_thread_structure( struct thread *thread )
     thread->creation_time = current_time;
     thread->exit_time     = 0;
     thread->locked_completion = NULL;
+    thread->completion_waiter = NULL;
 
     list_init( &thread->mutex_list );
     list_init( &thread->system_apc );
@@ -542,6 +544,7 @@ static void cleanup_thread( struct thread *thread )
     if (thread->request_fd) release_object( thread->request_fd );
     if (thread->reply_fd) release_object( thread->reply_fd );
     if (thread->wait_fd) release_object( thread->wait_fd );
+    release_completion_waiter( thread );
     cleanup_clipboard_thread(thread);
     destroy_thread_windows( thread );
     free_msg_queue( thread );
@@ -560,6 +563,7 @@ static void cleanup_thread( struct thread *thread )
     if (thread->input_shared_mapping) release_object( thread->input_shared_mapping );
     thread->input_shared_mapping = NULL;
     thread->req_data = NULL;
+    thread->req_data_size = 0;
     thread->reply_data = NULL;
     thread->request_fd = NULL;
     thread->reply_fd = NULL;
@@ -67,6 +67,7 @@ struct thread
     unsigned int           error;         /* current error code */
     union generic_request  req;           /* current request */
     void                  *req_data;      /* variable-size data for request */
+    unsigned int           req_data_size; /* allocated size of the request data buffer */
     unsigned int           req_toread;    /* amount of data still to read in request */
     void                  *reply_data;    /* variable-size data for reply */
     unsigned int           reply_size;    /* size of reply data */
@@ -95,6 +96,7 @@ struct thread
     data_size_t            desc_len;      /* thread description length in bytes */
     WCHAR                 *desc;          /* thread description string */
     struct object         *locked_completion; /* completion port wait object successfully waited by the thread */
+    struct object         *completion_waiter; /* completion port wait object counting the thread as a waiter */
     struct object         *queue_shared_mapping; /* thread queue shared memory mapping */
     queue_shm_t           *queue_shared;  /* thread queue shared memory ptr */
     struct object         *input_shared_mapping; /* thread input shared memory mapping */
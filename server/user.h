@@ -73,6 +73,8 @@ struct desktop
     unsigned int         last_press_alt:1; /* last key press was Alt (used to determine msg on Alt release) */
     struct object       *shared_mapping;   /* desktop shared memory mapping */
     const desktop_shm_t *shared;           /* desktop shared memory */
+    struct object       *windows_mapping;  /* shared memory mapping of the desktop windows */
+    const window_shm_t  *windows_shared;   /* shared memory of the desktop windows, by user handle index */
 };
 
 /* user handles functions */
@@ -86,6 +86,7 @@ struct window
     unsigned int     dpi;             /* window DPI or 0 if per-monitor aware */
     DPI_AWARENESS    dpi_awareness;   /* DPI awareness mode */
     lparam_t         user_data;       /* user-specific data */
+    const window_shm_t *shared;       /* window shared memory ptr */
     WCHAR           *text;            /* window caption text */
     data_size_t      text_len;        /* length of window caption */
     unsigned int     paint_flags;     /* various painting flags */
@@ -255,6 +256,70 @@ static unsigned int get_monitor_dpi( struct window *win )
     return win->dpi ? win->dpi : USER_DEFAULT_SCREEN_DPI;
 }
 
+#if defined(__i386__) || defined(__x86_64__)
+#define __SHARED_INCREMENT_SEQ( x ) ++(x)
+#else
+#define __SHARED_INCREMENT_SEQ( x ) __atomic_add_fetch( &(x), 1, __ATOMIC_RELEASE )
+#endif
+
+#define SHARED_WRITE_BEGIN( object, type )                           \
+    do {                                                             \
+        const type *__shared = (object)->shared;                     \
+        type *shared = (type *)__shared;                             \
+        unsigned int __seq = __SHARED_INCREMENT_SEQ( shared->seq );  \
+        assert( (__seq & 1) != 0 );                                  \
+        do
+
+#define SHARED_WRITE_END                                             \
+        while(0);                                                    \
+        __seq = __SHARED_INCREMENT_SEQ( shared->seq ) - __seq;       \
+        assert( __seq == 1 );                                        \
+    } while(0);
+
+/* get the shared memory slot for a window handle, in the mapping of its desktop */
+static const window_shm_t *get_window_shared( struct desktop *desktop, user_handle_t handle )
+{
+    if (!desktop->windows_shared) return NULL;
+    return &desktop->windows_shared[USER_HANDLE_INDEX( handle )];
+}
+
+/* update the window state exposed to clients */
+static void update_window_shared( struct window *win )
+{
+    if (!win->shared) return;
+
+    SHARED_WRITE_BEGIN( win, window_shm_t )
+    {
+        shared->handle      = win->handle;
+        shared->parent      = win->parent ? win->parent->handle : 0;
+        shared->owner       = win->owner;
+        shared->tid         = win->thread ? get_thread_id( win->thread ) : 0;
+        shared->pid         = win->thread ? get_process_id( win->thread->process ) : 0;
+        shared->style       = win->style;
+        shared->ex_style    = win->ex_style;
+        shared->dpi         = win->dpi;
+        shared->window_rect = win->window_rect;
+        shared->client_rect = win->client_rect;
+        shared->user_data   = win->user_data;
+        shared->id          = win->id;
+        shared->instance    = win->instance;
+    }
+    SHARED_WRITE_END
+}
+
+/* release the shared memory slot of a window before its handle is freed */
+static void free_window_shared( struct window *win )
+{
+    if (!win->shared) return;
+
+    SHARED_WRITE_BEGIN( win, window_shm_t )
+    {
+        memset( (char *)shared + sizeof(shared->seq), 0, sizeof(*shared) - sizeof(shared->seq) );
+    }
+    SHARED_WRITE_END
+    win->shared = NULL;
+}
+
 /* link a window at the right place in the siblings list */
 static int link_window( struct window *win, struct window *previous )
 {
@@ -311,6 +376,7 @@ static int link_window( struct window *win, struct window *previous )
     }
 
     win->is_linked = 1;
+    update_window_shared( win );
     return old_prev != win->entry.prev;
 }
 
@@ -356,6 +422,7 @@ static int set_parent_window( struct window *win, struct window *parent )
         win->is_linked = 0;
         win->is_orphan = 1;
     }
+    update_window_shared( win );
     return 1;
 }
 
@@ -494,6 +561,7 @@ static void detach_window_thread( struct window *win )
     /* destroyed when the desktop ref count reaches zero */
     release_object( win->desktop );
     win->thread = NULL;
+    update_window_shared( win );
 }
 
 /* get the process owning the top window of a given desktop */
@@ -578,6 +646,7 @@ static struct window *create_window( struct window *parent, struct window *owner
     win->dpi_awareness  = DPI_AWARENESS_PER_MONITOR_AWARE;
     win->dpi            = 0;
     win->user_data      = 0;
+    win->shared         = NULL;
     win->text           = NULL;
     win->text_len       = 0;
     win->paint_flags    = 0;
@@ -597,6 +666,7 @@ static struct window *create_window( struct window *parent, struct window *owner
         win->nb_extra_bytes = extra_bytes;
     }
     if (!(win->handle = alloc_user_handle( win, USER_WINDOW ))) goto failed;
+    win->shared = get_window_shared( desktop, win->handle );
 
     /* if parent belongs to a different thread and the window isn't */
     /* top-level, attach the two threads */
@@ -628,6 +698,7 @@ static struct window *create_window( struct window *parent, struct window *owner
     }
 
     current->desktop_users++;
+    update_window_shared( win );
     return win;
 
 failed:
@@ -635,6 +706,7 @@ failed:
     {
         if (win->handle)
         {
+            free_window_shared( win );
             free_user_handle( win->handle );
             win->handle = 0;
         }
@@ -1828,8 +1900,10 @@ static void set_window_pos( struct window *win, struct window *previous,
             offset_rect( &child->visible_rect, new_size - old_size, 0 );
             offset_rect( &child->surface_rect, new_size - old_size, 0 );
             offset_rect( &child->client_rect, new_size - old_size, 0 );
+            update_window_shared( child );
         }
     }
+    update_window_shared( win );
 
     /* reset cursor clip rectangle when the desktop changes size */
     if (win == win->desktop->top_window) set_clip_rectangle( win->desktop, NULL, SET_CURSOR_NOCLIP, 1 );
@@ -2046,6 +2120,7 @@ void free_window_handle( struct window *win )
     detach_window_thread( win );
 
     if (win->parent) set_parent_window( win, NULL );
+    free_window_shared( win );
     free_user_handle( win->handle );
     win->handle = 0;
     release_object( win );
@@ -2101,6 +2176,7 @@ DECL_HANDLER(create_window)
     }
     win->style = req->style;
     win->ex_style = req->ex_style;
+    update_window_shared( win );
 
     reply->handle    = win->handle;
     reply->parent    = win->parent ? win->parent->handle : 0;
@@ -2164,6 +2240,7 @@ DECL_HANDLER(get_desktop_window)
         {
             detach_window_thread( desktop->top_window );
             desktop->top_window->style  = WS_POPUP | WS_VISIBLE | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
+            update_window_shared( desktop->top_window );
         }
     }
 
@@ -2176,6 +2253,7 @@ DECL_HANDLER(get_desktop_window)
         {
             detach_window_thread( desktop->msg_window );
             desktop->msg_window->style = WS_POPUP | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
+            update_window_shared( desktop->msg_window );
         }
     }
 
@@ -2211,6 +2289,7 @@ DECL_HANDLER(set_window_owner)
 
     reply->prev_owner = win->owner;
     reply->full_owner = win->owner = owner ? owner->handle : 0;
+    update_window_shared( win );
 }
 
 
@@ -2285,6 +2364,7 @@ DECL_HANDLER(set_window_info)
 
     /* changing window style triggers a non-client paint */
     if (req->flags & SET_WIN_STYLE) win->paint_flags |= PAINT_NONCLIENT;
+    if (req->flags) update_window_shared( win );
 }
 
 
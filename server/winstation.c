@@ -248,6 +248,8 @@ static int init_desktop_mapping( struct desktop *desktop, const struct unicode_s
 
     desktop->shared = NULL;
     desktop->shared_mapping = NULL;
+    desktop->windows_shared = NULL;
+    desktop->windows_mapping = NULL;
 
     if (!(dir = create_desktop_map_directory( desktop->winstation ))) return 0;
     if ((desktop->shared_mapping = create_shared_mapping( dir, name, sizeof(struct desktop_shared_memory),
@@ -258,6 +260,15 @@ static int init_desktop_mapping( struct desktop *desktop, const struct unicode_s
     }
     release_object( dir );
 
+    /* the window state is optional, clients fall back to server requests without it */
+    if ((dir = create_window_map_directory( desktop->winstation )))
+    {
+        desktop->windows_mapping = create_shared_mapping( dir, name, MAX_USER_HANDLES * sizeof(struct window_shared_memory),
+                                                          0, NULL, (void **)&desktop->windows_shared );
+        release_object( dir );
+    }
+    clear_error();
+
     return !!desktop->shared;
 }
 
@@ -357,6 +368,8 @@ static void desktop_destroy( struct object *obj )
     list_remove( &desktop->entry );
     if (desktop->shared_mapping) release_object( desktop->shared_mapping );
     desktop->shared_mapping = NULL;
+    if (desktop->windows_mapping) release_object( desktop->windows_mapping );
+    desktop->windows_mapping = NULL;
     release_object( desktop->winstation );
 }
 
@@ -373,6 +386,7 @@ static void close_desktop_timeout( void *private )
     desktop->close_timeout = NULL;
     unlink_named_object( &desktop->obj );  /* make sure no other process can open it */
     unlink_named_object( desktop->shared_mapping );
+    if (desktop->windows_mapping) unlink_named_object( desktop->windows_mapping );
     post_desktop_message( desktop, WM_CLOSE, 0, 0 );  /* and signal the owner to quit */
 }
 